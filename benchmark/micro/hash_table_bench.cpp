@@ -0,0 +1,85 @@
+// Lookup throughput of the bucketized cuckoo table of HashJoin against
+// ska::flat_hash_map, for 1M keys up to the given maximum (100M by default).
+//
+// Usage: hash_table_bench [max_keys]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <ska/flat_hash_map.hpp>
+#include "operator/hash_join.h"
+
+
+class HashTableBench : public HashJoin {
+public:
+  typedef HashJoin::HashTable Table;
+  typedef HashJoin::Entry Entry;
+};
+
+static const int NUM_LOOKUPS = 10000000;
+static const int BATCH_SIZE = 256;
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, size_t num_keys, double seconds, size_t hits) {
+  std::cout << name << "\tkeys=" << num_keys << "\t" << NUM_LOOKUPS / seconds / 1e6 << " Mlookups/s\thits=" << hits << std::endl;
+}
+
+int main(int argc, char** argv) {
+  size_t max_keys = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+  std::mt19937 gen(42);
+
+  for(size_t num_keys = 1000000; num_keys <= max_keys; num_keys *= 10) {
+    // half of the lookups hit
+    std::vector<uint32_t> keys(num_keys);
+    for(size_t i=0; i<num_keys; i++) {
+      keys[i] = i * 2;
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+    std::vector<uint32_t> probes(NUM_LOOKUPS);
+    for(int i=0; i<NUM_LOOKUPS; i++) {
+      probes[i] = gen() % (num_keys * 2);
+    }
+
+    HashTableBench::Table cuckoo(num_keys);
+    for(size_t i=0; i<num_keys; i++) {
+      cuckoo.insert(keys[i], i);
+    }
+    ska::flat_hash_map<uint32_t, uint32_t> ska_map;
+    ska_map.reserve(num_keys);
+    for(size_t i=0; i<num_keys; i++) {
+      ska_map[keys[i]] = i;
+    }
+
+    size_t hits = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i=0; i<NUM_LOOKUPS; i++) {
+      hits += cuckoo.lookup(probes[i]) != nullptr;
+    }
+    report("cuckoo", num_keys, elapsed(start), hits);
+
+    hits = 0;
+    HashTableBench::Entry* entries[BATCH_SIZE];
+    start = std::chrono::steady_clock::now();
+    for(int i=0; i<NUM_LOOKUPS; i+=BATCH_SIZE) {
+      int n = NUM_LOOKUPS - i < BATCH_SIZE ? NUM_LOOKUPS - i : BATCH_SIZE;
+      cuckoo.lookup(&probes[i], n, entries);
+      for(int j=0; j<n; j++) {
+        hits += entries[j] != nullptr;
+      }
+    }
+    report("cuckoo-batch", num_keys, elapsed(start), hits);
+
+    hits = 0;
+    start = std::chrono::steady_clock::now();
+    for(int i=0; i<NUM_LOOKUPS; i++) {
+      hits += ska_map.find(probes[i]) != ska_map.end();
+    }
+    report("ska", num_keys, elapsed(start), hits);
+  }
+  return 0;
+}
@@ -26,6 +26,14 @@ BufferPage* BufferManager::getBufferPage(RandomRWFile *file, uint32_t block_no,
   if(iter != hash_table.end()) {
     page = (*iter).second;
 
+    // pages fixed by other readers are already off the LRU list
+    if(page->fix_count++ > 0) {
+      if(exclusive) {
+        mutex.unlock();
+      }
+      return page;
+    }
+
     if(page->prev_page != nullptr) {
       page->prev_page->next_page = page->next_page;
     } else if(page == this->lru_cache_head) {
@@ -64,6 +72,7 @@ BufferPage* BufferManager::getBufferPage(RandomRWFile *file, uint32_t block_no,
 
     page->next_page = nullptr;
     page->prev_page = nullptr;
+    page->fix_count = 1;
     hash_table[pageId] = page;
     page->file->read(page->block_data, BLOCK_SIZE, page->block_no * BLOCK_SIZE);
   }
@@ -98,6 +107,7 @@ BufferPage* BufferManager::allocBufferPage(RandomRWFile *file, uint32_t block_no
   }
   page->next_page = nullptr;
   page->prev_page = nullptr;
+  page->fix_count = 1;
   hash_table[pageId] = page;
   page->file->read(page->block_data, BLOCK_SIZE, page->block_no * BLOCK_SIZE);
   if(exclusive) {
@@ -110,7 +120,15 @@ void BufferManager::unfixBufferPage(BufferPage* page, bool dirty, bool exclusive
   if(exclusive) {
     mutex.lock();
   }
-  page->dirty = dirty;
+  if(dirty) {
+    page->dirty = true;
+  }
+  if(--page->fix_count > 0) {
+    if(exclusive) {
+      mutex.unlock();
+    }
+    return;
+  }
 
   page->next_page = this->lru_cache_head;
   page->prev_page = nullptr;
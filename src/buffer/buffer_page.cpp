@@ -1,7 +1,7 @@
 #include "buffer_page.h"
 
 BufferPage::BufferPage(RandomRWFile *file, uint32_t block_no)
-  : file(file), block_no(block_no), dirty(false), prev_page(nullptr), next_page(nullptr) {}
+  : file(file), block_no(block_no), dirty(false), fix_count(0), prev_page(nullptr), next_page(nullptr) {}
 
 BufferPage::~BufferPage() {}
 
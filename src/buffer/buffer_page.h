@@ -22,6 +22,7 @@ private:
 
   ReadWriteLatch latch;
   bool dirty;
+  int fix_count;
   uint32_t block_no;
   RandomRWFile* file;
   BufferPage* prev_page;
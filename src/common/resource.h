@@ -5,6 +5,9 @@
 #include <string>
 #include <vector>
 
+// Id in a column of a variable that an OPTIONAL left unbound.
+const uint32_t UNBOUND_ID = UINT32_MAX;
+
 enum ResourcePosition {
   SUBJECT = 1, PREDICATE = 2, OBJECT = 4
 };
@@ -1,13 +1,24 @@
 #include "config.h"
 #include "util/file_directory.h"
 #include "yaml-cpp/yaml.h"
+#include <cstdlib>
 
 
 const std::string ConfigKey::STORE_PATH = "store_path";
+const std::string ConfigKey::NUM_THREADS = "num_threads";
+const std::string ConfigKey::HASH_TABLE_LAYOUT = "hash_table_layout";
+const std::string ConfigKey::JOIN_FILTER = "join_filter";
+const std::string ConfigKey::JOIN_MEMORY_LIMIT = "join_memory_limit";
+const std::string ConfigKey::SPILL_PATH = "spill_path";
 
 
 const std::string Config::DEFAULT_CONFIG_FILEPATH = "/etc/bphj/init.conf";
 const std::string Config::DEFAULT_STORE_PATH = ".";
+const std::string Config::DEFAULT_NUM_THREADS = "1";
+const std::string Config::DEFAULT_HASH_TABLE_LAYOUT = "chained";
+const std::string Config::DEFAULT_JOIN_FILTER = "none";
+const std::string Config::DEFAULT_JOIN_MEMORY_LIMIT = "0";
+const std::string Config::DEFAULT_SPILL_PATH = "/tmp";
 
 std::map<std::string, std::string> Config::config_map;
 Config::StaticConstructor Config::static_constructor;
@@ -18,13 +29,41 @@ void Config::loadConfig(std::string config_filepath) {
   }
   YAML::Node config = YAML::LoadFile(config_filepath);
   if(config["db.location"]) {
-    config_map[DEFAULT_STORE_PATH] = config["db.location"].as<std::string>();
+    config_map[ConfigKey::STORE_PATH] = config["db.location"].as<std::string>();
+  }
+  if(config["query.threads"]) {
+    config_map[ConfigKey::NUM_THREADS] = config["query.threads"].as<std::string>();
+  }
+  if(config["query.hash_table"]) {
+    config_map[ConfigKey::HASH_TABLE_LAYOUT] = config["query.hash_table"].as<std::string>();
+  }
+  if(config["query.join_filter"]) {
+    config_map[ConfigKey::JOIN_FILTER] = config["query.join_filter"].as<std::string>();
+  }
+  if(config["query.memory_limit"]) {
+    config_map[ConfigKey::JOIN_MEMORY_LIMIT] = config["query.memory_limit"].as<std::string>();
+  }
+  if(config["query.spill_path"]) {
+    config_map[ConfigKey::SPILL_PATH] = config["query.spill_path"].as<std::string>();
   }
 }
 
+void Config::setParam(const std::string& key, const std::string& value) {
+  config_map[key] = value;
+}
+
 const std::string& Config::getParam(const std::string& key) const {
+  static const std::string empty;
   if(!config_map.count(key)) {
-    return "";
+    return empty;
   }
   return config_map[key];
 }
+
+int Config::getIntParam(const std::string& key) const {
+  const std::string& value = getParam(key);
+  if(value.empty()) {
+    return 0;
+  }
+  return std::atoi(value.c_str());
+}
@@ -7,21 +7,38 @@
 class ConfigKey {
 public:
   const static std::string STORE_PATH;
+  const static std::string NUM_THREADS;
+  const static std::string HASH_TABLE_LAYOUT;
+  const static std::string JOIN_FILTER;
+  const static std::string JOIN_MEMORY_LIMIT;
+  const static std::string SPILL_PATH;
 };
 
 class Config {
 public:
   static void loadConfig(std::string config_filepath);
+  static void setParam(const std::string& key, const std::string& value);
   const std::string& getParam(const std::string& key) const;
+  int getIntParam(const std::string& key) const;
 
 private:
   const static std::string DEFAULT_CONFIG_FILEPATH;
   const static std::string DEFAULT_STORE_PATH;
+  const static std::string DEFAULT_NUM_THREADS;
+  const static std::string DEFAULT_HASH_TABLE_LAYOUT;
+  const static std::string DEFAULT_JOIN_FILTER;
+  const static std::string DEFAULT_JOIN_MEMORY_LIMIT;
+  const static std::string DEFAULT_SPILL_PATH;
 
   static std::map<std::string, std::string> config_map;
   static struct StaticConstructor {
     StaticConstructor() {
       config_map[ConfigKey::STORE_PATH] = DEFAULT_STORE_PATH;
+      config_map[ConfigKey::NUM_THREADS] = DEFAULT_NUM_THREADS;
+      config_map[ConfigKey::HASH_TABLE_LAYOUT] = DEFAULT_HASH_TABLE_LAYOUT;
+      config_map[ConfigKey::JOIN_FILTER] = DEFAULT_JOIN_FILTER;
+      config_map[ConfigKey::JOIN_MEMORY_LIMIT] = DEFAULT_JOIN_MEMORY_LIMIT;
+      config_map[ConfigKey::SPILL_PATH] = DEFAULT_SPILL_PATH;
       loadConfig(DEFAULT_CONFIG_FILEPATH);
     }
   } static_constructor;
@@ -46,13 +46,19 @@ void Database::executeQuery(QueryGraph* query_graph, bool explain, bool silent)
   SemanticAnalyzer::analyse(query_graph, *dict);
   StatisticsManager stat_manager(*dict, *triple_table);
   std::unique_ptr<QueryPlan> query_plan = QueryPlanner::build(*query_graph, stat_manager);
+  if(query_plan == nullptr) {
+    std::cerr << "ORDER BY of an expression is not supported, order by a variable instead." << std::endl;
+    dict->clearTemporary();
+    return;
+  }
   if(explain){
     query_plan->print();
   }
 
   Runtime runtime(*this);
   //auto start = std::chrono::high_resolution_clock::now();
-  query_plan->execute(runtime, silent);
+  query_plan->execute(runtime, silent, explain);
+  dict->clearTemporary();
   //auto done = std::chrono::high_resolution_clock::now();
   //double exec_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(done-start).count();
   //std::cout << std::endl << "Running time: " << exec_time << " ms" << std::endl;
@@ -62,8 +68,14 @@ void Database::executeQuery(QueryGraph* query_graph, const std::string& out_file
   SemanticAnalyzer::analyse(query_graph, *dict);
   StatisticsManager stat_manager(*dict, *triple_table);
   std::unique_ptr<QueryPlan> query_plan = QueryPlanner::build(*query_graph, stat_manager);
+  if(query_plan == nullptr) {
+    std::cerr << "ORDER BY of an expression is not supported, order by a variable instead." << std::endl;
+    dict->clearTemporary();
+    return;
+  }
   Runtime runtime(*this, out_file_path);
-  query_plan->execute(runtime, silent);
+  query_plan->execute(runtime, silent, explain);
+  dict->clearTemporary();
 }
 
 Dictionary& Database::getDictionary() {
@@ -60,6 +60,33 @@ bool RocksDBStore::multiGet(const std::vector<std::string>& keys, std::vector<st
   return true;
 }
 
+bool RocksDBStore::get(const rocksdb::Slice& key, rocksdb::PinnableSlice* value) {
+  rocksdb::Status status = db->Get(rocksdb::ReadOptions(), db->DefaultColumnFamily(), key, value);
+  return status.ok();
+}
+
+bool RocksDBStore::multiGet(const std::vector<rocksdb::Slice>& keys, std::vector<rocksdb::PinnableSlice>* values, bool sorted) {
+  values->clear();
+  values->resize(keys.size());
+  return multiGet(keys.data(), keys.size(), values->data(), sorted);
+}
+
+bool RocksDBStore::multiGet(const rocksdb::Slice* keys, size_t num_keys, rocksdb::PinnableSlice* values, bool sorted) {
+  rocksdb::ReadOptions read_options;
+#if ROCKSDB_MAJOR >= 7
+  // reads the blocks of the keys concurrently where the platform allows it
+  read_options.async_io = true;
+#endif
+  std::vector<rocksdb::Status> status(num_keys);
+  db->MultiGet(read_options, db->DefaultColumnFamily(), num_keys, keys, values, status.data(), sorted);
+  for(int i=0; i<num_keys; i++) {
+    if(!status[i].ok() && !status[i].IsNotFound()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool RocksDBStore::put(const std::string& key, const std::string& value) {
   rocksdb::Status status = db->Put(rocksdb::WriteOptions(), key, value);
   return status.ok();
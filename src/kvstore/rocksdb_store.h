@@ -7,6 +7,7 @@
 #include "rocksdb/options.h"
 #include "rocksdb/write_batch.h"
 #include "rocksdb/sst_file_writer.h"
+#include "rocksdb/version.h"
 
 
 class RocksDBStore;
@@ -37,6 +38,12 @@ public:
   bool close();
   bool get(const std::string& key, std::string* value);
   bool multiGet(const std::vector<std::string>& keys, std::vector<std::string>* values);
+  // Reads the value in place, pinned until value is reset or destroyed.
+  bool get(const rocksdb::Slice& key, rocksdb::PinnableSlice* value);
+  // Reads every key with one batched lookup, values[i] is empty when keys[i]
+  // is missing. sorted tells the keys are in ascending order.
+  bool multiGet(const std::vector<rocksdb::Slice>& keys, std::vector<rocksdb::PinnableSlice>* values, bool sorted=false);
+  bool multiGet(const rocksdb::Slice* keys, size_t num_keys, rocksdb::PinnableSlice* values, bool sorted=false);
   bool put(const std::string& key, const std::string& value);
   bool ingestExternalFile(const SstFile& file);
 
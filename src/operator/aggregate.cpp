@@ -0,0 +1,474 @@
+#include "aggregate.h"
+#include "database/config.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+
+static const std::string XSD_NAMESPACE = "http://www.w3.org/2001/XMLSchema#";
+
+const int Aggregate::BATCH_SIZE = 4096;
+const size_t Aggregate::MIN_PARALLEL_ROWS = 2048;
+
+Aggregate::Aggregate(Operator* input, const std::map<uint32_t, Resource*>& resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<uint32_t>& group_keys, const std::vector<Aggregation>& aggregations, Dictionary& dict, double expected_cardinality, Resource* count_res)
+  : Operator(expected_cardinality), input(input), resources(resources), output_resources(output_resources), group_keys(group_keys), aggregations(aggregations), dict(dict), count_res(count_res),
+    row_column(nullptr), width(0), num_threads(1), thread_pool(nullptr), merging(false), batch_rows(0), emit_part(0), emit_group(0) {
+  Config config;
+  if(config.getIntParam(ConfigKey::NUM_THREADS) > 1) {
+    this->num_threads = config.getIntParam(ConfigKey::NUM_THREADS);
+  }
+}
+
+Aggregate::~Aggregate() {
+  for(int i=0; i<this->tasks.size(); i++) {
+    delete this->tasks[i];
+  }
+  delete this->thread_pool;
+  for(int i=0; i<this->partials.size(); i++) {
+    delete this->partials[i];
+  }
+  for(int i=0; i<this->groups.size(); i++) {
+    delete this->groups[i];
+  }
+}
+
+void Aggregate::open() {
+  this->input->open();
+  for(int k=0; k<this->group_keys.size(); k++) {
+    if(this->resources.count(this->group_keys[k])) {
+      this->key_columns.push_back(&this->resources[this->group_keys[k]]->column);
+    }
+  }
+  this->width = this->key_columns.size();
+  for(int a=0; a<this->aggregations.size(); a++) {
+    const QueryExpression* argument = this->aggregations[a].argument;
+    if(argument != nullptr && this->resources.count(argument->id)) {
+      this->arg_columns.push_back(&this->resources[argument->id]->column);
+    } else {
+      this->arg_columns.push_back(nullptr);
+    }
+  }
+  if(this->count_res != nullptr) {
+    this->row_column = &this->count_res->column;
+  } else if(!this->resources.empty()) {
+    this->row_column = &this->resources.begin()->second->column;
+  }
+
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    int key = -1, aggregate = -1, pos = 0;
+    for(int k=0; k<this->group_keys.size(); k++) {
+      if(this->group_keys[k] == iter->first) {
+        key = this->resources.count(iter->first) ? pos : -1;
+        break;
+      }
+      if(this->resources.count(this->group_keys[k])) {
+        pos++;
+      }
+    }
+    for(int a=0; a<this->aggregations.size(); a++) {
+      if(this->aggregations[a].variable.id == iter->first) {
+        aggregate = a;
+      }
+    }
+    this->output_list.push_back(iter->second);
+    this->output_key.push_back(key);
+    this->output_aggregate.push_back(aggregate);
+  }
+
+  int num_partials = 1;
+  if(this->num_threads > 1) {
+    num_partials = this->num_threads;
+    this->thread_pool = new ThreadPool(this->num_threads);
+    for(int p=0; p<num_partials; p++) {
+      this->tasks.push_back(new PartTask(this, p));
+    }
+  }
+  for(int p=0; p<num_partials; p++) {
+    this->partials.push_back(new Partial(this->width));
+  }
+  // without GROUP BY the solutions form one group, even when there are none
+  if(this->group_keys.empty()) {
+    addGroup(*this->partials[0], nullptr, hashKeys(nullptr, 0));
+  }
+}
+
+void Aggregate::close() {
+  this->input->close();
+}
+
+bool Aggregate::first() {
+  consume();
+  emit(BATCH_SIZE);
+  return true;
+}
+
+bool Aggregate::next() {
+  return emit(BATCH_SIZE) > 0;
+}
+
+void Aggregate::consume() {
+  bool more = this->input->first();
+  while(true) {
+    // rows may come with the call that reports the end of the input
+    size_t num_rows = this->row_column != nullptr ? this->row_column->size() : 0;
+    if(this->thread_pool != nullptr && num_rows >= MIN_PARALLEL_ROWS) {
+      this->merging = false;
+      this->batch_rows = num_rows;
+      for(int p=0; p<this->tasks.size(); p++) {
+        this->thread_pool->execute(this->tasks[p]);
+      }
+      this->thread_pool->wait();
+    } else if(num_rows > 0) {
+      aggregateRows(*this->partials[0], 0, num_rows);
+    }
+    for(std::map<uint32_t, Resource*>::iterator iter = resources.begin(), end = resources.end(); iter != end; ++iter) {
+      iter->second->column.clear();
+    }
+    if(this->count_res != nullptr) {
+      this->count_res->column.clear();
+    }
+    if(!more) {
+      break;
+    }
+    more = this->input->next();
+  }
+
+  if(this->partials.size() == 1) {
+    this->groups.swap(this->partials);
+    return;
+  }
+  // every partition of the groups is merged by one thread
+  this->merging = true;
+  for(int p=0; p<this->partials.size(); p++) {
+    this->groups.push_back(new Partial(this->width));
+  }
+  for(int p=0; p<this->tasks.size(); p++) {
+    this->thread_pool->execute(this->tasks[p]);
+  }
+  this->thread_pool->wait();
+  for(int p=0; p<this->partials.size(); p++) {
+    delete this->partials[p];
+  }
+  this->partials.clear();
+}
+
+void Aggregate::runPart(int part) {
+  if(this->merging) {
+    mergePartition(part);
+  } else {
+    size_t begin = this->batch_rows * part / this->tasks.size();
+    size_t end = this->batch_rows * (part + 1) / this->tasks.size();
+    aggregateRows(*this->partials[part], begin, end);
+  }
+}
+
+void Aggregate::aggregateRows(Partial& partial, size_t begin, size_t end) {
+  int num_aggregations = this->aggregations.size();
+  std::vector<uint32_t> keys(this->width);
+  for(size_t r=begin; r<end; r++) {
+    for(int k=0; k<this->width; k++) {
+      keys[k] = (*this->key_columns[k])[r];
+    }
+    uint32_t group = addGroup(partial, keys.data(), hashKeys(keys.data(), this->width));
+    uint64_t count = this->count_res != nullptr ? this->count_res->column[r] : 1;
+    State* states = partial.states.data() + (size_t)group * num_aggregations;
+    for(int a=0; a<num_aggregations; a++) {
+      if(this->aggregations[a].argument == nullptr) {
+        states[a].count += count;
+        continue;
+      }
+      // unbound values are left out of every aggregate
+      uint32_t id = this->arg_columns[a] != nullptr ? (*this->arg_columns[a])[r] : UNBOUND_ID;
+      if(id != UNBOUND_ID) {
+        accumulate(partial, states[a], a, id, count);
+      }
+    }
+  }
+}
+
+void Aggregate::mergePartition(int p) {
+  int num_aggregations = this->aggregations.size();
+  int num_partitions = this->groups.size();
+  Partial& merged = *this->groups[p];
+  for(int i=0; i<this->partials.size(); i++) {
+    Partial& partial = *this->partials[i];
+    for(uint32_t g=0; g<partial.table.size(); g++) {
+      uint64_t hash = partial.table.hash(g);
+      if((hash >> 32) % num_partitions != p) {
+        continue;
+      }
+      uint32_t group = addGroup(merged, partial.table.keys(g), hash);
+      for(int a=0; a<num_aggregations; a++) {
+        merge(merged, merged.states[(size_t)group * num_aggregations + a], partial.states[(size_t)g * num_aggregations + a], a);
+      }
+    }
+  }
+}
+
+uint32_t Aggregate::addGroup(Partial& partial, const uint32_t* keys, uint64_t hash) {
+  bool added;
+  uint32_t group = partial.table.insert(keys, hash, added);
+  if(added) {
+    partial.states.resize(partial.states.size() + this->aggregations.size());
+  }
+  return group;
+}
+
+void Aggregate::accumulate(Partial& partial, State& state, int a, uint32_t id, uint64_t count) {
+  if(this->aggregations[a].distinct) {
+    state.values.insert(id);
+  } else {
+    fold(partial, state, a, id, count);
+  }
+}
+
+void Aggregate::fold(Partial& partial, State& state, int a, uint32_t id, uint64_t count) {
+  switch(this->aggregations[a].function) {
+    case Aggregation::Count:
+      state.count += count;
+      break;
+    case Aggregation::Sum:
+    case Aggregation::Avg: {
+      const Filter::Term* term = decode(partial, id);
+      if(!term->numeric) {
+        state.error = true;
+        break;
+      }
+      state.count += count;
+      if(term->datatype == XSD_NAMESPACE + "decimal" || term->datatype == XSD_NAMESPACE + "float" || term->datatype == XSD_NAMESPACE + "double") {
+        state.integral = false;
+        state.sum += term->number * count;
+        break;
+      }
+      // the number of an integer is only exact up to 2^53, the lexical form
+      // is read again
+      errno = 0;
+      char* end;
+      long long value = std::strtoll(term->lexical.c_str(), &end, 10);
+      if(errno != 0 || *end != '\0' || !addInteger(state, value, count)) {
+        state.sum += term->number * count;
+      }
+      break;
+    }
+    case Aggregation::Min:
+    case Aggregation::Max: {
+      if(state.value == UNBOUND_ID) {
+        state.value = id;
+      } else if(state.value != id) {
+        int result = Filter::compareTerms(*decode(partial, id), *decode(partial, state.value));
+        if(this->aggregations[a].function == Aggregation::Min ? result < 0 : result > 0) {
+          state.value = id;
+        }
+      }
+      break;
+    }
+  }
+}
+
+void Aggregate::merge(Partial& partial, State& state, const State& other, int a) {
+  if(this->aggregations[a].distinct) {
+    state.values.insert(other.values.begin(), other.values.end());
+    return;
+  }
+  if(this->aggregations[a].function == Aggregation::Min || this->aggregations[a].function == Aggregation::Max) {
+    if(other.value != UNBOUND_ID) {
+      fold(partial, state, a, other.value, 1);
+    }
+    return;
+  }
+  state.count += other.count;
+  state.sum += other.sum;
+  if(!addInteger(state, other.integer_sum, 1)) {
+    state.sum += other.integer_sum;
+  }
+  state.integral = state.integral && other.integral;
+  state.error = state.error || other.error;
+}
+
+int Aggregate::emit(int max_rows) {
+  int num_rows = 0;
+  while(num_rows < max_rows && this->emit_part < this->groups.size()) {
+    Partial& partial = *this->groups[this->emit_part];
+    if(this->emit_group >= partial.table.size()) {
+      this->emit_part++;
+      this->emit_group = 0;
+      continue;
+    }
+    for(int s=0; s<this->output_list.size(); s++) {
+      uint32_t id = UNBOUND_ID;
+      if(this->output_key[s] >= 0) {
+        id = partial.table.keys(this->emit_group)[this->output_key[s]];
+      } else if(this->output_aggregate[s] >= 0) {
+        id = result(partial, this->emit_group, this->output_aggregate[s]);
+      }
+      this->output_list[s]->column.push_back(id);
+    }
+    this->emit_group++;
+    num_rows++;
+  }
+  return num_rows;
+}
+
+uint32_t Aggregate::result(Partial& partial, uint32_t group, int a) {
+  const State* state = &partial.states[(size_t)group * this->aggregations.size() + a];
+  State folded;
+  if(this->aggregations[a].distinct) {
+    for(std::unordered_set<uint32_t>::const_iterator iter = state->values.begin(); iter != state->values.end(); ++iter) {
+      fold(partial, folded, a, *iter, 1);
+    }
+    state = &folded;
+  }
+  switch(this->aggregations[a].function) {
+    case Aggregation::Count:
+      return this->dict.encodeTemporary(integerLiteral(state->count));
+    case Aggregation::Sum:
+      if(state->error) {
+        return UNBOUND_ID;
+      }
+      if(state->integral && state->sum == 0) {
+        return this->dict.encodeTemporary(integerLiteral(state->integer_sum));
+      }
+      return this->dict.encodeTemporary(numericLiteral(state->integer_sum + state->sum, state->integral));
+    case Aggregation::Avg:
+      if(state->error) {
+        return UNBOUND_ID;
+      }
+      if(state->count == 0) {
+        return this->dict.encodeTemporary(integerLiteral(0));
+      }
+      return this->dict.encodeTemporary(numericLiteral((state->integer_sum + state->sum) / state->count, false));
+    case Aggregation::Min:
+    case Aggregation::Max:
+      return state->value;
+  }
+  return UNBOUND_ID;
+}
+
+const Filter::Term* Aggregate::decode(Partial& partial, uint32_t id) {
+  std::unordered_map<uint32_t, Filter::Term>::iterator iter = partial.terms.find(id);
+  if(iter != partial.terms.end()) {
+    return &iter->second;
+  }
+  std::string str;
+  this->dict.lookupById(id, &str);
+  Filter::Term& term = partial.terms[id];
+  Filter::parseTerm(str, term);
+  return &term;
+}
+
+uint64_t Aggregate::hashKeys(const uint32_t* keys, int width) {
+  uint64_t hash = 0x9e3779b97f4a7c15ULL;
+  for(int k=0; k<width; k++) {
+    hash = (hash ^ keys[k]) * 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 32;
+  }
+  return hash;
+}
+
+bool Aggregate::addInteger(State& state, int64_t value, uint64_t count) {
+  int64_t product, sum;
+  if(count > INT64_MAX || __builtin_mul_overflow(value, (int64_t)count, &product) || __builtin_add_overflow(state.integer_sum, product, &sum)) {
+    return false;
+  }
+  state.integer_sum = sum;
+  return true;
+}
+
+std::string Aggregate::integerLiteral(int64_t number) {
+  return "\"" + std::to_string(number) + "\"^^<" + XSD_NAMESPACE + "integer>";
+}
+
+std::string Aggregate::numericLiteral(double number, bool integral) {
+  // every digit of the largest double before the point, the sign, the point
+  // and six digits after it
+  char buffer[std::numeric_limits<double>::max_exponent10 + 16];
+  if(integral) {
+    std::snprintf(buffer, sizeof(buffer), "%.0f", number);
+    return "\"" + std::string(buffer) + "\"^^<" + XSD_NAMESPACE + "integer>";
+  }
+  // the lexical form of a decimal has no exponent, and no trailing zeros
+  std::snprintf(buffer, sizeof(buffer), "%.6f", number);
+  size_t end = std::strlen(buffer);
+  while(buffer[end-1] == '0' && buffer[end-2] != '.') {
+    end--;
+  }
+  return "\"" + std::string(buffer, end) + "\"^^<" + XSD_NAMESPACE + "decimal>";
+}
+
+
+
+
+Aggregate::GroupTable::GroupTable(int width) : width(width), slots(16, 0) {}
+
+uint32_t Aggregate::GroupTable::insert(const uint32_t* keys, uint64_t hash, bool& added) {
+  size_t slot = find(keys, hash);
+  added = this->slots[slot] == 0;
+  if(!added) {
+    return (this->slots[slot] & 0xffffffff) - 1;
+  }
+  uint32_t group = this->hashes.size();
+  this->rows.insert(this->rows.end(), keys, keys + this->width);
+  this->hashes.push_back(hash);
+  this->slots[slot] = (hash & 0xffffffff00000000ULL) | (group + 1);
+  if(this->hashes.size() * 2 > this->slots.size()) {
+    grow();
+  }
+  return group;
+}
+
+size_t Aggregate::GroupTable::size() {
+  return this->hashes.size();
+}
+
+const uint32_t* Aggregate::GroupTable::keys(uint32_t group) {
+  return this->rows.data() + (size_t)group * this->width;
+}
+
+uint64_t Aggregate::GroupTable::hash(uint32_t group) {
+  return this->hashes[group];
+}
+
+size_t Aggregate::GroupTable::find(const uint32_t* keys, uint64_t hash) {
+  size_t mask = this->slots.size() - 1;
+  uint64_t tag = hash & 0xffffffff00000000ULL;
+  size_t slot = hash & mask;
+  while(this->slots[slot] != 0) {
+    uint64_t entry = this->slots[slot];
+    if((entry & 0xffffffff00000000ULL) == tag) {
+      const uint32_t* other = this->rows.data() + ((entry & 0xffffffff) - 1) * this->width;
+      if(std::memcmp(other, keys, this->width * sizeof(uint32_t)) == 0) {
+        return slot;
+      }
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void Aggregate::GroupTable::grow() {
+  std::vector<uint64_t> old_slots(this->slots.size() * 2, 0);
+  old_slots.swap(this->slots);
+  size_t mask = this->slots.size() - 1;
+  for(size_t i=0; i<old_slots.size(); i++) {
+    if(old_slots[i] == 0) {
+      continue;
+    }
+    size_t slot = this->hashes[(old_slots[i] & 0xffffffff) - 1] & mask;
+    while(this->slots[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    this->slots[slot] = old_slots[i];
+  }
+}
+
+Aggregate::State::State() : count(0), integer_sum(0), sum(0), integral(true), error(false), value(UNBOUND_ID) {}
+
+Aggregate::Partial::Partial(int width) : table(width) {}
+
+Aggregate::PartTask::PartTask(Aggregate* parent, int part) : parent(parent), part(part) {}
+
+void Aggregate::PartTask::run() {
+  parent->runPart(part);
+}
@@ -0,0 +1,157 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include "operator.h"
+#include "filter.h"
+#include "query/query_graph.h"
+#include "storage/dictionary.h"
+#include "thread/runnable.h"
+#include "thread/thread_pool.h"
+
+
+// GROUP BY with COUNT, SUM, MIN, MAX and AVG. Rows are grouped on the ids of
+// their group keys in an open addressing table, and no term is decoded
+// unless an aggregate needs its value. With more than one thread every
+// batch of the input is split between the threads, which pre-aggregate
+// their rows into tables of their own; once the input is drained the groups
+// are partitioned on their hash, and every partition is merged by one
+// thread. An input that reports repeated rows once with their count in
+// count_res is aggregated without expanding them. Results missing from the
+// dictionary are given temporary ids.
+class Aggregate : public Operator {
+public:
+  Aggregate(Operator* input, const std::map<uint32_t, Resource*>& resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<uint32_t>& group_keys, const std::vector<Aggregation>& aggregations, Dictionary& dict, double expected_cardinality, Resource* count_res=nullptr);
+  ~Aggregate();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  // Open addressing map from the keys of a group to its index.
+  class GroupTable {
+  public:
+    GroupTable(int width);
+
+    // Index of the group of the keys, which is added if missing.
+    uint32_t insert(const uint32_t* keys, uint64_t hash, bool& added);
+    size_t size();
+    const uint32_t* keys(uint32_t group);
+    uint64_t hash(uint32_t group);
+
+  private:
+    // slot holding the keys, or the empty slot they would take
+    size_t find(const uint32_t* keys, uint64_t hash);
+    void grow();
+
+    int width;
+    std::vector<uint32_t> rows;
+    std::vector<uint64_t> hashes;
+    // the high half of the group's hash, and its index plus one; 0 when empty
+    std::vector<uint64_t> slots;
+  };
+
+  struct State {
+    uint64_t count;
+    // SUM and AVG: the integers, exactly, and the values added as doubles,
+    // which are decimals and integers that do not fit in 64 bits
+    int64_t integer_sum;
+    double sum;
+    // SUM and AVG: every value was an integer, and none failed to add up
+    bool integral;
+    bool error;
+    // MIN and MAX: the value so far, UNBOUND_ID before the first one
+    uint32_t value;
+    // DISTINCT: the values, aggregated once the groups are complete
+    std::unordered_set<uint32_t> values;
+
+    State();
+  };
+
+  // Groups of one thread, states[g * aggregations.size() + a] is the state
+  // of aggregate a in group g.
+  struct Partial {
+    GroupTable table;
+    std::vector<State> states;
+    std::unordered_map<uint32_t, Filter::Term> terms;
+
+    Partial(int width);
+  };
+
+  class PartTask : public Runnable {
+  public:
+    PartTask(Aggregate* parent, int part);
+    void run();
+
+  private:
+    Aggregate* parent;
+    int part;
+  };
+
+  void consume();
+  void runPart(int part);
+  // Pre-aggregates the rows [begin, end) of the batch.
+  void aggregateRows(Partial& partial, size_t begin, size_t end);
+  // Merges the groups of every partial that fall in partition p.
+  void mergePartition(int p);
+  uint32_t addGroup(Partial& partial, const uint32_t* keys, uint64_t hash);
+  void accumulate(Partial& partial, State& state, int a, uint32_t id, uint64_t count);
+  void fold(Partial& partial, State& state, int a, uint32_t id, uint64_t count);
+  void merge(Partial& partial, State& state, const State& other, int a);
+  int emit(int max_rows);
+  uint32_t result(Partial& partial, uint32_t group, int a);
+  const Filter::Term* decode(Partial& partial, uint32_t id);
+  static uint64_t hashKeys(const uint32_t* keys, int width);
+  // Adds count times value to the exact sum of state, or tells it does not
+  // fit.
+  static bool addInteger(State& state, int64_t value, uint64_t count);
+  static std::string integerLiteral(int64_t number);
+  static std::string numericLiteral(double number, bool integral);
+
+  static const int BATCH_SIZE;
+  static const size_t MIN_PARALLEL_ROWS;
+
+  Operator* input;
+  std::map<uint32_t, Resource*> resources;
+  std::map<uint32_t, Resource*> output_resources;
+  std::vector<uint32_t> group_keys;
+  std::vector<Aggregation> aggregations;
+  Dictionary& dict;
+  Resource* count_res;
+
+  // the group keys bound by the input, the others are unbound in every group
+  std::vector<std::vector<uint32_t>*> key_columns;
+  // the column of every aggregate, nullptr for COUNT(*) or a variable the
+  // input does not bind
+  std::vector<std::vector<uint32_t>*> arg_columns;
+  std::vector<uint32_t>* row_column;
+  // output_list[s] is key output_key[s] if it is not negative, and
+  // aggregate output_aggregate[s] otherwise
+  std::vector<Resource*> output_list;
+  std::vector<int> output_key;
+  std::vector<int> output_aggregate;
+  int width;
+
+  int num_threads;
+  ThreadPool* thread_pool;
+  std::vector<PartTask*> tasks;
+  bool merging;
+  size_t batch_rows;
+  std::vector<Partial*> partials;
+  // one partial per partition after the merge
+  std::vector<Partial*> groups;
+  int emit_part;
+  uint32_t emit_group;
+
+  friend class AggregateTest;
+};
+
+
+#endif
@@ -1,487 +1,1452 @@
 #include "backprobe_hash_join.h"
+#include "database/config.h"
+#include "plan/lb_cost_model.h"
 #include <xorfilter/xorfilter.h>
-#include <xorfilter/hashutil.h>
+#include <xorfilter/binaryfusefilter_singleheader.h>
 
+#include <set>
+#include <algorithm>
+#include <sstream>
 #include <chrono>
 #include <iostream>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-BackProbeHashJoin::BackProbeHashJoin(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<JoinNode>& join_nodes, double expected_cardinality)
-  : Operator(expected_cardinality), inputs(inputs), input_resources(input_resources), output_resources(output_resources), bind_resources(input_resources.size()), join_nodes(join_nodes), thld_ratio(0.05), thld_count(10000000) {
+const int BackProbeHashJoin::FILTER_BATCH_SIZE = 1024;
+const int BackProbeHashJoin::PUSHDOWN_SAMPLE_SIZE = 32;
+const int BackProbeHashJoin::MAX_SPILL_PARTITIONS = 128;
+
+static inline uint32_t hashKey(uint32_t key) {
+  key ^= key >> 16;
+  key *= 0x85ebca6b;
+  key ^= key >> 13;
+  key *= 0xc2b2ae35;
+  key ^= key >> 16;
+  return key;
+}
+
+BackProbeHashJoin::BackProbeHashJoin(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<JoinNode>& join_nodes, double expected_cardinality, bool explain)
+  : Operator(expected_cardinality), inputs(inputs), input_resources(input_resources), output_resources(output_resources), count_res(nullptr), bind_resources(input_resources.size()), join_nodes(join_nodes), thld_ratio(0.05),
+    explain(explain), layout(HashTable::Chained), key_filter_type(HashTable::NoKeyFilter), num_threads(1), num_partitions(1), morsel_size(1 << 16), thread_pool(nullptr),
+    memory_limit(0), spillable(false), num_spill_partitions(0), spill_partition(0), batch_size(4096), row_limit(UINT64_MAX), num_rows(0), probe_pos(0) {
+  Config config;
+  if(config.getIntParam(ConfigKey::NUM_THREADS) > 1) {
+    this->num_threads = config.getIntParam(ConfigKey::NUM_THREADS);
+  }
+  if(config.getParam(ConfigKey::HASH_TABLE_LAYOUT) == "flat") {
+    this->layout = HashTable::Flat;
+  }
+  if(config.getParam(ConfigKey::JOIN_FILTER) == "xor") {
+    this->key_filter_type = HashTable::XorKeyFilter;
+  } else if(config.getParam(ConfigKey::JOIN_FILTER) == "fuse") {
+    this->key_filter_type = HashTable::FuseKeyFilter;
+  }
+  if(config.getIntParam(ConfigKey::JOIN_MEMORY_LIMIT) > 0) {
+    this->memory_limit = (size_t)config.getIntParam(ConfigKey::JOIN_MEMORY_LIMIT) << 20;
+    this->spill_path = config.getParam(ConfigKey::SPILL_PATH);
+  }
 }
 
 BackProbeHashJoin::~BackProbeHashJoin() {
   for(int i=0; i<this->hash_tables.size(); ++i) {
     delete this->hash_tables[i];
   }
+  for(int i=0; i<this->probe_contexts.size(); ++i) {
+    delete this->probe_contexts[i];
+  }
+  delete this->thread_pool;
 }
 
 void BackProbeHashJoin::open() {
   for(int i=0; i<inputs.size(); i++) {
     inputs[i]->open();
   }
-  /*
-  for(int i=0; i<join_nodes.size(); ++i) {
-    std::cout<<join_nodes[i].left_join_key<<" "<<join_nodes[i].right_join_key<<std::endl;
+
+  if(this->num_threads > 1) {
+    // a few partitions per thread keeps the insert phase balanced on skewed keys
+    while(this->num_partitions < this->num_threads * 4) {
+      this->num_partitions <<= 1;
+    }
+    this->thread_pool = new ThreadPool(this->num_threads);
+    this->morsel_rows.resize(this->num_threads * this->num_partitions);
+  }
+
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    this->slots[iter->first] = this->output_list.size();
+    this->output_list.push_back(iter->second);
+  }
+  for(int i=0; i<join_nodes.size(); i++) {
+    if(!this->slots.count(join_nodes[i].right_join_key)) {
+      int slot = this->slots.size();
+      this->slots[join_nodes[i].right_join_key] = slot;
+    }
   }
-  */
 
   std::set<uint32_t> checked;
-  uint32_t join_res = UINT32_MAX;
   for(int i=input_resources.size()-1; i>=0; i--) {
     for(std::map<uint32_t, Resource*>::iterator iter = input_resources[i].begin(), end = input_resources[i].end(); iter != end; ++iter) {
       if(checked.count(iter->first) != 0) {
         continue;
       }
 
-      if(output_resources.count(iter->first) != 0) {
-        bind_resources[i].push_back(std::make_pair(iter->second, output_resources[iter->first]));
+      if(this->slots.count(iter->first) != 0) {
+        bind_resources[i].push_back(std::make_pair(iter->second, this->slots[iter->first]));
         checked.insert(iter->first);
       }
     }
   }
+
+  // The key of a hash table is bound when the key is looked up, so an input
+  // binding nothing else only contributes the number of its rows per key.
+  this->count_only.resize(input_resources.size());
+  this->output_binds.resize(input_resources.size());
+  for(int i=0; i<input_resources.size(); i++) {
+    int key_slot = this->slots[join_nodes[i].right_join_key];
+    this->count_only[i] = bind_resources[i].empty() || (bind_resources[i].size() == 1 && bind_resources[i][0].second == key_slot);
+    this->output_binds[i].resize(this->output_list.size(), nullptr);
+    for(int j=0; j<bind_resources[i].size(); j++) {
+      if(bind_resources[i][j].second < this->output_list.size()) {
+        this->output_binds[i][bind_resources[i][j].second] = bind_resources[i][j].first;
+      }
+    }
+  }
+
+  // Only a star join, where every input is keyed on the same variable, can
+  // be split into partitions of the key that join independently.
+  this->spillable = this->memory_limit > 0;
+  for(int i=0; i<join_nodes.size(); i++) {
+    const JoinNode& node = join_nodes[i];
+    if(node.right_join_key != join_nodes[0].right_join_key || (node.left_join_key != UINT32_MAX && node.left_join_key != node.right_join_key)) {
+      this->spillable = false;
+    }
+  }
+}
+
+void BackProbeHashJoin::setCountResource(Resource* count_res) {
+  this->count_res = count_res;
+}
+
+void BackProbeHashJoin::setRowLimit(uint64_t row_limit) {
+  this->row_limit = row_limit;
 }
 
 void BackProbeHashJoin::close() {
   for(int i=0; i<inputs.size(); i++) {
     this->inputs[i]->close();
   }
+  if(this->explain) {
+    for(int i=0; i<this->strategies.size(); i++) {
+      std::cout << this->strategies[i] << std::endl;
+    }
+    for(int k=0; k<this->hash_tables.size(); k++) {
+      this->hash_tables[k]->printKeyFilterStats(std::cout);
+    }
+  }
+  removeSpillFiles();
+  delete this->thread_pool;
+  this->thread_pool = nullptr;
 }
 
 bool BackProbeHashJoin::first() {
   // build
   build();
+  if(this->num_spill_partitions > 0) {
+    loadSpilledPartition(0);
+  }
 
-  // proble
-  //auto start = std::chrono::high_resolution_clock::now();
+  // probe
+  initProbe();
   probe();
-  /*
-  auto done = std::chrono::high_resolution_clock::now();
-  double exec_time = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(done-start).count();
-  std::cout << std::endl << "probe time: " << exec_time << " ms" << std::endl;
-  */
   return true;
 }
 
 bool BackProbeHashJoin::next() {
-  return false;
+  return probe() > 0;
 }
 
 void BackProbeHashJoin::build() {
-  for(int i=0; i<this->join_nodes.size(); i++) {
-    // auto start = std::chrono::high_resolution_clock::now();
+  std::vector<HashTable*> branch_tables(this->join_nodes.size(), nullptr);
+  if(this->thread_pool != nullptr) {
+    buildBranches(branch_tables);
+  }
 
-    bool only_count = false;
-    /*
-    if(this->input_resources[i].size() == 1) {
-      only_count = true;
-    }
-    */
+  for(int i=0; i<this->join_nodes.size(); i++) {
     const JoinNode& node = this->join_nodes[i];
+    if(this->num_spill_partitions > 0) {
+      if(this->explain) {
+        std::stringstream ss;
+        ss << "->  Join node[input=" << i << " key=" << node.right_join_key << " strategy=spill]";
+        this->strategies.push_back(ss.str());
+      }
+      spillInput(i, true);
+      continue;
+    }
+    if(branch_tables[i] != nullptr) {
+      this->hash_tables.push_back(branch_tables[i]);
+      this->hash_table_map[node.right_join_key] = branch_tables[i];
+      if(this->explain) {
+        std::stringstream ss;
+        ss << "->  Join node[input=" << i << " key=" << node.right_join_key << " strategy=scan+branch]";
+        this->strategies.push_back(ss.str());
+      }
+      continue;
+    }
+
+    BuildContext context;
+    context.input = i;
+    context.filter_hash_table = nullptr;
+    context.filter_res = nullptr;
+    context.key_res = input_resources[i][node.right_join_key];
+    context.count_only = this->count_only[i];
+
+    std::stringstream costs;
+    HashTable* right_hash_table = this->hash_table_map.count(node.right_join_key) ? this->hash_table_map[node.right_join_key] : nullptr;
+    bool pushed = false;
     if(node.left_join_key != UINT32_MAX && node.left_join_key != node.right_join_key) {
-      if(node.can_filter && (this->hash_table_map.count(node.right_join_key)?this->hash_table_map[node.left_join_key]->numOfKeys()<this->hash_table_map[node.right_join_key]->numOfKeys():true) && (double)this->hash_table_map[node.left_join_key]->numOfKeys() / this->inputs[i]->getExpectedCardinality() < thld_ratio) {
-        if(node.left_res_pos == ResourcePosition::SUBJECT) {
-          this->inputs[i]->setTripleOrder(TripleOrder::SP);
-        } else {
-          this->inputs[i]->setTripleOrder(TripleOrder::OP);
-        }
-        Resource* left_res = input_resources[i][node.left_join_key];
-        Resource* right_res = input_resources[i][node.right_join_key];
-
-        this->hash_table_map[node.left_join_key]->getAllKeys(left_res->column);
-
-        HashTable* hash_table;
-        if(!this->hash_table_map.count(node.right_join_key)) {
-          hash_table = new HashTable(node.right_join_key);
-          this->hash_tables.push_back(hash_table);
-          this->hash_table_map[node.right_join_key] = hash_table;
-          hash_table->init(i);
-          int j=0;
-          if(!only_count) {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->insert(right_res->column[j], j);
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  hash_table->insert(right_res->column[j], j);
-                }
-              }
-            }
-          } else {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->insert(right_res->column[j]);
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  hash_table->insert(right_res->column[j]);
-                }
-              }
-            }
-          }
-        } else {
-          hash_table = this->hash_table_map[node.right_join_key];
-          hash_table->init(i);
-          int j=0;
-          if(!only_count) {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->append(right_res->column[j], j);
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  hash_table->append(right_res->column[j], j);
-                }
-              }
-            }
-          } else {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->append(right_res->column[j]);
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  hash_table->append(right_res->column[j]);
-                }
-              }
-            }
-          }
-        }
-      } else {
-        Resource* left_res = input_resources[i][node.left_join_key];
-        Resource* right_res = input_resources[i][node.right_join_key];
-
-        if(node.can_filter && this->hash_table_map.count(node.right_join_key)) {
-          if((double)this->hash_table_map[node.right_join_key]->numOfKeys() / this->inputs[i]->getExpectedCardinality() < thld_ratio) {
-            if(node.right_res_pos == ResourcePosition::SUBJECT) {
-              this->inputs[i]->setTripleOrder(TripleOrder::SP);
-            } else {
-              this->inputs[i]->setTripleOrder(TripleOrder::OP);
-            }
-            this->hash_table_map[node.right_join_key]->getAllKeys(right_res->column);
-          }
+      HashTable* left_hash_table = this->hash_table_map[node.left_join_key];
+      if(node.can_filter && (right_hash_table == nullptr || left_hash_table->numOfKeys() < right_hash_table->numOfKeys())) {
+        pushed = pushdownKeys(i, node.left_res_pos, left_hash_table, input_resources[i][node.left_join_key], costs);
+      }
+      if(!pushed) {
+        if(node.can_filter && right_hash_table != nullptr) {
+          pushed = pushdownKeys(i, node.right_res_pos, right_hash_table, context.key_res, costs);
         }
+        context.filter_hash_table = left_hash_table;
+        context.filter_res = input_resources[i][node.left_join_key];
+        left_hash_table->buildKeyFilter(this->key_filter_type);
+      }
+    } else if(node.can_filter && right_hash_table != nullptr) {
+      pushed = pushdownKeys(i, node.right_res_pos, right_hash_table, context.key_res, costs);
+    }
+    if(this->explain) {
+      std::stringstream ss;
+      ss << "->  Join node[input=" << i << " key=" << node.right_join_key
+         << " strategy=" << (pushed ? "pushdown" : "scan") << (context.filter_hash_table != nullptr ? "+filter" : "")
+         << costs.str() << "]";
+      this->strategies.push_back(ss.str());
+    }
 
-        HashTable* filter_hash_table = this->hash_table_map[node.left_join_key];
-        HashTable* hash_table;
-
-        if(!this->hash_table_map.count(node.right_join_key)) {
-          hash_table = new HashTable(node.right_join_key);
-          this->hash_tables.push_back(hash_table);
-          this->hash_table_map[node.right_join_key] = hash_table;
-          hash_table->init(i);
-          int j=0;
-          if(!only_count) {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                if(filter_hash_table->exist(left_res->column[j])) {
-                  hash_table->insert(right_res->column[j], j);
-                }
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  if(filter_hash_table->exist(left_res->column[j])) {
-                    hash_table->insert(right_res->column[j], j);
-                  }
-                }
-              }
-            }
-          } else {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                if(filter_hash_table->exist(left_res->column[j])) {
-                  hash_table->insert(right_res->column[j]);
-                }
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  if(filter_hash_table->exist(left_res->column[j])) {
-                    hash_table->insert(right_res->column[j]);
-                  }
-                }
-              }
-            }
-          }
-        } else {
-          hash_table = this->hash_table_map[node.right_join_key];
-          hash_table->init(i);
-          int j=0;
-          if(!only_count) {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                if(filter_hash_table->exist(left_res->column[j])) {
-                  hash_table->append(right_res->column[j], j);
-                }
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  if(filter_hash_table->exist(left_res->column[j])) {
-                    hash_table->append(right_res->column[j], j);
-                  }
-                }
-              }
-            }
-          } else {
-            if(this->inputs[i]->first()) {
-              for(; j<right_res->column.size(); j++) {
-                if(filter_hash_table->exist(left_res->column[j])) {
-                  hash_table->append(right_res->column[j]);
-                }
-              }
-              while(this->inputs[i]->next()) {
-                for(; j<right_res->column.size(); j++) {
-                  if(filter_hash_table->exist(left_res->column[j])) {
-                    hash_table->append(right_res->column[j]);
-                  }
-                }
-              }
-            }
-          }
-        }
+    if(!this->hash_table_map.count(node.right_join_key)) {
+      context.hash_table = createHashTable(node.right_join_key);
+      context.append = false;
+      this->hash_tables.push_back(context.hash_table);
+      this->hash_table_map[node.right_join_key] = context.hash_table;
+    } else {
+      context.hash_table = this->hash_table_map[node.right_join_key];
+      context.append = true;
+    }
+    context.hash_table->init(i);
+    buildHashTable(context, this->thread_pool);
+  }
+
+  for(int i=0; i<this->spill_writers.size(); i++) {
+    for(int p=0; p<this->spill_writers[i].size(); p++) {
+      this->spill_writers[i][p]->close();
+      delete this->spill_writers[i][p];
+    }
+  }
+  this->spill_writers.clear();
+}
+
+void BackProbeHashJoin::buildBranches(std::vector<HashTable*>& branch_tables) {
+  // Inputs that start a new hash table and are not filtered by another one
+  // do not depend on any earlier build, so they are scanned and built side by side.
+  std::set<uint32_t> keys;
+  std::vector<BuildContext> branches;
+  for(int i=0; i<this->join_nodes.size(); i++) {
+    const JoinNode& node = this->join_nodes[i];
+    bool filtered = node.left_join_key != UINT32_MAX && node.left_join_key != node.right_join_key;
+    if(!keys.count(node.right_join_key) && !filtered) {
+      BuildContext context;
+      context.input = i;
+      context.hash_table = nullptr;
+      context.filter_hash_table = nullptr;
+      context.filter_res = nullptr;
+      context.key_res = input_resources[i][node.right_join_key];
+      context.append = false;
+      context.count_only = this->count_only[i];
+      branches.push_back(context);
+    }
+    keys.insert(node.right_join_key);
+  }
+  if(branches.size() < 2) {
+    return;
+  }
+
+  std::vector<BranchTask*> tasks;
+  for(int i=0; i<branches.size(); i++) {
+    int input = branches[i].input;
+    branches[i].hash_table = createHashTable(this->join_nodes[input].right_join_key);
+    branches[i].hash_table->init(input);
+    branch_tables[input] = branches[i].hash_table;
+    tasks.push_back(new BranchTask(this, branches[i]));
+    this->thread_pool->execute(tasks.back());
+  }
+  this->thread_pool->wait();
+  for(int i=0; i<tasks.size(); i++) {
+    delete tasks[i];
+  }
+}
+
+BackProbeHashJoin::HashTable* BackProbeHashJoin::createHashTable(uint32_t key_res) {
+  return new HashTable(key_res, this->num_partitions, this->layout);
+}
+
+void BackProbeHashJoin::buildHashTable(const BuildContext& context, ThreadPool* pool) {
+  Operator* input = this->inputs[context.input];
+  if(!input->first()) {
+    finishHashTable(context.hash_table, pool);
+    return;
+  }
+  int j = 0;
+  do {
+    int n = context.key_res->column.size();
+    if(pool == nullptr) {
+      insertRows(context, j, n);
+      j = n;
+    } else if(n - j >= this->morsel_size) {
+      insertMorsel(context, j, n);
+      j = n;
+    }
+    if(this->spillable && buildMemoryUsage(context.input) > this->memory_limit) {
+      startSpill(context.input);
+      spillInput(context.input, false);
+      return;
+    }
+  } while(input->next());
+
+  if(j < context.key_res->column.size()) {
+    if(pool == nullptr) {
+      insertRows(context, j, context.key_res->column.size());
+    } else {
+      insertMorsel(context, j, context.key_res->column.size());
+    }
+  }
+  finishHashTable(context.hash_table, pool);
+}
+
+void BackProbeHashJoin::finishHashTable(HashTable* hash_table, ThreadPool* pool) {
+  if(hash_table->getLayout() == HashTable::Chained) {
+    return;
+  }
+  if(pool == nullptr) {
+    for(int p=0; p<hash_table->numOfPartitions(); p++) {
+      hash_table->finish(p);
+    }
+    return;
+  }
+  std::vector<FinishTask*> tasks;
+  for(int t=0; t<this->num_threads; t++) {
+    tasks.push_back(new FinishTask(this, hash_table, t));
+    pool->execute(tasks.back());
+  }
+  pool->wait();
+  for(int t=0; t<this->num_threads; t++) {
+    delete tasks[t];
+  }
+}
+
+void BackProbeHashJoin::insertRows(const BuildContext& context, int start, int end) {
+  uint32_t rows[FILTER_BATCH_SIZE];
+  for(int j=start; j<end; j+=FILTER_BATCH_SIZE) {
+    int n = end - j < FILTER_BATCH_SIZE ? end - j : FILTER_BATCH_SIZE;
+    int num_rows = n;
+    if(context.filter_hash_table != nullptr) {
+      num_rows = context.filter_hash_table->filter(&context.filter_res->column[j], n, rows);
+      for(int r=0; r<num_rows; r++) {
+        rows[r] += j;
       }
     } else {
-      Resource* right_res = input_resources[i][node.right_join_key];
-
-      if(node.can_filter && this->hash_table_map.count(node.right_join_key)) {
-        if((double)this->hash_table_map[node.right_join_key]->numOfKeys() / this->inputs[i]->getExpectedCardinality() < thld_ratio) {
-          if(node.right_res_pos == ResourcePosition::SUBJECT) {
-            this->inputs[i]->setTripleOrder(TripleOrder::SP);
-          } else {
-            this->inputs[i]->setTripleOrder(TripleOrder::OP);
-          }
-          this->hash_table_map[node.right_join_key]->getAllKeys(right_res->column);
-        }
+      for(int r=0; r<n; r++) {
+        rows[r] = j + r;
       }
+    }
+    insertRows(context, rows, num_rows);
+  }
+}
 
-
-      HashTable* hash_table;
-      if(!this->hash_table_map.count(node.right_join_key)) {
-        hash_table = new HashTable(node.right_join_key);
-        this->hash_tables.push_back(hash_table);
-        this->hash_table_map[node.right_join_key] = hash_table;
-        hash_table->init(i);
-        int j=0;
-        if(!only_count) {
-          if(this->inputs[i]->first()) {
-            for(; j<right_res->column.size(); j++) {
-              hash_table->insert(right_res->column[j], j);
-            }
-            while(this->inputs[i]->next()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->insert(right_res->column[j], j);
-              }
-            }
-          }
-        } else {
-          if(this->inputs[i]->first()) {
-            for(; j<right_res->column.size(); j++) {
-              hash_table->insert(right_res->column[j]);
-            }
-            while(this->inputs[i]->next()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->insert(right_res->column[j]);
-              }
-            }
-          }
-        }
+void BackProbeHashJoin::insertRows(const BuildContext& context, const uint32_t* rows, int num_rows) {
+  HashTable* hash_table = context.hash_table;
+  std::vector<uint32_t>& keys = context.key_res->column;
+  if(context.count_only) {
+    for(int r=0; r<num_rows; r++) {
+      if(context.append) {
+        hash_table->append(keys[rows[r]]);
       } else {
-        hash_table = this->hash_table_map[node.right_join_key];
-        hash_table->init(i);
-        int j=0;
-        if(!only_count) {
-          if(this->inputs[i]->first()) {
-            for(; j<right_res->column.size(); j++) {
-              hash_table->append(right_res->column[j], j);
-            }
-            while(this->inputs[i]->next()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->append(right_res->column[j], j);
-              }
-            }
-          }
-        } else {
-          if(this->inputs[i]->first()) {
-            for(; j<right_res->column.size(); j++) {
-              hash_table->append(right_res->column[j]);
-            }
-            while(this->inputs[i]->next()) {
-              for(; j<right_res->column.size(); j++) {
-                hash_table->append(right_res->column[j]);
-              }
-            }
-          }
-        }
+        hash_table->insert(keys[rows[r]]);
       }
     }
+  } else if(context.append) {
+    for(int r=0; r<num_rows; r++) {
+      hash_table->append(keys[rows[r]], rows[r]);
+    }
+  } else {
+    for(int r=0; r<num_rows; r++) {
+      hash_table->insert(keys[rows[r]], rows[r]);
+    }
   }
 }
 
-void BackProbeHashJoin::probe() {
-  int k = this->hash_tables.size()-1;
-  HashTable* hash_table = this->hash_tables[k];
-  HashTable::Iterator iter = hash_table->begin();
-  HashTable::Iterator end = hash_table->end();
-  for(; iter != end; ++iter) {
-    Entry* entry = &iter->entry;
-    EntryHead* next_head = iter->next;
-    int i = hash_table->getLevelValue(iter->level);
-    while(entry != nullptr) {
-      int idx = entry->value;
-      for(int j=0; j<bind_resources[i].size(); j++) {
-        bind_resources[i][j].second->id = bind_resources[i][j].first->column[idx];
+void BackProbeHashJoin::insertMorsel(const BuildContext& context, int start, int end) {
+  // Pass 1: every thread filters a slice of the morsel and scatters the
+  // surviving row ids by key partition.
+  std::vector<PartitionTask*> partition_tasks;
+  int step = (end - start + this->num_threads - 1) / this->num_threads;
+  for(int t=0; t<this->num_threads; t++) {
+    int slice_start = start + t * step < end ? start + t * step : end;
+    int slice_end = slice_start + step < end ? slice_start + step : end;
+    partition_tasks.push_back(new PartitionTask(this, &context, t, slice_start, slice_end));
+    this->thread_pool->execute(partition_tasks.back());
+  }
+  this->thread_pool->wait();
+
+  // Pass 2: every thread owns a disjoint set of partitions and inserts into them.
+  std::vector<InsertTask*> insert_tasks;
+  for(int t=0; t<this->num_threads; t++) {
+    insert_tasks.push_back(new InsertTask(this, &context, t));
+    this->thread_pool->execute(insert_tasks.back());
+  }
+  this->thread_pool->wait();
+
+  for(int t=0; t<this->num_threads; t++) {
+    delete partition_tasks[t];
+    delete insert_tasks[t];
+  }
+}
+
+bool BackProbeHashJoin::pushdownKeys(int i, ResourcePosition pos, HashTable* hash_table, Resource* res, std::ostream& costs) {
+  // Fetching the rows of every key costs one lookup per key plus the pages
+  // of large segments, estimated from a sample of the keys. It is compared
+  // with scanning the whole predicate.
+  Operator* input = this->inputs[i];
+  TripleOrder key_order = pos == ResourcePosition::SUBJECT ? TripleOrder::SP : TripleOrder::OP;
+  std::vector<uint32_t> keys;
+  hash_table->getAllKeys(keys);
+
+  int num_samples = keys.size() < PUSHDOWN_SAMPLE_SIZE ? keys.size() : PUSHDOWN_SAMPLE_SIZE;
+  cost_t lookup_cost = 0;
+  for(int s=0; s<num_samples && lookup_cost>=0; s++) {
+    int count = input->getCountByKey(key_order, keys[(size_t)s * keys.size() / num_samples]);
+    lookup_cost = count < 0 ? -1 : lookup_cost + LowerBoundsCostModel::estimateKeyLookup(count);
+  }
+  cost_t scan_cost = LowerBoundsCostModel::estimateTableScan((input->getExpectedCardinality()*sizeof(uint32_t)*2+BLOCK_SIZE)/BLOCK_SIZE);
+
+  bool pushdown;
+  costs << " " << (pos == ResourcePosition::SUBJECT ? "subject" : "object") << "_keys=" << keys.size();
+  if(lookup_cost >= 0 && num_samples > 0) {
+    lookup_cost = lookup_cost * keys.size() / num_samples;
+    pushdown = lookup_cost < scan_cost;
+    costs << " lookup_cost=" << lookup_cost << " scan_cost=" << scan_cost;
+  } else {
+    // no statistics for this input
+    pushdown = (double)keys.size() / input->getExpectedCardinality() < thld_ratio;
+  }
+
+  if(!pushdown) {
+    return false;
+  }
+  input->setTripleOrder(key_order);
+  res->column.insert(res->column.end(), keys.begin(), keys.end());
+  return true;
+}
+
+size_t BackProbeHashJoin::buildMemoryUsage(int last_input) {
+  // the columns of the inputs plus one hash table row per input row
+  size_t row_size = this->layout == HashTable::Chained ? sizeof(Entry) : sizeof(uint32_t);
+  size_t usage = 0;
+  for(int i=0; i<=last_input; i++) {
+    size_t num_rows = input_resources[i][join_nodes[i].right_join_key]->column.size();
+    usage += num_rows * (input_resources[i].size() * sizeof(uint32_t) + row_size);
+  }
+  return usage;
+}
+
+void BackProbeHashJoin::startSpill(int last_input) {
+  // Enough partitions for the expected build side to fit the budget twice over.
+  size_t row_size = this->layout == HashTable::Chained ? sizeof(Entry) : sizeof(uint32_t);
+  double expected = 0;
+  for(int i=0; i<this->inputs.size(); i++) {
+    expected += this->inputs[i]->getExpectedCardinality() * (input_resources[i].size() * sizeof(uint32_t) + row_size);
+  }
+  double usage = std::max(expected, (double)buildMemoryUsage(last_input));
+  this->num_spill_partitions = 2;
+  while(this->num_spill_partitions < MAX_SPILL_PARTITIONS && this->num_spill_partitions * (double)this->memory_limit < 2 * usage) {
+    this->num_spill_partitions <<= 1;
+  }
+  if(this->explain) {
+    std::stringstream ss;
+    ss << "->  Grace spill[input=" << last_input << " partitions=" << this->num_spill_partitions << " memory_limit=" << (this->memory_limit >> 20) << "MB]";
+    this->strategies.push_back(ss.str());
+  }
+
+  this->spill_writers.resize(this->inputs.size());
+  this->spill_rows.resize(this->inputs.size());
+  for(int i=0; i<this->inputs.size(); i++) {
+    this->spill_rows[i].resize(this->num_spill_partitions, 0);
+    for(int p=0; p<this->num_spill_partitions; p++) {
+      std::string file = spillFile(i, p);
+      File::remove(file);
+      this->spill_writers[i].push_back(new BufferedFileWriter(file));
+    }
+  }
+
+  // The rows already built are written out as well, and the hash table dropped.
+  for(int i=0; i<last_input; i++) {
+    spillRows(i);
+    for(std::map<uint32_t, Resource*>::iterator iter = input_resources[i].begin(), end = input_resources[i].end(); iter != end; ++iter) {
+      iter->second->column.shrink_to_fit();
+    }
+  }
+  for(int k=0; k<this->hash_tables.size(); k++) {
+    delete this->hash_tables[k];
+  }
+  this->hash_tables.clear();
+  this->hash_table_map.clear();
+}
+
+void BackProbeHashJoin::spillInput(int i, bool first) {
+  Operator* input = this->inputs[i];
+  if(first && !input->first()) {
+    return;
+  }
+  do {
+    spillRows(i);
+  } while(input->next());
+}
+
+void BackProbeHashJoin::spillRows(int i) {
+  std::vector<std::vector<uint32_t>*> columns;
+  for(std::map<uint32_t, Resource*>::iterator iter = input_resources[i].begin(), end = input_resources[i].end(); iter != end; ++iter) {
+    columns.push_back(&iter->second->column);
+  }
+  std::vector<uint32_t>& keys = input_resources[i][join_nodes[i].right_join_key]->column;
+  std::vector<uint32_t> row(columns.size());
+  for(int r=0; r<keys.size(); r++) {
+    // high bits of the hash, the low ones pick the buckets of flat tables
+    int p = ((uint64_t)hashKey(keys[r]) * this->num_spill_partitions) >> 32;
+    for(int c=0; c<columns.size(); c++) {
+      row[c] = (*columns[c])[r];
+    }
+    this->spill_writers[i][p]->append((const char*)row.data(), row.size() * sizeof(uint32_t));
+    ++this->spill_rows[i][p];
+  }
+  for(int c=0; c<columns.size(); c++) {
+    columns[c]->clear();
+  }
+}
+
+std::string BackProbeHashJoin::spillFile(int i, int p) {
+  std::stringstream ss;
+  ss << this->spill_path << "/bphj_" << getpid() << "_" << (void*)this << "_" << i << "_" << p << ".spill";
+  return ss.str();
+}
+
+int BackProbeHashJoin::loadSpilledRows(int i, int p) {
+  std::vector<std::vector<uint32_t>*> columns;
+  for(std::map<uint32_t, Resource*>::iterator iter = input_resources[i].begin(), end = input_resources[i].end(); iter != end; ++iter) {
+    columns.push_back(&iter->second->column);
+  }
+  int num_rows = this->spill_rows[i][p];
+  for(int c=0; c<columns.size(); c++) {
+    columns[c]->resize(num_rows);
+  }
+  std::string file = spillFile(i, p);
+  if(num_rows > 0) {
+    MmapFileReader reader(file);
+    const uint32_t* data = (const uint32_t*)reader.begin();
+    for(int r=0; r<num_rows; r++) {
+      for(int c=0; c<columns.size(); c++) {
+        (*columns[c])[r] = data[r * columns.size() + c];
       }
-      enumerate(hash_table, k-1, next_head);
-      entry = entry->next;
     }
+    reader.close();
   }
+  File::remove(file);
+  return num_rows;
 }
 
-void BackProbeHashJoin::enumerate(HashTable* hash_table, int k, EntryHead* head) {
-  if(head != nullptr) {
-    Entry* entry = &head->entry;
-    EntryHead* next_head = head->next;
-    int i = hash_table->getLevelValue(head->level);
-    while(entry != nullptr) {
-      int idx = entry->value;
-      for(int j=0; j<bind_resources[i].size(); ++j) {
-        bind_resources[i][j].second->id = bind_resources[i][j].first->column[idx];
+void BackProbeHashJoin::loadSpilledPartition(int p) {
+  for(int k=0; k<this->hash_tables.size(); k++) {
+    delete this->hash_tables[k];
+  }
+  this->hash_tables.clear();
+  this->hash_table_map.clear();
+  for(int c=0; c<this->probe_contexts.size(); c++) {
+    delete this->probe_contexts[c];
+  }
+  this->probe_contexts.clear();
+  this->probe_pos = 0;
+
+  uint32_t key = this->join_nodes[0].right_join_key;
+  HashTable* hash_table = createHashTable(key);
+  this->hash_tables.push_back(hash_table);
+  this->hash_table_map[key] = hash_table;
+  for(int i=0; i<this->inputs.size(); i++) {
+    BuildContext context;
+    context.input = i;
+    context.hash_table = hash_table;
+    context.filter_hash_table = nullptr;
+    context.filter_res = nullptr;
+    context.key_res = input_resources[i][key];
+    context.append = i > 0;
+    context.count_only = this->count_only[i];
+
+    hash_table->init(i);
+    int num_rows = loadSpilledRows(i, p);
+    if(this->thread_pool == nullptr) {
+      insertRows(context, 0, num_rows);
+    } else if(num_rows > 0) {
+      insertMorsel(context, 0, num_rows);
+    }
+    finishHashTable(hash_table, this->thread_pool);
+  }
+}
+
+void BackProbeHashJoin::removeSpillFiles() {
+  for(int i=0; i<this->spill_rows.size(); i++) {
+    for(int p=this->spill_partition; p<this->num_spill_partitions; p++) {
+      std::string file = spillFile(i, p);
+      if(File::exist(file)) {
+        File::remove(file);
       }
-      enumerate(hash_table, k, next_head);
-      entry = entry->next;
     }
+  }
+}
+
+void BackProbeHashJoin::initProbe() {
+  this->key_slots.resize(this->hash_tables.size());
+  for(int k=0; k<this->hash_tables.size(); k++) {
+    this->key_slots[k] = this->slots[this->hash_tables[k]->getKeyResourceId()];
+  }
+  HashTable* hash_table = this->hash_tables.back();
+  int num_columns = this->output_list.size() + (this->count_res != nullptr ? 1 : 0);
+
+  if(this->thread_pool == nullptr) {
+    ProbeContext* context = new ProbeContext(hash_table, 0, hash_table->numOfPartitions());
+    context->bindings.resize(this->slots.size());
+    for(int s=0; s<num_columns; s++) {
+      context->columns.push_back(&outputColumn(s));
+    }
+    this->probe_contexts.push_back(context);
     return;
   }
-  if(k >= 0) {
-    HashTable* new_hash_table = this->hash_tables[k];
-    EntryHead* new_head = new_hash_table->lookup(output_resources[new_hash_table->getKeyResourceId()]->id);
-    if(new_head == nullptr) {
-      return;
+
+  // Every partition of the top-level table is enumerated separately into
+  // private columns, which are appended to the output in partition order.
+  for(int p=0; p<hash_table->numOfPartitions(); p++) {
+    ProbeContext* context = new ProbeContext(hash_table, p, p+1);
+    context->bindings.resize(this->slots.size());
+    context->buffers.resize(num_columns);
+    for(int s=0; s<num_columns; s++) {
+      context->columns.push_back(&context->buffers[s]);
     }
-    Entry* entry = &new_head->entry;
-    EntryHead* next_head = new_head->next;
-    int i = new_hash_table->getLevelValue(new_head->level);
-    while(entry != nullptr) {
-      int idx = entry->value;
-      for(int j=0; j<bind_resources[i].size(); j++) {
-        bind_resources[i][j].second->id = bind_resources[i][j].first->column[idx];
+    this->probe_contexts.push_back(context);
+  }
+}
+
+int BackProbeHashJoin::probe() {
+  // the rows past the limit are never enumerated, nor the partitions holding them
+  if(this->num_rows >= this->row_limit) {
+    return 0;
+  }
+  int num_rows = probeHashTables();
+  while(num_rows == 0 && this->spill_partition + 1 < this->num_spill_partitions) {
+    loadSpilledPartition(++this->spill_partition);
+    initProbe();
+    num_rows = probeHashTables();
+  }
+  this->num_rows += num_rows;
+  return num_rows;
+}
+
+int BackProbeHashJoin::probeHashTables() {
+  if(this->thread_pool == nullptr) {
+    return enumerate(*this->probe_contexts[0], probeBatchSize());
+  }
+
+  int num_rows = 0;
+  while(num_rows == 0 && this->probe_pos < this->probe_contexts.size()) {
+    std::vector<ProbeTask*> tasks;
+    for(int p=this->probe_pos; p<this->probe_contexts.size() && tasks.size()<this->num_threads; p++) {
+      if(!this->probe_contexts[p]->done) {
+        tasks.push_back(new ProbeTask(this, this->probe_contexts[p], probeBatchSize()));
+        this->thread_pool->execute(tasks.back());
       }
-      enumerate(new_hash_table, k-1, next_head);
-      entry = entry->next;
     }
-  } else {
-    for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
-      iter->second->column.push_back(iter->second->id);
+    this->thread_pool->wait();
+    for(int t=0; t<tasks.size(); t++) {
+      num_rows += tasks[t]->numOfRows();
+      delete tasks[t];
+    }
+
+    for(int p=this->probe_pos; p<this->probe_contexts.size(); p++) {
+      ProbeContext* context = this->probe_contexts[p];
+      for(int s=0; s<context->columns.size(); s++) {
+        std::vector<uint32_t>& column = outputColumn(s);
+        column.insert(column.end(), context->columns[s]->begin(), context->columns[s]->end());
+        context->columns[s]->clear();
+      }
+    }
+    while(this->probe_pos < this->probe_contexts.size() && this->probe_contexts[this->probe_pos]->done) {
+      ++this->probe_pos;
+    }
+  }
+  return num_rows;
+}
+
+int BackProbeHashJoin::probeBatchSize() {
+  return this->row_limit - this->num_rows < this->batch_size ? this->row_limit - this->num_rows : this->batch_size;
+}
+
+std::vector<uint32_t>& BackProbeHashJoin::outputColumn(int s) {
+  if(s < this->output_list.size()) {
+    return this->output_list[s]->column;
+  }
+  return this->count_res->column;
+}
+
+void BackProbeHashJoin::bind(ProbeContext& context, int i, uint32_t idx) {
+  for(int j=0; j<bind_resources[i].size(); j++) {
+    context.bindings[bind_resources[i][j].second] = bind_resources[i][j].first->column[idx];
+  }
+}
+
+BackProbeHashJoin::Advance BackProbeHashJoin::advance(ProbeContext& context, const Frame& frame, Frame& next) {
+  next.weight = frame.weight;
+  if(frame.hash_table->descend(frame.cursor, next.cursor)) {
+    next.hash_table = frame.hash_table;
+    next.k = frame.k;
+    return NextLevel;
+  }
+  if(frame.k < 0) {
+    return LastLevel;
+  }
+  next.hash_table = this->hash_tables[frame.k];
+  next.k = frame.k - 1;
+  return next.hash_table->seek(context.bindings[this->key_slots[frame.k]], next.cursor) ? NextLevel : NoMatch;
+}
+
+int BackProbeHashJoin::emit(ProbeContext& context, int max_rows) {
+  // with a count column one row stands for up to UINT32_MAX copies
+  int num_rows = 0;
+  int num_outputs = this->output_list.size();
+  while(context.pending > 0 && num_rows < max_rows) {
+    uint64_t count = 1;
+    for(int s=0; s<num_outputs; s++) {
+      context.columns[s]->push_back(context.bindings[s]);
+    }
+    if(this->count_res != nullptr) {
+      count = context.pending < UINT32_MAX ? context.pending : UINT32_MAX;
+      context.columns[num_outputs]->push_back(count);
+    }
+    context.pending -= count;
+    ++num_rows;
+  }
+  return num_rows;
+}
+
+int BackProbeHashJoin::emitLastLevel(ProbeContext& context, Frame& frame, int max_rows) {
+  // Rows of the last level only differ in the columns bound by its input,
+  // so the output is filled a column at a time.
+  std::vector<uint32_t>& rows = context.rows;
+  rows.clear();
+  uint32_t value;
+  while(rows.size() < max_rows && frame.hash_table->nextRow(frame.cursor, value)) {
+    rows.push_back(value);
+  }
+  int n = rows.size();
+  if(n == 0) {
+    return 0;
+  }
+
+  const std::vector<Resource*>& binds = this->output_binds[frame.hash_table->getLevelValue(frame.cursor.level)];
+  for(int s=0; s<binds.size(); s++) {
+    std::vector<uint32_t>& column = *context.columns[s];
+    if(binds[s] == nullptr) {
+      column.insert(column.end(), n, context.bindings[s]);
+    } else {
+      const std::vector<uint32_t>& input_column = binds[s]->column;
+      for(int r=0; r<n; r++) {
+        column.push_back(input_column[rows[r]]);
+      }
+    }
+  }
+  if(this->count_res != nullptr) {
+    context.columns[binds.size()]->insert(context.columns[binds.size()]->end(), n, frame.weight);
+  }
+  return n;
+}
+
+int BackProbeHashJoin::enumerate(ProbeContext& context, int max_rows) {
+  int k = this->hash_tables.size()-1;
+  int num_rows = 0;
+  while(num_rows < max_rows) {
+    if(context.pending > 0) {
+      num_rows += emit(context, max_rows - num_rows);
+      continue;
+    }
+
+    Frame next;
+    if(context.frames.empty()) {
+      if(!(context.iter != context.end)) {
+        context.done = true;
+        break;
+      }
+      next.hash_table = this->hash_tables[k];
+      next.k = k-1;
+      next.weight = 1;
+      context.iter.cursor(next.cursor);
+      context.bindings[this->key_slots[k]] = context.iter.key();
+      ++context.iter;
+    } else {
+      Frame& frame = context.frames.back();
+      if(frame.k < 0 && !frame.hash_table->hasLowerLevel(frame.cursor) && (frame.weight == 1 || (this->count_res != nullptr && frame.weight <= UINT32_MAX))) {
+        int n = emitLastLevel(context, frame, max_rows - num_rows);
+        if(n == 0) {
+          context.frames.pop_back();
+        }
+        num_rows += n;
+        continue;
+      }
+      uint32_t value;
+      if(!frame.hash_table->nextRow(frame.cursor, value)) {
+        context.frames.pop_back();
+        continue;
+      }
+      bind(context, frame.hash_table->getLevelValue(frame.cursor.level), value);
+      Advance result = advance(context, frame, next);
+      if(result == LastLevel) {
+        context.pending = frame.weight;
+      }
+      if(result != NextLevel) {
+        continue;
+      }
+    }
+
+    // Count-only levels are not enumerated, their row counts multiply the
+    // weight of the rows found below them.
+    Advance result = NextLevel;
+    while(result == NextLevel && this->count_only[next.hash_table->getLevelValue(next.cursor.level)]) {
+      Frame counted = next;
+      counted.weight *= counted.hash_table->numOfRows(counted.cursor);
+      result = advance(context, counted, next);
+      if(result == LastLevel) {
+        context.pending = counted.weight;
+      }
+    }
+    if(result == NextLevel) {
+      context.frames.push_back(next);
+    }
+  }
+  return num_rows;
+}
+
+BackProbeHashJoin::ProbeContext::ProbeContext(HashTable* hash_table, int start_partition, int end_partition)
+  : iter(hash_table, start_partition, end_partition), end(hash_table, end_partition, end_partition), done(false), pending(0) {}
+
+// Build tasks
+BackProbeHashJoin::PartitionTask::PartitionTask(BackProbeHashJoin* join, const BuildContext* context, int thread, int start, int end)
+  : join(join), context(context), thread(thread), start(start), end(end) {}
+
+void BackProbeHashJoin::PartitionTask::run() {
+  HashTable* hash_table = context->hash_table;
+  int num_partitions = hash_table->numOfPartitions();
+  std::vector<uint32_t>* rows = &join->morsel_rows[thread * num_partitions];
+  for(int p=0; p<num_partitions; p++) {
+    rows[p].clear();
+  }
+  std::vector<uint32_t>& keys = context->key_res->column;
+  if(context->filter_hash_table == nullptr) {
+    for(int j=start; j<end; j++) {
+      rows[hash_table->partitionOf(keys[j])].push_back(j);
+    }
+    return;
+  }
+  uint32_t sel[FILTER_BATCH_SIZE];
+  for(int j=start; j<end; j+=FILTER_BATCH_SIZE) {
+    int n = end - j < FILTER_BATCH_SIZE ? end - j : FILTER_BATCH_SIZE;
+    int num_sel = context->filter_hash_table->filter(&context->filter_res->column[j], n, sel);
+    for(int r=0; r<num_sel; r++) {
+      rows[hash_table->partitionOf(keys[j + sel[r]])].push_back(j + sel[r]);
+    }
+  }
+}
+
+BackProbeHashJoin::InsertTask::InsertTask(BackProbeHashJoin* join, const BuildContext* context, int thread)
+  : join(join), context(context), thread(thread) {}
+
+void BackProbeHashJoin::InsertTask::run() {
+  int num_partitions = context->hash_table->numOfPartitions();
+  for(int p=thread; p<num_partitions; p+=join->num_threads) {
+    // slices are visited in order, so rows keep the same order as a serial build
+    for(int t=0; t<join->num_threads; t++) {
+      std::vector<uint32_t>& rows = join->morsel_rows[t * num_partitions + p];
+      join->insertRows(*context, rows.data(), rows.size());
     }
   }
 }
 
-// HashIterator
-BackProbeHashJoin::HashTable::HashTable(uint32_t key_res) : key_res(key_res), num_keys(0), curr_level(-1), prev_level(-1) {
+BackProbeHashJoin::ProbeTask::ProbeTask(BackProbeHashJoin* join, ProbeContext* context, int max_rows)
+  : join(join), context(context), max_rows(max_rows), num_rows(0) {}
+
+void BackProbeHashJoin::ProbeTask::run() {
+  num_rows = join->enumerate(*context, max_rows);
+}
+
+int BackProbeHashJoin::ProbeTask::numOfRows() {
+  return num_rows;
+}
+
+BackProbeHashJoin::FinishTask::FinishTask(BackProbeHashJoin* join, HashTable* hash_table, int thread)
+  : join(join), hash_table(hash_table), thread(thread) {}
+
+void BackProbeHashJoin::FinishTask::run() {
+  for(int p=thread; p<hash_table->numOfPartitions(); p+=join->num_threads) {
+    hash_table->finish(p);
+  }
+}
+
+BackProbeHashJoin::BranchTask::BranchTask(BackProbeHashJoin* join, const BuildContext& context)
+  : join(join), context(context) {}
+
+void BackProbeHashJoin::BranchTask::run() {
+  join->buildHashTable(context, nullptr);
+}
+
+// HashTable
+const uint32_t BackProbeHashJoin::HashTable::EMPTY_SLOT = UINT32_MAX;
+
+struct BackProbeHashJoin::HashTable::KeyFilter {
+  KeyFilter(KeyFilterType type, size_t size) : type(type), xor_filter(nullptr) {
+    if(type == XorKeyFilter) {
+      xor_filter = new xorfilter::XorFilter<uint64_t, uint8_t>(size);
+    } else if(!binary_fuse8_allocate(size, &fuse_filter)) {
+      fuse_filter.Fingerprints = nullptr;
+    }
+  }
+  ~KeyFilter() {
+    if(type == XorKeyFilter) {
+      delete xor_filter;
+    } else {
+      binary_fuse8_free(&fuse_filter);
+    }
+  }
+
+  bool populate(const std::vector<uint64_t>& keys) {
+    if(type == XorKeyFilter) {
+      return xor_filter->AddAll(keys, 0, keys.size()) == xorfilter::Ok;
+    }
+    return fuse_filter.Fingerprints != nullptr && binary_fuse8_populate(keys.data(), keys.size(), &fuse_filter);
+  }
+
+  bool contain(uint32_t key) {
+    if(type == XorKeyFilter) {
+      return xor_filter->Contain(key) == xorfilter::Ok;
+    }
+    return binary_fuse8_contain(key, &fuse_filter);
+  }
+
+  size_t sizeInBytes() {
+    if(type == XorKeyFilter) {
+      return xor_filter->SizeInBytes();
+    }
+    return binary_fuse8_size_in_bytes(&fuse_filter);
+  }
+
+  KeyFilterType type;
+  xorfilter::XorFilter<uint64_t, uint8_t>* xor_filter;
+  binary_fuse8_t fuse_filter;
+};
+
+BackProbeHashJoin::HashTable::HashTable(uint32_t key_res, int num_partitions, Layout layout)
+  : layout(layout), key_res(key_res), partition_bits(0), curr_level(-1), prev_level(-1),
+    key_filter(nullptr), key_filter_level(-1), filter_probes(0), filter_rejects(0), filter_false_positives(0) {
+  while((1 << partition_bits) < num_partitions) {
+    ++partition_bits;
+  }
+  for(int p=0; p<(1 << partition_bits); p++) {
+    Partition* partition = new Partition();
+    partition->num_keys = 0;
+    this->partitions.push_back(partition);
+  }
+}
+
+BackProbeHashJoin::HashTable::~HashTable() {
+  for(int p=0; p<this->partitions.size(); p++) {
+    delete this->partitions[p];
+  }
+  delete this->key_filter;
 }
 
 void BackProbeHashJoin::HashTable::init(int level_val) {
   this->prev_level = this->curr_level;
   ++this->curr_level;
-  this->num_keys = 0;
+  for(int p=0; p<this->partitions.size(); p++) {
+    this->partitions[p]->num_keys = 0;
+  }
   this->level_vals.push_back(level_val);
 }
 
 void BackProbeHashJoin::HashTable::insert(uint32_t key) {
-  auto it = this->table.find(key);
-  if(it != this->table.end()) {
+  Partition* partition = this->partitions[partitionOf(key)];
+  if(this->layout == Flat) {
+    partition->pending_keys.push_back(key);
+    return;
+  }
+  auto it = partition->table.find(key);
+  if(it != partition->table.end()) {
     EntryHead* head = it->second;
     ++head->entry.count;
   } else {
-    ++num_keys;
-    EntryHead* head = head_pool.alloc();
+    ++partition->num_keys;
+    EntryHead* head = partition->head_pool.alloc();
     head->next = nullptr;
     head->level = curr_level;
     head->entry.count = 1;
     head->entry.next = nullptr;
-    table[key] = head;
+    partition->table[key] = head;
   }
 }
 
 void BackProbeHashJoin::HashTable::insert(uint32_t key, uint32_t value) {
-  auto it = this->table.find(key);
-  if(it != this->table.end()) {
+  Partition* partition = this->partitions[partitionOf(key)];
+  if(this->layout == Flat) {
+    partition->pending_keys.push_back(key);
+    partition->pending_values.push_back(value);
+    return;
+  }
+  auto it = partition->table.find(key);
+  if(it != partition->table.end()) {
     EntryHead* head = it->second;
     Entry* prev = &head->entry;
 
-    Entry* entry = entry_pool.alloc();
+    Entry* entry = partition->entry_pool.alloc();
     entry->value = value;
     entry->count = 1;
     entry->next = prev->next;
     prev->next = entry;
   } else {
-    ++num_keys;
-    EntryHead* head = head_pool.alloc();
+    ++partition->num_keys;
+    EntryHead* head = partition->head_pool.alloc();
     head->next = nullptr;
     head->level = curr_level;
     head->entry.value = value;
     head->entry.count = 1;
     head->entry.next = nullptr;
-    table[key] = head;
+    partition->table[key] = head;
   }
 }
 
 void BackProbeHashJoin::HashTable::append(uint32_t key) {
-  auto it = this->table.find(key);
-  if(it != this->table.end()) {
+  Partition* partition = this->partitions[partitionOf(key)];
+  if(this->layout == Flat) {
+    Bucket* bucket = findBucket(partition, key);
+    if(bucket != nullptr && bucket->level == prev_level) {
+      partition->pending_keys.push_back(key);
+    }
+    return;
+  }
+  auto it = partition->table.find(key);
+  if(it != partition->table.end()) {
     EntryHead* head = it->second;
     if(curr_level == head->level) {
       ++head->entry.count;
     } else if(prev_level == head->level) {
-      ++num_keys;
-      EntryHead* new_head = head_pool.alloc();
+      ++partition->num_keys;
+      EntryHead* new_head = partition->head_pool.alloc();
       new_head->next = head;
       new_head->level = curr_level;
       new_head->entry.count = 1;
       new_head->entry.next = nullptr;
-      table[key] = new_head;
+      it->second = new_head;
     }
   }
 }
 
 void BackProbeHashJoin::HashTable::append(uint32_t key, uint32_t value) {
-  auto it = this->table.find(key);
-  if(it != this->table.end()) {
+  Partition* partition = this->partitions[partitionOf(key)];
+  if(this->layout == Flat) {
+    // the directory is only updated by finish(), so keys still at the
+    // previous level are exactly those that survive
+    Bucket* bucket = findBucket(partition, key);
+    if(bucket != nullptr && bucket->level == prev_level) {
+      partition->pending_keys.push_back(key);
+      partition->pending_values.push_back(value);
+    }
+    return;
+  }
+  auto it = partition->table.find(key);
+  if(it != partition->table.end()) {
     EntryHead* head = it->second;
     if(curr_level == head->level) {
       Entry* prev = &head->entry;
 
-      Entry* entry = entry_pool.alloc();
+      Entry* entry = partition->entry_pool.alloc();
       entry->value = value;
       entry->count = 1;
       entry->next = prev->next;
       prev->next = entry;
     } else if(prev_level == head->level) {
-      ++num_keys;
-      EntryHead* new_head = head_pool.alloc();
+      ++partition->num_keys;
+      EntryHead* new_head = partition->head_pool.alloc();
       new_head->next = head;
       new_head->level = curr_level;
       new_head->entry.value = value;
       new_head->entry.count = 1;
       new_head->entry.next = nullptr;
-      table[key] = new_head;
+      it->second = new_head;
+    }
+  }
+}
+
+void BackProbeHashJoin::HashTable::finish(int partition) {
+  if(this->layout == Flat) {
+    finishLevel(this->partitions[partition]);
+  }
+}
+
+void BackProbeHashJoin::HashTable::finishLevel(Partition* partition) {
+  std::vector<uint32_t>& keys = partition->pending_keys;
+  std::vector<uint32_t>& values = partition->pending_values;
+  std::vector<uint32_t> offsets(1, 0);
+  std::vector<uint32_t> links;
+
+  // Pass 1: give every key of this level a slot and count its rows.
+  std::vector<uint32_t> row_slots(keys.size());
+  for(int j=0; j<keys.size(); j++) {
+    Bucket* bucket = curr_level == 0 ? addBucket(partition, keys[j]) : findBucket(partition, keys[j]);
+    if(bucket->slot == EMPTY_SLOT || bucket->level != curr_level) {
+      if(curr_level > 0) {
+        links.push_back(bucket->slot);
+      }
+      bucket->slot = offsets.size() - 1;
+      bucket->level = curr_level;
+      offsets.push_back(0);
     }
+    row_slots[j] = bucket->slot;
+    ++offsets[bucket->slot + 1];
   }
+  for(int s=1; s<offsets.size(); s++) {
+    offsets[s] += offsets[s-1];
+  }
+
+  // Pass 2: scatter the rows into one contiguous range per key. Levels
+  // built without values only keep the counts.
+  std::vector<uint32_t> rows(values.size());
+  if(!values.empty()) {
+    std::vector<uint32_t> pos(offsets.begin(), offsets.end() - 1);
+    for(int j=0; j<keys.size(); j++) {
+      rows[pos[row_slots[j]]++] = values[j];
+    }
+  }
+
+  partition->num_keys = offsets.size() - 1;
+  partition->offsets.push_back(std::move(offsets));
+  partition->rows.push_back(std::move(rows));
+  partition->links.push_back(std::move(links));
+  std::vector<uint32_t>().swap(keys);
+  std::vector<uint32_t>().swap(values);
 }
 
-BackProbeHashJoin::EntryHead* BackProbeHashJoin::HashTable::lookup(uint32_t key) {
-  Entry* entry;
-  auto it = this->table.find(key);
-  if(it != this->table.end()) {
-    if(it->second->level == curr_level) {
-      return it->second;
+BackProbeHashJoin::HashTable::Bucket* BackProbeHashJoin::HashTable::findBucket(Partition* partition, uint32_t key) {
+  std::vector<Bucket>& buckets = partition->buckets;
+  if(buckets.empty()) {
+    return nullptr;
+  }
+  uint32_t mask = buckets.size() - 1;
+  for(uint32_t b = hashKey(key) & mask; buckets[b].slot != EMPTY_SLOT; b = (b + 1) & mask) {
+    if(buckets[b].key == key) {
+      return &buckets[b];
     }
   }
   return nullptr;
 }
 
+BackProbeHashJoin::HashTable::Bucket* BackProbeHashJoin::HashTable::addBucket(Partition* partition, uint32_t key) {
+  std::vector<Bucket>& buckets = partition->buckets;
+  // keys are only added at level 0, while the directory is kept at most half full
+  if(2 * (partition->num_keys + 1) > buckets.size()) {
+    std::vector<Bucket> old_buckets;
+    old_buckets.swap(buckets);
+    buckets.assign(old_buckets.empty() ? 16 : old_buckets.size() * 2, {0, EMPTY_SLOT, -1});
+    uint32_t mask = buckets.size() - 1;
+    for(int i=0; i<old_buckets.size(); i++) {
+      if(old_buckets[i].slot != EMPTY_SLOT) {
+        uint32_t b = hashKey(old_buckets[i].key) & mask;
+        while(buckets[b].slot != EMPTY_SLOT) {
+          b = (b + 1) & mask;
+        }
+        buckets[b] = old_buckets[i];
+      }
+    }
+  }
+  uint32_t mask = buckets.size() - 1;
+  uint32_t b = hashKey(key) & mask;
+  for(; buckets[b].slot != EMPTY_SLOT; b = (b + 1) & mask) {
+    if(buckets[b].key == key) {
+      return &buckets[b];
+    }
+  }
+  ++partition->num_keys;
+  buckets[b].key = key;
+  return &buckets[b];
+}
+
 bool BackProbeHashJoin::HashTable::exist(uint32_t key) {
-  auto it = this->table.find(key);
-  return it != this->table.end() && it->second->level == curr_level;
+  Partition* partition = this->partitions[partitionOf(key)];
+  if(this->layout == Flat) {
+    Bucket* bucket = findBucket(partition, key);
+    return bucket != nullptr && bucket->level == curr_level;
+  }
+  auto it = partition->table.find(key);
+  return it != partition->table.end() && it->second->level == curr_level;
+}
+
+int BackProbeHashJoin::HashTable::filter(const uint32_t* keys, int n, uint32_t* sel) {
+  if(this->key_filter == nullptr) {
+    return filterKeys(keys, n, sel);
+  }
+  // only keys passing the key filter are looked up in the table
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> positions;
+  for(int i=0; i<n; i++) {
+    if(this->key_filter->contain(keys[i])) {
+      candidates.push_back(keys[i]);
+      positions.push_back(i);
+    }
+  }
+  int num_sel = filterKeys(candidates.data(), candidates.size(), sel);
+  for(int r=0; r<num_sel; r++) {
+    sel[r] = positions[sel[r]];
+  }
+  this->filter_probes += n;
+  this->filter_rejects += n - candidates.size();
+  this->filter_false_positives += candidates.size() - num_sel;
+  return num_sel;
+}
+
+void BackProbeHashJoin::HashTable::buildKeyFilter(KeyFilterType type) {
+  if(type == NoKeyFilter || this->key_filter_level == this->curr_level) {
+    return;
+  }
+  delete this->key_filter;
+  this->key_filter = nullptr;
+  this->key_filter_level = this->curr_level;
+
+  std::vector<uint32_t> keys;
+  getAllKeys(keys);
+  if(keys.empty()) {
+    return;
+  }
+  this->key_filter = new KeyFilter(type, keys.size());
+  if(!this->key_filter->populate(std::vector<uint64_t>(keys.begin(), keys.end()))) {
+    delete this->key_filter;
+    this->key_filter = nullptr;
+  }
+}
+
+void BackProbeHashJoin::HashTable::printKeyFilterStats(std::ostream& out) {
+  if(this->key_filter == nullptr) {
+    return;
+  }
+  uint64_t probes = this->filter_probes;
+  uint64_t rejects = this->filter_rejects;
+  out << "->  Key filter";
+  out << "[" << "key=" << this->key_res << " type=" << (this->key_filter->type == XorKeyFilter ? "xor" : "fuse")
+      << " keys=" << numOfKeys() << " bytes=" << this->key_filter->sizeInBytes()
+      << " probes=" << probes << " rejected=" << rejects
+      << " rejection_rate=" << (probes == 0 ? 0.0 : (double)rejects / probes)
+      << " false_positives=" << this->filter_false_positives << "]" << std::endl;
+}
+
+int BackProbeHashJoin::HashTable::filterKeys(const uint32_t* keys, int n, uint32_t* sel) {
+  if(this->layout == Flat && this->partitions.size() == 1) {
+    return filterFlat(keys, n, sel);
+  }
+  int num_sel = 0;
+  for(int i=0; i<n; i++) {
+    sel[num_sel] = i;
+    num_sel += exist(keys[i]);
+  }
+  return num_sel;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Probes the home bucket of 8 keys at once with gathers; only keys that
+// collide with another key in their home bucket fall back to exist().
+__attribute__((target("avx2")))
+static int filterFlatAvx2(const uint32_t* keys, int n, uint32_t* sel, const uint32_t* buckets, uint32_t mask, int level, uint32_t empty_slot) {
+  const __m256i c1 = _mm256_set1_epi32(0x85ebca6b);
+  const __m256i c2 = _mm256_set1_epi32(0xc2b2ae35);
+  const __m256i mask_vec = _mm256_set1_epi32(mask);
+  const __m256i level_vec = _mm256_set1_epi32(level);
+  const __m256i empty_vec = _mm256_set1_epi32(empty_slot);
+  int num_sel = 0;
+  int i = 0;
+  for(; i+8<=n; i+=8) {
+    __m256i key = _mm256_loadu_si256((const __m256i*)(keys + i));
+    __m256i h = _mm256_xor_si256(key, _mm256_srli_epi32(key, 16));
+    h = _mm256_mullo_epi32(h, c1);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, c2);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    __m256i b = _mm256_and_si256(h, mask_vec);
+    // a bucket is three consecutive words: key, slot, level
+    __m256i idx = _mm256_add_epi32(_mm256_add_epi32(b, b), b);
+    __m256i bucket_key = _mm256_i32gather_epi32((const int*)buckets, idx, 4);
+    __m256i bucket_slot = _mm256_i32gather_epi32((const int*)buckets + 1, idx, 4);
+    __m256i bucket_level = _mm256_i32gather_epi32((const int*)buckets + 2, idx, 4);
+
+    __m256i empty = _mm256_cmpeq_epi32(bucket_slot, empty_vec);
+    __m256i same_key = _mm256_andnot_si256(empty, _mm256_cmpeq_epi32(bucket_key, key));
+    __m256i hit = _mm256_and_si256(same_key, _mm256_cmpeq_epi32(bucket_level, level_vec));
+    uint32_t hits = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+    uint32_t resolved = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(empty, same_key)));
+    if(resolved == 0xff) {
+      while(hits != 0) {
+        sel[num_sel++] = i + __builtin_ctz(hits);
+        hits &= hits - 1;
+      }
+      continue;
+    }
+    uint32_t home[8];
+    _mm256_storeu_si256((__m256i*)home, b);
+    for(int j=0; j<8; j++) {
+      if(hits & (1u << j)) {
+        sel[num_sel++] = i + j;
+      } else if(!(resolved & (1u << j))) {
+        // walk the probe sequence past the home bucket
+        for(uint32_t k = (home[j] + 1) & mask; buckets[3*k+1] != empty_slot; k = (k + 1) & mask) {
+          if(buckets[3*k] == keys[i+j]) {
+            if((int)buckets[3*k+2] == level) {
+              sel[num_sel++] = i + j;
+            }
+            break;
+          }
+        }
+      }
+    }
+  }
+  return num_sel;
+}
+#endif
+
+int BackProbeHashJoin::HashTable::filterFlat(const uint32_t* keys, int n, uint32_t* sel) {
+  static_assert(sizeof(Bucket) == 3 * sizeof(uint32_t), "buckets are gathered as three words");
+  Partition* partition = this->partitions[0];
+  int num_sel = 0;
+  int i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if(has_avx2 && !partition->buckets.empty()) {
+    num_sel = filterFlatAvx2(keys, n, sel, (const uint32_t*)partition->buckets.data(), partition->buckets.size() - 1, curr_level, EMPTY_SLOT);
+    i = n - n % 8;
+  }
+#endif
+  for(; i<n; i++) {
+    Bucket* bucket = findBucket(partition, keys[i]);
+    sel[num_sel] = i;
+    num_sel += bucket != nullptr && bucket->level == curr_level;
+  }
+  return num_sel;
+}
+
+bool BackProbeHashJoin::HashTable::seek(uint32_t key, Cursor& cursor) {
+  int p = partitionOf(key);
+  Partition* partition = this->partitions[p];
+  if(this->layout == Flat) {
+    Bucket* bucket = findBucket(partition, key);
+    if(bucket == nullptr || bucket->level != curr_level) {
+      return false;
+    }
+    setCursor(p, curr_level, bucket->slot, cursor);
+    return true;
+  }
+  auto it = partition->table.find(key);
+  if(it == partition->table.end() || it->second->level != curr_level) {
+    return false;
+  }
+  cursor.level = curr_level;
+  cursor.head = it->second;
+  cursor.entry = &it->second->entry;
+  return true;
+}
+
+bool BackProbeHashJoin::HashTable::descend(const Cursor& cursor, Cursor& next_cursor) {
+  if(this->layout == Flat) {
+    if(cursor.level == 0) {
+      return false;
+    }
+    uint32_t slot = this->partitions[cursor.partition]->links[cursor.level][cursor.slot];
+    setCursor(cursor.partition, cursor.level - 1, slot, next_cursor);
+    return true;
+  }
+  EntryHead* head = cursor.head->next;
+  if(head == nullptr) {
+    return false;
+  }
+  next_cursor.level = head->level;
+  next_cursor.head = head;
+  next_cursor.entry = &head->entry;
+  return true;
+}
+
+bool BackProbeHashJoin::HashTable::hasLowerLevel(const Cursor& cursor) {
+  if(this->layout == Flat) {
+    return cursor.level > 0;
+  }
+  return cursor.head->next != nullptr;
+}
+
+bool BackProbeHashJoin::HashTable::nextRow(Cursor& cursor, uint32_t& value) {
+  if(this->layout == Flat) {
+    if(cursor.row == cursor.row_end) {
+      return false;
+    }
+    value = *cursor.row++;
+    return true;
+  }
+  if(cursor.entry == nullptr) {
+    return false;
+  }
+  value = cursor.entry->value;
+  cursor.entry = cursor.entry->next;
+  return true;
+}
+
+uint32_t BackProbeHashJoin::HashTable::numOfRows(const Cursor& cursor) {
+  if(this->layout == Flat) {
+    const std::vector<uint32_t>& offsets = this->partitions[cursor.partition]->offsets[cursor.level];
+    return offsets[cursor.slot + 1] - offsets[cursor.slot];
+  }
+  return cursor.head->entry.count;
+}
+
+void BackProbeHashJoin::HashTable::setCursor(int partition, int level, uint32_t slot, Cursor& cursor) {
+  const std::vector<uint32_t>& offsets = this->partitions[partition]->offsets[level];
+  const std::vector<uint32_t>& rows = this->partitions[partition]->rows[level];
+  cursor.level = level;
+  cursor.partition = partition;
+  cursor.slot = slot;
+  cursor.row = rows.empty() ? rows.data() : rows.data() + offsets[slot];
+  cursor.row_end = rows.empty() ? rows.data() : rows.data() + offsets[slot + 1];
+}
+
+int BackProbeHashJoin::HashTable::partitionOf(uint32_t key) {
+  if(this->partition_bits == 0) {
+    return 0;
+  }
+  return (key * 2654435769u) >> (32 - this->partition_bits);
+}
+
+int BackProbeHashJoin::HashTable::numOfPartitions() {
+  return this->partitions.size();
+}
+
+BackProbeHashJoin::HashTable::Layout BackProbeHashJoin::HashTable::getLayout() {
+  return this->layout;
 }
 
 uint32_t BackProbeHashJoin::HashTable::getKeyResourceId() {
@@ -493,47 +1458,94 @@ int BackProbeHashJoin::HashTable::getLevelValue(int level) {
 }
 
 int BackProbeHashJoin::HashTable::numOfKeys() {
+  int num_keys = 0;
+  for(int p=0; p<this->partitions.size(); p++) {
+    num_keys += this->partitions[p]->num_keys;
+  }
   return num_keys;
 }
 
 bool BackProbeHashJoin::HashTable::getAllKeys(std::vector<uint32_t>& keys) {
-  for(ska::flat_hash_map<uint32_t, EntryHead*>::iterator it = this->table.begin(), end = this->table.end(); it != end; ++it) {
-    if(it->second->level == curr_level) {
-      keys.push_back(it->first);
-    }
+  for(Iterator it = begin(), end = this->end(); it != end; ++it) {
+    keys.push_back(it.key());
+  }
+  return true;
+}
+
+BackProbeHashJoin::HashTable::Iterator::Iterator(HashTable* hash_table, int partition, int end_partition)
+  : hash_table(hash_table), partition(partition), end_partition(end_partition), bucket(0) {
+  if(this->partition < this->end_partition) {
+    this->iter = hash_table->partitions[this->partition]->table.begin();
+    this->end = hash_table->partitions[this->partition]->table.end();
+    seek();
   }
 }
 
-BackProbeHashJoin::HashTable::Iterator::Iterator(ska::flat_hash_map<uint32_t, EntryHead*>::iterator iter, ska::flat_hash_map<uint32_t, EntryHead*>::iterator end, int curr_level)
-  : iter(iter), end(end), curr_level(curr_level) {
-  while(this->iter != end && this->iter->second->level != curr_level) {
-    ++this->iter;
+void BackProbeHashJoin::HashTable::Iterator::seek() {
+  while(true) {
+    if(hash_table->layout == Flat) {
+      std::vector<Bucket>& buckets = hash_table->partitions[partition]->buckets;
+      while(bucket < buckets.size() && (buckets[bucket].slot == EMPTY_SLOT || buckets[bucket].level != hash_table->curr_level)) {
+        ++bucket;
+      }
+      if(bucket < buckets.size() || ++partition == end_partition) {
+        return;
+      }
+      bucket = 0;
+    } else {
+      while(iter != end && iter->second->level != hash_table->curr_level) {
+        ++iter;
+      }
+      if(iter != end || ++partition == end_partition) {
+        return;
+      }
+      iter = hash_table->partitions[partition]->table.begin();
+      end = hash_table->partitions[partition]->table.end();
+    }
   }
 }
 
-BackProbeHashJoin::EntryHead& BackProbeHashJoin::HashTable::Iterator::operator*() {
-  return *iter->second;
+uint32_t BackProbeHashJoin::HashTable::Iterator::key() {
+  if(hash_table->layout == Flat) {
+    return hash_table->partitions[partition]->buckets[bucket].key;
+  }
+  return iter->first;
 }
-BackProbeHashJoin::EntryHead* BackProbeHashJoin::HashTable::Iterator::operator->() {
-  return iter->second;
+
+void BackProbeHashJoin::HashTable::Iterator::cursor(Cursor& cursor) {
+  if(hash_table->layout == Flat) {
+    hash_table->setCursor(partition, hash_table->curr_level, hash_table->partitions[partition]->buckets[bucket].slot, cursor);
+    return;
+  }
+  cursor.level = hash_table->curr_level;
+  cursor.head = iter->second;
+  cursor.entry = &iter->second->entry;
 }
 
 BackProbeHashJoin::HashTable::Iterator& BackProbeHashJoin::HashTable::Iterator::operator++() {
-  ++iter;
-  while(iter != end && iter->second->level != curr_level) {
+  if(hash_table->layout == Flat) {
+    ++bucket;
+  } else {
     ++iter;
   }
+  seek();
   return *this;
 }
 
 bool BackProbeHashJoin::HashTable::Iterator::operator!=(const BackProbeHashJoin::HashTable::Iterator& other) const {
-  return this->iter != other.iter;
+  if(this->partition != other.partition) {
+    return true;
+  }
+  if(this->partition >= this->end_partition) {
+    return false;
+  }
+  return hash_table->layout == Flat ? this->bucket != other.bucket : this->iter != other.iter;
 }
 
 BackProbeHashJoin::HashTable::Iterator BackProbeHashJoin::HashTable::begin() {
-  return Iterator(table.begin(), table.end(), curr_level);
+  return Iterator(this, 0, this->partitions.size());
 }
 
 BackProbeHashJoin::HashTable::Iterator BackProbeHashJoin::HashTable::end() {
-  return Iterator(table.end(), table.end(), curr_level);
+  return Iterator(this, this->partitions.size(), this->partitions.size());
 }
@@ -1,19 +1,24 @@
 #ifndef BACKPROBE_HASH_JOIN_H
 #define BACKPROBE_HASH_JOIN_H
 
+#include <atomic>
 #include <utility>
 #include <vector>
 #include <map>
+#include <ostream>
 #include <unordered_map>
 #include <ska/flat_hash_map.hpp>
 #include "operator.h"
 #include "util/memory_pool.h"
+#include "util/file_directory.h"
 #include "plan/query_plan.h"
+#include "thread/runnable.h"
+#include "thread/thread_pool.h"
 
 
 class BackProbeHashJoin : public Operator {
 public:
-  BackProbeHashJoin(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<JoinNode>& join_nodes, double expected_cardinality);
+  BackProbeHashJoin(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<JoinNode>& join_nodes, double expected_cardinality, bool explain=false);
   ~BackProbeHashJoin();
 
   void open();
@@ -25,6 +30,13 @@ public:
   bool first();
   bool next();
 
+  // Lets results carry a multiplicity instead of being repeated: every
+  // emitted row is followed by its count in count_res.
+  void setCountResource(Resource* count_res);
+  // Stops the enumeration once row_limit rows are emitted, for a LIMIT
+  // above the join.
+  void setRowLimit(uint64_t row_limit);
+
 protected:
   struct Entry {
     uint32_t value;
@@ -38,16 +50,56 @@ protected:
   };
   class HashTable {
   public:
-    HashTable(uint32_t key_res);
+    // Chained keeps per-key linked lists of levels and rows. Flat keeps an
+    // open-addressing directory over contiguous per-level row ranges, which
+    // are filled in two passes (count, then fill) when a level is finished.
+    enum Layout { Chained, Flat };
+    // Approximate filters over the keys of one level, tested by filter()
+    // before the table itself.
+    enum KeyFilterType { NoKeyFilter, XorKeyFilter, FuseKeyFilter };
+
+    // Position in the rows of one key at one level. descend() moves to the
+    // same key one level down, level 0 being the first input of the table.
+    struct Cursor {
+      int level;
+      EntryHead* head;
+      Entry* entry;
+      const uint32_t* row;
+      const uint32_t* row_end;
+      int partition;
+      uint32_t slot;
+    };
+
+    HashTable(uint32_t key_res, int num_partitions = 1, Layout layout = Chained);
+    ~HashTable();
 
     void init(int level_val);
     void insert(uint32_t key);
     void insert(uint32_t key, uint32_t value);
     void append(uint32_t key);
     void append(uint32_t key, uint32_t value);
-    EntryHead* lookup(uint32_t key);
+    void finish(int partition);
     bool exist(uint32_t key);
+    // Writes the positions i < n for which exist(keys[i]) holds into sel
+    // and returns how many there are.
+    int filter(const uint32_t* keys, int n, uint32_t* sel);
+    void buildKeyFilter(KeyFilterType type);
+    void printKeyFilterStats(std::ostream& out);
 
+    bool seek(uint32_t key, Cursor& cursor);
+    bool descend(const Cursor& cursor, Cursor& next_cursor);
+    bool hasLowerLevel(const Cursor& cursor);
+    bool nextRow(Cursor& cursor, uint32_t& value);
+    // Number of rows of the key at the cursor's level; levels built with
+    // insert(key)/append(key) only keep this count.
+    uint32_t numOfRows(const Cursor& cursor);
+
+    // Keys are split into independent partitions so that each partition
+    // can be filled by a different thread without locking.
+    int partitionOf(uint32_t key);
+    int numOfPartitions();
+
+    Layout getLayout();
     uint32_t getKeyResourceId();
     int getLevelValue(int level);
     int numOfKeys();
@@ -55,46 +107,247 @@ protected:
 
     class Iterator {
     public:
-      Iterator(ska::flat_hash_map<uint32_t, EntryHead*>::iterator iter, ska::flat_hash_map<uint32_t, EntryHead*>::iterator end, int curr_level);
-      EntryHead& operator*();
-      EntryHead* operator->();
+      Iterator(HashTable* hash_table, int partition, int end_partition);
+      uint32_t key();
+      void cursor(Cursor& cursor);
       Iterator& operator++();
       bool operator!=(const Iterator& other) const;
 
     private:
+      void seek();
+
+      HashTable* hash_table;
+      int partition;
+      int end_partition;
       ska::flat_hash_map<uint32_t, EntryHead*>::iterator iter;
       ska::flat_hash_map<uint32_t, EntryHead*>::iterator end;
-      int curr_level;
+      uint32_t bucket;
     };
 
     Iterator begin();
     Iterator end();
 
   private:
+    struct Bucket {
+      uint32_t key;
+      uint32_t slot;
+      int level;
+    };
+    struct Partition {
+      // Chained
+      ska::flat_hash_map<uint32_t, EntryHead*> table;
+      MemoryPool<EntryHead> head_pool;
+      MemoryPool<Entry> entry_pool;
+      // Flat: rows of slot s at level l are rows[l][offsets[l][s], offsets[l][s+1]),
+      // and links[l][s] is the slot of the same key at level l-1
+      std::vector<Bucket> buckets;
+      std::vector<std::vector<uint32_t>> offsets;
+      std::vector<std::vector<uint32_t>> rows;
+      std::vector<std::vector<uint32_t>> links;
+      std::vector<uint32_t> pending_keys;
+      std::vector<uint32_t> pending_values;
+
+      int num_keys;
+    };
+
+    struct KeyFilter;
+
+    Bucket* findBucket(Partition* partition, uint32_t key);
+    Bucket* addBucket(Partition* partition, uint32_t key);
+    int filterKeys(const uint32_t* keys, int n, uint32_t* sel);
+    int filterFlat(const uint32_t* keys, int n, uint32_t* sel);
+    void finishLevel(Partition* partition);
+    void setCursor(int partition, int level, uint32_t slot, Cursor& cursor);
+
+    static const uint32_t EMPTY_SLOT;
+
+    Layout layout;
     uint32_t key_res;
-    ska::flat_hash_map<uint32_t, EntryHead*> table;
-    MemoryPool<EntryHead> head_pool;
-    MemoryPool<Entry> entry_pool;
+    std::vector<Partition*> partitions;
+    int partition_bits;
     std::vector<int> level_vals;
-    int num_keys;
     int prev_level;
     int curr_level;
+
+    KeyFilter* key_filter;
+    int key_filter_level;
+    std::atomic<uint64_t> filter_probes;
+    std::atomic<uint64_t> filter_rejects;
+    std::atomic<uint64_t> filter_false_positives;
+  };
+
+  struct BuildContext {
+    int input;
+    HashTable* hash_table;
+    HashTable* filter_hash_table;
+    Resource* filter_res;
+    Resource* key_res;
+    bool append;
+    bool count_only;
+  };
+
+  class PartitionTask : public Runnable {
+  public:
+    PartitionTask(BackProbeHashJoin* join, const BuildContext* context, int thread, int start, int end);
+    void run();
+
+  private:
+    BackProbeHashJoin* join;
+    const BuildContext* context;
+    int thread, start, end;
+  };
+
+  class InsertTask : public Runnable {
+  public:
+    InsertTask(BackProbeHashJoin* join, const BuildContext* context, int thread);
+    void run();
+
+  private:
+    BackProbeHashJoin* join;
+    const BuildContext* context;
+    int thread;
+  };
+
+  // One level of the enumeration: the rows under `cursor` still to be visited.
+  // `k` is the next hash table to look up once the key's levels are exhausted,
+  // and `weight` the product of the row counts of the count-only levels above.
+  struct Frame {
+    HashTable* hash_table;
+    int k;
+    HashTable::Cursor cursor;
+    uint64_t weight;
+  };
+  enum Advance { NextLevel, NoMatch, LastLevel };
+
+  // Resumable state of one enumeration over a range of partitions of the
+  // top-level hash table, with its own binding slots and output columns.
+  struct ProbeContext {
+    ProbeContext(HashTable* hash_table, int start_partition, int end_partition);
+
+    HashTable::Iterator iter;
+    HashTable::Iterator end;
+    bool done;
+    std::vector<Frame> frames;
+    // copies of the current bindings still to be emitted
+    uint64_t pending;
+    std::vector<uint32_t> bindings;
+    std::vector<uint32_t> rows;
+    std::vector<std::vector<uint32_t>*> columns;
+    std::vector<std::vector<uint32_t>> buffers;
+  };
+
+  class ProbeTask : public Runnable {
+  public:
+    ProbeTask(BackProbeHashJoin* join, ProbeContext* context, int max_rows);
+    void run();
+    int numOfRows();
+
+  private:
+    BackProbeHashJoin* join;
+    ProbeContext* context;
+    int max_rows;
+    int num_rows;
+  };
+
+  class FinishTask : public Runnable {
+  public:
+    FinishTask(BackProbeHashJoin* join, HashTable* hash_table, int thread);
+    void run();
+
+  private:
+    BackProbeHashJoin* join;
+    HashTable* hash_table;
+    int thread;
+  };
+
+  class BranchTask : public Runnable {
+  public:
+    BranchTask(BackProbeHashJoin* join, const BuildContext& context);
+    void run();
+
+  private:
+    BackProbeHashJoin* join;
+    BuildContext context;
   };
 
   void build();
-  void probe();
-  void enumerate(HashTable* hash_table, int k, EntryHead* head);
+  void buildBranches(std::vector<HashTable*>& branch_tables);
+  HashTable* createHashTable(uint32_t key_res);
+  void buildHashTable(const BuildContext& context, ThreadPool* pool);
+  void finishHashTable(HashTable* hash_table, ThreadPool* pool);
+  void insertRows(const BuildContext& context, int start, int end);
+  void insertRows(const BuildContext& context, const uint32_t* rows, int num_rows);
+  void insertMorsel(const BuildContext& context, int start, int end);
+  bool pushdownKeys(int i, ResourcePosition pos, HashTable* hash_table, Resource* res, std::ostream& costs);
+  size_t buildMemoryUsage(int last_input);
+  void startSpill(int last_input);
+  void spillInput(int i, bool first);
+  void spillRows(int i);
+  std::string spillFile(int i, int p);
+  int loadSpilledRows(int i, int p);
+  void loadSpilledPartition(int p);
+  void removeSpillFiles();
+  void initProbe();
+  int probe();
+  int probeHashTables();
+  int probeBatchSize();
+  void bind(ProbeContext& context, int i, uint32_t idx);
+  Advance advance(ProbeContext& context, const Frame& frame, Frame& next);
+  int emit(ProbeContext& context, int max_rows);
+  int emitLastLevel(ProbeContext& context, Frame& frame, int max_rows);
+  int enumerate(ProbeContext& context, int max_rows);
+  std::vector<uint32_t>& outputColumn(int s);
+
+  static const int FILTER_BATCH_SIZE;
+  static const int PUSHDOWN_SAMPLE_SIZE;
+  static const int MAX_SPILL_PARTITIONS;
 
   double thld_ratio;
-  int thld_count;
+
+  bool explain;
+  HashTable::Layout layout;
+  HashTable::KeyFilterType key_filter_type;
+  int num_threads;
+  int num_partitions;
+  int morsel_size;
+  ThreadPool* thread_pool;
+  std::vector<std::vector<uint32_t>> morsel_rows;
+
+  // Grace mode: once the build side of a star join outgrows memory_limit,
+  // the rows of every input are hash partitioned on the join key to files
+  // under spill_path, and the partitions are built and probed one at a time.
+  size_t memory_limit;
+  std::string spill_path;
+  bool spillable;
+  int num_spill_partitions;
+  int spill_partition;
+  std::vector<std::vector<BufferedFileWriter*>> spill_writers;
+  std::vector<std::vector<int>> spill_rows;
+
+  int batch_size;
+  uint64_t row_limit;
+  uint64_t num_rows;
+  std::vector<ProbeContext*> probe_contexts;
+  int probe_pos;
 
   std::vector<Operator*> inputs;
   std::vector<std::map<uint32_t, Resource*>> input_resources;
   std::map<uint32_t, Resource*> output_resources;
+  Resource* count_res;
 
-  std::vector<std::vector<std::pair<Resource*, Resource*>>> bind_resources;
+  // output_list[0, output_resources.size()) are emitted, the remaining
+  // slots only hold join keys needed for lookups
+  std::map<uint32_t, int> slots;
+  std::vector<Resource*> output_list;
+  std::vector<std::vector<std::pair<Resource*, int>>> bind_resources;
+  std::vector<int> key_slots;
+  // inputs whose rows bind nothing but the key of their hash table
+  std::vector<bool> count_only;
+  // output_binds[i][s] is the column of input i bound to output slot s, if any
+  std::vector<std::vector<Resource*>> output_binds;
 
   std::vector<JoinNode> join_nodes;
+  std::vector<std::string> strategies;
 
   std::map<uint32_t, HashTable*> hash_table_map;
   std::vector<HashTable*> hash_tables;
@@ -0,0 +1,296 @@
+#include "deduplicate.h"
+#include "database/config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+
+const int Deduplicate::MAX_SPILL_PARTITIONS = 128;
+const int Deduplicate::CACHE_SIZE = 1 << 16;
+
+Deduplicate::Deduplicate(Operator* input, const std::map<uint32_t, Resource*>& resources, Strategy strategy, uint32_t order_key, double expected_cardinality, Resource* count_res)
+  : Operator(expected_cardinality), input(input), resources(resources), strategy(strategy), order_key(order_key), count_res(count_res), done(false), width(0), row_set(nullptr),
+    order_pos(0), has_group(false), group_key(0), memory_limit(0), frozen(false), num_spill_partitions(0), spill_partition(0) {
+  Config config;
+  if(strategy == Hash && config.getIntParam(ConfigKey::JOIN_MEMORY_LIMIT) > 0) {
+    this->memory_limit = (size_t)config.getIntParam(ConfigKey::JOIN_MEMORY_LIMIT) << 20;
+    this->spill_path = config.getParam(ConfigKey::SPILL_PATH);
+  }
+}
+
+Deduplicate::~Deduplicate() {
+  delete this->row_set;
+  for(int p=0; p<this->spill_writers.size(); p++) {
+    delete this->spill_writers[p];
+  }
+}
+
+void Deduplicate::open() {
+  this->input->open();
+  for(std::map<uint32_t, Resource*>::iterator iter = resources.begin(), end = resources.end(); iter != end; ++iter) {
+    if(iter->first == this->order_key) {
+      this->order_pos = this->columns.size();
+    }
+    this->columns.push_back(&iter->second->column);
+  }
+  this->width = this->columns.size();
+  if(this->strategy == Cache) {
+    this->cache_rows.resize((size_t)CACHE_SIZE * this->width);
+    this->cache_used.resize(CACHE_SIZE, false);
+  } else {
+    this->row_set = new RowSet(this->width);
+  }
+}
+
+void Deduplicate::close() {
+  this->input->close();
+  removeSpillFiles();
+}
+
+bool Deduplicate::first() {
+  return produce(true);
+}
+
+bool Deduplicate::next() {
+  return produce(false);
+}
+
+bool Deduplicate::produce(bool first) {
+  if(this->columns.empty()) {
+    return first ? this->input->first() : this->input->next();
+  }
+  // Batches of the input are deduplicated until one of them keeps a row.
+  while(!this->done) {
+    size_t start = numOfRows();
+    this->done = first ? !this->input->first() : !this->input->next();
+    first = false;
+    if(select(start) > 0) {
+      return true;
+    }
+  }
+  if(!this->spill_writers.empty()) {
+    for(int p=0; p<this->spill_writers.size(); p++) {
+      this->spill_writers[p]->close();
+      delete this->spill_writers[p];
+    }
+    this->spill_writers.clear();
+    // none of the rows in the set is in a partition
+    delete this->row_set;
+    this->row_set = new RowSet(this->width);
+  }
+  while(this->spill_partition < this->num_spill_partitions) {
+    if(loadSpilledPartition(this->spill_partition++) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Deduplicate::numOfRows() {
+  return this->columns[0]->size();
+}
+
+size_t Deduplicate::select(size_t start) {
+  size_t end = numOfRows();
+  size_t out = start;
+  std::vector<uint32_t> row(this->width);
+  for(size_t r=start; r<end; r++) {
+    for(int c=0; c<this->width; c++) {
+      row[c] = (*this->columns[c])[r];
+    }
+    uint64_t hash = hashRow(row.data(), this->width);
+    bool keep = false;
+    switch(this->strategy) {
+      case Hash:
+        if(!this->frozen) {
+          keep = this->row_set->insert(row.data(), hash);
+          if(keep && this->memory_limit > 0 && this->row_set->memoryUsage() > this->memory_limit) {
+            startSpill();
+          }
+        } else if(!this->row_set->contains(row.data(), hash)) {
+          spillRow(row.data(), hash);
+        }
+        break;
+      case Sorted:
+        // repeats of a row are adjacent to the other rows of its group
+        if(!this->has_group || row[this->order_pos] != this->group_key) {
+          this->row_set->clear();
+          this->group_key = row[this->order_pos];
+          this->has_group = true;
+        }
+        keep = this->row_set->insert(row.data(), hash);
+        break;
+      case Cache: {
+        size_t slot = hash & (CACHE_SIZE - 1);
+        uint32_t* cached = this->cache_rows.data() + slot * this->width;
+        keep = !this->cache_used[slot] || std::memcmp(cached, row.data(), this->width * sizeof(uint32_t)) != 0;
+        if(keep) {
+          std::copy(row.begin(), row.end(), cached);
+          this->cache_used[slot] = true;
+        }
+        break;
+      }
+    }
+    if(keep) {
+      for(int c=0; c<this->width; c++) {
+        (*this->columns[c])[out] = row[c];
+      }
+      ++out;
+    }
+  }
+  for(int c=0; c<this->width; c++) {
+    this->columns[c]->resize(out);
+  }
+  if(this->count_res != nullptr) {
+    this->count_res->column.clear();
+  }
+  return out - start;
+}
+
+uint64_t Deduplicate::hashRow(const uint32_t* row, int width) {
+  uint64_t hash = 0x9e3779b97f4a7c15ULL;
+  for(int c=0; c<width; c++) {
+    hash = (hash ^ row[c]) * 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 32;
+  }
+  return hash;
+}
+
+void Deduplicate::startSpill() {
+  // Enough partitions for the expected rows to fit the budget twice over.
+  double usage = std::max(this->expected_cardinality * this->width * sizeof(uint32_t) * 2, (double)this->row_set->memoryUsage());
+  this->num_spill_partitions = 2;
+  while(this->num_spill_partitions < MAX_SPILL_PARTITIONS && this->num_spill_partitions * (double)this->memory_limit < 2 * usage) {
+    this->num_spill_partitions <<= 1;
+  }
+  this->spill_rows.resize(this->num_spill_partitions, 0);
+  for(int p=0; p<this->num_spill_partitions; p++) {
+    std::string file = spillFile(p);
+    File::remove(file);
+    this->spill_writers.push_back(new BufferedFileWriter(file));
+  }
+  this->frozen = true;
+}
+
+void Deduplicate::spillRow(const uint32_t* row, uint64_t hash) {
+  // high bits of the hash, the low ones pick the slots of the set
+  int p = ((hash >> 32) * this->num_spill_partitions) >> 32;
+  this->spill_writers[p]->append((const char*)row, this->width * sizeof(uint32_t));
+  ++this->spill_rows[p];
+}
+
+std::string Deduplicate::spillFile(int p) {
+  std::stringstream ss;
+  ss << this->spill_path << "/distinct_" << getpid() << "_" << (void*)this << "_" << p << ".spill";
+  return ss.str();
+}
+
+size_t Deduplicate::loadSpilledPartition(int p) {
+  size_t num_rows = this->spill_rows[p];
+  size_t start = numOfRows();
+  std::string file = spillFile(p);
+  if(num_rows > 0) {
+    this->row_set->clear();
+    MmapFileReader reader(file);
+    const uint32_t* data = (const uint32_t*)reader.begin();
+    for(size_t r=0; r<num_rows; r++) {
+      const uint32_t* row = data + r * this->width;
+      if(this->row_set->insert(row, hashRow(row, this->width))) {
+        for(int c=0; c<this->width; c++) {
+          this->columns[c]->push_back(row[c]);
+        }
+      }
+    }
+    reader.close();
+  }
+  File::remove(file);
+  return numOfRows() - start;
+}
+
+void Deduplicate::removeSpillFiles() {
+  for(int p=0; p<this->spill_writers.size(); p++) {
+    this->spill_writers[p]->close();
+    delete this->spill_writers[p];
+  }
+  this->spill_writers.clear();
+  for(int p=this->spill_partition; p<this->num_spill_partitions; p++) {
+    std::string file = spillFile(p);
+    if(File::exist(file)) {
+      File::remove(file);
+    }
+  }
+  this->spill_partition = this->num_spill_partitions;
+}
+
+
+
+
+Deduplicate::RowSet::RowSet(int width) : width(width), num_rows(0), slots(16, 0) {}
+
+bool Deduplicate::RowSet::insert(const uint32_t* row, uint64_t hash) {
+  size_t slot = find(row, hash);
+  if(this->slots[slot] != 0) {
+    return false;
+  }
+  this->rows.insert(this->rows.end(), row, row + this->width);
+  ++this->num_rows;
+  this->slots[slot] = (hash & 0xffffffff00000000ULL) | this->num_rows;
+  if(this->num_rows * 2 > this->slots.size()) {
+    grow();
+  }
+  return true;
+}
+
+bool Deduplicate::RowSet::contains(const uint32_t* row, uint64_t hash) {
+  return this->slots[find(row, hash)] != 0;
+}
+
+void Deduplicate::RowSet::clear() {
+  // a large group leaves a large table, which is not swept for every small one
+  if(this->slots.size() > 16 && this->num_rows * 8 < this->slots.size()) {
+    std::vector<uint64_t>(16, 0).swap(this->slots);
+  } else {
+    std::fill(this->slots.begin(), this->slots.end(), 0);
+  }
+  this->rows.clear();
+  this->num_rows = 0;
+}
+
+size_t Deduplicate::RowSet::memoryUsage() {
+  return this->rows.capacity() * sizeof(uint32_t) + this->slots.size() * sizeof(uint64_t);
+}
+
+size_t Deduplicate::RowSet::find(const uint32_t* row, uint64_t hash) {
+  size_t mask = this->slots.size() - 1;
+  uint64_t tag = hash & 0xffffffff00000000ULL;
+  size_t slot = hash & mask;
+  while(this->slots[slot] != 0) {
+    uint64_t entry = this->slots[slot];
+    if((entry & 0xffffffff00000000ULL) == tag) {
+      const uint32_t* other = this->rows.data() + ((entry & 0xffffffff) - 1) * this->width;
+      if(std::memcmp(other, row, this->width * sizeof(uint32_t)) == 0) {
+        return slot;
+      }
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void Deduplicate::RowSet::grow() {
+  std::vector<uint64_t> old_slots(this->slots.size() * 2, 0);
+  old_slots.swap(this->slots);
+  size_t mask = this->slots.size() - 1;
+  for(size_t i=0; i<old_slots.size(); i++) {
+    if(old_slots[i] == 0) {
+      continue;
+    }
+    const uint32_t* row = this->rows.data() + ((old_slots[i] & 0xffffffff) - 1) * this->width;
+    size_t slot = Deduplicate::hashRow(row, this->width) & mask;
+    while(this->slots[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    this->slots[slot] = old_slots[i];
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef DEDUPLICATE_H
+#define DEDUPLICATE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "operator.h"
+#include "util/file_directory.h"
+
+
+// Removes repeated rows for DISTINCT and REDUCED. A row is the ids of all
+// its columns, and the columns of the input are compacted in place, so the
+// operator shares its resources with the input.
+//  - Hash keeps the distinct rows in a hash set. Past the memory limit the
+//    set stops growing, and the rows it does not hold are spilled to hash
+//    partitions that are deduplicated one by one once the input is drained.
+//  - Sorted needs the input sorted on one of the columns, and only keeps
+//    the rows of the current value of that column.
+//  - Cache drops the repeats found in a fixed number of recent rows, which
+//    is all REDUCED asks for.
+// An input that reports repeated rows once with their count in count_res
+// saves the repeats altogether; the counts are dropped.
+class Deduplicate : public Operator {
+public:
+  enum Strategy { Hash, Sorted, Cache };
+
+  Deduplicate(Operator* input, const std::map<uint32_t, Resource*>& resources, Strategy strategy, uint32_t order_key, double expected_cardinality, Resource* count_res=nullptr);
+  ~Deduplicate();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  // Open addressing set over rows of a fixed width.
+  class RowSet {
+  public:
+    RowSet(int width);
+
+    // Adds the row unless it is present, and tells whether it was added.
+    bool insert(const uint32_t* row, uint64_t hash);
+    bool contains(const uint32_t* row, uint64_t hash);
+    void clear();
+    size_t memoryUsage();
+
+  private:
+    // slot holding the row, or the empty slot it would take
+    size_t find(const uint32_t* row, uint64_t hash);
+    void grow();
+
+    int width;
+    size_t num_rows;
+    std::vector<uint32_t> rows;
+    // the high half of the row's hash, and its index plus one; 0 when empty
+    std::vector<uint64_t> slots;
+  };
+
+  bool produce(bool first);
+  size_t numOfRows();
+  // Keeps the rows from start on that are not repeats.
+  size_t select(size_t start);
+  static uint64_t hashRow(const uint32_t* row, int width);
+
+  void startSpill();
+  void spillRow(const uint32_t* row, uint64_t hash);
+  std::string spillFile(int p);
+  size_t loadSpilledPartition(int p);
+  void removeSpillFiles();
+
+  static const int MAX_SPILL_PARTITIONS;
+  static const int CACHE_SIZE;
+
+  Operator* input;
+  std::map<uint32_t, Resource*> resources;
+  Strategy strategy;
+  uint32_t order_key;
+  Resource* count_res;
+  bool done;
+
+  std::vector<std::vector<uint32_t>*> columns;
+  int width;
+  RowSet* row_set;
+
+  // Sorted: position of the order key in a row, and its current value
+  int order_pos;
+  bool has_group;
+  uint32_t group_key;
+
+  // Cache: CACHE_SIZE rows, a row is only compared with its slot
+  std::vector<uint32_t> cache_rows;
+  std::vector<bool> cache_used;
+
+  size_t memory_limit;
+  std::string spill_path;
+  bool frozen;
+  int num_spill_partitions;
+  int spill_partition;
+  std::vector<BufferedFileWriter*> spill_writers;
+  std::vector<size_t> spill_rows;
+};
+
+
+#endif
@@ -1,12 +1,28 @@
 #include "filter.h"
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 
-Filter::Filter(Operator* input, Resource* value, Resource* filter, double expected_cardinality)
-  : Operator(expected_cardinality), input(input), value(value), filter(filter) {}
+const uint32_t Filter::NO_ID = UINT32_MAX;
+const int Filter::FILTER_BATCH_SIZE = 1024;
+const size_t Filter::MAX_CACHED_TERMS = 1 << 20;
+
+static const std::string XSD_NAMESPACE = "http://www.w3.org/2001/XMLSchema#";
+
+Filter::Filter(Operator* input, const std::map<uint32_t, Resource*>& resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<const QueryExpression*>& expressions, Dictionary& dict, double expected_cardinality)
+  : Operator(expected_cardinality), input(input), resources(resources), output_resources(output_resources), expressions(expressions), dict(dict), done(false) {}
 
 Filter::~Filter() {}
 
 void Filter::open() {
   this->input->open();
+  for(std::map<uint32_t, Resource*>::iterator iter = resources.begin(), end = resources.end(); iter != end; ++iter) {
+    this->positions[iter->first] = this->columns.size();
+    this->columns.push_back(&iter->second->column);
+    this->outputs.push_back(this->output_resources.count(iter->first) != 0);
+  }
+  this->starts.resize(this->columns.size());
 }
 
 void Filter::close() {
@@ -14,19 +30,633 @@ void Filter::close() {
 }
 
 bool Filter::first() {
-  if(!filter->column.empty()) {
-    for(int i=0; i<filter->column.size(); i++) {
-      this->valid.insert(filter->column[i]);
+  return produce(true);
+}
+
+bool Filter::next() {
+  return produce(false);
+}
+
+bool Filter::produce(bool first) {
+  if(this->expressions.empty() || this->columns.empty()) {
+    return first ? this->input->first() : this->input->next();
+  }
+  // Batches of the input are filtered until one of them keeps a row.
+  while(!this->done) {
+    for(int c=0; c<this->columns.size(); c++) {
+      this->starts[c] = this->columns[c]->size();
+    }
+    this->done = first ? !this->input->first() : !this->input->next();
+    first = false;
+    if(select() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Filter::select() {
+  size_t end = this->columns[0]->size() - this->starts[0];
+  size_t out = 0;
+  std::vector<uint32_t> rows;
+  std::vector<Value> values;
+  for(size_t b=0; b<end; b+=FILTER_BATCH_SIZE) {
+    int n = end - b < FILTER_BATCH_SIZE ? end - b : FILTER_BATCH_SIZE;
+    rows.resize(n);
+    for(int i=0; i<n; i++) {
+      rows[i] = b + i;
+    }
+    // every expression only sees the rows kept by the previous ones
+    for(int e=0; e<this->expressions.size() && n>0; e++) {
+      evaluate(this->expressions[e], rows.data(), n, values);
+      int m = 0;
+      for(int i=0; i<n; i++) {
+        bool result;
+        if(effectiveBoolean(values[i], result) && result) {
+          rows[m++] = rows[i];
+        }
+      }
+      n = m;
+    }
+    for(int c=0; c<this->columns.size(); c++) {
+      uint32_t* column = this->columns[c]->data() + this->starts[c];
+      for(int i=0; i<n; i++) {
+        column[out+i] = column[rows[i]];
+      }
+    }
+    out += n;
+  }
+  for(int c=0; c<this->columns.size(); c++) {
+    this->columns[c]->resize(this->outputs[c] ? this->starts[c] + out : 0);
+  }
+
+  // no value of the batch refers to a cached term any more
+  if(this->terms.size() > MAX_CACHED_TERMS) {
+    this->terms.clear();
+    this->regex_results.clear();
+  }
+  return out;
+}
+
+void Filter::evaluate(const QueryExpression* exp, const uint32_t* rows, int n, std::vector<Value>& values) {
+  values.resize(n);
+  Value error;
+  error.kind = Value::Error;
+  switch(exp->type) {
+    case QueryExpression::Variable: {
+      std::unordered_map<uint32_t, int>::iterator iter = this->positions.find(exp->id);
+      if(iter == this->positions.end()) {
+        std::fill(values.begin(), values.end(), error);
+        break;
+      }
+      const uint32_t* column = this->columns[iter->second]->data() + this->starts[iter->second];
+      for(int i=0; i<n; i++) {
+        if(column[rows[i]] == UNBOUND_ID) {
+          values[i] = error;
+          continue;
+        }
+        values[i].kind = Value::RDFTerm;
+        values[i].id = column[rows[i]];
+        values[i].term = nullptr;
+      }
+      break;
+    }
+    case QueryExpression::Literal:
+    case QueryExpression::IRI: {
+      Value value;
+      value.kind = Value::RDFTerm;
+      value.id = exp->id;
+      value.term = constant(exp);
+      std::fill(values.begin(), values.end(), value);
+      break;
+    }
+    case QueryExpression::Or:
+    case QueryExpression::And:
+    case QueryExpression::Not:
+      evaluateLogical(exp, rows, n, values);
+      break;
+    case QueryExpression::Equal:
+    case QueryExpression::NotEqual:
+    case QueryExpression::Less:
+    case QueryExpression::LessOrEqual:
+    case QueryExpression::Greater:
+    case QueryExpression::GreaterOrEqual:
+    case QueryExpression::Plus:
+    case QueryExpression::Minus:
+    case QueryExpression::Mul:
+    case QueryExpression::Div:
+    case QueryExpression::Builtin_sameterm:
+    case QueryExpression::Builtin_langmatches: {
+      std::vector<Value> right;
+      evaluate(exp->arg_list[0], rows, n, values);
+      evaluate(exp->arg_list[1], rows, n, right);
+      for(int i=0; i<n; i++) {
+        if(exp->type >= QueryExpression::Plus && exp->type <= QueryExpression::Div) {
+          values[i] = arithmetic(exp->type, values[i], right[i]);
+        } else {
+          values[i] = compare(exp->type, values[i], right[i]);
+        }
+      }
+      break;
+    }
+    case QueryExpression::UnaryPlus:
+    case QueryExpression::UnaryMinus:
+      evaluate(exp->arg_list[0], rows, n, values);
+      for(int i=0; i<n; i++) {
+        double number;
+        if(numberOf(values[i], number)) {
+          values[i].kind = Value::Numeric;
+          values[i].number = exp->type == QueryExpression::UnaryMinus ? -number : number;
+        } else {
+          values[i] = error;
+        }
+      }
+      break;
+    case QueryExpression::Builtin_bound: {
+      std::unordered_map<uint32_t, int>::iterator iter = this->positions.find(exp->arg_list[0]->id);
+      const uint32_t* column = iter == this->positions.end() ? nullptr : this->columns[iter->second]->data() + this->starts[iter->second];
+      for(int i=0; i<n; i++) {
+        values[i].kind = Value::Boolean;
+        values[i].boolean = column != nullptr && column[rows[i]] != UNBOUND_ID;
+      }
+      break;
+    }
+    case QueryExpression::Builtin_str:
+    case QueryExpression::Builtin_lang:
+    case QueryExpression::Builtin_datatype:
+    case QueryExpression::Builtin_isiri:
+    case QueryExpression::Builtin_isuri:
+    case QueryExpression::Builtin_isblank:
+    case QueryExpression::Builtin_isliteral:
+      evaluate(exp->arg_list[0], rows, n, values);
+      for(int i=0; i<n; i++) {
+        values[i] = builtin(exp->type, values[i]);
+      }
+      break;
+    case QueryExpression::Builtin_regex:
+      evaluateRegex(exp, rows, n, values);
+      break;
+    default:
+      // functions and casts are not supported
+      std::fill(values.begin(), values.end(), error);
+      break;
+  }
+}
+
+void Filter::evaluateLogical(const QueryExpression* exp, const uint32_t* rows, int n, std::vector<Value>& values) {
+  evaluate(exp->arg_list[0], rows, n, values);
+  // 1 true, 0 false, -1 error
+  std::vector<int> left(n);
+  for(int i=0; i<n; i++) {
+    bool result;
+    left[i] = effectiveBoolean(values[i], result) ? result : -1;
+  }
+
+  std::vector<int> right(n, -1);
+  if(exp->type != QueryExpression::Not) {
+    // the right operand is only evaluated on the rows the left one leaves open
+    int decided = exp->type == QueryExpression::And ? 0 : 1;
+    std::vector<uint32_t> sub_rows;
+    std::vector<int> positions;
+    for(int i=0; i<n; i++) {
+      if(left[i] != decided) {
+        sub_rows.push_back(rows[i]);
+        positions.push_back(i);
+      }
+    }
+    std::vector<Value> sub_values;
+    evaluate(exp->arg_list[1], sub_rows.data(), sub_rows.size(), sub_values);
+    for(int j=0; j<positions.size(); j++) {
+      bool result;
+      right[positions[j]] = effectiveBoolean(sub_values[j], result) ? result : -1;
+    }
+  }
+
+  for(int i=0; i<n; i++) {
+    int result;
+    if(exp->type == QueryExpression::Not) {
+      result = left[i] < 0 ? -1 : !left[i];
+    } else if(exp->type == QueryExpression::And) {
+      result = (left[i] == 0 || right[i] == 0) ? 0 : (left[i] == 1 && right[i] == 1 ? 1 : -1);
+    } else {
+      result = (left[i] == 1 || right[i] == 1) ? 1 : (left[i] == 0 && right[i] == 0 ? 0 : -1);
+    }
+    values[i].kind = result < 0 ? Value::Error : Value::Boolean;
+    values[i].boolean = result == 1;
+  }
+}
+
+void Filter::evaluateRegex(const QueryExpression* exp, const uint32_t* rows, int n, std::vector<Value>& values) {
+  std::unordered_map<const QueryExpression*, std::regex>::iterator iter = this->regexes.find(exp);
+  if(iter == this->regexes.end()) {
+    std::regex::flag_type flags = std::regex::ECMAScript | std::regex::optimize;
+    if(exp->arg_list.size() > 2 && constant(exp->arg_list[2])->lexical.find('i') != std::string::npos) {
+      flags |= std::regex::icase;
+    }
+    try {
+      iter = this->regexes.emplace(exp, std::regex(constant(exp->arg_list[1])->lexical, flags)).first;
+    } catch(const std::regex_error& e) {
+      Value error;
+      error.kind = Value::Error;
+      values.assign(n, error);
+      return;
+    }
+  }
+
+  evaluate(exp->arg_list[0], rows, n, values);
+  // ids repeat a lot, so every id is only matched once
+  std::unordered_map<uint32_t, bool>& results = this->regex_results[exp];
+  for(int i=0; i<n; i++) {
+    Value& value = values[i];
+    if(value.kind == Value::RDFTerm && value.id != NO_ID) {
+      std::unordered_map<uint32_t, bool>::iterator result = results.find(value.id);
+      if(result != results.end()) {
+        value.kind = Value::Boolean;
+        value.boolean = result->second;
+        continue;
+      }
+    }
+    const std::string* str = stringOf(value);
+    if(str == nullptr) {
+      value.kind = Value::Error;
+      continue;
+    }
+    bool match = std::regex_search(*str, iter->second);
+    if(value.kind == Value::RDFTerm && value.id != NO_ID) {
+      results[value.id] = match;
+    }
+    value.kind = Value::Boolean;
+    value.boolean = match;
+  }
+}
+
+Filter::Value Filter::compare(QueryExpression::Type type, Value& left, Value& right) {
+  Value value;
+  value.kind = Value::Error;
+  if(left.kind == Value::Error || right.kind == Value::Error) {
+    return value;
+  }
+
+  switch(type) {
+    case QueryExpression::Equal:
+      return equal(left, right);
+    case QueryExpression::NotEqual:
+      value = equal(left, right);
+      value.boolean = !value.boolean;
+      return value;
+    case QueryExpression::Builtin_sameterm: {
+      if(left.kind != Value::RDFTerm || right.kind != Value::RDFTerm) {
+        return value;
+      }
+      value.kind = Value::Boolean;
+      if(left.id != NO_ID && right.id != NO_ID) {
+        value.boolean = left.id == right.id;
+      } else {
+        const Term* a = termOf(left);
+        const Term* b = termOf(right);
+        value.boolean = a->kind == b->kind && a->lexical == b->lexical && a->lang == b->lang && a->datatype == b->datatype;
+      }
+      return value;
+    }
+    case QueryExpression::Builtin_langmatches: {
+      const std::string* tag = stringOf(left);
+      const std::string* range = stringOf(right);
+      if(tag == nullptr || range == nullptr) {
+        return value;
+      }
+      value.kind = Value::Boolean;
+      if(*range == "*") {
+        value.boolean = !tag->empty();
+      } else {
+        value.boolean = tag->size() >= range->size() && (tag->size() == range->size() || (*tag)[range->size()] == '-')
+          && std::equal(range->begin(), range->end(), tag->begin(), [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+      }
+      return value;
+    }
+    default:
+      break;
+  }
+
+  int order;
+  double x, y;
+  const std::string *a, *b;
+  if(numberOf(left, x) && numberOf(right, y)) {
+    if(std::isnan(x) || std::isnan(y)) {
+      value.kind = Value::Boolean;
+      value.boolean = false;
+      return value;
+    }
+    order = x < y ? -1 : (x > y ? 1 : 0);
+  } else if((a = stringOf(left)) != nullptr && (b = stringOf(right)) != nullptr) {
+    order = a->compare(*b);
+  } else if(left.kind == Value::Boolean && right.kind == Value::Boolean) {
+    order = (int)left.boolean - (int)right.boolean;
+  } else {
+    return value;
+  }
+  value.kind = Value::Boolean;
+  switch(type) {
+    case QueryExpression::Less:
+      value.boolean = order < 0;
+      break;
+    case QueryExpression::LessOrEqual:
+      value.boolean = order <= 0;
+      break;
+    case QueryExpression::Greater:
+      value.boolean = order > 0;
+      break;
+    default:
+      value.boolean = order >= 0;
+      break;
+  }
+  return value;
+}
+
+Filter::Value Filter::equal(Value& left, Value& right) {
+  Value value;
+  value.kind = Value::Boolean;
+  if(left.kind == Value::RDFTerm && right.kind == Value::RDFTerm) {
+    // the dictionary holds every term once
+    if(left.id != NO_ID && left.id == right.id) {
+      value.boolean = true;
+      return value;
+    }
+    // and a term that is not a number only equals itself, which spares
+    // decoding the other side
+    bool both_ids = left.id != NO_ID && right.id != NO_ID;
+    if(both_ids && ((left.term != nullptr && !left.term->numeric) || (right.term != nullptr && !right.term->numeric))) {
+      value.boolean = false;
+      return value;
     }
+    const Term* a = termOf(left);
+    const Term* b = termOf(right);
+    if(a->numeric && b->numeric) {
+      value.boolean = a->number == b->number;
+    } else {
+      value.boolean = !both_ids && a->kind == b->kind && a->lexical == b->lexical && a->lang == b->lang && a->datatype == b->datatype;
+    }
+    return value;
+  }
+
+  double x, y;
+  const std::string *a, *b;
+  if(numberOf(left, x) && numberOf(right, y)) {
+    value.boolean = x == y;
+  } else if((a = stringOf(left)) != nullptr && (b = stringOf(right)) != nullptr) {
+    value.boolean = *a == *b;
+  } else if(left.kind == Value::Boolean && right.kind == Value::Boolean) {
+    value.boolean = left.boolean == right.boolean;
   } else {
-    this->valid.insert(filter->id);
+    value.boolean = false;
+  }
+  return value;
+}
+
+Filter::Value Filter::arithmetic(QueryExpression::Type type, Value& left, Value& right) {
+  Value value;
+  value.kind = Value::Error;
+  double x, y;
+  if(!numberOf(left, x) || !numberOf(right, y)) {
+    return value;
   }
-  if(!this->input->first()) {
+  value.kind = Value::Numeric;
+  switch(type) {
+    case QueryExpression::Plus:
+      value.number = x + y;
+      break;
+    case QueryExpression::Minus:
+      value.number = x - y;
+      break;
+    case QueryExpression::Mul:
+      value.number = x * y;
+      break;
+    default:
+      if(y == 0) {
+        value.kind = Value::Error;
+      }
+      value.number = x / y;
+      break;
+  }
+  return value;
+}
+
+Filter::Value Filter::builtin(QueryExpression::Type type, Value& arg) {
+  Value value;
+  value.kind = Value::Error;
+  if(arg.kind == Value::Error) {
+    return value;
+  }
+  const Term* term = arg.kind == Value::RDFTerm ? termOf(arg) : nullptr;
+  switch(type) {
+    case QueryExpression::Builtin_str:
+      if(arg.kind == Value::String) {
+        return arg;
+      }
+      if(term != nullptr && term->kind != Term::Blank) {
+        value.kind = Value::String;
+        value.str = &term->lexical;
+      }
+      break;
+    case QueryExpression::Builtin_lang:
+      if(term != nullptr && term->kind == Term::Literal) {
+        value.kind = Value::String;
+        value.str = &term->lang;
+      } else if(arg.kind == Value::String) {
+        value.kind = Value::String;
+        value.str = &this->empty_string;
+      }
+      break;
+    case QueryExpression::Builtin_datatype:
+      if(term != nullptr && term->kind == Term::Literal && term->lang.empty()) {
+        value.kind = Value::RDFTerm;
+        value.id = NO_ID;
+        value.term = iriTerm(term->datatype.empty() ? XSD_NAMESPACE + "string" : term->datatype);
+      }
+      break;
+    case QueryExpression::Builtin_isiri:
+    case QueryExpression::Builtin_isuri:
+      value.kind = Value::Boolean;
+      value.boolean = term != nullptr && term->kind == Term::IRI;
+      break;
+    case QueryExpression::Builtin_isblank:
+      value.kind = Value::Boolean;
+      value.boolean = term != nullptr && term->kind == Term::Blank;
+      break;
+    case QueryExpression::Builtin_isliteral:
+      value.kind = Value::Boolean;
+      value.boolean = term == nullptr || term->kind == Term::Literal;
+      break;
+    default:
+      break;
+  }
+  return value;
+}
+
+bool Filter::effectiveBoolean(Value& value, bool& result) {
+  switch(value.kind) {
+    case Value::Boolean:
+      result = value.boolean;
+      return true;
+    case Value::Numeric:
+      result = value.number != 0 && !std::isnan(value.number);
+      return true;
+    case Value::String:
+      result = !value.str->empty();
+      return true;
+    case Value::RDFTerm: {
+      const Term* term = termOf(value);
+      if(term->kind != Term::Literal) {
+        return false;
+      }
+      if(term->numeric) {
+        result = term->number != 0 && !std::isnan(term->number);
+      } else if(term->datatype == XSD_NAMESPACE + "boolean") {
+        result = term->lexical == "true" || term->lexical == "1";
+      } else {
+        result = !term->lexical.empty();
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+const Filter::Term* Filter::decode(uint32_t id) {
+  std::unordered_map<uint32_t, Term>::iterator iter = this->terms.find(id);
+  if(iter != this->terms.end()) {
+    return &iter->second;
+  }
+  std::string str;
+  this->dict.lookupById(id, &str);
+  Term& term = this->terms[id];
+  parseTerm(str, term);
+  return &term;
+}
+
+const Filter::Term* Filter::termOf(Value& value) {
+  if(value.term == nullptr) {
+    value.term = decode(value.id);
+  }
+  return value.term;
+}
+
+bool Filter::numberOf(Value& value, double& number) {
+  if(value.kind == Value::Numeric) {
+    number = value.number;
+    return true;
+  }
+  if(value.kind != Value::RDFTerm) {
     return false;
   }
-  return true;
+  const Term* term = termOf(value);
+  number = term->number;
+  return term->numeric;
 }
 
-bool Filter::next() {
-  return true;
+const std::string* Filter::stringOf(Value& value) {
+  if(value.kind == Value::String) {
+    return value.str;
+  }
+  if(value.kind != Value::RDFTerm) {
+    return nullptr;
+  }
+  const Term* term = termOf(value);
+  if(term->kind != Term::Literal || term->numeric) {
+    return nullptr;
+  }
+  return &term->lexical;
+}
+
+const Filter::Term* Filter::constant(const QueryExpression* exp) {
+  std::unordered_map<const QueryExpression*, Term>::iterator iter = this->constants.find(exp);
+  if(iter != this->constants.end()) {
+    return &iter->second;
+  }
+  Term& term = this->constants[exp];
+  parseTerm(exp->value, term);
+  return &term;
+}
+
+const Filter::Term* Filter::iriTerm(const std::string& iri) {
+  std::unordered_map<std::string, Term>::iterator iter = this->iris.find(iri);
+  if(iter != this->iris.end()) {
+    return &iter->second;
+  }
+  Term& term = this->iris[iri];
+  term.kind = Term::IRI;
+  term.lexical = iri;
+  term.numeric = false;
+  term.number = 0;
+  return &term;
+}
+
+void Filter::parseTerm(const std::string& str, Term& term) {
+  // terms are stored as <iri>, _:blank, "lexical"@lang or "lexical"^^<datatype>
+  term.numeric = false;
+  term.number = 0;
+  if(str.size() >= 2 && str[0] == '<') {
+    term.kind = Term::IRI;
+    term.lexical = str.substr(1, str.size() - 2);
+    return;
+  }
+  if(str.compare(0, 2, "_:") == 0) {
+    term.kind = Term::Blank;
+    term.lexical = str;
+    return;
+  }
+  term.kind = Term::Literal;
+  size_t end = str.rfind('"');
+  if(str.empty() || str[0] != '"' || end == 0) {
+    term.lexical = str;
+    return;
+  }
+  term.lexical = str.substr(1, end - 1);
+  if(end + 1 < str.size() && str[end+1] == '@') {
+    term.lang = str.substr(end + 2);
+  } else if(str.compare(end + 1, 3, "^^<") == 0) {
+    term.datatype = str.substr(end + 4, str.size() - end - 5);
+  }
+
+  static const char* numeric_types[] = {
+    "integer", "decimal", "float", "double", "int", "long", "short", "byte",
+    "nonNegativeInteger", "positiveInteger", "nonPositiveInteger", "negativeInteger",
+    "unsignedLong", "unsignedInt", "unsignedShort", "unsignedByte"
+  };
+  if(term.datatype.compare(0, XSD_NAMESPACE.size(), XSD_NAMESPACE) != 0 || term.lexical.empty()) {
+    return;
+  }
+  std::string type = term.datatype.substr(XSD_NAMESPACE.size());
+  for(int i=0; i<sizeof(numeric_types)/sizeof(numeric_types[0]); i++) {
+    if(type == numeric_types[i]) {
+      char* end_ptr;
+      term.number = std::strtod(term.lexical.c_str(), &end_ptr);
+      term.numeric = *end_ptr == '\0';
+      break;
+    }
+  }
+}
+
+int Filter::compareTerms(const Term& a, const Term& b) {
+  // Blank nodes come before IRIs before literals. Numbers compare by value
+  // and come before the other literals, so that the order stays transitive;
+  // other terms compare by their lexical forms.
+  static const int ranks[] = { 1, 2, 0 };
+  if(a.kind != b.kind) {
+    return ranks[a.kind] < ranks[b.kind] ? -1 : 1;
+  }
+  if(a.numeric != b.numeric) {
+    return a.numeric ? -1 : 1;
+  }
+  if(a.numeric && a.number != b.number) {
+    return a.number < b.number ? -1 : 1;
+  }
+  int result = a.lexical.compare(b.lexical);
+  if(result == 0) {
+    result = a.datatype.compare(b.datatype);
+  }
+  if(result == 0) {
+    result = a.lang.compare(b.lang);
+  }
+  return result;
 }
@@ -1,12 +1,25 @@
 #ifndef FILTER_H
 #define FILTER_H
 
-#include <unordered_set>
+#include <string>
+#include <vector>
+#include <map>
+#include <regex>
+#include <unordered_map>
 #include "operator.h"
+#include "query/query_graph.h"
+#include "storage/dictionary.h"
 
+// Evaluates SPARQL FILTER expressions over the batches of its input. The
+// rows of a batch are narrowed with selection vectors, and the columns of
+// the input are compacted in place, so the filter shares its resources with
+// the input. Columns only read by the expressions are not part of the
+// output and are cleared once a batch is filtered. Ids are only decoded
+// through the dictionary when an expression needs the term itself, and
+// decoded terms are cached with their type.
 class Filter : public Operator {
 public:
-  Filter(Operator* input, Resource* value, Resource* filter, double expected_cardinality);
+  Filter(Operator* input, const std::map<uint32_t, Resource*>& resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<const QueryExpression*>& expressions, Dictionary& dict, double expected_cardinality);
   ~Filter();
 
   void open();
@@ -15,11 +28,79 @@ public:
   bool first();
   bool next();
 
+  struct Term {
+    enum Kind { IRI, Literal, Blank };
+    Kind kind;
+    // IRI without brackets, or the lexical form of a literal
+    std::string lexical;
+    std::string lang;
+    std::string datatype;
+    bool numeric;
+    double number;
+  };
+
+  // Parses a term as the dictionary stores it.
+  static void parseTerm(const std::string& str, Term& term);
+  // Orders terms as ORDER BY does: negative if a comes before b.
+  static int compareTerms(const Term& a, const Term& b);
+
 protected:
+  struct Value {
+    enum Kind { Error, Boolean, Numeric, String, RDFTerm };
+    Kind kind;
+    bool boolean;
+    double number;
+    // RDFTerm: dictionary id, or NO_ID for terms missing from the dictionary
+    uint32_t id;
+    // RDFTerm: decoded on demand
+    const Term* term;
+    // String: the plain string, e.g. the result of str() or lang()
+    const std::string* str;
+  };
+
+  bool produce(bool first);
+  // Keeps the rows of the batch that satisfy every expression.
+  size_t select();
+  // values[i] is the value of exp on row rows[i] of the batch.
+  void evaluate(const QueryExpression* exp, const uint32_t* rows, int n, std::vector<Value>& values);
+  void evaluateLogical(const QueryExpression* exp, const uint32_t* rows, int n, std::vector<Value>& values);
+  void evaluateRegex(const QueryExpression* exp, const uint32_t* rows, int n, std::vector<Value>& values);
+  Value compare(QueryExpression::Type type, Value& left, Value& right);
+  Value equal(Value& left, Value& right);
+  Value arithmetic(QueryExpression::Type type, Value& left, Value& right);
+  Value builtin(QueryExpression::Type type, Value& arg);
+  bool effectiveBoolean(Value& value, bool& result);
+
+  const Term* decode(uint32_t id);
+  const Term* termOf(Value& value);
+  bool numberOf(Value& value, double& number);
+  const std::string* stringOf(Value& value);
+  const Term* constant(const QueryExpression* exp);
+  const Term* iriTerm(const std::string& iri);
+
+  static const uint32_t NO_ID;
+  static const int FILTER_BATCH_SIZE;
+  static const size_t MAX_CACHED_TERMS;
+
   Operator* input;
-  Resource *value, *filter;
+  std::map<uint32_t, Resource*> resources;
+  std::map<uint32_t, Resource*> output_resources;
+  std::vector<const QueryExpression*> expressions;
+  Dictionary& dict;
+  bool done;
 
-  std::unordered_set<uint32_t> valid;
+  // the batch starts at starts[c] of columns[c], since the consumer only
+  // clears the output columns
+  std::vector<std::vector<uint32_t>*> columns;
+  std::vector<size_t> starts;
+  std::vector<bool> outputs;
+  std::unordered_map<uint32_t, int> positions;
+  std::unordered_map<uint32_t, Term> terms;
+  std::unordered_map<const QueryExpression*, Term> constants;
+  std::unordered_map<std::string, Term> iris;
+  std::unordered_map<const QueryExpression*, std::regex> regexes;
+  std::unordered_map<const QueryExpression*, std::unordered_map<uint32_t, bool>> regex_results;
+  std::string empty_string;
 };
 
 
@@ -1,99 +1,472 @@
 #include "hash_join.h"
+#include "database/config.h"
+#include "thread/thread.h"
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-HashJoin::HashJoin(Operator* left, const std::vector<Resource*>& left_resources, Operator* right, const std::vector<Resource*>& right_resources, double expected_cardinality)
-  : Operator(expected_cardinality), left(left), left_resources(left_resources), right(right), right_resources(right_resources) {
+const int HashJoin::PROBE_BATCH_SIZE = 256;
+const size_t HashJoin::MAX_INITIAL_SIZE = 1 << 20;
+
+HashJoin::HashJoin(Operator* left, const std::map<uint32_t, Resource*>& left_resources, Operator* right, const std::map<uint32_t, Resource*>& right_resources, const std::map<uint32_t, Resource*>& output_resources, uint32_t join_key, double expected_cardinality, bool optional)
+  : Operator(expected_cardinality), left(left), right(right), left_resources(left_resources), right_resources(right_resources), output_resources(output_resources), join_key(join_key), optional(optional),
+    left_key(nullptr), right_key(nullptr), right_scan(nullptr), right_key_ids(nullptr), num_threads(1), thread_pool(nullptr), right_done(false), hash_table(nullptr) {
+  Config config;
+  if(config.getIntParam(ConfigKey::NUM_THREADS) > 1) {
+    this->num_threads = config.getIntParam(ConfigKey::NUM_THREADS);
+  }
+}
+
+HashJoin::~HashJoin() {
+  delete this->hash_table;
+  delete this->thread_pool;
 }
 
 void HashJoin::open() {
   left->open();
   right->open();
-  /*
-  HashTableBuilder builder(*this);
-  Thread thread(&builder);
-  thread->start();
-  */
+
+  if(this->join_key == UINT32_MAX) {
+    this->left_key = this->left_resources.begin()->second;
+    this->right_key = this->right_resources.begin()->second;
+  } else {
+    this->left_key = this->left_resources[this->join_key];
+    this->right_key = this->right_resources[this->join_key];
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    this->output_list.push_back(iter->second);
+    this->left_binds.push_back(this->left_resources.count(iter->first) ? this->left_resources[iter->first] : nullptr);
+    this->right_binds.push_back(this->right_resources.count(iter->first) ? this->right_resources[iter->first] : nullptr);
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = left_resources.begin(), end = left_resources.end(); iter != end; ++iter) {
+    if(iter->first != this->join_key && this->right_resources.count(iter->first)) {
+      this->checks.push_back(std::make_pair(iter->second, this->right_resources[iter->first]));
+    }
+  }
+  this->right_bind_ids.resize(this->right_binds.size());
+  this->check_ids.resize(this->checks.size());
+
+  // every column of a scan read in batches must be one of its views
+  this->right_scan = dynamic_cast<TableScan*>(this->right);
+  if(this->right_scan != nullptr && !this->right_scan->canScanBatches()) {
+    this->right_scan = nullptr;
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = right_resources.begin(), end = right_resources.end(); iter != end && this->right_scan != nullptr; ++iter) {
+    if(this->right_scan->getColumnView(iter->second, this->right_batch) == nullptr) {
+      this->right_scan = nullptr;
+    }
+  }
+  this->right_batch.size = 0;
+
+  size_t size = this->left->getExpectedCardinality() < MAX_INITIAL_SIZE ? this->left->getExpectedCardinality() : MAX_INITIAL_SIZE;
+  this->hash_table = new HashTable(size);
+  if(this->num_threads > 1) {
+    this->thread_pool = new ThreadPool(this->num_threads);
+  }
 }
 
 void HashJoin::close() {
+  if(this->right_scan != nullptr) {
+    this->right_scan->release(this->right_batch);
+  }
   left->close();
   right->close();
+  delete this->thread_pool;
+  this->thread_pool = nullptr;
 }
 
 
 bool HashJoin::first() {
+  // the left input is built while the right one fetches its first rows
+  HashTableBuilder builder(*this);
+  Thread thread(&builder, false);
+  if(thread.start()) {
+    this->right_done = !fetchRight(true);
+    thread.join();
+  } else {
+    build();
+    this->right_done = !fetchRight(true);
+  }
+
+  produce();
   return true;
 }
 
 bool HashJoin::next() {
-  return true;
+  return produce() > 0;
 }
 
+void HashJoin::build() {
+  if(!this->left->first()) {
+    return;
+  }
+  // without key, all rows are chained under key 0
+  bool keyed = this->join_key != UINT32_MAX;
+  std::vector<uint32_t>& keys = this->left_key->column;
+  int j = 0;
+  do {
+    for(; j<keys.size(); j++) {
+      this->hash_table->insert(keyed ? keys[j] : 0, j);
+    }
+  } while(this->left->next());
+  for(; j<keys.size(); j++) {
+    this->hash_table->insert(keyed ? keys[j] : 0, j);
+  }
+}
 
+int HashJoin::produce() {
+  // Batches of the right input are probed until one of them has matches.
+  int num_rows = 0;
+  while(num_rows == 0) {
+    if(numOfRightRows() == 0) {
+      if(this->right_done) {
+        break;
+      }
+      this->right_done = !fetchRight(false);
+      continue;
+    }
+    num_rows = probe();
+    if(this->right_scan != nullptr) {
+      // the pages stay pinned until the next batch is fetched
+      this->right_batch.size = 0;
+    } else {
+      for(std::map<uint32_t, Resource*>::iterator iter = right_resources.begin(), end = right_resources.end(); iter != end; ++iter) {
+        iter->second->column.clear();
+      }
+    }
+  }
+  return num_rows;
+}
 
+bool HashJoin::fetchRight(bool first) {
+  if(this->right_scan != nullptr) {
+    return first ? this->right_scan->firstBatch(this->right_batch) : this->right_scan->nextBatch(this->right_batch);
+  }
+  return first ? this->right->first() : this->right->next();
+}
 
-HashJoin::HashTable::HashTable() : table_size(1024), max_loop(512), num_keys(0) {
-  table.resize(table_size*2);
+size_t HashJoin::numOfRightRows() {
+  return this->right_scan != nullptr ? this->right_batch.size : this->right_key->column.size();
 }
 
-HashJoin::HashTable::HashTable(size_t size) {
-  table_size = 2;
-  while(table_size < size) {
-    table_size <<= 1;
+void HashJoin::bindRight() {
+  this->right_key_ids = getRightIds(this->right_key);
+  for(int s=0; s<this->right_binds.size(); s++) {
+    this->right_bind_ids[s] = getRightIds(this->right_binds[s]);
+  }
+  for(int c=0; c<this->checks.size(); c++) {
+    this->check_ids[c] = getRightIds(this->checks[c].second);
   }
-  max_loop = table_size >> 1;
-  table.resize(table_size*2);
 }
 
-size_t hash1 (uint32_t key, size_t table_size) {
-  return key & (table_size-1);
+const uint32_t* HashJoin::getRightIds(Resource* resource) {
+  if(resource == nullptr) {
+    return nullptr;
+  }
+  if(this->right_scan == nullptr) {
+    return resource->column.data();
+  }
+  const TripleTable::ColumnView* view = this->right_scan->getColumnView(resource, this->right_batch);
+  if(view->ids != nullptr) {
+    return view->ids;
+  }
+  std::vector<uint32_t>& ids = this->right_constants[resource];
+  ids.assign(this->right_batch.size, view->constant);
+  return ids.data();
+}
+
+int HashJoin::probe() {
+  int n = numOfRightRows();
+  bindRight();
+  std::vector<std::vector<uint32_t>*> columns;
+  for(int s=0; s<this->output_list.size(); s++) {
+    columns.push_back(&this->output_list[s]->column);
+  }
+  size_t num_rows = columns.empty() ? 0 : columns[0]->size();
+
+  if(this->thread_pool == nullptr || n < PROBE_BATCH_SIZE * this->num_threads) {
+    probeRows(0, n, columns);
+    return columns.empty() ? 0 : columns[0]->size() - num_rows;
+  }
+
+  // Every thread probes a slice of the batch into private columns, which
+  // are appended to the output in slice order.
+  std::vector<ProbeTask*> tasks;
+  int step = (n + this->num_threads - 1) / this->num_threads;
+  for(int t=0; t<this->num_threads; t++) {
+    int start = t * step < n ? t * step : n;
+    int end = start + step < n ? start + step : n;
+    tasks.push_back(new ProbeTask(*this, start, end));
+    this->thread_pool->execute(tasks.back());
+  }
+  this->thread_pool->wait();
+  int total = 0;
+  for(int t=0; t<tasks.size(); t++) {
+    for(int s=0; s<columns.size(); s++) {
+      columns[s]->insert(columns[s]->end(), tasks[t]->buffers[s].begin(), tasks[t]->buffers[s].end());
+    }
+    total += tasks[t]->numOfRows();
+    delete tasks[t];
+  }
+  return total;
 }
 
-size_t hash2 (uint32_t key, size_t table_size) {
-  return (key << 32) & (table_size-1);
+void HashJoin::probeRows(int start, int end, std::vector<std::vector<uint32_t>*>& columns) {
+  if(this->optional) {
+    probeOptionalRows(start, end, columns);
+    return;
+  }
+  Entry* entries[PROBE_BATCH_SIZE];
+  const uint32_t* keys = this->right_key_ids;
+  for(int j=start; j<end; j+=PROBE_BATCH_SIZE) {
+    int n = end - j < PROBE_BATCH_SIZE ? end - j : PROBE_BATCH_SIZE;
+    lookup(keys + j, n, entries);
+    for(int r=0; r<n; r++) {
+      for(Entry* entry = entries[r]; entry != nullptr; entry = this->hash_table->next(entry)) {
+        bool match = true;
+        for(int c=0; c<this->checks.size() && match; c++) {
+          match = this->checks[c].first->column[entry->row] == this->check_ids[c][j+r];
+        }
+        if(!match) {
+          continue;
+        }
+        for(int s=0; s<columns.size(); s++) {
+          if(this->left_binds[s] != nullptr) {
+            columns[s]->push_back(this->left_binds[s]->column[entry->row]);
+          } else {
+            columns[s]->push_back(this->right_bind_ids[s][j+r]);
+          }
+        }
+      }
+    }
+  }
 }
 
-void HashJoin::HashTable::insert(const std::vector<Resource*>& resources) {
-  Entry* entry = pool.alloc();
-  entry->key = resources[0]->id;
-  for(int i=0, j=1; j<resources.size(); i++, j++) {
-    entry->values[i] = resources[j]->id;
+void HashJoin::lookup(const uint32_t* keys, int n, Entry** entries) {
+  if(this->join_key != UINT32_MAX) {
+    this->hash_table->lookup(keys, n, entries);
+    return;
+  }
+  Entry* entry = this->hash_table->lookup(0);
+  for(int r=0; r<n; r++) {
+    entries[r] = entry;
   }
-  entry->next = nullptr;
+}
 
-  Entry* prev = lookup(entry->key);
-  if(prev) {
-    entry->next = prev->next;
-    prev->next = entry;
-  } else {
-    ++num_keys;
-    insert(entry);
+void HashJoin::probeOptionalRows(int start, int end, std::vector<std::vector<uint32_t>*>& columns) {
+  Entry* entries[PROBE_BATCH_SIZE];
+  const uint32_t* keys = this->right_key_ids;
+  for(int j=start; j<end; j+=PROBE_BATCH_SIZE) {
+    int n = end - j < PROBE_BATCH_SIZE ? end - j : PROBE_BATCH_SIZE;
+    lookup(keys + j, n, entries);
+    for(int r=0; r<n; r++) {
+      bool matched = false;
+      for(Entry* entry = entries[r]; entry != nullptr; entry = this->hash_table->next(entry)) {
+        bool match = true;
+        for(int c=0; c<this->checks.size() && match; c++) {
+          uint32_t left_value = this->checks[c].first->column[entry->row];
+          uint32_t right_value = this->check_ids[c][j+r];
+          match = left_value == right_value || left_value == UNBOUND_ID || right_value == UNBOUND_ID;
+        }
+        if(!match) {
+          continue;
+        }
+        matched = true;
+        for(int s=0; s<columns.size(); s++) {
+          uint32_t value = this->left_binds[s] != nullptr ? this->left_binds[s]->column[entry->row] : UNBOUND_ID;
+          if(value == UNBOUND_ID && this->right_binds[s] != nullptr) {
+            value = this->right_bind_ids[s][j+r];
+          }
+          columns[s]->push_back(value);
+        }
+      }
+      if(!matched) {
+        for(int s=0; s<columns.size(); s++) {
+          columns[s]->push_back(this->right_binds[s] != nullptr ? this->right_bind_ids[s][j+r] : UNBOUND_ID);
+        }
+      }
+    }
   }
 }
 
+
+
+
+const uint32_t HashJoin::HashTable::EMPTY_KEY = UINT32_MAX;
+const uint32_t HashJoin::HashTable::NO_ENTRY = UINT32_MAX;
+const uint32_t HashJoin::HashTable::SEED = 0x9747b28c;
+const int HashJoin::HashTable::LOOKUP_BATCH_SIZE = 64;
+
+HashJoin::HashTable::HashTable() : HashTable(1024) {}
+
+HashJoin::HashTable::HashTable(size_t size) : max_loop(128), num_keys(0), kick(0), empty_key_head(NO_ENTRY) {
+  // three quarters full at the expected size
+  num_buckets = 2;
+  while(num_buckets * BUCKET_SIZE * 3 < size * 4) {
+    num_buckets <<= 1;
+  }
+  clear(num_buckets);
+  entries.reserve(size);
+}
+
+void HashJoin::HashTable::clear(size_t num_buckets) {
+  Bucket empty;
+  std::fill(empty.keys, empty.keys + BUCKET_SIZE, EMPTY_KEY);
+  std::fill(empty.heads, empty.heads + BUCKET_SIZE, NO_ENTRY);
+  this->buckets.assign(num_buckets, empty);
+}
+
+void HashJoin::HashTable::hash(uint32_t key, size_t& b1, size_t& b2) {
+  // MurmurHash3's 64-bit finalizer; its two halves serve as independent hashes
+  uint64_t h = key ^ SEED;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  b1 = (uint32_t)h & (num_buckets-1);
+  b2 = (h >> 32) & (num_buckets-1);
+  if(b2 == b1) {
+    b2 ^= 1;
+  }
+}
+
+int HashJoin::HashTable::find(size_t bucket, uint32_t key) {
+  const uint32_t* keys = this->buckets[bucket].keys;
+  for(int i=0; i<BUCKET_SIZE; i++) {
+    if(keys[i] == key) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool HashJoin::HashTable::place(size_t bucket, uint32_t key, uint32_t head) {
+  int i = find(bucket, EMPTY_KEY);
+  if(i < 0) {
+    return false;
+  }
+  this->buckets[bucket].keys[i] = key;
+  this->buckets[bucket].heads[i] = head;
+  return true;
+}
+
+void HashJoin::HashTable::insert(uint32_t key, uint32_t row) {
+  Entry entry;
+  entry.key = key;
+  entry.row = row;
+  uint32_t idx = this->entries.size();
+
+  if(key == EMPTY_KEY) {
+    num_keys += empty_key_head == NO_ENTRY;
+    entry.next = empty_key_head;
+    empty_key_head = idx;
+    this->entries.push_back(entry);
+    return;
+  }
+  size_t b1, b2;
+  hash(key, b1, b2);
+  int i = find(b1, key);
+  size_t b = b1;
+  if(i < 0) {
+    i = find(b2, key);
+    b = b2;
+  }
+  if(i >= 0) {
+    entry.next = this->buckets[b].heads[i];
+    this->buckets[b].heads[i] = idx;
+    this->entries.push_back(entry);
+    return;
+  }
+  ++num_keys;
+  entry.next = NO_ENTRY;
+  this->entries.push_back(entry);
+  displace(key, idx);
+}
+
 HashJoin::Entry* HashJoin::HashTable::lookup(uint32_t key) {
-  Entry* entry;
-  entry = this->table[hash1(key, table_size)];
-  if(entry && entry->key == key) {
-    return entry;
+  if(key == EMPTY_KEY) {
+    return empty_key_head == NO_ENTRY ? nullptr : &this->entries[empty_key_head];
   }
-  entry = this->table[table_size + hash2(key, table_size)];
-  if(entry && entry->key == key) {
-    return entry;
+  size_t b1, b2;
+  hash(key, b1, b2);
+  int i = find(b1, key);
+  if(i >= 0) {
+    return &this->entries[this->buckets[b1].heads[i]];
+  }
+  i = find(b2, key);
+  if(i >= 0) {
+    return &this->entries[this->buckets[b2].heads[i]];
   }
   return nullptr;
 }
 
-bool HashJoin::HashTable::exist(uint32_t key) {
-  Entry* entry;
-  entry = this->table[hash1(key, table_size)];
-  if(entry && entry->key == key) {
-    return true;
+void HashJoin::HashTable::lookup(const uint32_t* keys, int n, Entry** entries) {
+  // Both candidate buckets of every key are fetched before any is compared,
+  // so the cache misses of a batch overlap.
+  uint32_t first[LOOKUP_BATCH_SIZE];
+  uint32_t second[LOOKUP_BATCH_SIZE];
+  int slots[LOOKUP_BATCH_SIZE];
+  for(int j=0; j<n; j+=LOOKUP_BATCH_SIZE) {
+    int m = n - j < LOOKUP_BATCH_SIZE ? n - j : LOOKUP_BATCH_SIZE;
+    for(int i=0; i<m; i++) {
+      size_t b1, b2;
+      hash(keys[j+i], b1, b2);
+      first[i] = b1;
+      second[i] = b2;
+      __builtin_prefetch(&this->buckets[b1]);
+      __builtin_prefetch(&this->buckets[b2]);
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if(has_avx2) {
+      matchBucketsAvx2(keys + j, m, this->buckets.data(), first, second, slots);
+    } else
+#endif
+    for(int i=0; i<m; i++) {
+      int k = find(first[i], keys[j+i]);
+      if(k >= 0) {
+        slots[i] = first[i] * BUCKET_SIZE + k;
+        continue;
+      }
+      k = find(second[i], keys[j+i]);
+      slots[i] = k >= 0 ? second[i] * BUCKET_SIZE + k : -1;
+    }
+    for(int i=0; i<m; i++) {
+      uint32_t head = slots[i] < 0 ? NO_ENTRY : this->buckets[slots[i] / BUCKET_SIZE].heads[slots[i] % BUCKET_SIZE];
+      entries[j+i] = head == NO_ENTRY ? nullptr : &this->entries[head];
+    }
   }
-  entry = this->table[table_size + hash2(key, table_size)];
-  if(entry && entry->key == key) {
-    return true;
+  for(int i=0; i<n; i++) {
+    if(keys[i] == EMPTY_KEY) {
+      entries[i] = lookup(EMPTY_KEY);
+    }
   }
-  return false;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void HashJoin::HashTable::matchBucketsAvx2(const uint32_t* keys, int n, const Bucket* buckets, const uint32_t* first, const uint32_t* second, int* slots) {
+  for(int i=0; i<n; i++) {
+    __m256i key = _mm256_set1_epi32(keys[i]);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key, _mm256_load_si256((const __m256i*)buckets[first[i]].keys))));
+    if(mask != 0) {
+      slots[i] = first[i] * BUCKET_SIZE + __builtin_ctz(mask);
+      continue;
+    }
+    mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key, _mm256_load_si256((const __m256i*)buckets[second[i]].keys))));
+    slots[i] = mask != 0 ? second[i] * BUCKET_SIZE + __builtin_ctz(mask) : -1;
+  }
+}
+#endif
+
+HashJoin::Entry* HashJoin::HashTable::next(const Entry* entry) {
+  return entry->next == NO_ENTRY ? nullptr : &this->entries[entry->next];
+}
+
+bool HashJoin::HashTable::exist(uint32_t key) {
+  return lookup(key) != nullptr;
 }
 
 int HashJoin::HashTable::numOfKeys() {
@@ -101,37 +474,46 @@ int HashJoin::HashTable::numOfKeys() {
 }
 
 bool HashJoin::HashTable::getAllKeys(std::vector<uint32_t>& keys) {
-  for(int i=0; i<this->table.size(); i++) {
-    Entry* entry = this->table[i];
-    if(entry) {
-      keys.push_back(entry->key);
+  for(int b=0; b<this->buckets.size(); b++) {
+    for(int i=0; i<BUCKET_SIZE; i++) {
+      if(this->buckets[b].heads[i] != NO_ENTRY) {
+        keys.push_back(this->buckets[b].keys[i]);
+      }
     }
   }
+  if(empty_key_head != NO_ENTRY) {
+    keys.push_back(EMPTY_KEY);
+  }
+  return true;
 }
 
-void HashJoin::HashTable::insert(Entry* entry) {
+void HashJoin::HashTable::displace(uint32_t key, uint32_t head) {
   for(int i = 0; i < max_loop; ++i) {
-    std::swap(entry, table[hash1(entry->key, table_size)]);
-    if(!entry) {
-      return;
-    }
-    std::swap(entry, table[table_size + hash2(entry->key, table_size)]);
-    if(!entry) {
+    size_t b1, b2;
+    hash(key, b1, b2);
+    if(place(b1, key, head) || place(b2, key, head)) {
       return;
     }
+    // both buckets are full: evict a key, which moves to its other bucket next
+    Bucket& bucket = this->buckets[(i & 1) ? b2 : b1];
+    int victim = kick++ % BUCKET_SIZE;
+    std::swap(key, bucket.keys[victim]);
+    std::swap(head, bucket.heads[victim]);
   }
   rehash();
-  insert(entry);
+  displace(key, head);
 }
 
 void HashJoin::HashTable::rehash() {
-  table_size *= 2;
-  std::vector<Entry*> old_table;
-  old_table.resize(table_size*2);
-  swap(table, old_table);
-  for (typename std::vector<Entry*>::const_iterator iter=old_table.begin(), end=old_table.end(); iter!=end; ++iter) {
-    if (*iter) {
-      insert(*iter);
+  num_buckets *= 2;
+  std::vector<Bucket> old_buckets;
+  swap(buckets, old_buckets);
+  clear(num_buckets);
+  for (typename std::vector<Bucket>::const_iterator iter=old_buckets.begin(), end=old_buckets.end(); iter!=end; ++iter) {
+    for(int i=0; i<BUCKET_SIZE; i++) {
+      if(iter->heads[i] != NO_ENTRY) {
+        displace(iter->keys[i], iter->heads[i]);
+      }
     }
   }
 }
@@ -142,4 +524,20 @@ void HashJoin::HashTable::rehash() {
 HashJoin::HashTableBuilder::HashTableBuilder(HashJoin& join) : join(join) {}
 
 void HashJoin::HashTableBuilder::run() {
+  join.build();
+}
+
+HashJoin::ProbeTask::ProbeTask(HashJoin& join, int start, int end)
+  : join(join), start(start), end(end), buffers(join.output_list.size()) {
+  for(int s=0; s<buffers.size(); s++) {
+    columns.push_back(&buffers[s]);
+  }
+}
+
+void HashJoin::ProbeTask::run() {
+  join.probeRows(start, end, columns);
+}
+
+int HashJoin::ProbeTask::numOfRows() {
+  return buffers.empty() ? 0 : buffers[0].size();
 }
@@ -2,14 +2,27 @@
 #define HASH_JOIN_H
 
 #include <vector>
+#include <map>
 #include "operator.h"
-#include "util/memory_pool.h"
+#include "table_scan.h"
 #include "thread/runnable.h"
+#include "thread/thread_pool.h"
 
 
+// Binary hash join on a single key. The left input is built into a cuckoo
+// hash table by a worker thread while the right input produces its first
+// rows, then every batch of the right input is probed as it arrives.
+// An optional join is the left join of OPTIONAL with the right input as the
+// required side: right rows matching no left row are kept, with the
+// variables only the left input binds set to UNBOUND_ID, and an unbound
+// value is compatible with any other. A join_key of UINT32_MAX joins
+// without key: every right row is checked against every left row, which
+// also joins on variables either side may leave unbound.
+// A right input that is a table scan is probed in batches of column views,
+// so its rows are never copied into the columns of its resources.
 class HashJoin : public Operator {
 public:
-  HashJoin(Operator* left, const std::vector<Resource*>& left_resources, Operator* right, const std::vector<Resource*>& right_resources, double expected_cardinality);
+  HashJoin(Operator* left, const std::map<uint32_t, Resource*>& left_resources, Operator* right, const std::map<uint32_t, Resource*>& right_resources, const std::map<uint32_t, Resource*>& output_resources, uint32_t join_key, double expected_cardinality, bool optional=false);
   ~HashJoin();
 
   void open();
@@ -20,31 +33,65 @@ public:
 
 protected:
   struct Entry {
-    Entry* next;
     uint32_t key;
-    uint32_t values[];
-    Entry(uint32_t key) : next(nullptr), key(key) {}
+    uint32_t row;
+    // index of the next row of the same key
+    uint32_t next;
   };
+  // Bucketized cuckoo hash table: every key lives in one of two buckets
+  // chosen by independent hashes, and the 8 keys of a bucket are compared
+  // with one SIMD instruction.
   class HashTable {
   public:
     HashTable();
     HashTable(size_t size);
 
-    void insert(const std::vector<Resource*>& resources);
+    void insert(uint32_t key, uint32_t row);
+    // Entries stay valid until the next insert.
     Entry* lookup(uint32_t key);
+    // Looks up n keys at once, entries[i] being the rows of keys[i] or nullptr.
+    void lookup(const uint32_t* keys, int n, Entry** entries);
+    Entry* next(const Entry* entry);
     bool exist(uint32_t key);
 
     int numOfKeys();
     bool getAllKeys(std::vector<uint32_t>& keys);
+
+    static const int BUCKET_SIZE = 8;
+
   private:
-    void insert(Entry* entry);
+    // One cache line: the keys fill the first 32 bytes, heads[i] is the
+    // first entry of keys[i].
+    struct alignas(64) Bucket {
+      uint32_t keys[BUCKET_SIZE];
+      uint32_t heads[BUCKET_SIZE];
+    };
+
+    void clear(size_t num_buckets);
+    void hash(uint32_t key, size_t& b1, size_t& b2);
+    int find(size_t bucket, uint32_t key);
+    bool place(size_t bucket, uint32_t key, uint32_t head);
+    // cuckoo insertion of a new key whose rows start at head
+    void displace(uint32_t key, uint32_t head);
     void rehash();
+    // matches keys[i] against its two buckets with one 256-bit compare each
+    static void matchBucketsAvx2(const uint32_t* keys, int n, const Bucket* buckets, const uint32_t* first, const uint32_t* second, int* slots);
 
-    MemoryPool<Entry> pool;
-    std::vector<Entry*> table;
-    size_t table_size;
+    static const uint32_t EMPTY_KEY;
+    static const uint32_t NO_ENTRY;
+    static const uint32_t SEED;
+    static const int LOOKUP_BATCH_SIZE;
+
+    std::vector<Bucket> buckets;
+    std::vector<Entry> entries;
+    size_t num_buckets;
     int max_loop;
     int num_keys;
+    int kick;
+    // first entry of the key equal to EMPTY_KEY
+    uint32_t empty_key_head;
+
+    friend class HashJoinTableTest;
   };
   class HashTableBuilder : public Runnable {
   public:
@@ -55,10 +102,68 @@ protected:
   };
   friend class HashTableBuilder;
 
+  class ProbeTask : public Runnable {
+  public:
+    ProbeTask(HashJoin& join, int start, int end);
+    void run();
+    int numOfRows();
+
+  private:
+    friend class HashJoin;
+
+    HashJoin& join;
+    int start, end;
+    std::vector<std::vector<uint32_t>> buffers;
+    std::vector<std::vector<uint32_t>*> columns;
+  };
+  friend class ProbeTask;
+
+  void build();
+  int produce();
+  int probe();
+  void probeRows(int start, int end, std::vector<std::vector<uint32_t>*>& columns);
+  void probeOptionalRows(int start, int end, std::vector<std::vector<uint32_t>*>& columns);
+  // entries[i] is the first left row matching keys[i], or nullptr
+  void lookup(const uint32_t* keys, int n, Entry** entries);
+  bool fetchRight(bool first);
+  size_t numOfRightRows();
+  // points the ids of the right side at its current rows
+  void bindRight();
+  const uint32_t* getRightIds(Resource* resource);
+
+  static const int PROBE_BATCH_SIZE;
+  static const size_t MAX_INITIAL_SIZE;
+
   Operator *left, *right;
-  std::vector<Resource*> left_resources, right_resources;
+  std::map<uint32_t, Resource*> left_resources, right_resources, output_resources;
+  uint32_t join_key;
+  bool optional;
+  // without key, the first column of each input only counts its rows
+  Resource *left_key, *right_key;
+
+  // output_list[s] is copied from left_binds[s] if set, from right_binds[s] otherwise
+  std::vector<Resource*> output_list;
+  std::vector<Resource*> left_binds, right_binds;
+  // other variables of both inputs, whose values must agree
+  std::vector<std::pair<Resource*, Resource*>> checks;
+
+  // set when the right input is read in batches
+  TableScan* right_scan;
+  TripleTable::Batch right_batch;
+  // a constant column of the batch, repeated for every row
+  std::map<Resource*, std::vector<uint32_t>> right_constants;
+  // ids of the current right rows for right_key, right_binds and checks
+  const uint32_t* right_key_ids;
+  std::vector<const uint32_t*> right_bind_ids;
+  std::vector<const uint32_t*> check_ids;
+
+  int num_threads;
+  ThreadPool* thread_pool;
+  bool right_done;
+
+  HashTable* hash_table;
 
-  HashTable hash_table;
+  friend class HashJoinTableTest;
 };
 
 
@@ -0,0 +1,256 @@
+#include "leapfrog_triejoin.h"
+#include <algorithm>
+
+const int LeapfrogTriejoin::BATCH_SIZE = 4096;
+
+LeapfrogTriejoin::LeapfrogTriejoin(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<uint32_t>& variable_order, double expected_cardinality)
+  : Operator(expected_cardinality), inputs(inputs), input_resources(input_resources), output_resources(output_resources), variable_order(variable_order), depth(-1) {}
+
+LeapfrogTriejoin::~LeapfrogTriejoin() {
+  for(int i=0; i<this->iterators.size(); i++) {
+    delete this->iterators[i];
+  }
+  for(int i=0; i<this->tries.size(); i++) {
+    delete this->tries[i];
+  }
+}
+
+void LeapfrogTriejoin::open() {
+  for(int i=0; i<this->inputs.size(); i++) {
+    this->inputs[i]->open();
+  }
+
+  std::map<uint32_t, int> depths;
+  for(int d=0; d<this->variable_order.size(); d++) {
+    depths[this->variable_order[d]] = d;
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    this->output_list.push_back(iter->second);
+    this->output_depths.push_back(depths[iter->first]);
+  }
+  this->bindings.resize(this->variable_order.size());
+}
+
+void LeapfrogTriejoin::close() {
+  for(int i=0; i<this->inputs.size(); i++) {
+    this->inputs[i]->close();
+  }
+}
+
+
+bool LeapfrogTriejoin::first() {
+  buildTries();
+  this->depth = this->levels.empty() ? -1 : 0;
+  enumerate(BATCH_SIZE);
+  return true;
+}
+
+bool LeapfrogTriejoin::next() {
+  return enumerate(BATCH_SIZE) > 0;
+}
+
+void LeapfrogTriejoin::buildTries() {
+  this->levels.resize(this->variable_order.size());
+  for(int d=0; d<this->levels.size(); d++) {
+    this->levels[d].p = 0;
+    this->levels[d].opened = false;
+  }
+  for(int i=0; i<this->inputs.size(); i++) {
+    if(this->inputs[i]->first()) {
+      while(this->inputs[i]->next());
+    }
+
+    // the columns of the input's variables, in the variable order
+    std::vector<std::vector<uint32_t>*> columns;
+    std::vector<int> input_depths;
+    for(int d=0; d<this->variable_order.size(); d++) {
+      if(this->input_resources[i].count(this->variable_order[d])) {
+        columns.push_back(&this->input_resources[i][this->variable_order[d]]->column);
+        input_depths.push_back(d);
+      }
+    }
+    Trie* trie = new Trie(columns.size());
+    trie->build(columns);
+    for(std::map<uint32_t, Resource*>::iterator iter = input_resources[i].begin(), end = input_resources[i].end(); iter != end; ++iter) {
+      iter->second->column.clear();
+      iter->second->column.shrink_to_fit();
+    }
+
+    TrieIterator* iterator = new TrieIterator(trie);
+    this->tries.push_back(trie);
+    this->iterators.push_back(iterator);
+    for(int l=0; l<input_depths.size(); l++) {
+      this->levels[input_depths[l]].iters.push_back(iterator);
+    }
+  }
+}
+
+bool LeapfrogTriejoin::leapfrogInit(Level& level) {
+  std::vector<TrieIterator*>& iters = level.iters;
+  if(iters.empty()) {
+    return false;
+  }
+  for(int j=0; j<iters.size(); j++) {
+    if(iters[j]->atEnd()) {
+      return false;
+    }
+  }
+  std::sort(iters.begin(), iters.end(), [](TrieIterator* a, TrieIterator* b) { return a->key() < b->key(); });
+  level.p = 0;
+  return leapfrogSearch(level);
+}
+
+bool LeapfrogTriejoin::leapfrogSearch(Level& level) {
+  // iters[p-1] holds the largest key; the others leap over it in turn
+  // until all of them agree
+  std::vector<TrieIterator*>& iters = level.iters;
+  int n = iters.size();
+  uint32_t max_key = iters[(level.p + n - 1) % n]->key();
+  while(true) {
+    if(iters[level.p]->key() == max_key) {
+      return true;
+    }
+    iters[level.p]->seek(max_key);
+    if(iters[level.p]->atEnd()) {
+      return false;
+    }
+    max_key = iters[level.p]->key();
+    level.p = (level.p + 1) % n;
+  }
+}
+
+bool LeapfrogTriejoin::leapfrogNext(Level& level) {
+  level.iters[level.p]->next();
+  if(level.iters[level.p]->atEnd()) {
+    return false;
+  }
+  level.p = (level.p + 1) % level.iters.size();
+  return leapfrogSearch(level);
+}
+
+int LeapfrogTriejoin::enumerate(int max_rows) {
+  // Iterative form of the recursion over the variable order, so that the
+  // enumeration can stop after a batch and resume where it left off.
+  int num_rows = 0;
+  int last = (int)this->levels.size() - 1;
+  while(this->depth >= 0 && num_rows < max_rows) {
+    Level& level = this->levels[this->depth];
+    bool found;
+    if(!level.opened) {
+      for(int j=0; j<level.iters.size(); j++) {
+        level.iters[j]->open();
+      }
+      level.opened = true;
+      found = leapfrogInit(level);
+    } else {
+      found = leapfrogNext(level);
+    }
+
+    if(!found) {
+      for(int j=0; j<level.iters.size(); j++) {
+        level.iters[j]->up();
+      }
+      level.opened = false;
+      --this->depth;
+      continue;
+    }
+
+    this->bindings[this->depth] = level.iters[level.p]->key();
+    if(this->depth < last) {
+      ++this->depth;
+      continue;
+    }
+    for(int s=0; s<this->output_list.size(); s++) {
+      this->output_list[s]->column.push_back(this->bindings[this->output_depths[s]]);
+    }
+    ++num_rows;
+  }
+  return num_rows;
+}
+
+
+
+
+LeapfrogTriejoin::Trie::Trie(int num_levels) : num_levels(num_levels), keys(num_levels), offsets(num_levels > 1 ? num_levels - 1 : 0) {}
+
+void LeapfrogTriejoin::Trie::build(const std::vector<std::vector<uint32_t>*>& columns) {
+  // A triple pattern binds at most two variables, so a row fits in one
+  // 64-bit word, which sorts faster than a permutation. Scans in the
+  // variable order, such as P scans whose subject comes first, are already sorted.
+  size_t n = columns.empty() ? 0 : columns[0]->size();
+  std::vector<uint64_t> rows(n);
+  for(size_t r=0; r<n; r++) {
+    rows[r] = ((uint64_t)(*columns[0])[r] << 32) | (num_levels > 1 ? (*columns[1])[r] : 0);
+  }
+  if(!std::is_sorted(rows.begin(), rows.end())) {
+    std::sort(rows.begin(), rows.end());
+  }
+
+  for(size_t r=0; r<n; r++) {
+    if(r > 0 && rows[r] == rows[r-1]) {
+      continue;
+    }
+    uint32_t key = rows[r] >> 32;
+    if(r == 0 || key != (uint32_t)(rows[r-1] >> 32)) {
+      if(num_levels > 1) {
+        offsets[0].push_back(keys[1].size());
+      }
+      keys[0].push_back(key);
+    }
+    if(num_levels > 1) {
+      keys[1].push_back((uint32_t)rows[r]);
+    }
+  }
+  if(num_levels > 1) {
+    offsets[0].push_back(keys[1].size());
+  }
+}
+
+int LeapfrogTriejoin::Trie::numOfLevels() {
+  return num_levels;
+}
+
+LeapfrogTriejoin::TrieIterator::TrieIterator(Trie* trie) : trie(trie), depth(-1), pos(trie->numOfLevels()), end(trie->numOfLevels()) {}
+
+void LeapfrogTriejoin::TrieIterator::open() {
+  uint32_t begin, limit;
+  if(depth < 0) {
+    begin = 0;
+    limit = trie->keys[0].size();
+  } else {
+    begin = trie->offsets[depth][pos[depth]];
+    limit = trie->offsets[depth][pos[depth]+1];
+  }
+  ++depth;
+  pos[depth] = begin;
+  end[depth] = limit;
+}
+
+void LeapfrogTriejoin::TrieIterator::up() {
+  --depth;
+}
+
+uint32_t LeapfrogTriejoin::TrieIterator::key() {
+  return trie->keys[depth][pos[depth]];
+}
+
+void LeapfrogTriejoin::TrieIterator::next() {
+  ++pos[depth];
+}
+
+void LeapfrogTriejoin::TrieIterator::seek(uint32_t key) {
+  // galloping search, since the next match is usually near
+  const std::vector<uint32_t>& keys = trie->keys[depth];
+  uint32_t low = pos[depth];
+  uint32_t step = 1;
+  while(low + step < end[depth] && keys[low + step] < key) {
+    low += step;
+    step <<= 1;
+  }
+  uint32_t high = std::min(low + step, end[depth]);
+  pos[depth] = std::lower_bound(keys.begin() + low, keys.begin() + high, key) - keys.begin();
+}
+
+bool LeapfrogTriejoin::TrieIterator::atEnd() {
+  return pos[depth] >= end[depth];
+}
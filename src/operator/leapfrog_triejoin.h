@@ -0,0 +1,98 @@
+#ifndef LEAPFROG_TRIEJOIN_H
+#define LEAPFROG_TRIEJOIN_H
+
+#include <vector>
+#include <map>
+#include "operator.h"
+
+
+// Worst-case optimal multiway join (Veldhuizen's Leapfrog Triejoin). Every
+// input becomes a trie whose levels follow the global variable order, and
+// the bindings are enumerated one variable at a time by intersecting the
+// sorted levels of the inputs that contain the variable, so no pairwise
+// intermediate result is ever built.
+class LeapfrogTriejoin : public Operator {
+public:
+  LeapfrogTriejoin(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<uint32_t>& variable_order, double expected_cardinality);
+  ~LeapfrogTriejoin();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  class TrieIterator;
+
+  // Distinct rows of one input sorted level by level: the children of node
+  // i at level l are keys[l+1][offsets[l][i], offsets[l][i+1]).
+  class Trie {
+  public:
+    Trie(int num_levels);
+
+    // Builds from the rows of columns, columns[l] holding the values of level l.
+    void build(const std::vector<std::vector<uint32_t>*>& columns);
+    int numOfLevels();
+
+  private:
+    friend class TrieIterator;
+
+    int num_levels;
+    std::vector<std::vector<uint32_t>> keys;
+    std::vector<std::vector<uint32_t>> offsets;
+  };
+
+  class TrieIterator {
+  public:
+    TrieIterator(Trie* trie);
+
+    // moves to the first child of the current key, or to the first key of the root
+    void open();
+    void up();
+    uint32_t key();
+    void next();
+    // moves to the least key not below key
+    void seek(uint32_t key);
+    bool atEnd();
+
+  private:
+    Trie* trie;
+    int depth;
+    std::vector<uint32_t> pos;
+    std::vector<uint32_t> end;
+  };
+
+  // Inputs binding the variable at one depth of the variable order.
+  struct Level {
+    std::vector<TrieIterator*> iters;
+    int p;
+    bool opened;
+  };
+
+  void buildTries();
+  bool leapfrogInit(Level& level);
+  bool leapfrogSearch(Level& level);
+  bool leapfrogNext(Level& level);
+  int enumerate(int max_rows);
+
+  static const int BATCH_SIZE;
+
+  std::vector<Operator*> inputs;
+  std::vector<std::map<uint32_t, Resource*>> input_resources;
+  std::map<uint32_t, Resource*> output_resources;
+  std::vector<uint32_t> variable_order;
+
+  std::vector<Trie*> tries;
+  std::vector<TrieIterator*> iterators;
+  std::vector<Level> levels;
+  int depth;
+  std::vector<uint32_t> bindings;
+
+  // output_list[s] takes the binding at output_depths[s]
+  std::vector<Resource*> output_list;
+  std::vector<int> output_depths;
+};
+
+
+#endif
@@ -0,0 +1,64 @@
+#include "limit.h"
+#include <algorithm>
+
+Limit::Limit(Operator* input, const std::map<uint32_t, Resource*>& resources, int offset, int limit, double expected_cardinality)
+  : Operator(expected_cardinality), input(input), resources(resources), offset(offset), limit(limit), done(false), num_skipped(0), num_rows(0) {}
+
+Limit::~Limit() {}
+
+void Limit::open() {
+  this->input->open();
+  for(std::map<uint32_t, Resource*>::iterator iter = resources.begin(), end = resources.end(); iter != end; ++iter) {
+    this->columns.push_back(&iter->second->column);
+  }
+}
+
+void Limit::close() {
+  this->input->close();
+}
+
+bool Limit::first() {
+  return produce(true);
+}
+
+bool Limit::next() {
+  return produce(false);
+}
+
+bool Limit::produce(bool first) {
+  if(this->columns.empty()) {
+    return first ? this->input->first() : this->input->next();
+  }
+  while(!this->done && (this->limit < 0 || this->num_rows < this->limit)) {
+    size_t start = numOfRows();
+    this->done = first ? !this->input->first() : !this->input->next();
+    first = false;
+    if(select(start) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Limit::numOfRows() {
+  return this->columns[0]->size();
+}
+
+size_t Limit::select(size_t start) {
+  size_t end = numOfRows();
+  size_t skip = std::min<size_t>(end - start, this->offset - this->num_skipped);
+  size_t keep = end - start - skip;
+  if(this->limit >= 0) {
+    keep = std::min<size_t>(keep, this->limit - this->num_rows);
+  }
+  for(int c=0; c<this->columns.size(); c++) {
+    std::vector<uint32_t>& column = *this->columns[c];
+    if(skip > 0) {
+      std::copy(column.begin() + start + skip, column.begin() + start + skip + keep, column.begin() + start);
+    }
+    column.resize(start + keep);
+  }
+  this->num_skipped += skip;
+  this->num_rows += keep;
+  return keep;
+}
@@ -0,0 +1,42 @@
+#ifndef LIMIT_H
+#define LIMIT_H
+
+#include <vector>
+#include <map>
+#include "operator.h"
+
+
+// Skips the first offset rows of its input and passes on at most limit rows
+// after them, or all of them if limit is negative. The columns of the input
+// are trimmed in place, and the input is not pulled any more once the limit
+// is reached.
+class Limit : public Operator {
+public:
+  Limit(Operator* input, const std::map<uint32_t, Resource*>& resources, int offset, int limit, double expected_cardinality);
+  ~Limit();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  bool produce(bool first);
+  size_t numOfRows();
+  // Trims the rows from start on, and tells how many are kept.
+  size_t select(size_t start);
+
+  Operator* input;
+  std::map<uint32_t, Resource*> resources;
+  int offset;
+  int limit;
+  bool done;
+
+  std::vector<std::vector<uint32_t>*> columns;
+  int num_skipped;
+  int num_rows;
+};
+
+
+#endif
@@ -0,0 +1,157 @@
+#include "merge_join.h"
+#include <algorithm>
+
+MergeJoin::MergeJoin(Operator* left, const std::map<uint32_t, Resource*>& left_resources, Operator* right, const std::map<uint32_t, Resource*>& right_resources, const std::map<uint32_t, Resource*>& output_resources, uint32_t join_key, double expected_cardinality)
+  : Operator(expected_cardinality), output_resources(output_resources), join_key(join_key) {
+  this->left.opt = left;
+  this->left.resources = left_resources;
+  this->left.key = nullptr;
+  this->left.pos = 0;
+  this->left.done = false;
+  this->right.opt = right;
+  this->right.resources = right_resources;
+  this->right.key = nullptr;
+  this->right.pos = 0;
+  this->right.done = false;
+}
+
+MergeJoin::~MergeJoin() {}
+
+void MergeJoin::open() {
+  left.opt->open();
+  right.opt->open();
+
+  this->left.key = this->left.resources[this->join_key];
+  this->right.key = this->right.resources[this->join_key];
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    this->output_list.push_back(iter->second);
+    this->left_binds.push_back(this->left.resources.count(iter->first) ? this->left.resources[iter->first] : nullptr);
+    this->right_binds.push_back(this->right.resources.count(iter->first) ? this->right.resources[iter->first] : nullptr);
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = left.resources.begin(), end = left.resources.end(); iter != end; ++iter) {
+    if(iter->first != this->join_key && this->right.resources.count(iter->first)) {
+      this->checks.push_back(std::make_pair(iter->second, this->right.resources[iter->first]));
+    }
+  }
+}
+
+void MergeJoin::close() {
+  left.opt->close();
+  right.opt->close();
+}
+
+
+bool MergeJoin::first() {
+  this->left.done = !this->left.opt->first();
+  this->right.done = !this->right.opt->first();
+
+  produce();
+  return true;
+}
+
+bool MergeJoin::next() {
+  return produce() > 0;
+}
+
+int MergeJoin::produce() {
+  // Batches are fetched until the merge of the rows at hand has matches.
+  int num_rows = 0;
+  while(num_rows == 0) {
+    num_rows = merge();
+    if(num_rows > 0) {
+      break;
+    }
+    if(this->left.pos == this->left.key->column.size()) {
+      if(this->left.done) {
+        break;
+      }
+      fetch(this->left);
+    } else if(this->right.pos == this->right.key->column.size()) {
+      if(this->right.done) {
+        break;
+      }
+      fetch(this->right);
+    } else if(runEnd(this->left) == this->left.key->column.size() && !this->left.done) {
+      fetch(this->left);
+    } else {
+      fetch(this->right);
+    }
+  }
+  return num_rows;
+}
+
+int MergeJoin::merge() {
+  const std::vector<uint32_t>& left_keys = this->left.key->column;
+  const std::vector<uint32_t>& right_keys = this->right.key->column;
+  size_t num_rows = this->output_list.empty() ? 0 : this->output_list[0]->column.size();
+  while(this->left.pos < left_keys.size() && this->right.pos < right_keys.size()) {
+    uint32_t key = left_keys[this->left.pos];
+    if(key < right_keys[this->right.pos]) {
+      this->left.pos = seek(this->left, right_keys[this->right.pos]);
+      continue;
+    }
+    if(right_keys[this->right.pos] < key) {
+      this->right.pos = seek(this->right, key);
+      continue;
+    }
+
+    // a run that reaches the end of a batch may go on in the next one
+    size_t left_end = runEnd(this->left);
+    size_t right_end = runEnd(this->right);
+    if((left_end == left_keys.size() && !this->left.done) || (right_end == right_keys.size() && !this->right.done)) {
+      break;
+    }
+    for(size_t l=this->left.pos; l<left_end; l++) {
+      for(size_t r=this->right.pos; r<right_end; r++) {
+        bool match = true;
+        for(int c=0; c<this->checks.size() && match; c++) {
+          match = this->checks[c].first->column[l] == this->checks[c].second->column[r];
+        }
+        if(!match) {
+          continue;
+        }
+        for(int s=0; s<this->output_list.size(); s++) {
+          if(this->left_binds[s] != nullptr) {
+            this->output_list[s]->column.push_back(this->left_binds[s]->column[l]);
+          } else {
+            this->output_list[s]->column.push_back(this->right_binds[s]->column[r]);
+          }
+        }
+      }
+    }
+    this->left.pos = left_end;
+    this->right.pos = right_end;
+  }
+  return this->output_list.empty() ? 0 : this->output_list[0]->column.size() - num_rows;
+}
+
+void MergeJoin::fetch(Input& input) {
+  for(std::map<uint32_t, Resource*>::iterator iter = input.resources.begin(), end = input.resources.end(); iter != end; ++iter) {
+    std::vector<uint32_t>& column = iter->second->column;
+    column.erase(column.begin(), column.begin() + std::min(input.pos, column.size()));
+  }
+  input.pos = 0;
+  input.done = !input.opt->next();
+}
+
+size_t MergeJoin::runEnd(const Input& input) {
+  uint32_t key = input.key->column[input.pos];
+  if(key == UINT32_MAX) {
+    return input.key->column.size();
+  }
+  return seek(input, key + 1);
+}
+
+size_t MergeJoin::seek(const Input& input, uint32_t key) {
+  // galloping search from pos, whose key is below the one sought, since
+  // matching keys are usually close
+  const std::vector<uint32_t>& keys = input.key->column;
+  size_t low = input.pos;
+  size_t step = 1;
+  while(low + step < keys.size() && keys[low + step] < key) {
+    low += step;
+    step <<= 1;
+  }
+  size_t high = std::min(low + step, keys.size());
+  return std::lower_bound(keys.begin() + low, keys.begin() + high, key) - keys.begin();
+}
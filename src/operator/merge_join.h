@@ -0,0 +1,55 @@
+#ifndef MERGE_JOIN_H
+#define MERGE_JOIN_H
+
+#include <vector>
+#include <map>
+#include "operator.h"
+
+
+// Binary sort-merge join on a single key. Both inputs must produce their
+// rows in ascending order of the key, as P order scans do for subjects, so
+// no hash table is built: runs of equal keys are matched as they stream by
+// and the output keeps the key order.
+class MergeJoin : public Operator {
+public:
+  MergeJoin(Operator* left, const std::map<uint32_t, Resource*>& left_resources, Operator* right, const std::map<uint32_t, Resource*>& right_resources, const std::map<uint32_t, Resource*>& output_resources, uint32_t join_key, double expected_cardinality);
+  ~MergeJoin();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  // Rows of one input not consumed yet, from pos to the end of its columns.
+  struct Input {
+    Operator* opt;
+    std::map<uint32_t, Resource*> resources;
+    Resource* key;
+    size_t pos;
+    bool done;
+  };
+
+  int produce();
+  int merge();
+  // Drops the consumed rows of the input and appends its next batch.
+  void fetch(Input& input);
+  // End of the run of the key at pos, which is only known to be complete
+  // if it stops before the end of the columns or the input is done.
+  size_t runEnd(const Input& input);
+  size_t seek(const Input& input, uint32_t key);
+
+  Input left, right;
+  std::map<uint32_t, Resource*> output_resources;
+  uint32_t join_key;
+
+  // output_list[s] is copied from left_binds[s] if set, from right_binds[s] otherwise
+  std::vector<Resource*> output_list;
+  std::vector<Resource*> left_binds, right_binds;
+  // other variables of both inputs, whose values must agree
+  std::vector<std::pair<Resource*, Resource*>> checks;
+};
+
+
+#endif
@@ -14,3 +14,7 @@ double Operator::getExpectedCardinality() {
 void Operator::setTripleOrder(TripleOrder triple_order) {
   this->triple_order = triple_order;
 }
+
+int Operator::getCountByKey(TripleOrder key_order, uint32_t key) {
+  return -1;
+}
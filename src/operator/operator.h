@@ -23,6 +23,8 @@ public:
 
   double getExpectedCardinality();
   void setTripleOrder(TripleOrder triple_order);
+  // Number of rows with the given key in SP or OP order, or -1 if unknown.
+  virtual int getCountByKey(TripleOrder key_order, uint32_t key);
 
 protected:
   Operator(double expected_cardinality);
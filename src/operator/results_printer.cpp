@@ -1,8 +1,8 @@
 #include "results_printer.h"
 
 
-ResultsPrinter::ResultsPrinter(Dictionary& dict, const std::vector<std::string>& projection, Operator* input, const std::vector<Resource*>& resources, std::ostream& out, double expected_cardinality, bool silent)
-  : Operator(expected_cardinality), dict(dict), projection(projection), input(input), resources(resources), out(out), silent(silent), result_count(0) {}
+ResultsPrinter::ResultsPrinter(Dictionary& dict, const std::vector<std::string>& projection, Operator* input, const std::vector<Resource*>& resources, std::ostream& out, double expected_cardinality, bool silent, Resource* count_res)
+  : Operator(expected_cardinality), dict(dict), projection(projection), input(input), resources(resources), out(out), silent(silent), count_res(count_res), result_count(0) {}
 
 ResultsPrinter::~ResultsPrinter() {}
 
@@ -23,24 +23,7 @@ bool ResultsPrinter::first() {
     out << "--------------------------------------------------------------------------------\n";
   }
   if(this->input->first()) {
-    if(resources.size() != 0) {
-      int count = resources[0]->column.size();
-      result_count += count;
-      if(!silent) {
-        for(int i=0; i<count; i++) {
-          for(int j=0; j<resources.size(); j++) {
-            std::string literal;
-            dict.lookupById(resources[j]->column[i], &resources[j]->literal);
-            out << resources[j]->literal << "  ";
-            // out << resources[j]->column[i] << "  ";
-          }
-          out << "\n";
-        }
-      }
-      for(int i=0; i<resources.size(); ++i) {
-        resources[i]->column.clear();
-      }
-    }
+    printResults();
     return true;
   } else {
     return false;
@@ -49,26 +32,56 @@ bool ResultsPrinter::first() {
 
 bool ResultsPrinter::next() {
   while(this->input->next()) {
-    if(resources.size() != 0) {
-      int count = resources[0]->column.size();
-      result_count += count;
+    printResults();
+    return true;
+  }
+  out << "Total results: " << result_count << "\n";
+  return false;
+}
+
+void ResultsPrinter::printResults() {
+  if(count_res != nullptr) {
+    // every row stands for as many results as its count
+    int count = count_res->column.size();
+    for(int i=0; i<count; i++) {
+      result_count += count_res->column[i];
       if(!silent) {
-        for(int i=0; i<count; i++) {
+        for(int j=0; j<resources.size(); j++) {
+          lookup(resources[j]->column[i], resources[j]->literal);
+        }
+        for(uint32_t c=0; c<count_res->column[i]; c++) {
           for(int j=0; j<resources.size(); j++) {
-            std::string literal;
-            dict.lookupById(resources[j]->column[i], &resources[j]->literal);
             out << resources[j]->literal << "  ";
-            // out << resources[j]->column[i] << "  ";
           }
           out << "\n";
         }
       }
-      for(int i=0; i<resources.size(); i++) {
-        resources[i]->column.clear();
+    }
+    count_res->column.clear();
+  } else if(resources.size() != 0) {
+    int count = resources[0]->column.size();
+    result_count += count;
+    if(!silent) {
+      for(int i=0; i<count; i++) {
+        for(int j=0; j<resources.size(); j++) {
+          lookup(resources[j]->column[i], resources[j]->literal);
+          out << resources[j]->literal << "  ";
+          // out << resources[j]->column[i] << "  ";
+        }
+        out << "\n";
       }
     }
-    return true;
   }
-  out << "Total results: " << result_count << "\n";
-  return false;
+  for(int i=0; i<resources.size(); i++) {
+    resources[i]->column.clear();
+  }
+}
+
+void ResultsPrinter::lookup(uint32_t id, std::string& literal) {
+  // variables left unbound by an OPTIONAL print empty
+  if(id == UNBOUND_ID) {
+    literal.clear();
+  } else {
+    dict.lookupById(id, &literal);
+  }
 }
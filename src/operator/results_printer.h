@@ -10,7 +10,7 @@
 
 class ResultsPrinter : public Operator {
 public:
-  ResultsPrinter(Dictionary& dict, const std::vector<std::string>& projection, Operator* input, const std::vector<Resource*>& resources, std::ostream& out, double expected_cardinality, bool silent=false);
+  ResultsPrinter(Dictionary& dict, const std::vector<std::string>& projection, Operator* input, const std::vector<Resource*>& resources, std::ostream& out, double expected_cardinality, bool silent=false, Resource* count_res=nullptr);
   ~ResultsPrinter();
 
   void open();
@@ -20,6 +20,9 @@ public:
   bool next();
 
 protected:
+  void printResults();
+  void lookup(uint32_t id, std::string& literal);
+
   Dictionary& dict;
   std::vector<std::string> projection;
 
@@ -30,7 +33,10 @@ protected:
 
   bool silent;
 
-  int result_count;
+  // multiplicity of every row, if the input provides one
+  Resource* count_res;
+
+  uint64_t result_count;
 };
 
 
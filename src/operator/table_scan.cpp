@@ -1,8 +1,8 @@
 #include "table_scan.h"
 #include <iostream>
 
-TableScan::TableScan(TripleTable& table, TripleOrder triple_order, Resource* subject, Resource* predicate, Resource* object, double expected_cardinality)
-  : Operator(expected_cardinality, triple_order), table(table), subject(subject), predicate(predicate), object(object), scanner(nullptr) {}
+TableScan::TableScan(TripleTable& table, TripleOrder triple_order, Resource* subject, Resource* predicate, Resource* object, double expected_cardinality, bool same_variable)
+  : Operator(expected_cardinality, triple_order), table(table), subject(subject), predicate(predicate), object(object), same_variable(same_variable), scanner(nullptr) {}
 
 TableScan::~TableScan() {
   if(scanner != nullptr) {
@@ -17,11 +17,90 @@ void TableScan::close() {}
 bool TableScan::first() {
   scanner = new TripleTable::BlockScanner(this->table, triple_order, subject, predicate, object);
   if(!scanner->find()) {
+    reportFailure();
     return false;
   }
-  return scanner->next();
+  return next();
 }
 
 bool TableScan::next() {
-  return scanner->next();
+  if(!same_variable) {
+    if(scanner->next()) {
+      return true;
+    }
+    reportFailure();
+    return false;
+  }
+  // The object column is the output of the variable, the subject column is
+  // only read to compare and is truncated after every batch.
+  while(true) {
+    size_t subject_start = subject->column.size();
+    size_t start = object->column.size();
+    if(!scanner->next()) {
+      reportFailure();
+      return false;
+    }
+    std::vector<uint32_t>& column = object->column;
+    size_t out = start;
+    for(size_t i=start; i<column.size(); i++) {
+      if(subject->column[subject_start+i-start] == column[i]) {
+        column[out++] = column[i];
+      }
+    }
+    column.resize(out);
+    subject->column.resize(subject_start);
+    if(out > start) {
+      return true;
+    }
+  }
+}
+
+int TableScan::getCountByKey(TripleOrder key_order, uint32_t key) {
+  return this->table.count(key_order, key, predicate->id, key);
+}
+
+bool TableScan::canScanBatches() {
+  return !same_variable;
+}
+
+bool TableScan::firstBatch(TripleTable::Batch& batch) {
+  scanner = new TripleTable::BlockScanner(this->table, triple_order, subject, predicate, object);
+  if(!scanner->find()) {
+    reportFailure();
+    return false;
+  }
+  return nextBatch(batch);
+}
+
+bool TableScan::nextBatch(TripleTable::Batch& batch) {
+  if(scanner->nextBatch(batch)) {
+    return true;
+  }
+  reportFailure();
+  return false;
+}
+
+void TableScan::release(TripleTable::Batch& batch) {
+  if(scanner != nullptr) {
+    scanner->release(batch);
+  }
+}
+
+void TableScan::reportFailure() {
+  if(scanner->hasFailed()) {
+    std::cerr << "Table scan failed to read the segments of its keys, the results are incomplete." << std::endl;
+  }
+}
+
+const TripleTable::ColumnView* TableScan::getColumnView(const Resource* resource, const TripleTable::Batch& batch) {
+  if(resource == nullptr) {
+    return nullptr;
+  }
+  if(resource == subject) {
+    return &batch.subject;
+  }
+  if(resource == object) {
+    return &batch.object;
+  }
+  return nullptr;
 }
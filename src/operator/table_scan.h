@@ -8,7 +8,7 @@
 
 class TableScan : public Operator {
 public:
-  TableScan(TripleTable& table, TripleOrder triple_order, Resource* subject, Resource* predicate, Resource* object, double expected_cardinality);
+  TableScan(TripleTable& table, TripleOrder triple_order, Resource* subject, Resource* predicate, Resource* object, double expected_cardinality, bool same_variable=false);
   ~TableScan();
 
   void open();
@@ -20,9 +20,25 @@ public:
   bool first();
   bool next();
 
+  int getCountByKey(TripleOrder key_order, uint32_t key);
+
+  // Batch mode: the rows are handed out as views into the pinned pages of
+  // the table instead of being appended to the columns of the resources.
+  bool canScanBatches();
+  bool firstBatch(TripleTable::Batch& batch);
+  bool nextBatch(TripleTable::Batch& batch);
+  void release(TripleTable::Batch& batch);
+  // the column of batch holding the rows of resource, or nullptr
+  const TripleTable::ColumnView* getColumnView(const Resource* resource, const TripleTable::Batch& batch);
+
 protected:
+  // Reports a scan that ended because segments could not be read.
+  void reportFailure();
+
   TripleTable& table;
   Resource *subject, *predicate, *object;
+  // ?x p ?x: only the rows whose subject equals the object are kept
+  bool same_variable;
 
   TripleTable::BlockScanner* scanner;
 };
@@ -0,0 +1,154 @@
+#include "top_k.h"
+#include <algorithm>
+
+const int TopK::BATCH_SIZE = 4096;
+const size_t TopK::MAX_CACHED_TERMS = 1 << 20;
+
+TopK::TopK(Operator* input, const std::map<uint32_t, Resource*>& resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<uint32_t>& order_keys, const std::vector<bool>& ascending, int k, Dictionary& dict, double expected_cardinality)
+  : Operator(expected_cardinality), input(input), resources(resources), output_resources(output_resources), order_keys(order_keys), ascending(ascending), k(k), dict(dict),
+    width(0), scratch(0), emit_pos(0) {}
+
+TopK::~TopK() {}
+
+void TopK::open() {
+  this->input->open();
+  std::map<uint32_t, int> positions;
+  for(std::map<uint32_t, Resource*>::iterator iter = resources.begin(), end = resources.end(); iter != end; ++iter) {
+    positions[iter->first] = this->columns.size();
+    this->columns.push_back(&iter->second->column);
+  }
+  this->width = this->columns.size();
+  // keys the input does not bind are unbound on every row, and order nothing
+  for(int o=0; o<this->order_keys.size(); o++) {
+    if(positions.count(this->order_keys[o])) {
+      this->order_pos.push_back(positions[this->order_keys[o]]);
+      this->order_ascending.push_back(this->ascending[o]);
+    }
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    this->output_list.push_back(iter->second);
+    this->output_pos.push_back(positions[iter->first]);
+  }
+}
+
+void TopK::close() {
+  this->input->close();
+}
+
+bool TopK::first() {
+  consume();
+  emit(BATCH_SIZE);
+  return true;
+}
+
+bool TopK::next() {
+  return emit(BATCH_SIZE) > 0;
+}
+
+void TopK::consume() {
+  if(this->width == 0 || this->k == 0) {
+    return;
+  }
+  if(this->k > 0) {
+    // k slots for the heap, and one for the row being compared
+    this->rows.resize((size_t)(this->k + 1) * this->width);
+    this->heap.reserve(this->k);
+    this->scratch = this->k;
+  }
+  auto order = [this](uint32_t a, uint32_t b) { return less(a, b); };
+  if(this->input->first()) {
+    do {
+      size_t n = this->columns[0]->size();
+      for(size_t r=0; r<n; r++) {
+        if(this->k < 0 || this->heap.size() < this->k) {
+          uint32_t slot = this->heap.size();
+          if(this->k < 0) {
+            this->rows.resize(this->rows.size() + this->width);
+          }
+          copyRow(r, slot);
+          this->heap.push_back(slot);
+          if(this->k > 0) {
+            std::push_heap(this->heap.begin(), this->heap.end(), order);
+          }
+          continue;
+        }
+        copyRow(r, this->scratch);
+        if(less(this->scratch, this->heap.front())) {
+          // the row takes the place of the last one kept
+          std::pop_heap(this->heap.begin(), this->heap.end(), order);
+          std::swap(this->scratch, this->heap.back());
+          std::push_heap(this->heap.begin(), this->heap.end(), order);
+        }
+      }
+      for(int c=0; c<this->width; c++) {
+        this->columns[c]->clear();
+      }
+      if(this->terms.size() > MAX_CACHED_TERMS) {
+        this->terms.clear();
+      }
+    } while(this->input->next());
+  }
+
+  if(this->k > 0) {
+    std::sort_heap(this->heap.begin(), this->heap.end(), order);
+  } else {
+    std::stable_sort(this->heap.begin(), this->heap.end(), order);
+  }
+  this->terms.clear();
+}
+
+void TopK::copyRow(size_t r, uint32_t slot) {
+  uint32_t* row = this->rows.data() + (size_t)slot * this->width;
+  for(int c=0; c<this->width; c++) {
+    row[c] = (*this->columns[c])[r];
+  }
+}
+
+int TopK::emit(int max_rows) {
+  int num_rows = std::min<size_t>(max_rows, this->heap.size() - this->emit_pos);
+  for(int s=0; s<this->output_list.size(); s++) {
+    std::vector<uint32_t>& column = this->output_list[s]->column;
+    for(int r=0; r<num_rows; r++) {
+      column.push_back(this->rows[(size_t)this->heap[this->emit_pos + r] * this->width + this->output_pos[s]]);
+    }
+  }
+  this->emit_pos += num_rows;
+  return num_rows;
+}
+
+bool TopK::less(uint32_t a, uint32_t b) {
+  const uint32_t* row_a = this->rows.data() + (size_t)a * this->width;
+  const uint32_t* row_b = this->rows.data() + (size_t)b * this->width;
+  for(int o=0; o<this->order_pos.size(); o++) {
+    uint32_t id_a = row_a[this->order_pos[o]];
+    uint32_t id_b = row_b[this->order_pos[o]];
+    if(id_a == id_b) {
+      continue;
+    }
+    int result = compare(id_a, id_b);
+    if(result != 0) {
+      return this->order_ascending[o] ? result < 0 : result > 0;
+    }
+  }
+  return false;
+}
+
+int TopK::compare(uint32_t a, uint32_t b) {
+  // SPARQL orders unbound values before any term
+  if(a == UNBOUND_ID || b == UNBOUND_ID) {
+    return a == UNBOUND_ID ? -1 : 1;
+  }
+  return Filter::compareTerms(*decode(a), *decode(b));
+}
+
+const Filter::Term* TopK::decode(uint32_t id) {
+  std::unordered_map<uint32_t, Filter::Term>::iterator iter = this->terms.find(id);
+  if(iter != this->terms.end()) {
+    return &iter->second;
+  }
+  std::string str;
+  this->dict.lookupById(id, &str);
+  Filter::Term& term = this->terms[id];
+  Filter::parseTerm(str, term);
+  return &term;
+}
@@ -0,0 +1,67 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include "operator.h"
+#include "filter.h"
+#include "storage/dictionary.h"
+
+
+// ORDER BY, keeping only the first k rows when the query has a LIMIT. The
+// rows are kept in a bounded max-heap whose top is the last row to be
+// returned, so a row behind it is dropped after one comparison. Ids carry
+// no order of their terms, so the terms of the order keys are decoded
+// through the dictionary, and cached. Without a limit (k < 0) every row is
+// kept and sorted once the input is drained.
+class TopK : public Operator {
+public:
+  TopK(Operator* input, const std::map<uint32_t, Resource*>& resources, const std::map<uint32_t, Resource*>& output_resources, const std::vector<uint32_t>& order_keys, const std::vector<bool>& ascending, int k, Dictionary& dict, double expected_cardinality);
+  ~TopK();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  void consume();
+  void copyRow(size_t r, uint32_t slot);
+  int emit(int max_rows);
+  // Tells whether the row in slot a comes before the one in slot b.
+  bool less(uint32_t a, uint32_t b);
+  int compare(uint32_t a, uint32_t b);
+  const Filter::Term* decode(uint32_t id);
+
+  static const int BATCH_SIZE;
+  static const size_t MAX_CACHED_TERMS;
+
+  Operator* input;
+  std::map<uint32_t, Resource*> resources;
+  std::map<uint32_t, Resource*> output_resources;
+  std::vector<uint32_t> order_keys;
+  std::vector<bool> ascending;
+  int k;
+  Dictionary& dict;
+
+  std::vector<std::vector<uint32_t>*> columns;
+  int width;
+  // positions in a row of the order keys bound by the input
+  std::vector<int> order_pos;
+  std::vector<bool> order_ascending;
+  // output_list[s] takes position output_pos[s] of a row
+  std::vector<Resource*> output_list;
+  std::vector<int> output_pos;
+
+  // rows in slots of width ids, and the slots of the heap
+  std::vector<uint32_t> rows;
+  std::vector<uint32_t> heap;
+  uint32_t scratch;
+  size_t emit_pos;
+  std::unordered_map<uint32_t, Filter::Term> terms;
+};
+
+
+#endif
@@ -0,0 +1,189 @@
+#include "union.h"
+#include "database/config.h"
+#include <algorithm>
+
+const int Union::MAX_QUEUED_BATCHES = 4;
+
+Union::Union(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, double expected_cardinality)
+  : Operator(expected_cardinality), inputs(inputs), input_resources(input_resources), output_resources(output_resources),
+    current(0), started(false), num_threads(1), thread_pool(nullptr), num_running(0), stopped(false) {
+  Config config;
+  if(config.getIntParam(ConfigKey::NUM_THREADS) > 1) {
+    this->num_threads = config.getIntParam(ConfigKey::NUM_THREADS);
+  }
+}
+
+Union::~Union() {
+  for(int i=0; i<this->tasks.size(); i++) {
+    delete this->tasks[i];
+  }
+  delete this->thread_pool;
+}
+
+void Union::open() {
+  for(int i=0; i<this->inputs.size(); i++) {
+    this->inputs[i]->open();
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+    this->columns.push_back(&iter->second->column);
+  }
+  this->input_binds.resize(this->inputs.size());
+  for(int i=0; i<this->inputs.size(); i++) {
+    std::map<uint32_t, Resource*>& resources = this->input_resources[i];
+    for(std::map<uint32_t, Resource*>::iterator iter = output_resources.begin(), end = output_resources.end(); iter != end; ++iter) {
+      this->input_binds[i].push_back(resources.count(iter->first) ? resources[iter->first] : nullptr);
+    }
+    this->row_resources.push_back(resources.empty() ? nullptr : resources.begin()->second);
+  }
+
+  if(this->num_threads > 1 && this->inputs.size() > 1) {
+    this->thread_pool = new ThreadPool(std::min<int>(this->num_threads, this->inputs.size()));
+    for(int i=0; i<this->inputs.size(); i++) {
+      this->tasks.push_back(new BranchTask(this, i));
+    }
+  }
+}
+
+void Union::close() {
+  if(this->thread_pool != nullptr) {
+    // workers blocked on a full queue give up their batch and stop
+    this->mutex.lock();
+    this->stopped = true;
+    this->space_cond.notifyAll();
+    this->mutex.unlock();
+    this->thread_pool->wait();
+  }
+  for(int i=0; i<this->inputs.size(); i++) {
+    this->inputs[i]->close();
+  }
+}
+
+bool Union::first() {
+  if(this->thread_pool != nullptr) {
+    this->num_running = this->tasks.size();
+    for(int i=0; i<this->tasks.size(); i++) {
+      this->thread_pool->execute(this->tasks[i]);
+    }
+  }
+  produce();
+  return true;
+}
+
+bool Union::next() {
+  return produce() > 0;
+}
+
+int Union::produce() {
+  if(this->thread_pool == nullptr) {
+    while(this->current < this->inputs.size()) {
+      Operator* input = this->inputs[this->current];
+      bool more = this->started ? input->next() : input->first();
+      this->started = true;
+      int num_rows = copyRows(this->current, this->columns);
+      if(!more) {
+        this->current++;
+        this->started = false;
+      }
+      if(num_rows > 0) {
+        return num_rows;
+      }
+    }
+    return 0;
+  }
+
+  this->mutex.lock();
+  while(this->batches.empty() && this->num_running > 0) {
+    this->batch_cond.wait(this->mutex);
+  }
+  if(this->batches.empty()) {
+    this->mutex.unlock();
+    return 0;
+  }
+  std::vector<std::vector<uint32_t>> batch;
+  batch.swap(this->batches.front());
+  this->batches.pop_front();
+  this->space_cond.notifyOne();
+  this->mutex.unlock();
+
+  for(int s=0; s<this->columns.size(); s++) {
+    this->columns[s]->insert(this->columns[s]->end(), batch[s].begin(), batch[s].end());
+  }
+  return batch.empty() ? 0 : batch[0].size();
+}
+
+void Union::runBranch(int i) {
+  this->mutex.lock();
+  bool stopped = this->stopped;
+  this->mutex.unlock();
+
+  if(!stopped) {
+    std::vector<std::vector<uint32_t>> batch(this->columns.size());
+    std::vector<std::vector<uint32_t>*> batch_columns;
+    for(int s=0; s<batch.size(); s++) {
+      batch_columns.push_back(&batch[s]);
+    }
+    bool more = this->inputs[i]->first();
+    while(true) {
+      // rows may come with the call that reports the end of the input
+      if(copyRows(i, batch_columns) > 0 && !push(batch)) {
+        break;
+      }
+      if(!more) {
+        break;
+      }
+      more = this->inputs[i]->next();
+    }
+  }
+
+  this->mutex.lock();
+  this->num_running--;
+  this->batch_cond.notifyAll();
+  this->mutex.unlock();
+}
+
+int Union::copyRows(int i, std::vector<std::vector<uint32_t>*>& columns) {
+  if(this->row_resources[i] == nullptr) {
+    return 0;
+  }
+  int num_rows = this->row_resources[i]->column.size();
+  for(int s=0; s<columns.size(); s++) {
+    if(this->input_binds[i][s] != nullptr) {
+      std::vector<uint32_t>& column = this->input_binds[i][s]->column;
+      columns[s]->insert(columns[s]->end(), column.begin(), column.end());
+    } else {
+      columns[s]->resize(columns[s]->size() + num_rows, UNBOUND_ID);
+    }
+  }
+  for(std::map<uint32_t, Resource*>::iterator iter = input_resources[i].begin(), end = input_resources[i].end(); iter != end; ++iter) {
+    iter->second->column.clear();
+  }
+  return num_rows;
+}
+
+bool Union::push(std::vector<std::vector<uint32_t>>& batch) {
+  this->mutex.lock();
+  while(this->batches.size() >= MAX_QUEUED_BATCHES && !this->stopped) {
+    this->space_cond.wait(this->mutex);
+  }
+  if(this->stopped) {
+    this->mutex.unlock();
+    return false;
+  }
+  // the columns of batch stay in place, the worker keeps pointers to them
+  this->batches.emplace_back(batch.size());
+  for(int s=0; s<batch.size(); s++) {
+    this->batches.back()[s].swap(batch[s]);
+  }
+  this->batch_cond.notifyOne();
+  this->mutex.unlock();
+  return true;
+}
+
+
+
+
+Union::BranchTask::BranchTask(Union* parent, int input) : parent(parent), input(input) {}
+
+void Union::BranchTask::run() {
+  parent->runBranch(input);
+}
@@ -0,0 +1,77 @@
+#ifndef UNION_H
+#define UNION_H
+
+#include <deque>
+#include <vector>
+#include <map>
+#include "operator.h"
+#include "thread/mutex.h"
+#include "thread/condition.h"
+#include "thread/runnable.h"
+#include "thread/thread_pool.h"
+
+
+// UNION of the solutions of its inputs, one input per branch. With more
+// than one thread the branches are evaluated concurrently: a worker runs
+// every branch and copies its batches into a bounded queue, from which
+// they are returned in the order they arrive. With one thread the branches
+// are read one after the other. Variables a branch does not bind are
+// UNBOUND_ID on its rows.
+class Union : public Operator {
+public:
+  Union(const std::vector<Operator*>& inputs, const std::vector<std::map<uint32_t, Resource*>>& input_resources, const std::map<uint32_t, Resource*>& output_resources, double expected_cardinality);
+  ~Union();
+
+  void open();
+  void close();
+
+  bool first();
+  bool next();
+
+protected:
+  class BranchTask : public Runnable {
+  public:
+    BranchTask(Union* parent, int input);
+    void run();
+
+  private:
+    Union* parent;
+    int input;
+  };
+
+  int produce();
+  void runBranch(int i);
+  // Moves the rows of the current batch of input i to the end of columns.
+  int copyRows(int i, std::vector<std::vector<uint32_t>*>& columns);
+  // Queues a batch, and tells whether the consumer still wants it.
+  bool push(std::vector<std::vector<uint32_t>>& batch);
+
+  static const int MAX_QUEUED_BATCHES;
+
+  std::vector<Operator*> inputs;
+  std::vector<std::map<uint32_t, Resource*>> input_resources;
+  std::map<uint32_t, Resource*> output_resources;
+
+  std::vector<std::vector<uint32_t>*> columns;
+  // input_binds[i][s] is the column of input i bound to output slot s, if any
+  std::vector<std::vector<Resource*>> input_binds;
+  // a column of every input, which tells how many rows its batch has
+  std::vector<Resource*> row_resources;
+
+  // one thread: the input being read, and whether it was started
+  int current;
+  bool started;
+
+  int num_threads;
+  ThreadPool* thread_pool;
+  std::vector<BranchTask*> tasks;
+  std::deque<std::vector<std::vector<uint32_t>>> batches;
+  int num_running;
+  bool stopped;
+  Mutex mutex;
+  Condition batch_cond;
+  Condition space_cond;
+};
+
+
+#endif
@@ -1,4 +1,4 @@
-/* A Bison parser, made by GNU Bison 3.7.5.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -53,7 +53,7 @@
 extern int rqdebug;
 #endif
 /* "%code requires" blocks.  */
-#line 71 "sparql_parser.y"
+#line 73 "sparql_parser.y"
 
 
 #include <cstdlib>
@@ -168,7 +168,7 @@ struct SPARQLParseContext;
 #if ! defined RQSTYPE && ! defined RQSTYPE_IS_DECLARED
 union RQSTYPE
 {
-#line 110 "sparql_parser.y"
+#line 112 "sparql_parser.y"
 
   char* strval;
   QueryResource *resource;
@@ -199,9 +199,11 @@ struct RQLTYPE
 
 
 
+
 int rqparse (yyscan_t scanner, SPARQLParseContext* context, QueryGraph* query_graph);
+
 /* "%code provides" blocks.  */
-#line 164 "sparql_parser.y"
+#line 166 "sparql_parser.y"
 
 
 #define YYSTYPE         RQSTYPE
@@ -217,6 +219,6 @@ int rqlex_destroy (yyscan_t scanner);
 int rqlex(YYSTYPE * yylval, YYLTYPE * yylloc, yyscan_t scanner);
 
 
-#line 221 "sparql_lexer.h"
+#line 223 "sparql_lexer.h"
 
 #endif /* !YY_RQ_SPARQL_LEXER_H_INCLUDED  */
@@ -1,4 +1,4 @@
-/* A Bison parser, made by GNU Bison 3.7.5.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -46,10 +46,10 @@
    USER NAME SPACE" below.  */
 
 /* Identify Bison output, and Bison version.  */
-#define YYBISON 30705
+#define YYBISON 30802
 
 /* Bison version string.  */
-#define YYBISON_VERSION "3.7.5"
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -79,6 +79,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <strings.h>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
@@ -105,15 +106,16 @@ struct SPARQLParseContext {
   std::vector<QueryResource*> subjects;
   std::vector<QueryResource*> predicates;
   QueryPattern* pattern;
-  QueryPattern* parent_pattern;
+  // enclosing patterns of the current one, innermost last
+  std::vector<QueryPattern*> parent_patterns;
+  // the aggregate of the select expression being parsed
+  Aggregation aggregation;
 
   SPARQLParseContext() : bknode_id_gen(0) {
     pattern = nullptr;
-    parent_pattern = nullptr;
   }
   ~SPARQLParseContext() {
     pattern = nullptr;
-    parent_pattern = nullptr;
   }
 };
 
@@ -126,7 +128,7 @@ int rqerror(YYLTYPE* llocp, yyscan_t scanner, SPARQLParseContext* context, Query
 
 
 
-#line 130 "sparql_parser.cpp"
+#line 132 "sparql_parser.cpp"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -243,63 +245,72 @@ enum yysymbol_kind_t
   YYSYMBOL_duplicate_modifier = 86,        /* duplicate_modifier  */
   YYSYMBOL_select_list = 87,               /* select_list  */
   YYSYMBOL_variables = 88,                 /* variables  */
-  YYSYMBOL_construct_query = 89,           /* construct_query  */
-  YYSYMBOL_describe_query = 90,            /* describe_query  */
-  YYSYMBOL_describe_list = 91,             /* describe_list  */
-  YYSYMBOL_var_or_iri_list = 92,           /* var_or_iri_list  */
-  YYSYMBOL_ask_query = 93,                 /* ask_query  */
-  YYSYMBOL_dataset_clause = 94,            /* dataset_clause  */
-  YYSYMBOL_from_clause = 95,               /* from_clause  */
-  YYSYMBOL_where_clause = 96,              /* where_clause  */
-  YYSYMBOL_solution_modifier = 97,         /* solution_modifier  */
-  YYSYMBOL_limit_offset_clause = 98,       /* limit_offset_clause  */
-  YYSYMBOL_order_clause = 99,              /* order_clause  */
-  YYSYMBOL_order_conditions = 100,         /* order_conditions  */
-  YYSYMBOL_order_condition = 101,          /* order_condition  */
-  YYSYMBOL_limit_clause = 102,             /* limit_clause  */
-  YYSYMBOL_offset_clause = 103,            /* offset_clause  */
-  YYSYMBOL_group_graph_pattern = 104,      /* group_graph_pattern  */
-  YYSYMBOL_pattern_lbracket = 105,         /* pattern_lbracket  */
-  YYSYMBOL_pattern_rbracket = 106,         /* pattern_rbracket  */
-  YYSYMBOL_graph_pattern = 107,            /* graph_pattern  */
-  YYSYMBOL_basic_graph_pattern = 108,      /* basic_graph_pattern  */
-  YYSYMBOL_optional_graph_pattern = 109,   /* optional_graph_pattern  */
-  YYSYMBOL_union_graph_pattern = 110,      /* union_graph_pattern  */
-  YYSYMBOL_filter = 111,                   /* filter  */
-  YYSYMBOL_constraint = 112,               /* constraint  */
-  YYSYMBOL_function_call = 113,            /* function_call  */
-  YYSYMBOL_construct_template = 114,       /* construct_template  */
-  YYSYMBOL_construct_lbracket = 115,       /* construct_lbracket  */
-  YYSYMBOL_construct_rbracket = 116,       /* construct_rbracket  */
-  YYSYMBOL_construct_triples = 117,        /* construct_triples  */
-  YYSYMBOL_triples_same_subject = 118,     /* triples_same_subject  */
-  YYSYMBOL_subject1 = 119,                 /* subject1  */
-  YYSYMBOL_subject2 = 120,                 /* subject2  */
-  YYSYMBOL_property_list = 121,            /* property_list  */
-  YYSYMBOL_object_list = 122,              /* object_list  */
-  YYSYMBOL_object = 123,                   /* object  */
-  YYSYMBOL_verb = 124,                     /* verb  */
-  YYSYMBOL_type_element = 125,             /* type_element  */
-  YYSYMBOL_blank_node_property_list = 126, /* blank_node_property_list  */
-  YYSYMBOL_open_square_bracket = 127,      /* open_square_bracket  */
-  YYSYMBOL_var_element = 128,              /* var_element  */
-  YYSYMBOL_iri_element = 129,              /* iri_element  */
-  YYSYMBOL_literal_element = 130,          /* literal_element  */
-  YYSYMBOL_blank_node_element = 131,       /* blank_node_element  */
-  YYSYMBOL_expression_list = 132,          /* expression_list  */
-  YYSYMBOL_expression = 133,               /* expression  */
-  YYSYMBOL_conditional_expression = 134,   /* conditional_expression  */
-  YYSYMBOL_relation_expression = 135,      /* relation_expression  */
-  YYSYMBOL_numeric_expression = 136,       /* numeric_expression  */
-  YYSYMBOL_unary_expression = 137,         /* unary_expression  */
-  YYSYMBOL_primary_expression = 138,       /* primary_expression  */
-  YYSYMBOL_bracketted_expression = 139,    /* bracketted_expression  */
-  YYSYMBOL_built_in_call = 140,            /* built_in_call  */
-  YYSYMBOL_literal = 141,                  /* literal  */
-  YYSYMBOL_rdf_literal = 142,              /* rdf_literal  */
-  YYSYMBOL_numeric_literal = 143,          /* numeric_literal  */
-  YYSYMBOL_boolean_literal = 144,          /* boolean_literal  */
-  YYSYMBOL_iri = 145                       /* iri  */
+  YYSYMBOL_select_variable = 89,           /* select_variable  */
+  YYSYMBOL_aggregate = 90,                 /* aggregate  */
+  YYSYMBOL_aggregate_modifier = 91,        /* aggregate_modifier  */
+  YYSYMBOL_aggregate_argument = 92,        /* aggregate_argument  */
+  YYSYMBOL_as_keyword = 93,                /* as_keyword  */
+  YYSYMBOL_construct_query = 94,           /* construct_query  */
+  YYSYMBOL_describe_query = 95,            /* describe_query  */
+  YYSYMBOL_describe_list = 96,             /* describe_list  */
+  YYSYMBOL_var_or_iri_list = 97,           /* var_or_iri_list  */
+  YYSYMBOL_ask_query = 98,                 /* ask_query  */
+  YYSYMBOL_dataset_clause = 99,            /* dataset_clause  */
+  YYSYMBOL_from_clause = 100,              /* from_clause  */
+  YYSYMBOL_where_clause = 101,             /* where_clause  */
+  YYSYMBOL_solution_modifier = 102,        /* solution_modifier  */
+  YYSYMBOL_order_limit_clause = 103,       /* order_limit_clause  */
+  YYSYMBOL_group_clause = 104,             /* group_clause  */
+  YYSYMBOL_group_keyword = 105,            /* group_keyword  */
+  YYSYMBOL_group_conditions = 106,         /* group_conditions  */
+  YYSYMBOL_limit_offset_clause = 107,      /* limit_offset_clause  */
+  YYSYMBOL_order_clause = 108,             /* order_clause  */
+  YYSYMBOL_order_conditions = 109,         /* order_conditions  */
+  YYSYMBOL_order_condition = 110,          /* order_condition  */
+  YYSYMBOL_limit_clause = 111,             /* limit_clause  */
+  YYSYMBOL_offset_clause = 112,            /* offset_clause  */
+  YYSYMBOL_group_graph_pattern = 113,      /* group_graph_pattern  */
+  YYSYMBOL_pattern_lbracket = 114,         /* pattern_lbracket  */
+  YYSYMBOL_pattern_rbracket = 115,         /* pattern_rbracket  */
+  YYSYMBOL_graph_pattern = 116,            /* graph_pattern  */
+  YYSYMBOL_basic_graph_pattern = 117,      /* basic_graph_pattern  */
+  YYSYMBOL_optional_graph_pattern = 118,   /* optional_graph_pattern  */
+  YYSYMBOL_union_graph_pattern = 119,      /* union_graph_pattern  */
+  YYSYMBOL_filter = 120,                   /* filter  */
+  YYSYMBOL_constraint = 121,               /* constraint  */
+  YYSYMBOL_function_call = 122,            /* function_call  */
+  YYSYMBOL_construct_template = 123,       /* construct_template  */
+  YYSYMBOL_construct_lbracket = 124,       /* construct_lbracket  */
+  YYSYMBOL_construct_rbracket = 125,       /* construct_rbracket  */
+  YYSYMBOL_construct_triples = 126,        /* construct_triples  */
+  YYSYMBOL_triples_same_subject = 127,     /* triples_same_subject  */
+  YYSYMBOL_subject1 = 128,                 /* subject1  */
+  YYSYMBOL_subject2 = 129,                 /* subject2  */
+  YYSYMBOL_property_list = 130,            /* property_list  */
+  YYSYMBOL_object_list = 131,              /* object_list  */
+  YYSYMBOL_object = 132,                   /* object  */
+  YYSYMBOL_verb = 133,                     /* verb  */
+  YYSYMBOL_type_element = 134,             /* type_element  */
+  YYSYMBOL_blank_node_property_list = 135, /* blank_node_property_list  */
+  YYSYMBOL_open_square_bracket = 136,      /* open_square_bracket  */
+  YYSYMBOL_var_element = 137,              /* var_element  */
+  YYSYMBOL_iri_element = 138,              /* iri_element  */
+  YYSYMBOL_literal_element = 139,          /* literal_element  */
+  YYSYMBOL_blank_node_element = 140,       /* blank_node_element  */
+  YYSYMBOL_expression_list = 141,          /* expression_list  */
+  YYSYMBOL_expression = 142,               /* expression  */
+  YYSYMBOL_conditional_expression = 143,   /* conditional_expression  */
+  YYSYMBOL_relation_expression = 144,      /* relation_expression  */
+  YYSYMBOL_numeric_expression = 145,       /* numeric_expression  */
+  YYSYMBOL_unary_expression = 146,         /* unary_expression  */
+  YYSYMBOL_primary_expression = 147,       /* primary_expression  */
+  YYSYMBOL_bracketted_expression = 148,    /* bracketted_expression  */
+  YYSYMBOL_built_in_call = 149,            /* built_in_call  */
+  YYSYMBOL_literal = 150,                  /* literal  */
+  YYSYMBOL_rdf_literal = 151,              /* rdf_literal  */
+  YYSYMBOL_numeric_literal = 152,          /* numeric_literal  */
+  YYSYMBOL_boolean_literal = 153,          /* boolean_literal  */
+  YYSYMBOL_iri = 154                       /* iri  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
@@ -416,7 +427,7 @@ typedef int yytype_uint16;
 
 
 /* Stored state numbers (used for stacks). */
-typedef yytype_uint8 yy_state_t;
+typedef yytype_int16 yy_state_t;
 
 /* State numbers in computations.  */
 typedef int yy_state_fast_t;
@@ -457,12 +468,18 @@ typedef int yy_state_fast_t;
 # define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && ! defined __ICC && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                            \
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
     _Pragma ("GCC diagnostic push")                                     \
     _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
 # define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
@@ -624,16 +641,16 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  7
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   326
+#define YYLAST   348
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  78
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  68
+#define YYNNTS  77
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  157
+#define YYNRULES  172
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  253
+#define YYNSTATES  277
 
 /* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   316
@@ -685,25 +702,27 @@ static const yytype_int8 yytranslate[] =
 };
 
 #if RQDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,   186,   186,   188,   190,   192,   194,   199,   204,   205,
-     210,   211,   215,   223,   233,   235,   240,   246,   248,   249,
-     254,   256,   260,   266,   275,   282,   288,   290,   294,   296,
-     298,   300,   305,   313,   314,   318,   326,   328,   333,   335,
-     337,   342,   344,   346,   348,   353,   357,   359,   363,   370,
-     377,   384,   398,   403,   408,   414,   422,   428,   430,   434,
-     436,   438,   440,   446,   451,   456,   463,   468,   470,   472,
-     477,   487,   498,   504,   511,   516,   518,   523,   529,   535,
-     543,   545,   547,   551,   556,   562,   571,   578,   588,   590,
-     592,   594,   596,   601,   603,   605,   609,   625,   633,   642,
-     659,   670,   681,   698,   707,   714,   722,   727,   735,   743,
-     748,   756,   764,   772,   780,   788,   796,   801,   809,   817,
-     825,   833,   838,   845,   852,   859,   864,   866,   868,   870,
-     879,   888,   900,   905,   917,   924,   931,   938,   946,   954,
-     961,   968,   975,   982,   993,   995,   997,  1002,  1010,  1020,
-    1033,  1039,  1045,  1054,  1060,  1069,  1079,  1089
+       0,   188,   188,   190,   192,   194,   196,   201,   206,   207,
+     212,   213,   217,   225,   235,   237,   242,   265,   267,   268,
+     273,   275,   279,   281,   285,   291,   302,   327,   329,   333,
+     342,   346,   358,   365,   371,   373,   377,   379,   381,   383,
+     388,   396,   397,   401,   409,   411,   416,   418,   422,   424,
+     426,   428,   432,   436,   447,   453,   462,   464,   466,   468,
+     473,   477,   479,   483,   490,   497,   504,   518,   523,   528,
+     534,   542,   549,   551,   555,   557,   559,   561,   567,   572,
+     577,   584,   589,   591,   593,   598,   608,   619,   625,   632,
+     637,   639,   644,   650,   656,   664,   666,   668,   672,   677,
+     683,   692,   699,   709,   711,   713,   715,   717,   722,   724,
+     726,   730,   746,   754,   763,   780,   791,   802,   819,   828,
+     835,   843,   848,   856,   864,   869,   877,   885,   893,   901,
+     909,   917,   922,   930,   938,   946,   954,   959,   966,   973,
+     980,   985,   987,   989,   991,  1000,  1009,  1021,  1026,  1038,
+    1045,  1052,  1059,  1067,  1075,  1082,  1089,  1096,  1103,  1114,
+    1116,  1118,  1123,  1131,  1141,  1154,  1160,  1166,  1175,  1181,
+    1190,  1200,  1210
 };
 #endif
 
@@ -732,19 +751,21 @@ static const char *const yytname[] =
   "'('", "')'", "':'", "'{'", "'}'", "'.'", "';'", "','", "']'", "'['",
   "'_'", "'!'", "$accept", "query", "prologue", "base_declaration",
   "prefix_declaration", "prefix_list", "prefix", "select_query",
-  "duplicate_modifier", "select_list", "variables", "construct_query",
-  "describe_query", "describe_list", "var_or_iri_list", "ask_query",
-  "dataset_clause", "from_clause", "where_clause", "solution_modifier",
-  "limit_offset_clause", "order_clause", "order_conditions",
-  "order_condition", "limit_clause", "offset_clause",
-  "group_graph_pattern", "pattern_lbracket", "pattern_rbracket",
-  "graph_pattern", "basic_graph_pattern", "optional_graph_pattern",
-  "union_graph_pattern", "filter", "constraint", "function_call",
-  "construct_template", "construct_lbracket", "construct_rbracket",
-  "construct_triples", "triples_same_subject", "subject1", "subject2",
-  "property_list", "object_list", "object", "verb", "type_element",
-  "blank_node_property_list", "open_square_bracket", "var_element",
-  "iri_element", "literal_element", "blank_node_element",
+  "duplicate_modifier", "select_list", "variables", "select_variable",
+  "aggregate", "aggregate_modifier", "aggregate_argument", "as_keyword",
+  "construct_query", "describe_query", "describe_list", "var_or_iri_list",
+  "ask_query", "dataset_clause", "from_clause", "where_clause",
+  "solution_modifier", "order_limit_clause", "group_clause",
+  "group_keyword", "group_conditions", "limit_offset_clause",
+  "order_clause", "order_conditions", "order_condition", "limit_clause",
+  "offset_clause", "group_graph_pattern", "pattern_lbracket",
+  "pattern_rbracket", "graph_pattern", "basic_graph_pattern",
+  "optional_graph_pattern", "union_graph_pattern", "filter", "constraint",
+  "function_call", "construct_template", "construct_lbracket",
+  "construct_rbracket", "construct_triples", "triples_same_subject",
+  "subject1", "subject2", "property_list", "object_list", "object", "verb",
+  "type_element", "blank_node_property_list", "open_square_bracket",
+  "var_element", "iri_element", "literal_element", "blank_node_element",
   "expression_list", "expression", "conditional_expression",
   "relation_expression", "numeric_expression", "unary_expression",
   "primary_expression", "bracketted_expression", "built_in_call",
@@ -758,23 +779,7 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 }
 #endif
 
-#ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_int16 yytoknum[] =
-{
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,   297,   298,   299,   300,   301,   302,   303,   304,
-     305,   306,   307,   308,   309,   310,   311,   312,   313,   314,
-     315,    43,    45,    42,    47,   316,    40,    41,    58,   123,
-     125,    46,    59,    44,    93,    91,    95,    33
-};
-#endif
-
-#define YYPACT_NINF (-148)
+#define YYPACT_NINF (-165)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -784,244 +789,260 @@ static const yytype_int16 yytoknum[] =
 #define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-      11,   -56,  -148,    26,   232,    33,  -148,  -148,    75,   -24,
-      64,    43,  -148,  -148,  -148,  -148,    44,  -148,   101,  -148,
-    -148,   -34,  -148,    64,   235,  -148,    -7,  -148,  -148,  -148,
-      39,  -148,    61,    64,    -3,  -148,  -148,    71,    44,  -148,
-    -148,    64,    56,    -7,  -148,  -148,  -148,    97,    22,  -148,
-      57,    57,  -148,    57,  -148,  -148,  -148,  -148,   100,  -148,
-    -148,  -148,    28,   127,  -148,    -7,  -148,  -148,   139,   152,
-      -7,  -148,    41,   149,  -148,   235,  -148,    39,   150,   160,
-    -148,  -148,  -148,   150,     4,  -148,  -148,   153,    95,   207,
-     162,  -148,  -148,  -148,   177,    41,   250,   186,   187,  -148,
-    -148,   146,   230,   267,  -148,  -148,    57,   -16,   211,  -148,
-    -148,  -148,  -148,  -148,  -148,  -148,  -148,  -148,  -148,   231,
-     100,  -148,  -148,   223,   100,  -148,  -148,  -148,    98,  -148,
-    -148,  -148,  -148,  -148,   160,   -10,  -148,   160,   224,   229,
-     229,   229,   234,   236,   229,   229,   229,   229,   238,   144,
-    -148,  -148,  -148,  -148,   -31,  -148,  -148,  -148,   229,   229,
-    -148,    98,  -148,  -148,   211,  -148,  -148,   240,  -148,  -148,
-    -148,   144,   144,  -148,  -148,  -148,  -148,   144,  -148,  -148,
-    -148,  -148,  -148,  -148,   219,   219,   219,  -148,   239,   125,
-    -148,    96,  -148,  -148,  -148,  -148,  -148,  -148,  -148,  -148,
-     -31,  -148,   144,  -148,  -148,  -148,   241,   225,   228,   242,
-    -148,  -148,  -148,  -148,   144,   144,   144,   144,   144,   144,
-     144,   144,   144,   144,   144,   144,     7,  -148,  -148,   144,
-     144,   144,   262,  -148,   218,   218,   218,   218,   218,   218,
-     145,   145,  -148,  -148,  -148,   144,   245,   246,    54,  -148,
-    -148,  -148,  -148
+      17,   -32,  -165,    28,   252,    39,  -165,  -165,   180,    -7,
+      52,   154,  -165,  -165,  -165,  -165,    37,  -165,    95,  -165,
+    -165,    98,  -165,    52,    87,  -165,    -8,  -165,  -165,  -165,
+      24,  -165,    99,    52,   139,  -165,  -165,    42,    37,  -165,
+    -165,   111,    52,   -34,  -165,    -8,  -165,  -165,  -165,   120,
+     128,  -165,   222,   222,  -165,   222,  -165,  -165,  -165,  -165,
+      91,  -165,  -165,  -165,    40,   133,  -165,    -8,  -165,  -165,
+     159,   146,   172,   165,    -8,  -165,    30,   210,  -165,    87,
+    -165,    24,   204,   213,  -165,  -165,  -165,   204,   -22,  -165,
+    -165,   216,    -2,   267,   230,  -165,  -165,  -165,   245,   290,
+    -165,   248,    30,   295,   251,   253,  -165,  -165,  -165,   102,
+     297,  -165,   246,   294,   296,  -165,  -165,   222,    34,   237,
+    -165,  -165,  -165,  -165,  -165,  -165,  -165,  -165,  -165,  -165,
+     209,    91,  -165,  -165,   240,    91,  -165,  -165,  -165,   -29,
+     247,  -165,    90,  -165,  -165,  -165,   257,  -165,  -165,  -165,
+     213,     2,  -165,   213,   249,   250,   250,   250,   254,   255,
+     250,   250,   250,   250,   256,   147,  -165,  -165,  -165,  -165,
+     -35,  -165,  -165,  -165,  -165,  -165,   258,  -165,   250,   250,
+    -165,    90,  -165,  -165,  -165,   261,   237,  -165,  -165,   262,
+    -165,  -165,  -165,   147,   147,  -165,  -165,  -165,  -165,   147,
+    -165,  -165,  -165,  -165,  -165,  -165,   197,   197,   197,  -165,
+     259,   231,  -165,    88,  -165,  -165,  -165,  -165,  -165,  -165,
+    -165,  -165,   -35,  -165,   147,  -165,  -165,  -165,  -165,  -165,
+     260,   263,   264,   265,  -165,  -165,  -165,  -165,   147,   147,
+     147,   147,   147,   147,   147,   147,   147,   147,   147,   147,
+      20,  -165,  -165,   147,   147,   147,   276,  -165,   157,   157,
+     157,   157,   157,   157,   219,   219,  -165,  -165,  -165,   147,
+     266,   268,    92,  -165,  -165,  -165,  -165
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
 static const yytype_uint8 yydefact[] =
 {
        9,     0,     6,     0,     0,    11,     8,     1,    19,     0,
-      34,     0,     2,     3,     4,     5,    15,     7,    10,    17,
-      18,     0,    73,    34,     0,    35,     0,    33,    28,   155,
-       0,    27,     0,    34,    26,    29,    14,     0,    15,    22,
-      21,    34,    20,     0,   103,    99,    98,     0,     0,    75,
-       0,    78,    83,     0,    80,    81,    82,   100,     0,    55,
-      32,    37,     0,     0,   157,     0,    30,    31,     0,     0,
-       0,    23,    40,     0,    74,     0,    72,    96,    77,     0,
-      95,    93,    94,    79,     0,    36,    64,     0,    57,    58,
-       0,   156,    25,    12,     0,    40,     0,     0,     0,    24,
-      39,     0,    41,    42,   102,    76,     0,   147,    84,    86,
-      92,    88,    89,    90,    91,   101,    97,    56,    54,     0,
-       0,    62,    61,     0,     0,    59,    13,    16,     0,    53,
-      52,    38,    43,    44,     0,     0,   148,     0,     0,     0,
+      42,     0,     2,     3,     4,     5,    15,     7,    10,    17,
+      18,     0,    88,    42,     0,    43,     0,    41,    36,   170,
+       0,    35,     0,    42,    34,    37,    14,     0,    15,    24,
+      21,     0,    42,    20,    22,     0,   118,   114,   113,     0,
+       0,    90,     0,    93,    98,     0,    95,    96,    97,   115,
+       0,    70,    40,    45,     0,     0,   172,     0,    38,    39,
+       0,     0,     0,     0,     0,    23,    51,     0,    89,     0,
+      87,   111,    92,     0,   110,   108,   109,    94,     0,    44,
+      79,     0,    72,    73,     0,   171,    33,    12,     0,    28,
+      31,     0,    51,     0,     0,     0,    53,    32,    47,    51,
+       0,    50,    49,    56,    57,   117,    91,     0,   162,    99,
+     101,   107,   103,   104,   105,   106,   116,   112,    71,    69,
+       0,     0,    77,    76,     0,     0,    74,    13,    27,     0,
+       0,    16,     0,    68,    67,    46,     0,    48,    58,    59,
+       0,     0,   163,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,    81,    84,    82,    83,
+       0,    78,    75,    80,    29,    30,     0,    25,     0,     0,
+      66,    60,    61,    65,    54,    52,   100,   164,   102,     0,
+     149,   150,   151,     0,     0,   154,   155,   156,   157,     0,
+     168,   169,   166,   167,   165,   145,     0,     0,     0,   143,
+       0,   121,   124,   131,   136,   140,   141,   142,   146,   159,
+     160,   161,   144,    86,     0,    26,    63,    64,    62,    55,
+       0,     0,     0,     0,   138,   139,   137,   147,     0,     0,
        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
-      66,    69,    67,    68,     0,    63,    60,    65,     0,     0,
-      51,    45,    46,    50,    85,   149,    87,     0,   134,   135,
-     136,     0,     0,   139,   140,   141,   142,     0,   153,   154,
-     151,   152,   150,   130,     0,     0,     0,   128,     0,   106,
-     109,   116,   121,   125,   126,   127,   131,   144,   145,   146,
-     129,    71,     0,    48,    49,    47,     0,     0,     0,     0,
-     123,   124,   122,   132,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,     0,     0,     0,   104,   133,     0,
-       0,     0,   107,   108,   110,   111,   112,   113,   114,   115,
-     117,   118,   119,   120,    70,     0,     0,     0,     0,   105,
-     137,   138,   143
+       0,   119,   148,     0,     0,     0,   122,   123,   125,   126,
+     127,   128,   129,   130,   132,   133,   134,   135,    85,     0,
+       0,     0,     0,   120,   152,   153,   158
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
-    -148,  -148,  -148,  -148,  -148,  -148,   269,  -148,  -148,  -148,
-    -148,  -148,  -148,  -148,  -148,  -148,     8,  -148,   -27,   214,
-     213,  -148,  -148,   155,   215,   217,   -53,  -148,  -148,  -148,
-    -148,  -148,  -148,  -148,   198,  -101,  -148,  -148,  -148,  -148,
-     -42,  -148,  -148,    69,   188,   183,   220,  -148,   -68,  -148,
-     -47,   -43,  -148,   -64,    90,  -147,     0,  -148,   -30,  -148,
-     -37,    85,  -100,  -148,   -62,  -148,  -148,   -11
+    -165,  -165,  -165,  -165,  -165,  -165,   285,  -165,  -165,  -165,
+    -165,   281,  -165,  -165,  -165,  -165,  -165,  -165,  -165,  -165,
+    -165,    15,  -165,   -27,   226,   220,  -165,  -165,  -165,   218,
+    -165,  -165,   150,   225,   221,   -56,  -165,  -165,  -165,  -165,
+    -165,  -165,  -165,   202,  -118,  -165,  -165,  -165,  -165,   -28,
+    -165,  -165,    23,   190,   188,   227,  -165,   -73,  -165,   -50,
+     -46,  -165,   -68,    93,  -164,    46,  -165,    51,  -165,   -94,
+      11,  -116,  -165,   -67,  -165,  -165,   -11
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_uint8 yydefgoto[] =
 {
-       0,     3,     4,     5,    17,    18,    37,    12,    21,    41,
-      42,    13,    14,    33,    34,    15,    26,    27,    60,    99,
-     100,   101,   161,   162,   102,   103,    61,    62,   118,    87,
-      88,   121,    89,   122,   163,   187,    23,    24,    76,    48,
-      49,    50,    51,    78,   108,   109,    79,    80,    52,    53,
-      54,    55,   113,    56,   226,   227,   189,   190,   191,   192,
-     193,   194,   195,   196,   197,   198,   199,   200
+       0,     3,     4,     5,    17,    18,    37,    12,    21,    42,
+      43,    44,    73,   139,   176,   101,    13,    14,    33,    34,
+      15,    26,    27,    62,   107,   108,   109,   110,   185,   111,
+     112,   181,   182,   113,   114,    63,    64,   129,    91,    92,
+     132,    93,   133,   183,   209,    23,    24,    80,    50,    51,
+      52,    53,    82,   119,   120,    83,    84,    54,    55,    56,
+      57,   124,    58,   250,   251,   211,   212,   213,   214,   215,
+     216,   217,   218,   219,   220,   221,   222
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
-static const yytype_uint8 yytable[] =
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int16 yytable[] =
 {
-      35,     6,   188,    81,    81,    85,    81,    82,    82,    86,
-      82,   110,    58,    57,     1,   114,    72,   115,   151,   153,
-      90,   201,    39,    67,   207,   208,     7,   151,   153,    40,
-     209,    43,   111,   105,   135,   202,   112,    16,    92,    57,
-      57,    65,    57,    95,   136,    22,   123,    29,    30,    70,
-      96,    57,     2,    66,    29,    30,    97,    98,    32,    81,
-     151,   153,    59,    82,    57,    32,   110,   155,    57,   110,
-     114,   157,   115,   114,   244,   115,   106,    57,   116,    44,
-     245,    25,   246,   247,    45,    29,    30,   111,    19,    20,
-     111,   112,    74,    75,   112,    57,    32,    59,   249,    28,
-      29,    30,    36,    46,    47,    38,    31,    63,   154,   158,
-     159,    32,    71,    45,    29,    77,   119,   154,   120,    64,
-      83,   252,    84,    57,   165,    32,    57,   245,   138,   139,
-     140,   141,   142,   143,   144,   145,   146,   147,   148,    68,
-     216,   217,   218,   219,   220,   221,    44,   210,   211,   212,
-     154,    45,    29,    30,   160,    29,    30,   222,   223,   224,
-     225,    97,    98,    32,   149,    73,    32,   214,   215,    59,
-      46,    47,   178,   179,   138,   139,   140,   141,   142,   143,
-     144,   145,   146,   147,   148,    91,   234,   235,   236,   237,
-     238,   239,   240,   241,   242,   243,    93,   180,   181,   182,
-     183,    29,    30,   107,   152,   184,   185,   104,   224,   225,
-     149,    44,    32,   152,   232,   233,    45,    29,    30,   107,
-      94,   186,   106,   117,   168,   169,   170,   124,    32,   173,
-     174,   175,   176,   125,   126,    46,    47,     8,     9,    10,
-      11,   129,   130,   203,   204,    97,   152,   178,   179,   138,
-     139,   140,   141,   142,   143,   144,   145,   146,   147,   148,
-     128,   138,   139,   140,   141,   142,   143,   144,   145,   146,
-     147,   148,   180,   181,   182,   183,    29,    30,   107,   222,
-     223,   224,   225,    98,   137,   149,    44,    32,    29,    30,
-     167,    45,    29,    30,   156,   149,   206,   149,   229,    32,
-     171,   230,   172,    32,   177,   215,   213,    69,   228,   127,
-      46,    47,   250,   251,   131,   231,   205,   150,   133,   132,
-     166,   248,   164,     0,     0,     0,   134
+      35,   210,    85,    85,    89,    85,    86,    86,    90,    86,
+     121,    60,   167,    59,   169,   125,   126,   223,    76,   130,
+       1,   131,    39,    69,   167,     6,   169,   174,     7,   231,
+     232,   224,    41,   122,   175,   233,    94,   123,    45,   103,
+      96,    59,    59,    16,    59,   104,   105,   102,    67,    46,
+     117,   116,   127,    59,    47,    29,    30,    74,     2,    29,
+      30,    61,    22,   167,   134,   169,    32,    85,    59,    25,
+      32,    86,    59,    48,    49,   171,    87,   121,    88,   173,
+     121,    59,   125,   126,   151,   125,   126,   268,   106,   270,
+     271,    46,    65,   269,   152,    36,    47,    29,    30,    38,
+     122,   178,   179,   122,   123,   273,    59,   123,    32,    61,
+      70,   103,   234,   235,   236,    48,    49,   104,   105,   170,
+     154,   155,   156,   157,   158,   159,   160,   161,   162,   163,
+     164,   170,   240,   241,   242,   243,   244,   245,    46,    59,
+     187,   168,    59,    47,    29,    30,   180,    29,    30,   246,
+     247,   248,   249,   168,    39,    32,   165,    66,    32,   276,
+      61,    40,    48,    49,    41,   269,   190,   191,   192,    72,
+     170,   195,   196,   197,   198,   200,   201,   154,   155,   156,
+     157,   158,   159,   160,   161,   162,   163,   164,    77,   226,
+     227,    95,   168,    19,    20,    68,    29,    30,    78,    79,
+     202,   203,   204,   205,    29,    30,   118,    32,   206,   207,
+      28,    29,    30,   165,    98,    32,    97,    31,   246,   247,
+     248,   249,    32,   100,   208,   200,   201,   154,   155,   156,
+     157,   158,   159,   160,   161,   162,   163,   164,    99,   154,
+     155,   156,   157,   158,   159,   160,   161,   162,   163,   164,
+     202,   203,   204,   205,    29,    30,   118,     8,     9,    10,
+      11,   104,   105,   165,    46,    32,    29,    30,   115,    47,
+      29,    30,   118,   238,   239,   165,   117,    32,    47,    29,
+      81,    32,   248,   249,   256,   257,   128,   135,    48,    49,
+      32,   258,   259,   260,   261,   262,   263,   264,   265,   266,
+     267,   136,   137,   138,   140,   142,   143,   146,   144,   104,
+     153,   172,   105,   184,   177,   189,   165,   229,   230,   239,
+     193,   194,   199,    71,    75,   225,   237,   252,   141,   145,
+     147,   228,   166,   274,   148,   275,   253,   254,   255,   149,
+     186,   188,     0,     0,   150,     0,     0,     0,   272
 };
 
 static const yytype_int16 yycheck[] =
 {
-      11,    57,   149,    50,    51,    58,    53,    50,    51,    62,
-      53,    79,    19,    24,     3,    79,    43,    79,   119,   119,
-      62,    52,    56,    34,   171,   172,     0,   128,   128,    63,
-     177,    23,    79,    75,    50,    66,    79,     4,    65,    50,
-      51,    33,    53,    70,    60,    69,    88,    57,    58,    41,
-       9,    62,    41,    56,    57,    58,    15,    16,    68,   106,
-     161,   161,    69,   106,    75,    68,   134,   120,    79,   137,
-     134,   124,   134,   137,    67,   137,    72,    88,    74,    51,
-      73,    17,   229,   230,    56,    57,    58,   134,    13,    14,
-     137,   134,    70,    71,   137,   106,    68,    69,   245,    56,
-      57,    58,    58,    75,    76,     4,    63,    68,   119,    11,
-      12,    68,    56,    56,    57,    58,    21,   128,    23,    58,
-      51,    67,    53,   134,   135,    68,   137,    73,    30,    31,
-      32,    33,    34,    35,    36,    37,    38,    39,    40,    68,
-      44,    45,    46,    47,    48,    49,    51,   184,   185,   186,
-     161,    56,    57,    58,    56,    57,    58,    61,    62,    63,
-      64,    15,    16,    68,    66,    68,    68,    42,    43,    69,
-      75,    76,    28,    29,    30,    31,    32,    33,    34,    35,
-      36,    37,    38,    39,    40,    58,   216,   217,   218,   219,
-     220,   221,   222,   223,   224,   225,    57,    53,    54,    55,
-      56,    57,    58,    59,   119,    61,    62,    58,    63,    64,
-      66,    51,    68,   128,   214,   215,    56,    57,    58,    59,
-      68,    77,    72,    70,   139,   140,   141,    20,    68,   144,
-     145,   146,   147,    71,    57,    75,    76,     5,     6,     7,
-       8,    55,    55,   158,   159,    15,   161,    28,    29,    30,
+      11,   165,    52,    53,    60,    55,    52,    53,    64,    55,
+      83,    19,   130,    24,   130,    83,    83,    52,    45,    21,
+       3,    23,    56,    34,   142,    57,   142,    56,     0,   193,
+     194,    66,    66,    83,    63,   199,    64,    83,    23,     9,
+      67,    52,    53,     4,    55,    15,    16,    74,    33,    51,
+      72,    79,    74,    64,    56,    57,    58,    42,    41,    57,
+      58,    69,    69,   181,    92,   181,    68,   117,    79,    17,
+      68,   117,    83,    75,    76,   131,    53,   150,    55,   135,
+     153,    92,   150,   150,    50,   153,   153,    67,    58,   253,
+     254,    51,    68,    73,    60,    58,    56,    57,    58,     4,
+     150,    11,    12,   153,   150,   269,   117,   153,    68,    69,
+      68,     9,   206,   207,   208,    75,    76,    15,    16,   130,
+      30,    31,    32,    33,    34,    35,    36,    37,    38,    39,
+      40,   142,    44,    45,    46,    47,    48,    49,    51,   150,
+     151,   130,   153,    56,    57,    58,    56,    57,    58,    61,
+      62,    63,    64,   142,    56,    68,    66,    58,    68,    67,
+      69,    63,    75,    76,    66,    73,   155,   156,   157,    58,
+     181,   160,   161,   162,   163,    28,    29,    30,    31,    32,
+      33,    34,    35,    36,    37,    38,    39,    40,    68,   178,
+     179,    58,   181,    13,    14,    56,    57,    58,    70,    71,
+      53,    54,    55,    56,    57,    58,    59,    68,    61,    62,
+      56,    57,    58,    66,    68,    68,    57,    63,    61,    62,
+      63,    64,    68,    58,    77,    28,    29,    30,    31,    32,
+      33,    34,    35,    36,    37,    38,    39,    40,    66,    30,
       31,    32,    33,    34,    35,    36,    37,    38,    39,    40,
-      10,    30,    31,    32,    33,    34,    35,    36,    37,    38,
-      39,    40,    53,    54,    55,    56,    57,    58,    59,    61,
-      62,    63,    64,    16,    73,    66,    51,    68,    57,    58,
-      66,    56,    57,    58,    71,    66,    56,    66,    73,    68,
-      66,    73,    66,    68,    66,    43,    67,    38,    67,    95,
-      75,    76,    67,    67,   101,    73,   161,   119,   103,   102,
-     137,   231,   134,    -1,    -1,    -1,   106
+      53,    54,    55,    56,    57,    58,    59,     5,     6,     7,
+       8,    15,    16,    66,    51,    68,    57,    58,    58,    56,
+      57,    58,    59,    42,    43,    66,    72,    68,    56,    57,
+      58,    68,    63,    64,   238,   239,    70,    20,    75,    76,
+      68,   240,   241,   242,   243,   244,   245,   246,   247,   248,
+     249,    71,    57,    13,    56,    10,    55,    10,    55,    15,
+      73,    71,    16,    56,    67,    66,    66,    56,    56,    43,
+      66,    66,    66,    38,    43,    67,    67,    67,   102,   109,
+     112,   181,   130,    67,   113,    67,    73,    73,    73,   114,
+     150,   153,    -1,    -1,   117,    -1,    -1,    -1,   255
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
 static const yytype_uint8 yystos[] =
 {
        0,     3,    41,    79,    80,    81,    57,     0,     5,     6,
-       7,     8,    85,    89,    90,    93,     4,    82,    83,    13,
-      14,    86,    69,   114,   115,    17,    94,    95,    56,    57,
-      58,    63,    68,    91,    92,   145,    58,    84,     4,    56,
-      63,    87,    88,    94,    51,    56,    75,    76,   117,   118,
-     119,   120,   126,   127,   128,   129,   131,   145,    19,    69,
-      96,   104,   105,    68,    58,    94,    56,   145,    68,    84,
-      94,    56,    96,    68,    70,    71,   116,    58,   121,   124,
-     125,   128,   129,   121,   121,   104,   104,   107,   108,   110,
-     118,    58,    96,    57,    68,    96,     9,    15,    16,    97,
-      98,    99,   102,   103,    58,   118,    72,    59,   122,   123,
-     126,   128,   129,   130,   131,   142,    74,    70,   106,    21,
-      23,   109,   111,   118,    20,    71,    57,    97,    10,    55,
-      55,    98,   103,   102,   124,    50,    60,    73,    30,    31,
-      32,    33,    34,    35,    36,    37,    38,    39,    40,    66,
-     112,   113,   139,   140,   145,   104,    71,   104,    11,    12,
-      56,   100,   101,   112,   122,   145,   123,    66,   139,   139,
-     139,    66,    66,   139,   139,   139,   139,    66,    28,    29,
-      53,    54,    55,    56,    61,    62,    77,   113,   133,   134,
-     135,   136,   137,   138,   139,   140,   141,   142,   143,   144,
-     145,    52,    66,   139,   139,   101,    56,   133,   133,   133,
-     138,   138,   138,    67,    42,    43,    44,    45,    46,    47,
-      48,    49,    61,    62,    63,    64,   132,   133,    67,    73,
-      73,    73,   134,   134,   136,   136,   136,   136,   136,   136,
-     136,   136,   136,   136,    67,    73,   133,   133,   132,   133,
-      67,    67,    67
+       7,     8,    85,    94,    95,    98,     4,    82,    83,    13,
+      14,    86,    69,   123,   124,    17,    99,   100,    56,    57,
+      58,    63,    68,    96,    97,   154,    58,    84,     4,    56,
+      63,    66,    87,    88,    89,    99,    51,    56,    75,    76,
+     126,   127,   128,   129,   135,   136,   137,   138,   140,   154,
+      19,    69,   101,   113,   114,    68,    58,    99,    56,   154,
+      68,    84,    58,    90,    99,    89,   101,    68,    70,    71,
+     125,    58,   130,   133,   134,   137,   138,   130,   130,   113,
+     113,   116,   117,   119,   127,    58,   101,    57,    68,    66,
+      58,    93,   101,     9,    15,    16,    58,   102,   103,   104,
+     105,   107,   108,   111,   112,    58,   127,    72,    59,   131,
+     132,   135,   137,   138,   139,   140,   151,    74,    70,   115,
+      21,    23,   118,   120,   127,    20,    71,    57,    13,    91,
+      56,   102,    10,    55,    55,   103,    10,   107,   112,   111,
+     133,    50,    60,    73,    30,    31,    32,    33,    34,    35,
+      36,    37,    38,    39,    40,    66,   121,   122,   148,   149,
+     154,   113,    71,   113,    56,    63,    92,    67,    11,    12,
+      56,   109,   110,   121,    56,   106,   131,   154,   132,    66,
+     148,   148,   148,    66,    66,   148,   148,   148,   148,    66,
+      28,    29,    53,    54,    55,    56,    61,    62,    77,   122,
+     142,   143,   144,   145,   146,   147,   148,   149,   150,   151,
+     152,   153,   154,    52,    66,    67,   148,   148,   110,    56,
+      56,   142,   142,   142,   147,   147,   147,    67,    42,    43,
+      44,    45,    46,    47,    48,    49,    61,    62,    63,    64,
+     141,   142,    67,    73,    73,    73,   143,   143,   145,   145,
+     145,   145,   145,   145,   145,   145,   145,   145,    67,    73,
+     142,   142,   141,   142,    67,    67,    67
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_uint8 yyr1[] =
 {
        0,    78,    79,    79,    79,    79,    79,    80,    81,    81,
       82,    82,    83,    83,    84,    84,    85,    86,    86,    86,
-      87,    87,    88,    88,    89,    90,    91,    91,    92,    92,
-      92,    92,    93,    94,    94,    95,    96,    96,    97,    97,
-      97,    98,    98,    98,    98,    99,   100,   100,   101,   101,
-     101,   101,   102,   103,   104,   105,   106,   107,   107,   108,
-     108,   108,   108,   109,   110,   110,   111,   112,   112,   112,
-     113,   113,   114,   115,   116,   117,   117,   118,   118,   118,
-     119,   119,   119,   120,   121,   121,   122,   122,   123,   123,
-     123,   123,   123,   124,   124,   124,   125,   126,   127,   128,
-     129,   130,   131,   131,   132,   132,   133,   134,   134,   134,
-     135,   135,   135,   135,   135,   135,   135,   136,   136,   136,
-     136,   136,   137,   137,   137,   137,   138,   138,   138,   138,
-     138,   138,   139,   140,   140,   140,   140,   140,   140,   140,
-     140,   140,   140,   140,   141,   141,   141,   142,   142,   142,
-     143,   143,   143,   144,   144,   145,   145,   145
+      87,    87,    88,    88,    89,    89,    90,    91,    91,    92,
+      92,    93,    94,    95,    96,    96,    97,    97,    97,    97,
+      98,    99,    99,   100,   101,   101,   102,   102,   103,   103,
+     103,   103,   104,   105,   106,   106,   107,   107,   107,   107,
+     108,   109,   109,   110,   110,   110,   110,   111,   112,   113,
+     114,   115,   116,   116,   117,   117,   117,   117,   118,   119,
+     119,   120,   121,   121,   121,   122,   122,   123,   124,   125,
+     126,   126,   127,   127,   127,   128,   128,   128,   129,   130,
+     130,   131,   131,   132,   132,   132,   132,   132,   133,   133,
+     133,   134,   135,   136,   137,   138,   139,   140,   140,   141,
+     141,   142,   143,   143,   143,   144,   144,   144,   144,   144,
+     144,   144,   145,   145,   145,   145,   145,   146,   146,   146,
+     146,   147,   147,   147,   147,   147,   147,   148,   149,   149,
+     149,   149,   149,   149,   149,   149,   149,   149,   149,   150,
+     150,   150,   151,   151,   151,   152,   152,   152,   153,   153,
+     154,   154,   154
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     2,     2,     2,     2,     1,     2,     2,     0,
        1,     0,     4,     5,     1,     0,     6,     1,     1,     0,
-       1,     1,     1,     2,     5,     4,     1,     1,     1,     1,
-       2,     2,     3,     1,     0,     1,     2,     1,     2,     1,
-       0,     1,     1,     2,     2,     3,     1,     2,     2,     2,
-       1,     1,     2,     2,     3,     1,     1,     1,     1,     2,
-       3,     2,     2,     2,     1,     3,     2,     1,     1,     1,
-       4,     2,     3,     1,     1,     1,     3,     2,     1,     2,
-       1,     1,     1,     1,     2,     4,     1,     3,     1,     1,
-       1,     1,     1,     1,     1,     1,     1,     3,     1,     1,
-       1,     1,     3,     1,     1,     3,     1,     3,     3,     1,
-       3,     3,     3,     3,     3,     3,     1,     3,     3,     3,
-       3,     1,     2,     2,     2,     1,     1,     1,     1,     1,
-       1,     1,     3,     4,     2,     2,     2,     6,     6,     2,
-       2,     2,     2,     6,     1,     1,     1,     1,     2,     3,
-       1,     1,     1,     1,     1,     1,     3,     2
+       1,     1,     1,     2,     1,     5,     5,     1,     0,     1,
+       1,     1,     5,     4,     1,     1,     1,     1,     2,     2,
+       3,     1,     0,     1,     2,     1,     2,     1,     2,     1,
+       1,     0,     3,     1,     1,     2,     1,     1,     2,     2,
+       3,     1,     2,     2,     2,     1,     1,     2,     2,     3,
+       1,     1,     1,     1,     2,     3,     2,     2,     2,     1,
+       3,     2,     1,     1,     1,     4,     2,     3,     1,     1,
+       1,     3,     2,     1,     2,     1,     1,     1,     1,     2,
+       4,     1,     3,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     3,     1,     1,     1,     1,     3,     1,     1,
+       3,     1,     3,     3,     1,     3,     3,     3,     3,     3,
+       3,     1,     3,     3,     3,     3,     1,     2,     2,     2,
+       1,     1,     1,     1,     1,     1,     1,     3,     4,     2,
+       2,     2,     6,     6,     2,     2,     2,     2,     6,     1,
+       1,     1,     1,     2,     3,     1,     1,     1,     1,     1,
+       1,     3,     2
 };
 
 
@@ -1033,6 +1054,7 @@ enum { YYENOMEM = -2 };
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
@@ -1100,12 +1122,19 @@ do {                                            \
 } while (0)
 
 
-/* YY_LOCATION_PRINT -- Print the location on the stream.
+/* YYLOCATION_PRINT -- Print the location on the stream.
    This macro was not mandated originally: define only if we know
    we won't break user code: when these are the locations we know.  */
 
-# ifndef YY_LOCATION_PRINT
-#  if defined RQLTYPE_IS_TRIVIAL && RQLTYPE_IS_TRIVIAL
+# ifndef YYLOCATION_PRINT
+
+#  if defined YY_LOCATION_PRINT
+
+   /* Temporary convenience wrapper in case some people defined the
+      undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YYLOCATION_PRINT(File, Loc)  YY_LOCATION_PRINT(File, *(Loc))
+
+#  elif defined RQLTYPE_IS_TRIVIAL && RQLTYPE_IS_TRIVIAL
 
 /* Print *YYLOCP on YYO.  Private, do not rely on its existence. */
 
@@ -1133,15 +1162,23 @@ yy_location_print_ (FILE *yyo, YYLTYPE const * const yylocp)
         res += YYFPRINTF (yyo, "-%d", end_col);
     }
   return res;
- }
+}
 
-#   define YY_LOCATION_PRINT(File, Loc)          \
-  yy_location_print_ (File, &(Loc))
+#   define YYLOCATION_PRINT  yy_location_print_
+
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT(File, Loc)  YYLOCATION_PRINT(File, &(Loc))
 
 #  else
-#   define YY_LOCATION_PRINT(File, Loc) ((void) 0)
+
+#   define YYLOCATION_PRINT(File, Loc) ((void) 0)
+    /* Temporary convenience wrapper in case some people defined the
+       undocumented and private YY_LOCATION_PRINT macros.  */
+#   define YY_LOCATION_PRINT  YYLOCATION_PRINT
+
 #  endif
-# endif /* !defined YY_LOCATION_PRINT */
+# endif /* !defined YYLOCATION_PRINT */
 
 
 # define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
@@ -1172,10 +1209,6 @@ yy_symbol_value_print (FILE *yyo,
   YY_USE (query_graph);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yykind < YYNTOKENS)
-    YYPRINT (yyo, yytoknum[yykind], *yyvaluep);
-# endif
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
@@ -1193,7 +1226,7 @@ yy_symbol_print (FILE *yyo,
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  YY_LOCATION_PRINT (yyo, *yylocationp);
+  YYLOCATION_PRINT (yyo, yylocationp);
   YYFPRINTF (yyo, ": ");
   yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp, scanner, context, query_graph);
   YYFPRINTF (yyo, ")");
@@ -1575,87 +1608,87 @@ yydestruct (const char *yymsg,
   switch (yykind)
     {
     case YYSYMBOL_DECIMAL: /* DECIMAL  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1581 "sparql_parser.cpp"
+#line 1614 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_DOUBLE: /* DOUBLE  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1587 "sparql_parser.cpp"
+#line 1620 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_INTEGER: /* INTEGER  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1593 "sparql_parser.cpp"
+#line 1626 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_VARIABLE: /* VARIABLE  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1599 "sparql_parser.cpp"
+#line 1632 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_IRI: /* IRI  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1605 "sparql_parser.cpp"
+#line 1638 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_IDENTIFIER: /* IDENTIFIER  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1611 "sparql_parser.cpp"
+#line 1644 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_STRING: /* STRING  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1617 "sparql_parser.cpp"
+#line 1650 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_LANGTAG: /* LANGTAG  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1623 "sparql_parser.cpp"
+#line 1656 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_prefix: /* prefix  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1629 "sparql_parser.cpp"
+#line 1662 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_literal: /* literal  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1635 "sparql_parser.cpp"
+#line 1668 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_rdf_literal: /* rdf_literal  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1641 "sparql_parser.cpp"
+#line 1674 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_numeric_literal: /* numeric_literal  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1647 "sparql_parser.cpp"
+#line 1680 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_boolean_literal: /* boolean_literal  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1653 "sparql_parser.cpp"
+#line 1686 "sparql_parser.cpp"
         break;
 
     case YYSYMBOL_iri: /* iri  */
-#line 158 "sparql_parser.y"
+#line 160 "sparql_parser.y"
             { free(((*yyvaluep).strval)); }
-#line 1659 "sparql_parser.cpp"
+#line 1692 "sparql_parser.cpp"
         break;
 
       default:
@@ -1749,6 +1782,7 @@ YYLTYPE yylloc = yyloc_default;
   YYDPRINTF ((stderr, "Starting parse\n"));
 
   yychar = RQEMPTY; /* Cause a token to be read.  */
+
   yylsp[0] = yylloc;
   goto yysetstate;
 
@@ -1775,7 +1809,7 @@ yysetstate:
 
   if (yyss + yystacksize - 1 <= yyssp)
 #if !defined yyoverflow && !defined YYSTACK_RELOCATE
-    goto yyexhaustedlab;
+    YYNOMEM;
 #else
     {
       /* Get the current used size of the three stacks, in elements.  */
@@ -1806,7 +1840,7 @@ yysetstate:
 # else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
@@ -1817,7 +1851,7 @@ yysetstate:
           YY_CAST (union yyalloc *,
                    YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
         YYSTACK_RELOCATE (yyls_alloc, yyls);
@@ -1841,6 +1875,7 @@ yysetstate:
     }
 #endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
+
   if (yystate == YYFINAL)
     YYACCEPT;
 
@@ -1957,43 +1992,43 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* query: prologue select_query  */
-#line 186 "sparql_parser.y"
+#line 188 "sparql_parser.y"
                         { YYACCEPT; }
-#line 1963 "sparql_parser.cpp"
+#line 1998 "sparql_parser.cpp"
     break;
 
   case 3: /* query: prologue construct_query  */
-#line 188 "sparql_parser.y"
+#line 190 "sparql_parser.y"
                            { YYACCEPT; }
-#line 1969 "sparql_parser.cpp"
+#line 2004 "sparql_parser.cpp"
     break;
 
   case 4: /* query: prologue describe_query  */
-#line 190 "sparql_parser.y"
+#line 192 "sparql_parser.y"
                           { YYACCEPT; }
-#line 1975 "sparql_parser.cpp"
+#line 2010 "sparql_parser.cpp"
     break;
 
   case 5: /* query: prologue ask_query  */
-#line 192 "sparql_parser.y"
+#line 194 "sparql_parser.y"
                      { YYACCEPT; }
-#line 1981 "sparql_parser.cpp"
+#line 2016 "sparql_parser.cpp"
     break;
 
   case 6: /* query: END_OF_FILE  */
-#line 194 "sparql_parser.y"
+#line 196 "sparql_parser.y"
               { YYABORT; }
-#line 1987 "sparql_parser.cpp"
+#line 2022 "sparql_parser.cpp"
     break;
 
   case 8: /* base_declaration: BASE IRI  */
-#line 204 "sparql_parser.y"
+#line 206 "sparql_parser.y"
            { context->base = (yyvsp[0].strval); free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 1993 "sparql_parser.cpp"
+#line 2028 "sparql_parser.cpp"
     break;
 
   case 12: /* prefix_list: PREFIX prefix ':' IRI  */
-#line 215 "sparql_parser.y"
+#line 217 "sparql_parser.y"
                         {
     context->prefixes[(yyvsp[-2].strval)] = (yyvsp[0].strval);
     free((yyvsp[-2].strval));
@@ -2001,11 +2036,11 @@ yyreduce:
     free((yyvsp[0].strval));
     (yyvsp[0].strval) = nullptr;
   }
-#line 2005 "sparql_parser.cpp"
+#line 2040 "sparql_parser.cpp"
     break;
 
   case 13: /* prefix_list: prefix_list PREFIX prefix ':' IRI  */
-#line 223 "sparql_parser.y"
+#line 225 "sparql_parser.y"
                                     {
     context->prefixes[(yyvsp[-2].strval)] = (yyvsp[0].strval);
     free((yyvsp[-2].strval));
@@ -2013,183 +2048,312 @@ yyreduce:
     free((yyvsp[0].strval));
     (yyvsp[0].strval) = nullptr;
   }
-#line 2017 "sparql_parser.cpp"
+#line 2052 "sparql_parser.cpp"
     break;
 
   case 14: /* prefix: IDENTIFIER  */
-#line 233 "sparql_parser.y"
+#line 235 "sparql_parser.y"
              { (yyval.strval) = (yyvsp[0].strval); }
-#line 2023 "sparql_parser.cpp"
+#line 2058 "sparql_parser.cpp"
     break;
 
   case 15: /* prefix: %empty  */
-#line 235 "sparql_parser.y"
+#line 237 "sparql_parser.y"
               { (yyval.strval) = strdup(""); }
-#line 2029 "sparql_parser.cpp"
+#line 2064 "sparql_parser.cpp"
     break;
 
   case 16: /* select_query: SELECT duplicate_modifier select_list dataset_clause where_clause solution_modifier  */
-#line 240 "sparql_parser.y"
+#line 242 "sparql_parser.y"
                                                                                       {
     query_graph->setQueryForm(SelectQuery);
+    // with aggregates, a solution is a group, so only its keys and
+    // aggregates can be projected
+    if(!query_graph->group_by.empty() || !query_graph->aggregations.empty()) {
+      std::unordered_set<std::string> grouped;
+      for(int i=0; i<query_graph->group_by.size(); i++) {
+        grouped.insert(query_graph->group_by[i].value);
+      }
+      for(int i=0; i<query_graph->aggregations.size(); i++) {
+        grouped.insert(query_graph->aggregations[i].variable.value);
+      }
+      for(int i=0; i<query_graph->projection.size(); i++) {
+        if(!grouped.count(query_graph->projection[i].value)) {
+          yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, projected variable is neither grouped nor aggregated"));
+          YYERROR;
+        }
+      }
+    }
   }
-#line 2037 "sparql_parser.cpp"
+#line 2089 "sparql_parser.cpp"
     break;
 
   case 17: /* duplicate_modifier: DISTINCT  */
-#line 246 "sparql_parser.y"
+#line 265 "sparql_parser.y"
            { query_graph->setDuplicateModifier(Distinct); }
-#line 2043 "sparql_parser.cpp"
+#line 2095 "sparql_parser.cpp"
     break;
 
   case 18: /* duplicate_modifier: REDUCED  */
-#line 248 "sparql_parser.y"
+#line 267 "sparql_parser.y"
           { query_graph->setDuplicateModifier(Reduced); }
-#line 2049 "sparql_parser.cpp"
+#line 2101 "sparql_parser.cpp"
     break;
 
   case 21: /* select_list: '*'  */
-#line 256 "sparql_parser.y"
+#line 275 "sparql_parser.y"
       { context->all_variables = true; }
-#line 2055 "sparql_parser.cpp"
+#line 2107 "sparql_parser.cpp"
     break;
 
-  case 22: /* variables: VARIABLE  */
-#line 260 "sparql_parser.y"
+  case 24: /* select_variable: VARIABLE  */
+#line 285 "sparql_parser.y"
            {
     query_graph->addProjection((yyvsp[0].strval));
     free((yyvsp[0].strval));
     (yyvsp[0].strval) = nullptr;
   }
-#line 2065 "sparql_parser.cpp"
+#line 2117 "sparql_parser.cpp"
     break;
 
-  case 23: /* variables: variables VARIABLE  */
-#line 266 "sparql_parser.y"
-                     {
-    query_graph->addProjection((yyvsp[0].strval));
+  case 25: /* select_variable: '(' aggregate as_keyword VARIABLE ')'  */
+#line 291 "sparql_parser.y"
+                                        {
+    context->aggregation.variable.value = (yyvsp[-1].strval);
+    query_graph->addAggregation(context->aggregation);
+    query_graph->addProjection((yyvsp[-1].strval));
+    free((yyvsp[-1].strval));
+    (yyvsp[-1].strval) = nullptr;
+  }
+#line 2129 "sparql_parser.cpp"
+    break;
+
+  case 26: /* aggregate: IDENTIFIER '(' aggregate_modifier aggregate_argument ')'  */
+#line 302 "sparql_parser.y"
+                                                           {
+    if(strcasecmp((yyvsp[-4].strval), "COUNT") == 0) {
+      context->aggregation.function = Aggregation::Count;
+    } else if(strcasecmp((yyvsp[-4].strval), "SUM") == 0) {
+      context->aggregation.function = Aggregation::Sum;
+    } else if(strcasecmp((yyvsp[-4].strval), "MIN") == 0) {
+      context->aggregation.function = Aggregation::Min;
+    } else if(strcasecmp((yyvsp[-4].strval), "MAX") == 0) {
+      context->aggregation.function = Aggregation::Max;
+    } else if(strcasecmp((yyvsp[-4].strval), "AVG") == 0) {
+      context->aggregation.function = Aggregation::Avg;
+    } else {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting COUNT, SUM, MIN, MAX or AVG"));
+      YYERROR;
+    }
+    if(context->aggregation.argument == nullptr && (context->aggregation.function != Aggregation::Count || context->aggregation.distinct)) {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, '*' is only supported by COUNT without DISTINCT"));
+      YYERROR;
+    }
+    free((yyvsp[-4].strval));
+    (yyvsp[-4].strval) = nullptr;
+  }
+#line 2156 "sparql_parser.cpp"
+    break;
+
+  case 27: /* aggregate_modifier: DISTINCT  */
+#line 327 "sparql_parser.y"
+           { context->aggregation.distinct = true; }
+#line 2162 "sparql_parser.cpp"
+    break;
+
+  case 28: /* aggregate_modifier: %empty  */
+#line 329 "sparql_parser.y"
+              { context->aggregation.distinct = false; }
+#line 2168 "sparql_parser.cpp"
+    break;
+
+  case 29: /* aggregate_argument: VARIABLE  */
+#line 333 "sparql_parser.y"
+           {
+    QueryExpression* exp = query_graph->createExpression();
+    exp->type = QueryExpression::Variable;
+    exp->value = (yyvsp[0].strval);
+    context->aggregation.argument = exp;
     free((yyvsp[0].strval));
     (yyvsp[0].strval) = nullptr;
   }
-#line 2075 "sparql_parser.cpp"
+#line 2181 "sparql_parser.cpp"
     break;
 
-  case 24: /* construct_query: CONSTRUCT construct_template dataset_clause where_clause solution_modifier  */
-#line 275 "sparql_parser.y"
+  case 30: /* aggregate_argument: '*'  */
+#line 342 "sparql_parser.y"
+      { context->aggregation.argument = nullptr; }
+#line 2187 "sparql_parser.cpp"
+    break;
+
+  case 31: /* as_keyword: IDENTIFIER  */
+#line 346 "sparql_parser.y"
+             {
+    if(strcasecmp((yyvsp[0].strval), "AS") != 0) {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting AS"));
+      YYERROR;
+    }
+    free((yyvsp[0].strval));
+    (yyvsp[0].strval) = nullptr;
+  }
+#line 2200 "sparql_parser.cpp"
+    break;
+
+  case 32: /* construct_query: CONSTRUCT construct_template dataset_clause where_clause solution_modifier  */
+#line 358 "sparql_parser.y"
                                                                              {
     query_graph->setQueryForm(ConstructQuery);
   }
-#line 2083 "sparql_parser.cpp"
+#line 2208 "sparql_parser.cpp"
     break;
 
-  case 25: /* describe_query: DESCRIBE describe_list dataset_clause where_clause  */
-#line 282 "sparql_parser.y"
+  case 33: /* describe_query: DESCRIBE describe_list dataset_clause where_clause  */
+#line 365 "sparql_parser.y"
                                                      {
     query_graph->setQueryForm(DescribeQuery);
   }
-#line 2091 "sparql_parser.cpp"
+#line 2216 "sparql_parser.cpp"
     break;
 
-  case 27: /* describe_list: '*'  */
-#line 290 "sparql_parser.y"
+  case 35: /* describe_list: '*'  */
+#line 373 "sparql_parser.y"
       { context->all_variables = true; }
-#line 2097 "sparql_parser.cpp"
+#line 2222 "sparql_parser.cpp"
     break;
 
-  case 28: /* var_or_iri_list: VARIABLE  */
-#line 294 "sparql_parser.y"
+  case 36: /* var_or_iri_list: VARIABLE  */
+#line 377 "sparql_parser.y"
            { free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 2103 "sparql_parser.cpp"
+#line 2228 "sparql_parser.cpp"
     break;
 
-  case 29: /* var_or_iri_list: iri  */
-#line 296 "sparql_parser.y"
+  case 37: /* var_or_iri_list: iri  */
+#line 379 "sparql_parser.y"
       { free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 2109 "sparql_parser.cpp"
+#line 2234 "sparql_parser.cpp"
     break;
 
-  case 30: /* var_or_iri_list: var_or_iri_list VARIABLE  */
-#line 298 "sparql_parser.y"
+  case 38: /* var_or_iri_list: var_or_iri_list VARIABLE  */
+#line 381 "sparql_parser.y"
                            { free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 2115 "sparql_parser.cpp"
+#line 2240 "sparql_parser.cpp"
     break;
 
-  case 31: /* var_or_iri_list: var_or_iri_list iri  */
-#line 300 "sparql_parser.y"
+  case 39: /* var_or_iri_list: var_or_iri_list iri  */
+#line 383 "sparql_parser.y"
                       { free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 2121 "sparql_parser.cpp"
+#line 2246 "sparql_parser.cpp"
     break;
 
-  case 32: /* ask_query: ASK dataset_clause where_clause  */
-#line 305 "sparql_parser.y"
+  case 40: /* ask_query: ASK dataset_clause where_clause  */
+#line 388 "sparql_parser.y"
                                   {
     query_graph->setQueryForm(AskQuery);
   }
-#line 2129 "sparql_parser.cpp"
+#line 2254 "sparql_parser.cpp"
     break;
 
-  case 35: /* from_clause: FROM  */
-#line 318 "sparql_parser.y"
+  case 43: /* from_clause: FROM  */
+#line 401 "sparql_parser.y"
        {
     yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, FROM clause is currently not supported, expecting ':' or 'a'"));
     YYERROR;
   }
-#line 2138 "sparql_parser.cpp"
+#line 2263 "sparql_parser.cpp"
     break;
 
-  case 36: /* where_clause: WHERE group_graph_pattern  */
-#line 326 "sparql_parser.y"
+  case 44: /* where_clause: WHERE group_graph_pattern  */
+#line 409 "sparql_parser.y"
                             { query_graph->pattern = (yyvsp[0].pattern); }
-#line 2144 "sparql_parser.cpp"
+#line 2269 "sparql_parser.cpp"
     break;
 
-  case 37: /* where_clause: group_graph_pattern  */
-#line 328 "sparql_parser.y"
+  case 45: /* where_clause: group_graph_pattern  */
+#line 411 "sparql_parser.y"
                       { query_graph->pattern = (yyvsp[0].pattern); }
-#line 2150 "sparql_parser.cpp"
+#line 2275 "sparql_parser.cpp"
+    break;
+
+  case 49: /* order_limit_clause: order_clause  */
+#line 424 "sparql_parser.y"
+               { yyunget(scanner); }
+#line 2281 "sparql_parser.cpp"
     break;
 
-  case 40: /* solution_modifier: %empty  */
-#line 337 "sparql_parser.y"
+  case 51: /* order_limit_clause: %empty  */
+#line 428 "sparql_parser.y"
               { yyunget(scanner); }
-#line 2156 "sparql_parser.cpp"
+#line 2287 "sparql_parser.cpp"
     break;
 
-  case 48: /* order_condition: ASC bracketted_expression  */
-#line 363 "sparql_parser.y"
+  case 53: /* group_keyword: IDENTIFIER  */
+#line 436 "sparql_parser.y"
+             {
+    if(strcasecmp((yyvsp[0].strval), "GROUP") != 0) {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting GROUP"));
+      YYERROR;
+    }
+    free((yyvsp[0].strval));
+    (yyvsp[0].strval) = nullptr;
+  }
+#line 2300 "sparql_parser.cpp"
+    break;
+
+  case 54: /* group_conditions: VARIABLE  */
+#line 447 "sparql_parser.y"
+           {
+    query_graph->addGroupBy((yyvsp[0].strval));
+    free((yyvsp[0].strval));
+    (yyvsp[0].strval) = nullptr;
+  }
+#line 2310 "sparql_parser.cpp"
+    break;
+
+  case 55: /* group_conditions: group_conditions VARIABLE  */
+#line 453 "sparql_parser.y"
+                            {
+    query_graph->addGroupBy((yyvsp[0].strval));
+    free((yyvsp[0].strval));
+    (yyvsp[0].strval) = nullptr;
+  }
+#line 2320 "sparql_parser.cpp"
+    break;
+
+  case 63: /* order_condition: ASC bracketted_expression  */
+#line 483 "sparql_parser.y"
                             {
     Order order;
     order.ascending = true;
     order.condition = (yyvsp[0].expression);
     query_graph->addOrder(order);
   }
-#line 2167 "sparql_parser.cpp"
+#line 2331 "sparql_parser.cpp"
     break;
 
-  case 49: /* order_condition: DESC bracketted_expression  */
-#line 370 "sparql_parser.y"
+  case 64: /* order_condition: DESC bracketted_expression  */
+#line 490 "sparql_parser.y"
                              {
     Order order;
     order.ascending = false;
     order.condition = (yyvsp[0].expression);
     query_graph->addOrder(order);
   }
-#line 2178 "sparql_parser.cpp"
+#line 2342 "sparql_parser.cpp"
     break;
 
-  case 50: /* order_condition: constraint  */
-#line 377 "sparql_parser.y"
+  case 65: /* order_condition: constraint  */
+#line 497 "sparql_parser.y"
              {
     Order order;
     order.ascending = true;
     order.condition = (yyvsp[0].expression);
     query_graph->addOrder(order);
   }
-#line 2189 "sparql_parser.cpp"
+#line 2353 "sparql_parser.cpp"
     break;
 
-  case 51: /* order_condition: VARIABLE  */
-#line 384 "sparql_parser.y"
+  case 66: /* order_condition: VARIABLE  */
+#line 504 "sparql_parser.y"
            {
     Order order;
     order.ascending = true;
@@ -2200,108 +2364,109 @@ yyreduce:
     free((yyvsp[0].strval));
     (yyvsp[0].strval) = nullptr;
   }
-#line 2204 "sparql_parser.cpp"
+#line 2368 "sparql_parser.cpp"
     break;
 
-  case 52: /* limit_clause: LIMIT INTEGER  */
-#line 398 "sparql_parser.y"
+  case 67: /* limit_clause: LIMIT INTEGER  */
+#line 518 "sparql_parser.y"
                 { query_graph->setLimit(atol((yyvsp[0].strval))); free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 2210 "sparql_parser.cpp"
+#line 2374 "sparql_parser.cpp"
     break;
 
-  case 53: /* offset_clause: OFFSET INTEGER  */
-#line 403 "sparql_parser.y"
+  case 68: /* offset_clause: OFFSET INTEGER  */
+#line 523 "sparql_parser.y"
                  { query_graph->setOffset(atol((yyvsp[0].strval))); free((yyvsp[0].strval)); (yyvsp[0].strval) = nullptr; }
-#line 2216 "sparql_parser.cpp"
+#line 2380 "sparql_parser.cpp"
     break;
 
-  case 54: /* group_graph_pattern: pattern_lbracket graph_pattern pattern_rbracket  */
-#line 408 "sparql_parser.y"
+  case 69: /* group_graph_pattern: pattern_lbracket graph_pattern pattern_rbracket  */
+#line 528 "sparql_parser.y"
                                                   {
     (yyval.pattern) = (yyvsp[-1].pattern);
   }
-#line 2224 "sparql_parser.cpp"
+#line 2388 "sparql_parser.cpp"
     break;
 
-  case 55: /* pattern_lbracket: '{'  */
-#line 414 "sparql_parser.y"
+  case 70: /* pattern_lbracket: '{'  */
+#line 534 "sparql_parser.y"
       {
-    context->parent_pattern = context->pattern;
+    context->parent_patterns.push_back(context->pattern);
     context->pattern = query_graph->createPattern();
     context->pattern->type = QueryPattern::Basic;
   }
-#line 2234 "sparql_parser.cpp"
+#line 2398 "sparql_parser.cpp"
     break;
 
-  case 56: /* pattern_rbracket: '}'  */
-#line 422 "sparql_parser.y"
+  case 71: /* pattern_rbracket: '}'  */
+#line 542 "sparql_parser.y"
       {
-    context->pattern = context->parent_pattern;
+    context->pattern = context->parent_patterns.back();
+    context->parent_patterns.pop_back();
   }
-#line 2242 "sparql_parser.cpp"
+#line 2407 "sparql_parser.cpp"
     break;
 
-  case 57: /* graph_pattern: basic_graph_pattern  */
-#line 428 "sparql_parser.y"
+  case 72: /* graph_pattern: basic_graph_pattern  */
+#line 549 "sparql_parser.y"
                       { (yyval.pattern) = context->pattern; }
-#line 2248 "sparql_parser.cpp"
+#line 2413 "sparql_parser.cpp"
     break;
 
-  case 58: /* graph_pattern: union_graph_pattern  */
-#line 430 "sparql_parser.y"
+  case 73: /* graph_pattern: union_graph_pattern  */
+#line 551 "sparql_parser.y"
                       { (yyval.pattern) = context->pattern; }
-#line 2254 "sparql_parser.cpp"
+#line 2419 "sparql_parser.cpp"
     break;
 
-  case 63: /* optional_graph_pattern: OPTIONAL group_graph_pattern  */
-#line 446 "sparql_parser.y"
+  case 78: /* optional_graph_pattern: OPTIONAL group_graph_pattern  */
+#line 567 "sparql_parser.y"
                                {  context->pattern->optionals.push_back((yyvsp[0].pattern)); }
-#line 2260 "sparql_parser.cpp"
+#line 2425 "sparql_parser.cpp"
     break;
 
-  case 64: /* union_graph_pattern: group_graph_pattern  */
-#line 451 "sparql_parser.y"
+  case 79: /* union_graph_pattern: group_graph_pattern  */
+#line 572 "sparql_parser.y"
                       {
     context->pattern->sub_patterns.push_back((yyvsp[0].pattern));
     context->pattern->type = QueryPattern::Union;
   }
-#line 2269 "sparql_parser.cpp"
+#line 2434 "sparql_parser.cpp"
     break;
 
-  case 65: /* union_graph_pattern: union_graph_pattern UNION group_graph_pattern  */
-#line 456 "sparql_parser.y"
+  case 80: /* union_graph_pattern: union_graph_pattern UNION group_graph_pattern  */
+#line 577 "sparql_parser.y"
                                                 {
     context->pattern->sub_patterns.push_back((yyvsp[0].pattern));
   }
-#line 2277 "sparql_parser.cpp"
+#line 2442 "sparql_parser.cpp"
     break;
 
-  case 66: /* filter: FILTER constraint  */
-#line 463 "sparql_parser.y"
+  case 81: /* filter: FILTER constraint  */
+#line 584 "sparql_parser.y"
                     { context->pattern->filters.push_back((yyvsp[0].expression)); }
-#line 2283 "sparql_parser.cpp"
+#line 2448 "sparql_parser.cpp"
     break;
 
-  case 67: /* constraint: bracketted_expression  */
-#line 468 "sparql_parser.y"
+  case 82: /* constraint: bracketted_expression  */
+#line 589 "sparql_parser.y"
                         { (yyval.expression) = (yyvsp[0].expression); }
-#line 2289 "sparql_parser.cpp"
+#line 2454 "sparql_parser.cpp"
     break;
 
-  case 68: /* constraint: built_in_call  */
-#line 470 "sparql_parser.y"
+  case 83: /* constraint: built_in_call  */
+#line 591 "sparql_parser.y"
                 { (yyval.expression) = (yyvsp[0].expression); }
-#line 2295 "sparql_parser.cpp"
+#line 2460 "sparql_parser.cpp"
     break;
 
-  case 69: /* constraint: function_call  */
-#line 472 "sparql_parser.y"
+  case 84: /* constraint: function_call  */
+#line 593 "sparql_parser.y"
                 { (yyval.expression) = (yyvsp[0].expression); }
-#line 2301 "sparql_parser.cpp"
+#line 2466 "sparql_parser.cpp"
     break;
 
-  case 70: /* function_call: iri '(' expression_list ')'  */
-#line 477 "sparql_parser.y"
+  case 85: /* function_call: iri '(' expression_list ')'  */
+#line 598 "sparql_parser.y"
                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Function;
@@ -2311,11 +2476,11 @@ yyreduce:
     (yyvsp[-3].strval) = nullptr;
     query_graph->removeExpression((yyvsp[-1].expression));
   }
-#line 2315 "sparql_parser.cpp"
+#line 2480 "sparql_parser.cpp"
     break;
 
-  case 71: /* function_call: iri NIL  */
-#line 487 "sparql_parser.y"
+  case 86: /* function_call: iri NIL  */
+#line 608 "sparql_parser.y"
           {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Function;
@@ -2323,172 +2488,172 @@ yyreduce:
     free((yyvsp[-1].strval));
     (yyvsp[-1].strval) = nullptr;
   }
-#line 2327 "sparql_parser.cpp"
+#line 2492 "sparql_parser.cpp"
     break;
 
-  case 72: /* construct_template: construct_lbracket construct_triples construct_rbracket  */
-#line 498 "sparql_parser.y"
+  case 87: /* construct_template: construct_lbracket construct_triples construct_rbracket  */
+#line 619 "sparql_parser.y"
                                                           {
     query_graph->construct_pattern = context->pattern;
   }
-#line 2335 "sparql_parser.cpp"
+#line 2500 "sparql_parser.cpp"
     break;
 
-  case 73: /* construct_lbracket: '{'  */
-#line 504 "sparql_parser.y"
+  case 88: /* construct_lbracket: '{'  */
+#line 625 "sparql_parser.y"
       {
     context->pattern = query_graph->createPattern();
     context->pattern->type = QueryPattern::Basic;
   }
-#line 2344 "sparql_parser.cpp"
+#line 2509 "sparql_parser.cpp"
     break;
 
-  case 77: /* triples_same_subject: subject1 property_list  */
-#line 523 "sparql_parser.y"
+  case 92: /* triples_same_subject: subject1 property_list  */
+#line 644 "sparql_parser.y"
                          {
     QueryResource *subject = context->subjects.back();
     context->resource_pool.free(subject);
     context->subjects.pop_back();
   }
-#line 2354 "sparql_parser.cpp"
+#line 2519 "sparql_parser.cpp"
     break;
 
-  case 78: /* triples_same_subject: subject2  */
-#line 529 "sparql_parser.y"
+  case 93: /* triples_same_subject: subject2  */
+#line 650 "sparql_parser.y"
            {
     QueryResource *subject = context->subjects.back();
     context->resource_pool.free(subject);
     context->subjects.pop_back();
   }
-#line 2364 "sparql_parser.cpp"
+#line 2529 "sparql_parser.cpp"
     break;
 
-  case 79: /* triples_same_subject: subject2 property_list  */
-#line 535 "sparql_parser.y"
+  case 94: /* triples_same_subject: subject2 property_list  */
+#line 656 "sparql_parser.y"
                          {
     QueryResource *subject = context->subjects.back();
     context->resource_pool.free(subject);
     context->subjects.pop_back();
   }
-#line 2374 "sparql_parser.cpp"
+#line 2539 "sparql_parser.cpp"
     break;
 
-  case 80: /* subject1: var_element  */
-#line 543 "sparql_parser.y"
+  case 95: /* subject1: var_element  */
+#line 664 "sparql_parser.y"
               { context->subjects.push_back((yyvsp[0].resource)); }
-#line 2380 "sparql_parser.cpp"
+#line 2545 "sparql_parser.cpp"
     break;
 
-  case 81: /* subject1: iri_element  */
-#line 545 "sparql_parser.y"
+  case 96: /* subject1: iri_element  */
+#line 666 "sparql_parser.y"
               { context->subjects.push_back((yyvsp[0].resource)); }
-#line 2386 "sparql_parser.cpp"
+#line 2551 "sparql_parser.cpp"
     break;
 
-  case 82: /* subject1: blank_node_element  */
-#line 547 "sparql_parser.y"
+  case 97: /* subject1: blank_node_element  */
+#line 668 "sparql_parser.y"
                      { context->subjects.push_back((yyvsp[0].resource)); }
-#line 2392 "sparql_parser.cpp"
+#line 2557 "sparql_parser.cpp"
     break;
 
-  case 83: /* subject2: blank_node_property_list  */
-#line 551 "sparql_parser.y"
+  case 98: /* subject2: blank_node_property_list  */
+#line 672 "sparql_parser.y"
                            { context->subjects.push_back((yyvsp[0].resource)); }
-#line 2398 "sparql_parser.cpp"
+#line 2563 "sparql_parser.cpp"
     break;
 
-  case 84: /* property_list: verb object_list  */
-#line 556 "sparql_parser.y"
+  case 99: /* property_list: verb object_list  */
+#line 677 "sparql_parser.y"
                    {
     QueryResource *predicate = context->predicates.back();
     context->resource_pool.free(predicate);
     context->predicates.pop_back();
   }
-#line 2408 "sparql_parser.cpp"
+#line 2573 "sparql_parser.cpp"
     break;
 
-  case 85: /* property_list: property_list ';' verb object_list  */
-#line 562 "sparql_parser.y"
+  case 100: /* property_list: property_list ';' verb object_list  */
+#line 683 "sparql_parser.y"
                                      {
     QueryResource *predicate = context->predicates.back();
     context->resource_pool.free(predicate);
     context->predicates.pop_back();
   }
-#line 2418 "sparql_parser.cpp"
+#line 2583 "sparql_parser.cpp"
     break;
 
-  case 86: /* object_list: object  */
-#line 571 "sparql_parser.y"
+  case 101: /* object_list: object  */
+#line 692 "sparql_parser.y"
          {
     QueryResource *object = (yyvsp[0].resource);
     int node = query_graph->addNode(QueryNode(*context->subjects.back(), *context->predicates.back(), *object));
     context->pattern->nodes.push_back(node);
     context->resource_pool.free(object);
   }
-#line 2429 "sparql_parser.cpp"
+#line 2594 "sparql_parser.cpp"
     break;
 
-  case 87: /* object_list: object_list ',' object  */
-#line 578 "sparql_parser.y"
+  case 102: /* object_list: object_list ',' object  */
+#line 699 "sparql_parser.y"
                          {
     QueryResource *object = (yyvsp[0].resource);
     int node = query_graph->addNode(QueryNode(*context->subjects.back(), *context->predicates.back(), *object));
     context->pattern->nodes.push_back(node);
     context->resource_pool.free(object);
   }
-#line 2440 "sparql_parser.cpp"
+#line 2605 "sparql_parser.cpp"
     break;
 
-  case 88: /* object: var_element  */
-#line 588 "sparql_parser.y"
+  case 103: /* object: var_element  */
+#line 709 "sparql_parser.y"
               { (yyval.resource) = (yyvsp[0].resource); }
-#line 2446 "sparql_parser.cpp"
+#line 2611 "sparql_parser.cpp"
     break;
 
-  case 89: /* object: iri_element  */
-#line 590 "sparql_parser.y"
+  case 104: /* object: iri_element  */
+#line 711 "sparql_parser.y"
               { (yyval.resource) = (yyvsp[0].resource); }
-#line 2452 "sparql_parser.cpp"
+#line 2617 "sparql_parser.cpp"
     break;
 
-  case 90: /* object: literal_element  */
-#line 592 "sparql_parser.y"
+  case 105: /* object: literal_element  */
+#line 713 "sparql_parser.y"
                   { (yyval.resource) = (yyvsp[0].resource); }
-#line 2458 "sparql_parser.cpp"
+#line 2623 "sparql_parser.cpp"
     break;
 
-  case 91: /* object: blank_node_element  */
-#line 594 "sparql_parser.y"
+  case 106: /* object: blank_node_element  */
+#line 715 "sparql_parser.y"
                      { (yyval.resource) = (yyvsp[0].resource); }
-#line 2464 "sparql_parser.cpp"
+#line 2629 "sparql_parser.cpp"
     break;
 
-  case 92: /* object: blank_node_property_list  */
-#line 596 "sparql_parser.y"
+  case 107: /* object: blank_node_property_list  */
+#line 717 "sparql_parser.y"
                            { (yyval.resource) = (yyvsp[0].resource); }
-#line 2470 "sparql_parser.cpp"
+#line 2635 "sparql_parser.cpp"
     break;
 
-  case 93: /* verb: var_element  */
-#line 601 "sparql_parser.y"
+  case 108: /* verb: var_element  */
+#line 722 "sparql_parser.y"
               { context->predicates.push_back((yyvsp[0].resource)); }
-#line 2476 "sparql_parser.cpp"
+#line 2641 "sparql_parser.cpp"
     break;
 
-  case 94: /* verb: iri_element  */
-#line 603 "sparql_parser.y"
+  case 109: /* verb: iri_element  */
+#line 724 "sparql_parser.y"
               { context->predicates.push_back((yyvsp[0].resource)); }
-#line 2482 "sparql_parser.cpp"
+#line 2647 "sparql_parser.cpp"
     break;
 
-  case 95: /* verb: type_element  */
-#line 605 "sparql_parser.y"
+  case 110: /* verb: type_element  */
+#line 726 "sparql_parser.y"
                { context->predicates.push_back((yyvsp[0].resource)); }
-#line 2488 "sparql_parser.cpp"
+#line 2653 "sparql_parser.cpp"
     break;
 
-  case 96: /* type_element: IDENTIFIER  */
-#line 609 "sparql_parser.y"
+  case 111: /* type_element: IDENTIFIER  */
+#line 730 "sparql_parser.y"
              {
     if(strcmp((yyvsp[0].strval), "a") != 0 && strcmp((yyvsp[0].strval), "A") != 0){
       yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting ':' or 'a'"));
@@ -2501,32 +2666,32 @@ yyreduce:
     resource->value = RDFVocabulary::RDF_TYPE;
     (yyval.resource) = resource;
   }
-#line 2505 "sparql_parser.cpp"
+#line 2670 "sparql_parser.cpp"
     break;
 
-  case 97: /* blank_node_property_list: open_square_bracket property_list ']'  */
-#line 625 "sparql_parser.y"
+  case 112: /* blank_node_property_list: open_square_bracket property_list ']'  */
+#line 746 "sparql_parser.y"
                                         {
     QueryResource *blankNode = context->subjects.back();
     context->subjects.pop_back();
     (yyval.resource) = blankNode;
   }
-#line 2515 "sparql_parser.cpp"
+#line 2680 "sparql_parser.cpp"
     break;
 
-  case 98: /* open_square_bracket: '['  */
-#line 633 "sparql_parser.y"
+  case 113: /* open_square_bracket: '['  */
+#line 754 "sparql_parser.y"
       {
     QueryResource *subject = context->resource_pool.alloc();
     subject->type = QueryResource::Variable;
     subject->value = context->bknode_id_gen.generate();
     context->subjects.push_back(subject);
   }
-#line 2526 "sparql_parser.cpp"
+#line 2691 "sparql_parser.cpp"
     break;
 
-  case 99: /* var_element: VARIABLE  */
-#line 642 "sparql_parser.y"
+  case 114: /* var_element: VARIABLE  */
+#line 763 "sparql_parser.y"
            {
     QueryResource *resource = context->resource_pool.alloc();
     resource->type = QueryResource::Variable;
@@ -2541,11 +2706,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.resource) = resource;
   }
-#line 2545 "sparql_parser.cpp"
+#line 2710 "sparql_parser.cpp"
     break;
 
-  case 100: /* iri_element: iri  */
-#line 659 "sparql_parser.y"
+  case 115: /* iri_element: iri  */
+#line 780 "sparql_parser.y"
       {
     QueryResource *resource = context->resource_pool.alloc();
     resource->type = QueryResource::IRI;
@@ -2554,11 +2719,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.resource) = resource;
   }
-#line 2558 "sparql_parser.cpp"
+#line 2723 "sparql_parser.cpp"
     break;
 
-  case 101: /* literal_element: rdf_literal  */
-#line 670 "sparql_parser.y"
+  case 116: /* literal_element: rdf_literal  */
+#line 791 "sparql_parser.y"
               {
     QueryResource *resource = context->resource_pool.alloc();
     resource->type = QueryResource::Literal;
@@ -2567,11 +2732,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.resource) = resource;
   }
-#line 2571 "sparql_parser.cpp"
+#line 2736 "sparql_parser.cpp"
     break;
 
-  case 102: /* blank_node_element: '_' ':' IDENTIFIER  */
-#line 681 "sparql_parser.y"
+  case 117: /* blank_node_element: '_' ':' IDENTIFIER  */
+#line 802 "sparql_parser.y"
                      {
     std::string bknode_id;
     if(context->blank_nodes.count((yyvsp[0].strval))) {
@@ -2588,48 +2753,48 @@ yyreduce:
     resource->value = bknode_id;
     (yyval.resource) = resource;
   }
-#line 2592 "sparql_parser.cpp"
+#line 2757 "sparql_parser.cpp"
     break;
 
-  case 103: /* blank_node_element: ANON  */
-#line 698 "sparql_parser.y"
+  case 118: /* blank_node_element: ANON  */
+#line 819 "sparql_parser.y"
        {
     QueryResource *resource = context->resource_pool.alloc();
     resource->type = QueryResource::Variable;
     resource->value = context->bknode_id_gen.generate();
     (yyval.resource) = resource;
   }
-#line 2603 "sparql_parser.cpp"
+#line 2768 "sparql_parser.cpp"
     break;
 
-  case 104: /* expression_list: expression  */
-#line 707 "sparql_parser.y"
+  case 119: /* expression_list: expression  */
+#line 828 "sparql_parser.y"
              {
     QueryExpression* exp = query_graph->createExpression();;
     exp->type = QueryExpression::ArgumentList;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2614 "sparql_parser.cpp"
+#line 2779 "sparql_parser.cpp"
     break;
 
-  case 105: /* expression_list: expression_list ',' expression  */
-#line 714 "sparql_parser.y"
+  case 120: /* expression_list: expression_list ',' expression  */
+#line 835 "sparql_parser.y"
                                  {
     (yyvsp[-2].expression)->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = (yyvsp[-2].expression);
   }
-#line 2623 "sparql_parser.cpp"
+#line 2788 "sparql_parser.cpp"
     break;
 
-  case 106: /* expression: conditional_expression  */
-#line 722 "sparql_parser.y"
+  case 121: /* expression: conditional_expression  */
+#line 843 "sparql_parser.y"
                          { (yyval.expression) = (yyvsp[0].expression); }
-#line 2629 "sparql_parser.cpp"
+#line 2794 "sparql_parser.cpp"
     break;
 
-  case 107: /* conditional_expression: conditional_expression OP_OR conditional_expression  */
-#line 727 "sparql_parser.y"
+  case 122: /* conditional_expression: conditional_expression OP_OR conditional_expression  */
+#line 848 "sparql_parser.y"
                                                       {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Or;
@@ -2637,11 +2802,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2641 "sparql_parser.cpp"
+#line 2806 "sparql_parser.cpp"
     break;
 
-  case 108: /* conditional_expression: conditional_expression OP_AND conditional_expression  */
-#line 735 "sparql_parser.y"
+  case 123: /* conditional_expression: conditional_expression OP_AND conditional_expression  */
+#line 856 "sparql_parser.y"
                                                        {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::And;
@@ -2649,17 +2814,17 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2653 "sparql_parser.cpp"
+#line 2818 "sparql_parser.cpp"
     break;
 
-  case 109: /* conditional_expression: relation_expression  */
-#line 743 "sparql_parser.y"
+  case 124: /* conditional_expression: relation_expression  */
+#line 864 "sparql_parser.y"
                       { (yyval.expression) = (yyvsp[0].expression); }
-#line 2659 "sparql_parser.cpp"
+#line 2824 "sparql_parser.cpp"
     break;
 
-  case 110: /* relation_expression: numeric_expression OP_EQ numeric_expression  */
-#line 748 "sparql_parser.y"
+  case 125: /* relation_expression: numeric_expression OP_EQ numeric_expression  */
+#line 869 "sparql_parser.y"
                                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Equal;
@@ -2667,11 +2832,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2671 "sparql_parser.cpp"
+#line 2836 "sparql_parser.cpp"
     break;
 
-  case 111: /* relation_expression: numeric_expression OP_NE numeric_expression  */
-#line 756 "sparql_parser.y"
+  case 126: /* relation_expression: numeric_expression OP_NE numeric_expression  */
+#line 877 "sparql_parser.y"
                                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::NotEqual;
@@ -2679,11 +2844,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2683 "sparql_parser.cpp"
+#line 2848 "sparql_parser.cpp"
     break;
 
-  case 112: /* relation_expression: numeric_expression OP_LT numeric_expression  */
-#line 764 "sparql_parser.y"
+  case 127: /* relation_expression: numeric_expression OP_LT numeric_expression  */
+#line 885 "sparql_parser.y"
                                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Less;
@@ -2691,11 +2856,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2695 "sparql_parser.cpp"
+#line 2860 "sparql_parser.cpp"
     break;
 
-  case 113: /* relation_expression: numeric_expression OP_GT numeric_expression  */
-#line 772 "sparql_parser.y"
+  case 128: /* relation_expression: numeric_expression OP_GT numeric_expression  */
+#line 893 "sparql_parser.y"
                                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Greater;
@@ -2703,11 +2868,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2707 "sparql_parser.cpp"
+#line 2872 "sparql_parser.cpp"
     break;
 
-  case 114: /* relation_expression: numeric_expression OP_LE numeric_expression  */
-#line 780 "sparql_parser.y"
+  case 129: /* relation_expression: numeric_expression OP_LE numeric_expression  */
+#line 901 "sparql_parser.y"
                                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::LessOrEqual;
@@ -2715,11 +2880,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2719 "sparql_parser.cpp"
+#line 2884 "sparql_parser.cpp"
     break;
 
-  case 115: /* relation_expression: numeric_expression OP_GE numeric_expression  */
-#line 788 "sparql_parser.y"
+  case 130: /* relation_expression: numeric_expression OP_GE numeric_expression  */
+#line 909 "sparql_parser.y"
                                               {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::GreaterOrEqual;
@@ -2727,17 +2892,17 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2731 "sparql_parser.cpp"
+#line 2896 "sparql_parser.cpp"
     break;
 
-  case 116: /* relation_expression: numeric_expression  */
-#line 796 "sparql_parser.y"
+  case 131: /* relation_expression: numeric_expression  */
+#line 917 "sparql_parser.y"
                      { (yyval.expression) = (yyvsp[0].expression); }
-#line 2737 "sparql_parser.cpp"
+#line 2902 "sparql_parser.cpp"
     break;
 
-  case 117: /* numeric_expression: numeric_expression '+' numeric_expression  */
-#line 801 "sparql_parser.y"
+  case 132: /* numeric_expression: numeric_expression '+' numeric_expression  */
+#line 922 "sparql_parser.y"
                                             {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Plus;
@@ -2745,11 +2910,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2749 "sparql_parser.cpp"
+#line 2914 "sparql_parser.cpp"
     break;
 
-  case 118: /* numeric_expression: numeric_expression '-' numeric_expression  */
-#line 809 "sparql_parser.y"
+  case 133: /* numeric_expression: numeric_expression '-' numeric_expression  */
+#line 930 "sparql_parser.y"
                                             {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Minus;
@@ -2757,11 +2922,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2761 "sparql_parser.cpp"
+#line 2926 "sparql_parser.cpp"
     break;
 
-  case 119: /* numeric_expression: numeric_expression '*' numeric_expression  */
-#line 817 "sparql_parser.y"
+  case 134: /* numeric_expression: numeric_expression '*' numeric_expression  */
+#line 938 "sparql_parser.y"
                                             {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Mul;
@@ -2769,11 +2934,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2773 "sparql_parser.cpp"
+#line 2938 "sparql_parser.cpp"
     break;
 
-  case 120: /* numeric_expression: numeric_expression '/' numeric_expression  */
-#line 825 "sparql_parser.y"
+  case 135: /* numeric_expression: numeric_expression '/' numeric_expression  */
+#line 946 "sparql_parser.y"
                                             {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Div;
@@ -2781,74 +2946,74 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2785 "sparql_parser.cpp"
+#line 2950 "sparql_parser.cpp"
     break;
 
-  case 121: /* numeric_expression: unary_expression  */
-#line 833 "sparql_parser.y"
+  case 136: /* numeric_expression: unary_expression  */
+#line 954 "sparql_parser.y"
                    { (yyval.expression) = (yyvsp[0].expression); }
-#line 2791 "sparql_parser.cpp"
+#line 2956 "sparql_parser.cpp"
     break;
 
-  case 122: /* unary_expression: '!' primary_expression  */
-#line 838 "sparql_parser.y"
+  case 137: /* unary_expression: '!' primary_expression  */
+#line 959 "sparql_parser.y"
                                       {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Not;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2802 "sparql_parser.cpp"
+#line 2967 "sparql_parser.cpp"
     break;
 
-  case 123: /* unary_expression: '+' primary_expression  */
-#line 845 "sparql_parser.y"
+  case 138: /* unary_expression: '+' primary_expression  */
+#line 966 "sparql_parser.y"
                                       {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::UnaryPlus;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2813 "sparql_parser.cpp"
+#line 2978 "sparql_parser.cpp"
     break;
 
-  case 124: /* unary_expression: '-' primary_expression  */
-#line 852 "sparql_parser.y"
+  case 139: /* unary_expression: '-' primary_expression  */
+#line 973 "sparql_parser.y"
                                       {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::UnaryMinus;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2824 "sparql_parser.cpp"
+#line 2989 "sparql_parser.cpp"
     break;
 
-  case 125: /* unary_expression: primary_expression  */
-#line 859 "sparql_parser.y"
+  case 140: /* unary_expression: primary_expression  */
+#line 980 "sparql_parser.y"
                      { (yyval.expression) = (yyvsp[0].expression); }
-#line 2830 "sparql_parser.cpp"
+#line 2995 "sparql_parser.cpp"
     break;
 
-  case 126: /* primary_expression: bracketted_expression  */
-#line 864 "sparql_parser.y"
+  case 141: /* primary_expression: bracketted_expression  */
+#line 985 "sparql_parser.y"
                         { (yyval.expression) = (yyvsp[0].expression); }
-#line 2836 "sparql_parser.cpp"
+#line 3001 "sparql_parser.cpp"
     break;
 
-  case 127: /* primary_expression: built_in_call  */
-#line 866 "sparql_parser.y"
+  case 142: /* primary_expression: built_in_call  */
+#line 987 "sparql_parser.y"
                 { (yyval.expression) = (yyvsp[0].expression); }
-#line 2842 "sparql_parser.cpp"
+#line 3007 "sparql_parser.cpp"
     break;
 
-  case 128: /* primary_expression: function_call  */
-#line 868 "sparql_parser.y"
+  case 143: /* primary_expression: function_call  */
+#line 989 "sparql_parser.y"
                 { (yyval.expression) = (yyvsp[0].expression); }
-#line 2848 "sparql_parser.cpp"
+#line 3013 "sparql_parser.cpp"
     break;
 
-  case 129: /* primary_expression: iri  */
-#line 870 "sparql_parser.y"
+  case 144: /* primary_expression: iri  */
+#line 991 "sparql_parser.y"
       {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::IRI;
@@ -2857,11 +3022,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.expression) = exp;
   }
-#line 2861 "sparql_parser.cpp"
+#line 3026 "sparql_parser.cpp"
     break;
 
-  case 130: /* primary_expression: VARIABLE  */
-#line 879 "sparql_parser.y"
+  case 145: /* primary_expression: VARIABLE  */
+#line 1000 "sparql_parser.y"
            {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Variable;
@@ -2870,11 +3035,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.expression) = exp;
   }
-#line 2874 "sparql_parser.cpp"
+#line 3039 "sparql_parser.cpp"
     break;
 
-  case 131: /* primary_expression: literal  */
-#line 888 "sparql_parser.y"
+  case 146: /* primary_expression: literal  */
+#line 1009 "sparql_parser.y"
           {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Literal;
@@ -2883,17 +3048,17 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.expression) = exp;
   }
-#line 2887 "sparql_parser.cpp"
+#line 3052 "sparql_parser.cpp"
     break;
 
-  case 132: /* bracketted_expression: '(' expression ')'  */
-#line 900 "sparql_parser.y"
+  case 147: /* bracketted_expression: '(' expression ')'  */
+#line 1021 "sparql_parser.y"
                      { (yyval.expression) = (yyvsp[-1].expression); }
-#line 2893 "sparql_parser.cpp"
+#line 3058 "sparql_parser.cpp"
     break;
 
-  case 133: /* built_in_call: BIC_BOUND '(' VARIABLE ')'  */
-#line 905 "sparql_parser.y"
+  case 148: /* built_in_call: BIC_BOUND '(' VARIABLE ')'  */
+#line 1026 "sparql_parser.y"
                              {
     QueryExpression* arg = query_graph->createExpression();
     arg->type = QueryExpression::Variable;
@@ -2905,44 +3070,44 @@ yyreduce:
     exp->arg_list.push_back(arg);
     (yyval.expression) = exp;
   }
-#line 2909 "sparql_parser.cpp"
+#line 3074 "sparql_parser.cpp"
     break;
 
-  case 134: /* built_in_call: BIC_STR bracketted_expression  */
-#line 917 "sparql_parser.y"
+  case 149: /* built_in_call: BIC_STR bracketted_expression  */
+#line 1038 "sparql_parser.y"
                                 {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_str;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2920 "sparql_parser.cpp"
+#line 3085 "sparql_parser.cpp"
     break;
 
-  case 135: /* built_in_call: BIC_LANG bracketted_expression  */
-#line 924 "sparql_parser.y"
+  case 150: /* built_in_call: BIC_LANG bracketted_expression  */
+#line 1045 "sparql_parser.y"
                                  {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_lang;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2931 "sparql_parser.cpp"
+#line 3096 "sparql_parser.cpp"
     break;
 
-  case 136: /* built_in_call: BIC_DATATYPE bracketted_expression  */
-#line 931 "sparql_parser.y"
+  case 151: /* built_in_call: BIC_DATATYPE bracketted_expression  */
+#line 1052 "sparql_parser.y"
                                      {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_datatype;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2942 "sparql_parser.cpp"
+#line 3107 "sparql_parser.cpp"
     break;
 
-  case 137: /* built_in_call: BIC_SAMETERM '(' expression ',' expression ')'  */
-#line 938 "sparql_parser.y"
+  case 152: /* built_in_call: BIC_SAMETERM '(' expression ',' expression ')'  */
+#line 1059 "sparql_parser.y"
                                                  {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_sameterm;
@@ -2950,11 +3115,11 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[-1].expression));
     (yyval.expression) = exp;
   }
-#line 2954 "sparql_parser.cpp"
+#line 3119 "sparql_parser.cpp"
     break;
 
-  case 138: /* built_in_call: BIC_LANGMATCHES '(' expression ',' expression ')'  */
-#line 946 "sparql_parser.y"
+  case 153: /* built_in_call: BIC_LANGMATCHES '(' expression ',' expression ')'  */
+#line 1067 "sparql_parser.y"
                                                     {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_langmatches;
@@ -2962,55 +3127,55 @@ yyreduce:
     exp->arg_list.push_back((yyvsp[-1].expression));
     (yyval.expression) = exp;
   }
-#line 2966 "sparql_parser.cpp"
+#line 3131 "sparql_parser.cpp"
     break;
 
-  case 139: /* built_in_call: BIC_ISIRI bracketted_expression  */
-#line 954 "sparql_parser.y"
+  case 154: /* built_in_call: BIC_ISIRI bracketted_expression  */
+#line 1075 "sparql_parser.y"
                                   {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_isiri;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2977 "sparql_parser.cpp"
+#line 3142 "sparql_parser.cpp"
     break;
 
-  case 140: /* built_in_call: BIC_ISURI bracketted_expression  */
-#line 961 "sparql_parser.y"
+  case 155: /* built_in_call: BIC_ISURI bracketted_expression  */
+#line 1082 "sparql_parser.y"
                                   {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_isuri;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2988 "sparql_parser.cpp"
+#line 3153 "sparql_parser.cpp"
     break;
 
-  case 141: /* built_in_call: BIC_ISBLANK bracketted_expression  */
-#line 968 "sparql_parser.y"
+  case 156: /* built_in_call: BIC_ISBLANK bracketted_expression  */
+#line 1089 "sparql_parser.y"
                                     {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_isblank;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 2999 "sparql_parser.cpp"
+#line 3164 "sparql_parser.cpp"
     break;
 
-  case 142: /* built_in_call: BIC_ISLITERAL bracketted_expression  */
-#line 975 "sparql_parser.y"
+  case 157: /* built_in_call: BIC_ISLITERAL bracketted_expression  */
+#line 1096 "sparql_parser.y"
                                       {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_isliteral;
     exp->arg_list.push_back((yyvsp[0].expression));
     (yyval.expression) = exp;
   }
-#line 3010 "sparql_parser.cpp"
+#line 3175 "sparql_parser.cpp"
     break;
 
-  case 143: /* built_in_call: BIC_REGEX '(' expression ',' expression_list ')'  */
-#line 982 "sparql_parser.y"
+  case 158: /* built_in_call: BIC_REGEX '(' expression ',' expression_list ')'  */
+#line 1103 "sparql_parser.y"
                                                     {
     QueryExpression* exp = query_graph->createExpression();
     exp->type = QueryExpression::Builtin_regex;
@@ -3019,41 +3184,41 @@ yyreduce:
     query_graph->removeExpression((yyvsp[-1].expression));
     (yyval.expression) = exp;
   }
-#line 3023 "sparql_parser.cpp"
+#line 3188 "sparql_parser.cpp"
     break;
 
-  case 144: /* literal: rdf_literal  */
-#line 993 "sparql_parser.y"
+  case 159: /* literal: rdf_literal  */
+#line 1114 "sparql_parser.y"
               { (yyval.strval) = (yyvsp[0].strval); }
-#line 3029 "sparql_parser.cpp"
+#line 3194 "sparql_parser.cpp"
     break;
 
-  case 145: /* literal: numeric_literal  */
-#line 995 "sparql_parser.y"
+  case 160: /* literal: numeric_literal  */
+#line 1116 "sparql_parser.y"
                   { (yyval.strval) = (yyvsp[0].strval); }
-#line 3035 "sparql_parser.cpp"
+#line 3200 "sparql_parser.cpp"
     break;
 
-  case 146: /* literal: boolean_literal  */
-#line 997 "sparql_parser.y"
+  case 161: /* literal: boolean_literal  */
+#line 1118 "sparql_parser.y"
                   { (yyval.strval) = (yyvsp[0].strval); }
-#line 3041 "sparql_parser.cpp"
+#line 3206 "sparql_parser.cpp"
     break;
 
-  case 147: /* rdf_literal: STRING  */
-#line 1002 "sparql_parser.y"
+  case 162: /* rdf_literal: STRING  */
+#line 1123 "sparql_parser.y"
          {
     std::stringstream ss;
-    ss << "\"" << (yyvsp[0].strval) << "\"" << XSDVocabulary::XSD_STRING;
+    ss << "\"" << (yyvsp[0].strval) << "\"" << "^^" << XSDVocabulary::XSD_STRING;
     free((yyvsp[0].strval));
     (yyvsp[0].strval) = nullptr;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3053 "sparql_parser.cpp"
+#line 3218 "sparql_parser.cpp"
     break;
 
-  case 148: /* rdf_literal: STRING LANGTAG  */
-#line 1010 "sparql_parser.y"
+  case 163: /* rdf_literal: STRING LANGTAG  */
+#line 1131 "sparql_parser.y"
                  {
     std::stringstream ss;
     ss << "\"" << (yyvsp[-1].strval) << "\"" << (yyvsp[0].strval);
@@ -3063,11 +3228,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3067 "sparql_parser.cpp"
+#line 3232 "sparql_parser.cpp"
     break;
 
-  case 149: /* rdf_literal: STRING TYPE iri  */
-#line 1020 "sparql_parser.y"
+  case 164: /* rdf_literal: STRING TYPE iri  */
+#line 1141 "sparql_parser.y"
                   {
     std::stringstream ss;
     ss << "\"" << (yyvsp[-2].strval) << "\"" << "^^" << (yyvsp[0].strval);
@@ -3077,61 +3242,61 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3081 "sparql_parser.cpp"
+#line 3246 "sparql_parser.cpp"
     break;
 
-  case 150: /* numeric_literal: INTEGER  */
-#line 1033 "sparql_parser.y"
+  case 165: /* numeric_literal: INTEGER  */
+#line 1154 "sparql_parser.y"
           {
     std::stringstream ss;
     ss << "\"" << (yyvsp[0].strval) << "\"" << "^^" << XSDVocabulary::XSD_INTEGER;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3091 "sparql_parser.cpp"
+#line 3256 "sparql_parser.cpp"
     break;
 
-  case 151: /* numeric_literal: DECIMAL  */
-#line 1039 "sparql_parser.y"
+  case 166: /* numeric_literal: DECIMAL  */
+#line 1160 "sparql_parser.y"
           {
     std::stringstream ss;
     ss << "\"" << (yyvsp[0].strval) << "\"" << "^^" << XSDVocabulary::XSD_DECIMAL;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3101 "sparql_parser.cpp"
+#line 3266 "sparql_parser.cpp"
     break;
 
-  case 152: /* numeric_literal: DOUBLE  */
-#line 1045 "sparql_parser.y"
+  case 167: /* numeric_literal: DOUBLE  */
+#line 1166 "sparql_parser.y"
          {
     std::stringstream ss;
     ss << "\"" << (yyvsp[0].strval) << "\"" << "^^" << XSDVocabulary::XSD_DOUBLE;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3111 "sparql_parser.cpp"
+#line 3276 "sparql_parser.cpp"
     break;
 
-  case 153: /* boolean_literal: BOOL_TRUE  */
-#line 1054 "sparql_parser.y"
+  case 168: /* boolean_literal: BOOL_TRUE  */
+#line 1175 "sparql_parser.y"
             {
     std::stringstream ss;
     ss << "\"true\"" << "^^" << XSDVocabulary::XSD_BOOLEAN;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3121 "sparql_parser.cpp"
+#line 3286 "sparql_parser.cpp"
     break;
 
-  case 154: /* boolean_literal: BOOL_FALSE  */
-#line 1060 "sparql_parser.y"
+  case 169: /* boolean_literal: BOOL_FALSE  */
+#line 1181 "sparql_parser.y"
              {
     std::stringstream ss;
     ss << "\"false\"" << "^^" << XSDVocabulary::XSD_BOOLEAN;
     (yyval.strval) = strdup(ss.str().c_str());
   }
-#line 3131 "sparql_parser.cpp"
+#line 3296 "sparql_parser.cpp"
     break;
 
-  case 155: /* iri: IRI  */
-#line 1069 "sparql_parser.y"
+  case 170: /* iri: IRI  */
+#line 1190 "sparql_parser.y"
       {
     std::string str = (yyvsp[0].strval);
     if(!context->base.empty() && str.find("://")==std::string::npos){
@@ -3141,11 +3306,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.strval) = strdup(str.c_str());
   }
-#line 3145 "sparql_parser.cpp"
+#line 3310 "sparql_parser.cpp"
     break;
 
-  case 156: /* iri: IDENTIFIER ':' IDENTIFIER  */
-#line 1079 "sparql_parser.y"
+  case 171: /* iri: IDENTIFIER ':' IDENTIFIER  */
+#line 1200 "sparql_parser.y"
                             {
     std::string str = context->prefixes[(yyvsp[-2].strval)];
     str.insert(str.length()-1, (yyvsp[0].strval), strlen((yyvsp[0].strval)));
@@ -3155,11 +3320,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.strval) = strdup(str.c_str());
   }
-#line 3159 "sparql_parser.cpp"
+#line 3324 "sparql_parser.cpp"
     break;
 
-  case 157: /* iri: ':' IDENTIFIER  */
-#line 1089 "sparql_parser.y"
+  case 172: /* iri: ':' IDENTIFIER  */
+#line 1210 "sparql_parser.y"
                 {
     std::string str = context->prefixes[""];
     str.insert(str.length()-1, (yyvsp[0].strval), strlen((yyvsp[0].strval)));
@@ -3167,11 +3332,11 @@ yyreduce:
     (yyvsp[0].strval) = nullptr;
     (yyval.strval) = strdup(str.c_str());
   }
-#line 3171 "sparql_parser.cpp"
+#line 3336 "sparql_parser.cpp"
     break;
 
 
-#line 3175 "sparql_parser.cpp"
+#line 3340 "sparql_parser.cpp"
 
       default: break;
     }
@@ -3248,7 +3413,7 @@ yyerrlab:
           }
         yyerror (&yylloc, scanner, context, query_graph, yymsgp);
         if (yysyntax_error_status == YYENOMEM)
-          goto yyexhaustedlab;
+          YYNOMEM;
       }
     }
 
@@ -3285,6 +3450,7 @@ yyerrorlab:
      label yyerrorlab therefore never appears in user code.  */
   if (0)
     YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -3348,7 +3514,7 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
 /*-----------------------------------.
@@ -3356,24 +3522,22 @@ yyacceptlab:
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
-#if 1
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (&yylloc, scanner, context, query_graph, YY_("memory exhausted"));
   yyresult = 2;
-  goto yyreturn;
-#endif
+  goto yyreturnlab;
 
 
-/*-------------------------------------------------------.
-| yyreturn -- parsing is finished, clean up and return.  |
-`-------------------------------------------------------*/
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != RQEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -3401,7 +3565,7 @@ yyreturn:
   return yyresult;
 }
 
-#line 1098 "sparql_parser.y"
+#line 1219 "sparql_parser.y"
 
 
 
@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include <cstring>
+#include <strings.h>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
@@ -46,15 +47,16 @@ struct SPARQLParseContext {
   std::vector<QueryResource*> subjects;
   std::vector<QueryResource*> predicates;
   QueryPattern* pattern;
-  QueryPattern* parent_pattern;
+  // enclosing patterns of the current one, innermost last
+  std::vector<QueryPattern*> parent_patterns;
+  // the aggregate of the select expression being parsed
+  Aggregation aggregation;
 
   SPARQLParseContext() : bknode_id_gen(0) {
     pattern = nullptr;
-    parent_pattern = nullptr;
   }
   ~SPARQLParseContext() {
     pattern = nullptr;
-    parent_pattern = nullptr;
   }
 };
 
@@ -239,6 +241,23 @@ prefix:
 select_query:
   SELECT duplicate_modifier select_list dataset_clause where_clause solution_modifier {
     query_graph->setQueryForm(SelectQuery);
+    // with aggregates, a solution is a group, so only its keys and
+    // aggregates can be projected
+    if(!query_graph->group_by.empty() || !query_graph->aggregations.empty()) {
+      std::unordered_set<std::string> grouped;
+      for(int i=0; i<query_graph->group_by.size(); i++) {
+        grouped.insert(query_graph->group_by[i].value);
+      }
+      for(int i=0; i<query_graph->aggregations.size(); i++) {
+        grouped.insert(query_graph->aggregations[i].variable.value);
+      }
+      for(int i=0; i<query_graph->projection.size(); i++) {
+        if(!grouped.count(query_graph->projection[i].value)) {
+          yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, projected variable is neither grouped nor aggregated"));
+          YYERROR;
+        }
+      }
+    }
   }
   ;
 
@@ -257,16 +276,80 @@ select_list:
   ;
 
 variables:
+  select_variable
+  |
+  variables select_variable
+  ;
+
+select_variable:
   VARIABLE {
     query_graph->addProjection($1);
     free($1);
     $1 = nullptr;
   }
   |
-  variables VARIABLE {
-    query_graph->addProjection($2);
-    free($2);
-    $2 = nullptr;
+  '(' aggregate as_keyword VARIABLE ')' {
+    context->aggregation.variable.value = $4;
+    query_graph->addAggregation(context->aggregation);
+    query_graph->addProjection($4);
+    free($4);
+    $4 = nullptr;
+  }
+  ;
+
+/* aggregate keywords are not reserved by the lexer, they come as IDENTIFIER */
+aggregate:
+  IDENTIFIER '(' aggregate_modifier aggregate_argument ')' {
+    if(strcasecmp($1, "COUNT") == 0) {
+      context->aggregation.function = Aggregation::Count;
+    } else if(strcasecmp($1, "SUM") == 0) {
+      context->aggregation.function = Aggregation::Sum;
+    } else if(strcasecmp($1, "MIN") == 0) {
+      context->aggregation.function = Aggregation::Min;
+    } else if(strcasecmp($1, "MAX") == 0) {
+      context->aggregation.function = Aggregation::Max;
+    } else if(strcasecmp($1, "AVG") == 0) {
+      context->aggregation.function = Aggregation::Avg;
+    } else {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting COUNT, SUM, MIN, MAX or AVG"));
+      YYERROR;
+    }
+    if(context->aggregation.argument == nullptr && (context->aggregation.function != Aggregation::Count || context->aggregation.distinct)) {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, '*' is only supported by COUNT without DISTINCT"));
+      YYERROR;
+    }
+    free($1);
+    $1 = nullptr;
+  }
+  ;
+
+aggregate_modifier:
+  DISTINCT { context->aggregation.distinct = true; }
+  |
+  /* empty */ { context->aggregation.distinct = false; }
+  ;
+
+aggregate_argument:
+  VARIABLE {
+    QueryExpression* exp = query_graph->createExpression();
+    exp->type = QueryExpression::Variable;
+    exp->value = $1;
+    context->aggregation.argument = exp;
+    free($1);
+    $1 = nullptr;
+  }
+  |
+  '*' { context->aggregation.argument = nullptr; }
+  ;
+
+as_keyword:
+  IDENTIFIER {
+    if(strcasecmp($1, "AS") != 0) {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting AS"));
+      YYERROR;
+    }
+    free($1);
+    $1 = nullptr;
   }
   ;
 
@@ -330,13 +413,50 @@ where_clause:
 
 /* 14 */
 solution_modifier:
+  group_clause order_limit_clause
+  |
+  order_limit_clause
+  ;
+
+order_limit_clause:
   order_clause limit_offset_clause
   |
+  order_clause { yyunget(scanner); }
+  |
   limit_offset_clause
   |
   /* empty */ { yyunget(scanner); }
   ;
 
+group_clause:
+  group_keyword BY group_conditions
+  ;
+
+group_keyword:
+  IDENTIFIER {
+    if(strcasecmp($1, "GROUP") != 0) {
+      yyerror (&yylloc, scanner, context, query_graph, YY_("syntax error, unexpected IDENTIFIER, expecting GROUP"));
+      YYERROR;
+    }
+    free($1);
+    $1 = nullptr;
+  }
+  ;
+
+group_conditions:
+  VARIABLE {
+    query_graph->addGroupBy($1);
+    free($1);
+    $1 = nullptr;
+  }
+  |
+  group_conditions VARIABLE {
+    query_graph->addGroupBy($2);
+    free($2);
+    $2 = nullptr;
+  }
+  ;
+
 /* 15 */
 limit_offset_clause:
   limit_clause
@@ -412,7 +532,7 @@ group_graph_pattern:
 
 pattern_lbracket:
   '{' {
-    context->parent_pattern = context->pattern;
+    context->parent_patterns.push_back(context->pattern);
     context->pattern = query_graph->createPattern();
     context->pattern->type = QueryPattern::Basic;
   }
@@ -420,7 +540,8 @@ pattern_lbracket:
 
 pattern_rbracket:
   '}' {
-    context->pattern = context->parent_pattern;
+    context->pattern = context->parent_patterns.back();
+    context->parent_patterns.pop_back();
   }
   ;
 
@@ -1001,7 +1122,7 @@ literal:
 rdf_literal:
   STRING {
     std::stringstream ss;
-    ss << "\"" << $1 << "\"" << XSDVocabulary::XSD_STRING;
+    ss << "\"" << $1 << "\"" << "^^" << XSDVocabulary::XSD_STRING;
     free($1);
     $1 = nullptr;
     $$ = strdup(ss.str().c_str());
@@ -19,13 +19,21 @@ public:
     return card;
   }
 
+  // One key-value lookup, plus the data pages of segments too large to be
+  // stored inline.
+  static cost_t estimateKeyLookup(double card) {
+    if(card*sizeof(uint32_t) <= segment_inline_size) {
+      return kv_lookup_costs;
+    }
+    return kv_lookup_costs + (int)((card*sizeof(uint32_t)+BLOCK_SIZE-1)/BLOCK_SIZE)*page_scan_costs;
+  }
+
 private:
-  static const cost_t page_scan_costs;
-  static const cost_t kv_lookup_costs;
+  static constexpr cost_t page_scan_costs = 17;
+  static constexpr cost_t kv_lookup_costs = 4;
+  static constexpr double segment_inline_size = 4000;
 };
 
-const cost_t LowerBoundsCostModel::page_scan_costs = 17;
-
 
 
 #endif
@@ -10,8 +10,8 @@ QueryPlan::QueryPlan() {}
 
 QueryPlan::~QueryPlan() {}
 
-void QueryPlan::execute(Runtime& runtime, bool silent) {
-  Operator* operator_tree = CodeGenerator::generate(runtime, this->root, silent);
+void QueryPlan::execute(Runtime& runtime, bool silent, bool explain) {
+  Operator* operator_tree = CodeGenerator::generate(runtime, this->root, silent, explain);
   operator_tree->open();
   if(operator_tree->first()) {
     while(operator_tree->next());
@@ -37,10 +37,42 @@ std::ostream& operator<<(std::ostream& out, PlanNode* node) {
       out << "->  Hash join";
       out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
       break;
+    case PlanNode::MergeJoin:
+      out << "->  Merge join";
+      out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
     case PlanNode::BackProbeHashJoin:
       out << "->  Back-probe Hash join";
       out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
       break;
+    case PlanNode::LeapfrogTriejoin:
+      out << "->  Leapfrog triejoin";
+      out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
+    case PlanNode::OptionalJoin:
+      out << "->  Optional join";
+      out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
+    case PlanNode::Union:
+      out << "->  Union";
+      out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
+    case PlanNode::Aggregate:
+      out << "->  Aggregate";
+      out << "[" << "groups=" << node->group_res.size() << " cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
+    case PlanNode::Distinct:
+      out << (node->duplicate_modifier == Reduced ? "->  Reduced" : "->  Distinct");
+      out << "[" << "ordering=" << node->ordering << " cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
+    case PlanNode::TopK:
+      out << "->  Top-k";
+      out << "[" << "k=" << node->limit << " cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
+    case PlanNode::Limit:
+      out << "->  Limit";
+      out << "[" << "offset=" << node->offset << " limit=" << node->limit << " cardinality=" << node->cardinality << " cost=" << node->costs << "]";
+      break;
     case PlanNode::ResultsPrinter:
       out << "->  Results printer";
       out << "[" << "cardinality=" << node->cardinality << " cost=" << node->costs << "]";
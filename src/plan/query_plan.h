@@ -33,7 +33,7 @@ struct JoinNode {
 };
 
 struct PlanNode {
-  enum Operator { TableScan, Filter, HashJoin, BackProbeHashJoin, ResultsPrinter };
+  enum Operator { TableScan, Filter, HashJoin, MergeJoin, BackProbeHashJoin, LeapfrogTriejoin, OptionalJoin, Union, Aggregate, Distinct, TopK, Limit, ResultsPrinter };
   Operator op;
 
   PlanNode* next;
@@ -42,7 +42,8 @@ struct PlanNode {
   std::set<uint32_t> required_res;
   BitSet available_res;
 
-  //Store for BackProbeHashJoin
+  //Store for BackProbeHashJoin, LeapfrogTriejoin keeps its variable order in join_res,
+  //OptionalJoin builds child 0, the OPTIONAL, and probes child 1 on join_res[0]
   std::vector<JoinNode> join_nodes;
   BitSet head, tail;
   bool is_star;
@@ -54,16 +55,27 @@ struct PlanNode {
   QueryNode query_node;
 
   // Store for Filter
-  uint32_t filter_key;
-  uint32_t filter_value;
+  std::vector<const QueryExpression*> filters;
 
-  // Store for ResultsPrinter
+  // Store for Aggregate, grouped on group_res
+  std::vector<uint32_t> group_res;
+  std::vector<Aggregation> aggregations;
+
+  // Store for Distinct and ResultsPrinter
   std::vector<QueryResource> projection;
+  DuplicateModifier duplicate_modifier;
+
+  // Store for TopK and Limit, a negative limit keeps every row
+  std::vector<uint32_t> order_res;
+  std::vector<bool> ascending;
+  int limit;
+  int offset;
 
   double cardinality;
   double costs;
   std::map<uint32_t, double> densities;
 
+  // variable the output rows are sorted on, or -1
   int ordering;
 };
 
@@ -75,7 +87,7 @@ public:
   QueryPlan();
   ~QueryPlan();
 
-  void execute(Runtime& runtime, bool silent);
+  void execute(Runtime& runtime, bool silent, bool explain=false);
   void print();
 
 protected:
@@ -10,15 +10,54 @@ QueryPlanner::~QueryPlanner() { delete plan; }
 QueryPlanner::QuerySolution::QuerySolution(size_t num_of_nodes) : nodes(num_of_nodes) {}
 
 QueryPlan* QueryPlanner::build(const QueryGraph& graph) {
+  if(!isOrderSupported(graph)) {
+    return nullptr;
+  }
   QueryPlan* new_plan = new QueryPlan();
   plan = new_plan;
 
-  std::vector<QuerySolution*> node_solutions(graph.numOfNodes());
+  PlanNode* best_node = buildGroup(graph, graph.getQueryPattern());
+
+  std::vector<const QueryExpression*> filters;
+  collectFilters(graph.getQueryPattern(), filters);
+  if(!filters.empty()) {
+    best_node = createFilterNode(filters, best_node);
+  }
+  if(!graph.getGroupBy().empty() || !graph.getAggregations().empty()) {
+    best_node = createAggregateNode(graph, best_node);
+  }
+  if(graph.getDuplicateModifier() != None) {
+    best_node = createDistinctNode(graph, best_node);
+  }
+  if(!graph.getOrder().empty()) {
+    best_node = createTopKNode(graph, best_node);
+  }
+  if(graph.getLimit() >= 0 || graph.getOffset() > 0) {
+    best_node = createLimitNode(graph, best_node);
+  }
+
+  plan->root = createResultsPrinterNode(graph, best_node);
+
+  std::set<uint32_t> required_res;
+  bindResource(plan->root, required_res);
+  optimize(plan->root);
+
+  plan = nullptr;
+  return new_plan;
+}
+
+std::unique_ptr<QueryPlan> QueryPlanner::build(const QueryGraph& graph, StatisticsManager& stat_manager) {
+  QueryPlanner planner(stat_manager);
+  return std::unique_ptr<QueryPlan>(planner.build(graph));
+}
+
+PlanNode* QueryPlanner::buildNodes(const QueryGraph& graph, const std::vector<int>& node_indexes) {
+  std::vector<QuerySolution*> node_solutions(node_indexes.size());
   std::unordered_map<int, std::vector<int>> res_to_node;
   int max_count = 0;
   uint32_t max_res = 0;
-  for(int i=0; i<graph.numOfNodes(); i++) {
-    QuerySolution* solution = buildScan(graph, i);
+  for(int i=0; i<node_indexes.size(); i++) {
+    QuerySolution* solution = buildScan(graph, node_indexes[i]);
     node_solutions[i] = solution;
 
     if(solution->root->query_node.subject.type == QueryResource::Variable) {
@@ -37,48 +76,108 @@ QueryPlan* QueryPlanner::build(const QueryGraph& graph) {
     }
   }
 
-  if(res_to_node[max_res].size() > 2 && (double)res_to_node[max_res].size()/node_solutions.size() > 0.5) {
-    std::vector<QuerySolution*> sub_solutions;
-    std::vector<int> node_indexes = res_to_node[max_res];
-    int i=0, j=0;
-    std::vector<QuerySolution*>::iterator iter = node_solutions.begin();
-    while(iter != node_solutions.end()) {
-      if(i<node_indexes.size() && j==node_indexes[i]) {
-        sub_solutions.push_back(*iter);
-        iter = node_solutions.erase(iter);
-        i++;
-      } else {
-        ++iter;
+  PlanNode* best_node;
+  if(isCyclic(graph, node_solutions)) {
+    // pairwise plans of cyclic patterns blow up their intermediate results
+    best_node = buildLeapfrogTriejoin(graph, node_solutions)->root;
+  } else {
+    if(res_to_node[max_res].size() > 2 && (double)res_to_node[max_res].size()/node_solutions.size() > 0.5) {
+      std::vector<QuerySolution*> sub_solutions;
+      std::vector<int> star_indexes = res_to_node[max_res];
+      int i=0, j=0;
+      std::vector<QuerySolution*>::iterator iter = node_solutions.begin();
+      while(iter != node_solutions.end()) {
+        if(i<star_indexes.size() && j==star_indexes[i]) {
+          sub_solutions.push_back(*iter);
+          iter = node_solutions.erase(iter);
+          i++;
+        } else {
+          ++iter;
+        }
+        j++;
       }
-      j++;
+
+      node_solutions.push_back(buildStar(graph, sub_solutions, max_res));
     }
 
-    node_solutions.push_back(buildStar(graph, sub_solutions, max_res));
+    QuerySolution *solution = buildJoin(graph, graph.getQueryPattern(), node_solutions);
+    PlanNode* join_node = solution->root;
+    best_node = solution->root;
+    while(join_node != nullptr) {
+      if(join_node->costs < best_node->costs) {
+        best_node = join_node;
+      }
+      join_node = join_node->next;
+    }
   }
+  return best_node;
+}
 
-  QuerySolution *solution = buildJoin(graph, graph.getQueryPattern(), node_solutions);
-  PlanNode* join_node = solution->root;
-  PlanNode* best_node = solution->root;
-  while(join_node != nullptr) {
-    if(join_node->costs < best_node->costs) {
-      best_node = join_node;
+PlanNode* QueryPlanner::buildGroup(const QueryGraph& graph, const QueryPattern* pattern) {
+  if(pattern->type == QueryPattern::Union) {
+    QuerySolution* solution = buildUnion(graph, pattern);
+    return solution == nullptr ? nullptr : solution->root;
+  }
+  // The triples of the group outside its OPTIONALs are joined first, and
+  // every OPTIONAL is then left joined to them in turn.
+  std::vector<int> node_indexes;
+  collectNodes(pattern, node_indexes);
+  std::vector<const QueryPattern*> optionals;
+  collectOptionals(pattern, optionals);
+
+  int i = 0;
+  PlanNode* node = nullptr;
+  if(!node_indexes.empty()) {
+    node = buildNodes(graph, node_indexes);
+  }
+  while(node == nullptr && i < optionals.size()) {
+    // an OPTIONAL of an empty group extends the empty solution
+    node = buildNestedGroup(graph, optionals[i++]);
+  }
+  if(node == nullptr) {
+    return nullptr;
+  }
+  for(; i<optionals.size(); i++) {
+    PlanNode* optional_node = buildNestedGroup(graph, optionals[i]);
+    if(optional_node != nullptr) {
+      node = createOptionalJoin(node, optional_node);
     }
-    join_node = join_node->next;
   }
+  return node;
+}
 
-  plan->root = createResultsPrinterNode(graph, best_node);
-
-  std::set<uint32_t> required_res;
-  bindResource(plan->root, required_res);
-  optimize(plan->root);
-
-  plan = nullptr;
-  return new_plan;
+PlanNode* QueryPlanner::buildNestedGroup(const QueryGraph& graph, const QueryPattern* pattern) {
+  PlanNode* node = buildGroup(graph, pattern);
+  std::vector<const QueryExpression*> filters;
+  collectFilters(pattern, filters);
+  if(node != nullptr && !filters.empty()) {
+    node = createFilterNode(filters, node);
+  }
+  return node;
 }
 
-std::unique_ptr<QueryPlan> QueryPlanner::build(const QueryGraph& graph, StatisticsManager& stat_manager) {
-  QueryPlanner planner(stat_manager);
-  return std::unique_ptr<QueryPlan>(planner.build(graph));
+QueryPlanner::QuerySolution* QueryPlanner::buildUnion(const QueryGraph& graph, const QueryPattern* pattern) {
+  // every branch is planned and costed on its own
+  std::vector<PlanNode*> child_nodes;
+  std::vector<int> node_indexes;
+  for(int i=0; i<pattern->sub_patterns.size(); i++) {
+    PlanNode* child = buildNestedGroup(graph, pattern->sub_patterns[i]);
+    if(child != nullptr) {
+      child_nodes.push_back(child);
+      collectNodes(pattern->sub_patterns[i], node_indexes);
+    }
+  }
+  if(child_nodes.empty()) {
+    return nullptr;
+  }
+
+  QuerySolution* solution = solution_pool.alloc();
+  solution->nodes = BitSet(graph.numOfNodes());
+  for(int i=0; i<node_indexes.size(); i++) {
+    solution->nodes.set(node_indexes[i]);
+  }
+  solution->root = child_nodes.size() == 1 ? child_nodes[0] : createUnionNode(child_nodes);
+  return solution;
 }
 
 QueryPlanner::QuerySolution* QueryPlanner::buildStar(const QueryGraph& graph, std::vector<QuerySolution*>& child_solutions, uint32_t join_key) {
@@ -244,9 +343,22 @@ QueryPlanner::QuerySolution* QueryPlanner::buildJoin(const QueryGraph& graph, co
               join_nodes.push_back(JoinNode(UINT32_MAX, join_key));
               BitSet available_res = left_res|right_res;
 
-              node = createBackProbeHashJoin(child_nodes, join_nodes, join_res, available_res);
               double left_cost = std::min(left->cardinality, right->cardinality*right->densities[join_key]/left->densities[join_key]);
-              node->costs = right->costs + right->cardinality + left->costs + left_cost;
+              if(left->ordering == (int)join_key && right->ordering == (int)join_key) {
+                // both sides arrive sorted on the key, so they are merged
+                // without building a hash table
+                node = createMergeJoin(child_nodes, join_nodes, join_res, available_res);
+                node->costs = right->costs + right->cardinality + left->costs + left->cardinality;
+                node->ordering = join_key;
+              } else if(left->op == PlanNode::TableScan && left->triple_order == TripleOrder::P) {
+                node = createBackProbeHashJoin(child_nodes, join_nodes, join_res, available_res);
+                node->costs = right->costs + right->cardinality + left->costs + left_cost;
+              } else {
+                // the keys of the right side cannot be pushed into the left
+                // one, which is streamed through a pipelined binary join
+                node = createHashJoin(child_nodes, join_nodes, join_res, available_res);
+                node->costs = right->costs + right->cardinality + left->costs + left->cardinality;
+              }
               node->cardinality = left_cost;
             }
 
@@ -273,6 +385,115 @@ QueryPlanner::QuerySolution* QueryPlanner::buildJoin(const QueryGraph& graph, co
 }
 
 
+static int findRoot(std::vector<int>& parents, int x) {
+  while(parents[x] != x) {
+    parents[x] = parents[parents[x]];
+    x = parents[x];
+  }
+  return x;
+}
+
+bool QueryPlanner::isCyclic(const QueryGraph& graph, const std::vector<QuerySolution*>& node_solutions) {
+  std::vector<const QueryNode*> query_nodes;
+  for(int i=0; i<node_solutions.size(); i++) {
+    PlanNode* node = node_solutions[i]->root;
+    if(node->op != PlanNode::TableScan) {
+      return false;
+    }
+    query_nodes.push_back(&node->query_node);
+  }
+  return isCyclic(graph.numOfVariables(), query_nodes);
+}
+
+bool QueryPlanner::isCyclic(int num_variables, const std::vector<const QueryNode*>& query_nodes) {
+  // Variables are vertices and patterns binding two of them are edges; an
+  // edge between two variables that are already connected closes a cycle.
+  std::vector<int> parents(num_variables);
+  for(int v=0; v<parents.size(); v++) {
+    parents[v] = v;
+  }
+  bool cyclic = false;
+  for(int i=0; i<query_nodes.size(); i++) {
+    const QueryNode* query_node = query_nodes[i];
+    if(query_node->subject.type != QueryResource::Variable || query_node->object.type != QueryResource::Variable) {
+      continue;
+    }
+    // ?x p ?x binds one variable, a self loop that joins nothing
+    if(query_node->subject.id == query_node->object.id) {
+      continue;
+    }
+    int x = findRoot(parents, query_node->subject.id);
+    int y = findRoot(parents, query_node->object.id);
+    if(x == y) {
+      cyclic = true;
+    } else {
+      parents[x] = y;
+    }
+  }
+  return cyclic;
+}
+
+QueryPlanner::QuerySolution* QueryPlanner::buildLeapfrogTriejoin(const QueryGraph& graph, const std::vector<QuerySolution*>& child_solutions) {
+  QuerySolution* solution = solution_pool.alloc();
+  solution->nodes = BitSet(graph.numOfNodes());
+
+  BitSet available_res(graph.numOfVariables());
+  std::vector<PlanNode*> child_nodes;
+  std::map<uint32_t, std::vector<PlanNode*>> res_to_nodes;
+  for(int i=0; i<child_solutions.size(); i++) {
+    PlanNode* child = child_solutions[i]->root;
+    solution->nodes |= child_solutions[i]->nodes;
+    available_res |= child->available_res;
+    child_nodes.push_back(child);
+    for(BitSet::SetBitIterator iter = child->available_res.begin(); iter != child->available_res.end(); ++iter) {
+      res_to_nodes[*iter].push_back(child);
+    }
+  }
+
+  // Variable order: the variable of most patterns first, then always the
+  // one sharing most patterns with the variables already ordered, so that
+  // every level is intersected over as many inputs as possible. Ties go to
+  // the variable of the smallest pattern.
+  std::vector<uint32_t> join_res;
+  std::set<PlanNode*> bound_nodes;
+  while(join_res.size() < res_to_nodes.size()) {
+    uint32_t best_res = UINT32_MAX;
+    int best_bound = -1, best_count = -1;
+    double best_card = 0;
+    for(std::map<uint32_t, std::vector<PlanNode*>>::iterator iter = res_to_nodes.begin(); iter != res_to_nodes.end(); ++iter) {
+      if(std::find(join_res.begin(), join_res.end(), iter->first) != join_res.end()) {
+        continue;
+      }
+      int bound = 0;
+      double card = iter->second[0]->cardinality;
+      for(int x=0; x<iter->second.size(); ++x) {
+        bound += bound_nodes.count(iter->second[x]);
+        card = std::min(card, iter->second[x]->cardinality);
+      }
+      int count = iter->second.size();
+      if(bound > best_bound || (bound == best_bound && (count > best_count || (count == best_count && card < best_card)))) {
+        best_res = iter->first;
+        best_bound = bound;
+        best_count = count;
+        best_card = card;
+      }
+    }
+    join_res.push_back(best_res);
+    bound_nodes.insert(res_to_nodes[best_res].begin(), res_to_nodes[best_res].end());
+  }
+
+  PlanNode* node = createLeapfrogTriejoin(child_nodes, join_res, available_res);
+  node->costs = 0;
+  node->cardinality = child_nodes[0]->cardinality;
+  for(int x=0; x<child_nodes.size(); ++x) {
+    node->costs += child_nodes[x]->costs + child_nodes[x]->cardinality;
+    node->cardinality = std::min(node->cardinality, child_nodes[x]->cardinality);
+  }
+
+  solution->root = node;
+  return solution;
+}
+
 QueryPlanner::QuerySolution* QueryPlanner::buildScan(const QueryGraph& graph, int node_index) {
   QuerySolution *solution = solution_pool.alloc();
   solution->nodes = BitSet(graph.numOfNodes());
@@ -289,6 +510,29 @@ PlanNode* QueryPlanner::createHashJoin(const std::vector<PlanNode*>& child_nodes
   PlanNode* node = plan->createPlanNode();
   node->op = PlanNode::HashJoin;
   node->next = nullptr;
+  node->ordering = -1;
+  node->child_nodes = child_nodes;
+  node->join_nodes = join_nodes;
+  node->join_res = join_res;
+  node->available_res = available_res;
+  node->densities = std::map<uint32_t, double>();
+  for(int i=0; i<child_nodes.size(); ++i) {
+    for (std::map<uint32_t, double>::iterator it = child_nodes[i]->densities.begin(); it != child_nodes[i]->densities.end(); ++it) {
+      if(node->densities.count(it->first)) {
+        node->densities[it->first] = std::max(node->densities[it->first], it->second);
+      } else {
+        node->densities[it->first] = it->second;
+      }
+    }
+  }
+  return node;
+}
+
+PlanNode* QueryPlanner::createMergeJoin(const std::vector<PlanNode*>& child_nodes, const std::vector<JoinNode>& join_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::MergeJoin;
+  node->next = nullptr;
+  node->ordering = -1;
   node->child_nodes = child_nodes;
   node->join_nodes = join_nodes;
   node->join_res = join_res;
@@ -306,10 +550,32 @@ PlanNode* QueryPlanner::createHashJoin(const std::vector<PlanNode*>& child_nodes
   return node;
 }
 
+PlanNode* QueryPlanner::createLeapfrogTriejoin(const std::vector<PlanNode*>& child_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::LeapfrogTriejoin;
+  node->next = nullptr;
+  node->ordering = join_res.empty() ? -1 : join_res[0];
+  node->child_nodes = child_nodes;
+  node->join_res = join_res;
+  node->available_res = available_res;
+  node->densities = std::map<uint32_t, double>();
+  for(int i=0; i<child_nodes.size(); ++i) {
+    for (std::map<uint32_t, double>::iterator it = child_nodes[i]->densities.begin(); it != child_nodes[i]->densities.end(); ++it) {
+      if(node->densities.count(it->first)) {
+        node->densities[it->first] = std::max(node->densities[it->first], it->second);
+      } else {
+        node->densities[it->first] = it->second;
+      }
+    }
+  }
+  return node;
+}
+
 PlanNode* QueryPlanner::createBackProbeHashJoin(const std::vector<PlanNode*>& child_nodes, const std::vector<JoinNode>& join_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res) {
   PlanNode* node = plan->createPlanNode();
   node->op = PlanNode::BackProbeHashJoin;
   node->next = nullptr;
+  node->ordering = -1;
   node->child_nodes = child_nodes;
   node->join_nodes = join_nodes;
   node->join_res = join_res;
@@ -327,6 +593,107 @@ PlanNode* QueryPlanner::createBackProbeHashJoin(const std::vector<PlanNode*>& ch
   return node;
 }
 
+BitSet QueryPlanner::getCertainRes(const PlanNode* node) {
+  switch(node->op) {
+    case PlanNode::TableScan:
+      return node->available_res;
+    case PlanNode::OptionalJoin:
+      return getCertainRes(node->child_nodes[1]);
+    case PlanNode::HashJoin:
+    case PlanNode::MergeJoin:
+    case PlanNode::BackProbeHashJoin:
+    case PlanNode::LeapfrogTriejoin:
+      {
+        BitSet res = getCertainRes(node->child_nodes[0]);
+        for(int i=1; i<node->child_nodes.size(); i++) {
+          res |= getCertainRes(node->child_nodes[i]);
+        }
+        return res;
+      }
+    case PlanNode::Union:
+      {
+        BitSet res = getCertainRes(node->child_nodes[0]);
+        for(int i=1; i<node->child_nodes.size(); i++) {
+          res &= getCertainRes(node->child_nodes[i]);
+        }
+        return res;
+      }
+    default:
+      return node->child_nodes.empty() ? node->available_res : getCertainRes(node->child_nodes[0]);
+  }
+}
+
+uint32_t QueryPlanner::getOptionalJoinKey(const PlanNode* required, const PlanNode* optional) {
+  // A hash lookup only finds equal keys, so the key must be bound on every
+  // row of both sides; other shared variables are compared with unbound
+  // values matching any other. Without such a key every required row is
+  // compared with every optional row.
+  BitSet key_res = getCertainRes(required);
+  key_res &= getCertainRes(optional);
+  return key_res.any() ? *key_res.begin() : UINT32_MAX;
+}
+
+PlanNode* QueryPlanner::createOptionalJoin(PlanNode* required, PlanNode* optional) {
+  // The optional side is built and the required one probed, so the rows
+  // of the required side stream through as they are produced.
+  uint32_t join_key = getOptionalJoinKey(required, optional);
+
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::OptionalJoin;
+  node->next = nullptr;
+  // rows leave in the order of the required side
+  node->ordering = required->ordering;
+  node->child_nodes.push_back(optional);
+  node->child_nodes.push_back(required);
+  node->join_nodes.push_back(JoinNode(UINT32_MAX, join_key));
+  node->join_nodes.push_back(JoinNode(UINT32_MAX, join_key));
+  node->join_res.push_back(join_key);
+  node->available_res = required->available_res | optional->available_res;
+  node->densities = required->densities;
+  for(std::map<uint32_t, double>::iterator it = optional->densities.begin(); it != optional->densities.end(); ++it) {
+    if(!node->densities.count(it->first)) {
+      node->densities[it->first] = it->second;
+    }
+  }
+  node->costs = required->costs + required->cardinality + optional->costs + optional->cardinality;
+  // every required row is kept, matched or not
+  node->cardinality = required->cardinality;
+  if(join_key == UINT32_MAX) {
+    node->costs += required->cardinality * optional->cardinality;
+    // an OPTIONAL sharing no variable extends every row with all its rows
+    BitSet shared_res = required->available_res & optional->available_res;
+    if(!shared_res.any()) {
+      node->cardinality = required->cardinality * std::max(1.0, optional->cardinality);
+    }
+  }
+  return node;
+}
+
+PlanNode* QueryPlanner::createUnionNode(const std::vector<PlanNode*>& child_nodes) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::Union;
+  node->next = nullptr;
+  node->ordering = -1;
+  node->child_nodes = child_nodes;
+  node->available_res = child_nodes[0]->available_res;
+  node->densities = std::map<uint32_t, double>();
+  node->costs = 0;
+  node->cardinality = 0;
+  for(int i=0; i<child_nodes.size(); ++i) {
+    node->available_res |= child_nodes[i]->available_res;
+    node->costs += child_nodes[i]->costs + child_nodes[i]->cardinality;
+    node->cardinality += child_nodes[i]->cardinality;
+    for (std::map<uint32_t, double>::iterator it = child_nodes[i]->densities.begin(); it != child_nodes[i]->densities.end(); ++it) {
+      if(node->densities.count(it->first)) {
+        node->densities[it->first] = std::max(node->densities[it->first], it->second);
+      } else {
+        node->densities[it->first] = it->second;
+      }
+    }
+  }
+  return node;
+}
+
 PlanNode* QueryPlanner::createTableScanNode(int node_index, const QueryNode& query_node, int total_num_variables) {
   PlanNode* node = plan->createPlanNode();
   node->op = PlanNode::TableScan;
@@ -361,38 +728,169 @@ PlanNode* QueryPlanner::createTableScanNode(int node_index, const QueryNode& que
     node->available_res = BitSet(total_num_variables);
     node->available_res.set(query_node.subject.id);
     node->available_res.set(query_node.object.id);
+    // P order segments are stored sorted by subject
+    node->ordering = query_node.subject.id;
   }
 
-  if(query_node.subject.id == query_node.object.id) {
-    node = createFilterNode(query_node.subject.id, 0, node);
-  }
   return node;
 }
 
-PlanNode* QueryPlanner::createFilterNode(uint32_t filter_key, uint32_t filter_value, PlanNode* child) {
+PlanNode* QueryPlanner::createFilterNode(const std::vector<const QueryExpression*>& filters, PlanNode* child) {
   PlanNode* node = plan->createPlanNode();
   node->op = PlanNode::Filter;
   node->next = nullptr;
+  node->ordering = child->ordering;
   node->child_nodes.push_back(child);
-  node->filter_key = filter_key;
-  node->filter_value = filter_value;
+  node->filters = filters;
   node->available_res = child->available_res;
-  node->costs = child->costs + child->cardinality;
+  node->densities = child->densities;
+  node->costs = child->costs + LowerBoundsCostModel::estimateFilter(child->cardinality);
+  // every condition is assumed to keep half of the rows
+  node->cardinality = child->cardinality / (1 << std::min<size_t>(filters.size(), 16));
+  return node;
+}
+
+PlanNode* QueryPlanner::createAggregateNode(const QueryGraph& graph, PlanNode* child) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::Aggregate;
+  node->next = nullptr;
+  node->child_nodes.push_back(child);
+  node->aggregations = graph.getAggregations();
+  // a solution is a group, which binds its keys and aggregates only
+  node->available_res = BitSet(graph.numOfVariables());
+  const std::vector<QueryResource>& group_by = graph.getGroupBy();
+  for(int i=0; i<group_by.size(); i++) {
+    node->group_res.push_back(group_by[i].id);
+    node->available_res.set(group_by[i].id);
+  }
+  for(int i=0; i<node->aggregations.size(); i++) {
+    node->available_res.set(node->aggregations[i].variable.id);
+  }
+  node->ordering = -1;
+  node->costs = child->costs + LowerBoundsCostModel::estimateFilter(child->cardinality);
+  // at most one group per row, and a single one without GROUP BY
+  node->cardinality = node->group_res.empty() ? 1 : child->cardinality;
+  return node;
+}
+
+PlanNode* QueryPlanner::createDistinctNode(const QueryGraph& graph, PlanNode* child) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::Distinct;
+  node->next = nullptr;
+  node->child_nodes.push_back(child);
+  node->projection = graph.getProjection();
+  node->duplicate_modifier = graph.getDuplicateModifier();
+  // rows sorted on a projected variable are deduplicated one value at a time
+  node->ordering = -1;
+  for(int i=0; i<node->projection.size(); i++) {
+    if((int)node->projection[i].id == child->ordering) {
+      node->ordering = child->ordering;
+    }
+  }
+  node->available_res = child->available_res;
+  node->costs = child->costs + LowerBoundsCostModel::estimateFilter(child->cardinality);
   node->cardinality = child->cardinality;
   return node;
 }
 
+PlanNode* QueryPlanner::createTopKNode(const QueryGraph& graph, PlanNode* child) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::TopK;
+  node->next = nullptr;
+  node->child_nodes.push_back(child);
+  // only the rows up to the end of the slice need to be ordered
+  node->limit = graph.getLimit() >= 0 ? graph.getLimit() + graph.getOffset() : -1;
+  node->offset = 0;
+  const std::vector<Order>& order = graph.getOrder();
+  for(int i=0; i<order.size(); i++) {
+    node->order_res.push_back(order[i].condition->id);
+    node->ascending.push_back(order[i].ascending);
+  }
+  node->ordering = -1;
+  node->available_res = child->available_res;
+  node->costs = child->costs + LowerBoundsCostModel::estimateFilter(child->cardinality);
+  node->cardinality = node->limit >= 0 ? std::min<double>(child->cardinality, node->limit) : child->cardinality;
+  return node;
+}
+
+PlanNode* QueryPlanner::createLimitNode(const QueryGraph& graph, PlanNode* child) {
+  PlanNode* node = plan->createPlanNode();
+  node->op = PlanNode::Limit;
+  node->next = nullptr;
+  node->child_nodes.push_back(child);
+  node->limit = graph.getLimit();
+  node->offset = graph.getOffset();
+  node->ordering = child->ordering;
+  node->available_res = child->available_res;
+  node->costs = child->costs;
+  node->cardinality = std::max<double>(child->cardinality - node->offset, 0);
+  if(node->limit >= 0) {
+    node->cardinality = std::min<double>(node->cardinality, node->limit);
+  }
+  return node;
+}
+
 PlanNode* QueryPlanner::createResultsPrinterNode(const QueryGraph& graph, PlanNode* child) {
   PlanNode* node = plan->createPlanNode();
   node->op = PlanNode::ResultsPrinter;
   node->next = nullptr;
   node->child_nodes.push_back(child);
   node->projection = graph.getProjection();
+  node->ordering = -1;
   node->costs = child->costs + child->cardinality;
   node->cardinality = child->cardinality;
   return node;
 }
 
+bool QueryPlanner::isOrderSupported(const QueryGraph& graph) {
+  const std::vector<Order>& order = graph.getOrder();
+  for(int i=0; i<order.size(); i++) {
+    if(order[i].condition->type != QueryExpression::Variable) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void QueryPlanner::collectNodes(const QueryPattern* pattern, std::vector<int>& nodes) {
+  if(pattern == nullptr || pattern->type == QueryPattern::Union) {
+    return;
+  }
+  nodes.insert(nodes.end(), pattern->nodes.begin(), pattern->nodes.end());
+  for(int i=0; i<pattern->sub_patterns.size(); i++) {
+    collectNodes(pattern->sub_patterns[i], nodes);
+  }
+}
+
+void QueryPlanner::collectOptionals(const QueryPattern* pattern, std::vector<const QueryPattern*>& optionals) {
+  if(pattern == nullptr || pattern->type == QueryPattern::Union) {
+    return;
+  }
+  optionals.insert(optionals.end(), pattern->optionals.begin(), pattern->optionals.end());
+  for(int i=0; i<pattern->sub_patterns.size(); i++) {
+    collectOptionals(pattern->sub_patterns[i], optionals);
+  }
+}
+
+void QueryPlanner::collectFilters(const QueryPattern* pattern, std::vector<const QueryExpression*>& filters) {
+  if(pattern == nullptr || pattern->type == QueryPattern::Union) {
+    return;
+  }
+  filters.insert(filters.end(), pattern->filters.begin(), pattern->filters.end());
+  for(int i=0; i<pattern->sub_patterns.size(); i++) {
+    collectFilters(pattern->sub_patterns[i], filters);
+  }
+}
+
+void QueryPlanner::collectVariables(const QueryExpression* exp, std::set<uint32_t>& res) {
+  if(exp->type == QueryExpression::Variable) {
+    res.insert(exp->id);
+  }
+  for(int i=0; i<exp->arg_list.size(); i++) {
+    collectVariables(exp->arg_list[i], res);
+  }
+}
+
 void QueryPlanner::bindResource(PlanNode* node, const std::set<uint32_t>& required_res) {
   node->required_res = required_res;
   std::set<uint32_t> res = required_res;
@@ -400,7 +898,30 @@ void QueryPlanner::bindResource(PlanNode* node, const std::set<uint32_t>& requir
     for(int i=0; i<node->projection.size(); i++) {
       res.insert(node->projection[i].id);
     }
-  } else if(node->op == PlanNode::HashJoin || node->op == PlanNode::BackProbeHashJoin) {
+  } else if(node->op == PlanNode::Aggregate) {
+    // rows are only read for their group keys and aggregated variables
+    res.clear();
+    res.insert(node->group_res.begin(), node->group_res.end());
+    for(int i=0; i<node->aggregations.size(); i++) {
+      if(node->aggregations[i].argument != nullptr) {
+        res.insert(node->aggregations[i].argument->id);
+      }
+    }
+    // COUNT(*) still needs a column to count the rows, unless they come
+    // with their counts from a back-probe join
+    PlanNode* child = node->child_nodes[0];
+    if(res.empty() && child->op != PlanNode::BackProbeHashJoin && child->available_res.any()) {
+      res.insert(*child->available_res.begin());
+    }
+  } else if(node->op == PlanNode::Distinct) {
+    // rows are distinct on the projection, no other variable is passed on
+    res.clear();
+    for(int i=0; i<node->projection.size(); i++) {
+      res.insert(node->projection[i].id);
+    }
+  } else if(node->op == PlanNode::TopK) {
+    res.insert(node->order_res.begin(), node->order_res.end());
+  } else if(node->op == PlanNode::HashJoin || node->op == PlanNode::MergeJoin || node->op == PlanNode::BackProbeHashJoin) {
     for(int i=1; i<node->join_nodes.size(); i++) {
       if(node->join_nodes[i].left_join_key != UINT32_MAX) {
         res.insert(node->join_nodes[i].left_join_key);
@@ -409,6 +930,43 @@ void QueryPlanner::bindResource(PlanNode* node, const std::set<uint32_t>& requir
         res.insert(node->join_nodes[i].right_join_key);
       }
     }
+  } else if(node->op == PlanNode::OptionalJoin) {
+    // optional rows must agree with the required row on every shared variable
+    BitSet shared_res = node->child_nodes[0]->available_res & node->child_nodes[1]->available_res;
+    for(BitSet::SetBitIterator iter = shared_res.begin(); iter != shared_res.end(); ++iter) {
+      res.insert(*iter);
+    }
+    // without a key both sides still need a column to count their rows
+    if(!shared_res.any()) {
+      for(int i=0; i<node->child_nodes.size(); i++) {
+        if(node->child_nodes[i]->available_res.any()) {
+          res.insert(*node->child_nodes[i]->available_res.begin());
+        }
+      }
+    }
+  } else if(node->op == PlanNode::Union) {
+    // a branch binding none of the variables still needs a column to
+    // count its rows
+    for(int i=0; i<node->child_nodes.size(); i++) {
+      PlanNode* child = node->child_nodes[i];
+      std::set<uint32_t> child_res = res;
+      bool bound = false;
+      for(std::set<uint32_t>::iterator iter = res.begin(); iter != res.end() && !bound; ++iter) {
+        bound = child->available_res.test(*iter);
+      }
+      if(!bound && child->available_res.any()) {
+        child_res.insert(*child->available_res.begin());
+      }
+      bindResource(child, child_res);
+    }
+    return;
+  } else if(node->op == PlanNode::Filter) {
+    for(int i=0; i<node->filters.size(); i++) {
+      collectVariables(node->filters[i], res);
+    }
+  } else if(node->op == PlanNode::LeapfrogTriejoin) {
+    // every variable is a level of the tries of its patterns
+    res.insert(node->join_res.begin(), node->join_res.end());
   }
 
   for(int i=0; i<node->child_nodes.size(); i++) {
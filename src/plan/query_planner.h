@@ -28,22 +28,50 @@ public:
   QueryPlanner(StatisticsManager& stat_manager);
   ~QueryPlanner();
 
+  // nullptr if the query cannot be planned, see isOrderSupported
   QueryPlan* build(const QueryGraph& graph);
 
   static std::unique_ptr<QueryPlan> build(const QueryGraph& graph, StatisticsManager& stat_manager);
 
 private:
+  PlanNode* buildGroup(const QueryGraph& graph, const QueryPattern* pattern);
+  PlanNode* buildNestedGroup(const QueryGraph& graph, const QueryPattern* pattern);
+  PlanNode* buildNodes(const QueryGraph& graph, const std::vector<int>& node_indexes);
   QuerySolution* buildStar(const QueryGraph& graph, std::vector<QuerySolution*>& child_solutions, uint32_t join_key);
   QuerySolution* buildJoin(const QueryGraph& graph, const QueryPattern* pattern, const std::vector<QuerySolution*>& node_solutions);
+  QuerySolution* buildLeapfrogTriejoin(const QueryGraph& graph, const std::vector<QuerySolution*>& child_solutions);
   QuerySolution* buildUnion(const QueryGraph& graph, const QueryPattern* pattern);
   QuerySolution* buildScan(const QueryGraph& graph, int node_index);
 
   PlanNode* createHashJoin(const std::vector<PlanNode*>& child_nodes, const std::vector<JoinNode>& join_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res);
+  PlanNode* createMergeJoin(const std::vector<PlanNode*>& child_nodes, const std::vector<JoinNode>& join_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res);
+  PlanNode* createLeapfrogTriejoin(const std::vector<PlanNode*>& child_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res);
   PlanNode* createBackProbeHashJoin(const std::vector<PlanNode*>& child_nodes, const std::vector<JoinNode>& join_nodes, const std::vector<uint32_t>& join_res, BitSet& available_res);
+  PlanNode* createUnionNode(const std::vector<PlanNode*>& child_nodes);
+  PlanNode* createOptionalJoin(PlanNode* required, PlanNode* optional);
   PlanNode* createTableScanNode(int node_index, const QueryNode& query_node, int total_num_variables);
-  PlanNode* createFilterNode(uint32_t filter_key, uint32_t filter_value, PlanNode* child);
+  PlanNode* createFilterNode(const std::vector<const QueryExpression*>& filters, PlanNode* child);
+  PlanNode* createAggregateNode(const QueryGraph& graph, PlanNode* child);
+  PlanNode* createDistinctNode(const QueryGraph& graph, PlanNode* child);
+  PlanNode* createTopKNode(const QueryGraph& graph, PlanNode* child);
+  PlanNode* createLimitNode(const QueryGraph& graph, PlanNode* child);
   PlanNode* createResultsPrinterNode(const QueryGraph& graph, PlanNode* child);
 
+  // TopK orders by the terms of variables, expressions are not evaluated
+  static bool isOrderSupported(const QueryGraph& graph);
+  bool isCyclic(const QueryGraph& graph, const std::vector<QuerySolution*>& node_solutions);
+  static bool isCyclic(int num_variables, const std::vector<const QueryNode*>& query_nodes);
+  // variables bound on every row of the node, which OPTIONAL may leave
+  // unbound otherwise
+  static BitSet getCertainRes(const PlanNode* node);
+  // variable an OPTIONAL is hashed on, or UINT32_MAX to join without key
+  static uint32_t getOptionalJoinKey(const PlanNode* required, const PlanNode* optional);
+
+  void collectNodes(const QueryPattern* pattern, std::vector<int>& nodes);
+  void collectOptionals(const QueryPattern* pattern, std::vector<const QueryPattern*>& optionals);
+  void collectFilters(const QueryPattern* pattern, std::vector<const QueryExpression*>& filters);
+  void collectVariables(const QueryExpression* exp, std::set<uint32_t>& res);
+
   void bindResource(PlanNode* node, const std::set<uint32_t>& required_res);
 
   void optimize(PlanNode* node);
@@ -53,6 +81,8 @@ private:
   QueryPlan *plan;
 
   MemoryPool<QuerySolution> solution_pool;
+
+  friend class QueryPlannerTest;
 };
 
 
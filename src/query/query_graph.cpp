@@ -5,7 +5,7 @@ QueryNode::QueryNode(QueryResource subject, QueryResource predicate, QueryResour
   : subject(subject), predicate(predicate), object(object) {
 }
 
-QueryGraph::QueryGraph() : var_count(0) {}
+QueryGraph::QueryGraph() : duplicate_modifier(None), limit(-1), offset(0), var_count(0) {}
 
 QueryGraph::~QueryGraph() {}
 
@@ -61,6 +61,18 @@ int QueryGraph::getOffset() const {
   return offset;
 }
 
+const std::vector<Order>& QueryGraph::getOrder() const {
+  return order;
+}
+
+const std::vector<QueryResource>& QueryGraph::getGroupBy() const {
+  return group_by;
+}
+
+const std::vector<Aggregation>& QueryGraph::getAggregations() const {
+  return aggregations;
+}
+
 // set
 
 int QueryGraph::addNode(const QueryNode& node) {
@@ -94,6 +106,14 @@ void QueryGraph::addOrder(const Order& order) {
   this->order.push_back(order);
 }
 
+void QueryGraph::addGroupBy(const std::string& name) {
+  group_by.push_back(QueryResource(QueryResource::Variable, name));
+}
+
+void QueryGraph::addAggregation(const Aggregation& aggregation) {
+  aggregations.push_back(aggregation);
+}
+
 // new
 QueryExpression* QueryGraph::createExpression() {
   return expression_pool.alloc();
@@ -56,6 +56,18 @@ struct Order {
   QueryExpression *condition;
 };
 
+struct Aggregation {
+  enum Function { Count, Sum, Min, Max, Avg };
+  Function function;
+  bool distinct;
+  // the aggregated variable, or nullptr for COUNT(*)
+  QueryExpression *argument;
+  // the variable the result is bound to
+  QueryResource variable;
+
+  Aggregation() : function(Count), distinct(false), argument(nullptr), variable(QueryResource::Variable, "") {}
+};
+
 struct SPARQLParseContext;
 struct YYLTYPE;
 class SemanticAnalyzer;
@@ -76,6 +88,9 @@ public:
   DuplicateModifier getDuplicateModifier() const;
   int getLimit() const;
   int getOffset() const;
+  const std::vector<Order>& getOrder() const;
+  const std::vector<QueryResource>& getGroupBy() const;
+  const std::vector<Aggregation>& getAggregations() const;
 
 private:
   void setQueryForm(QueryForm query_form);
@@ -89,6 +104,8 @@ private:
   void setLimit(int limit);
   void setOffset(int offset);
   void addOrder(const Order& order);
+  void addGroupBy(const std::string& name);
+  void addAggregation(const Aggregation& aggregation);
 
   friend class SemanticAnalyzer;
   friend int yyparse(void* scanner, SPARQLParseContext* context, QueryGraph* query_graph);
@@ -105,6 +122,8 @@ private:
   int limit;
   int offset;
   std::vector<Order> order;
+  std::vector<QueryResource> group_by;
+  std::vector<Aggregation> aggregations;
 
   std::unordered_map<std::string, uint32_t> var_id_map;
   uint32_t var_count;
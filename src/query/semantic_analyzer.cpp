@@ -13,6 +13,24 @@ void SemanticAnalyzer::analyseProjection() {
   }
 }
 
+void SemanticAnalyzer::analyseOrder() {
+  for(std::vector<Order>::iterator it = query_graph->order.begin(), end = query_graph->order.end(); it != end; ++it) {
+    encodeExpression(it->condition);
+  }
+}
+
+void SemanticAnalyzer::analyseAggregation() {
+  for(std::vector<QueryResource>::iterator it = query_graph->group_by.begin(), end = query_graph->group_by.end(); it != end; ++it) {
+    it->id = query_graph->getVariableId(it->value);
+  }
+  for(std::vector<Aggregation>::iterator it = query_graph->aggregations.begin(), end = query_graph->aggregations.end(); it != end; ++it) {
+    if(it->argument != nullptr) {
+      encodeExpression(it->argument);
+    }
+    it->variable.id = query_graph->getVariableId(it->variable.value);
+  }
+}
+
 void SemanticAnalyzer::analysePatternGroup(QueryPattern* pattern) {
   switch(pattern->type) {
     case QueryPattern::Basic:
@@ -39,6 +57,9 @@ void SemanticAnalyzer::analyseBasicGraphPattern(QueryPattern* pattern) {
     QueryNode& node = this->query_graph->nodes[*it];
     encodeNode(&node);
   }
+  for(std::vector<QueryExpression*>::iterator it = pattern->filters.begin(); it != pattern->filters.end(); ++it){
+    encodeExpression(*it);
+  }
   for(std::vector<QueryPattern*>::iterator it = pattern->optionals.begin(); it != pattern->optionals.end(); ++it){
     analysePatternGroup(*it);
   }
@@ -65,12 +86,33 @@ void SemanticAnalyzer::encodeResource(QueryResource* res) {
   }
 }
 
+void SemanticAnalyzer::encodeExpression(QueryExpression* exp) {
+  switch(exp->type){
+    case QueryExpression::Variable:
+      exp->id = query_graph->getVariableId(exp->value);
+      break;
+    case QueryExpression::Literal:
+    case QueryExpression::IRI:
+      uint32_t code;
+      // constants missing from the dictionary cannot equal any stored term
+      exp->id = dict.lookup(exp->value, &code) ? code : UINT32_MAX;
+      break;
+    default:
+      break;
+  }
+  for(std::vector<QueryExpression*>::iterator it = exp->arg_list.begin(); it != exp->arg_list.end(); ++it){
+    encodeExpression(*it);
+  }
+}
+
 void SemanticAnalyzer::analyse(QueryGraph* query_graph) {
   this->query_graph = query_graph;
   if(query_graph->getQueryForm() == QueryForm::SelectQuery) {
     analyseProjection();
   }
   analysePatternGroup(query_graph->pattern);
+  analyseAggregation();
+  analyseOrder();
 }
 
 void SemanticAnalyzer::analyse(QueryGraph* query_graph, Dictionary& dict) {
@@ -21,10 +21,13 @@ public:
 
 private:
   void analyseProjection();
+  void analyseOrder();
+  void analyseAggregation();
   void analysePatternGroup(QueryPattern* pattern);
   void analyseBasicGraphPattern(QueryPattern* pattern);
   void encodeNode(QueryNode* node);
   void encodeResource(QueryResource* res);
+  void encodeExpression(QueryExpression* exp);
 
 
   Dictionary& dict;
@@ -1,14 +1,21 @@
 #include "code_generator.h"
 #include "operator/filter.h"
+#include "operator/deduplicate.h"
+#include "operator/aggregate.h"
+#include "operator/top_k.h"
+#include "operator/limit.h"
 #include "operator/hash_join.h"
+#include "operator/merge_join.h"
 #include "operator/backprobe_hash_join.h"
+#include "operator/leapfrog_triejoin.h"
+#include "operator/union.h"
 #include "operator/table_scan.h"
 #include "operator/results_printer.h"
 
 #include <iostream>
 
 
-CodeGenerator::CodeGenerator(Runtime& runtime, bool silent) : runtime(runtime), silent(silent) {}
+CodeGenerator::CodeGenerator(Runtime& runtime, bool silent, bool explain) : runtime(runtime), silent(silent), explain(explain) {}
 
 CodeGenerator::~CodeGenerator() {}
 
@@ -17,8 +24,8 @@ Operator* CodeGenerator::generate(const PlanNode* plan_node) {
   return generateInternal(plan_node, resources);
 }
 
-Operator* CodeGenerator::generate(Runtime& runtime, const PlanNode* plan_node, bool silent) {
-  CodeGenerator generator(runtime, silent);
+Operator* CodeGenerator::generate(Runtime& runtime, const PlanNode* plan_node, bool silent, bool explain) {
+  CodeGenerator generator(runtime, silent, explain);
   return generator.generate(plan_node);
 }
 
@@ -28,12 +35,27 @@ Operator* CodeGenerator::generateInternal(const PlanNode* plan_node, std::map<ui
       return generateResultsPrinter(plan_node, resources);
     case PlanNode::BackProbeHashJoin:
       return generateBackProbeHashJoin(plan_node, resources);
+    case PlanNode::LeapfrogTriejoin:
+      return generateLeapfrogTriejoin(plan_node, resources);
     case PlanNode::HashJoin:
-      return generateBackProbeHashJoin(plan_node, resources);
+    case PlanNode::OptionalJoin:
+      return generateHashJoin(plan_node, resources);
+    case PlanNode::MergeJoin:
+      return generateMergeJoin(plan_node, resources);
+    case PlanNode::Union:
+      return generateUnion(plan_node, resources);
     case PlanNode::TableScan:
       return generateTableScan(plan_node, resources);
     case PlanNode::Filter:
       return generateFilter(plan_node, resources);
+    case PlanNode::Aggregate:
+      return generateAggregate(plan_node, resources);
+    case PlanNode::Distinct:
+      return generateDistinct(plan_node, resources);
+    case PlanNode::TopK:
+      return generateTopK(plan_node, resources);
+    case PlanNode::Limit:
+      return generateLimit(plan_node, resources);
   }
   return nullptr;
 }
@@ -47,7 +69,55 @@ Operator* CodeGenerator::generateResultsPrinter(const PlanNode* plan_node, std::
     projection[i] = plan_node->projection[i].value;
     rcs[i] = resources[plan_node->projection[i].id];
   }
-  Operator* opt = new ResultsPrinter(runtime.db.getDictionary(), projection, child, rcs, runtime.getOstream(), plan_node->cardinality, this->silent);
+  // a back-probe join can report repeated rows once with their count
+  Resource* count_res = nullptr;
+  BackProbeHashJoin* join = dynamic_cast<BackProbeHashJoin*>(child);
+  if(join != nullptr) {
+    count_res = runtime.createResource();
+    join->setCountResource(count_res);
+  }
+  Operator* opt = new ResultsPrinter(runtime.db.getDictionary(), projection, child, rcs, runtime.getOstream(), plan_node->cardinality, this->silent, count_res);
+  return opt;
+}
+
+Operator* CodeGenerator::generateHashJoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  // child 0 is built, child 1 is probed
+  std::map<uint32_t, Resource*> left_rcs, right_rcs;
+  Operator* left = generateInternal(plan_node->child_nodes[0], left_rcs);
+  Operator* right = generateInternal(plan_node->child_nodes[1], right_rcs);
+
+  // output resources
+  std::map<uint32_t, Resource*> res;
+  for(std::set<uint32_t>::const_iterator iter = plan_node->required_res.begin(); iter != plan_node->required_res.end(); ++iter) {
+    if(left_rcs.count(*iter) != 0 || right_rcs.count(*iter) != 0) {
+      res[*iter] = runtime.createResource();
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
+
+  // an optional join keeps the probed rows that match nothing
+  Operator* opt = new HashJoin(left, left_rcs, right, right_rcs, res, plan_node->join_res[0], plan_node->cardinality, plan_node->op == PlanNode::OptionalJoin);
+  return opt;
+}
+
+Operator* CodeGenerator::generateMergeJoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  // both children are sorted on join_res[0]
+  std::map<uint32_t, Resource*> left_rcs, right_rcs;
+  Operator* left = generateInternal(plan_node->child_nodes[0], left_rcs);
+  Operator* right = generateInternal(plan_node->child_nodes[1], right_rcs);
+
+  // output resources
+  std::map<uint32_t, Resource*> res;
+  for(std::set<uint32_t>::const_iterator iter = plan_node->required_res.begin(); iter != plan_node->required_res.end(); ++iter) {
+    if(left_rcs.count(*iter) != 0 || right_rcs.count(*iter) != 0) {
+      res[*iter] = runtime.createResource();
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
+
+  Operator* opt = new MergeJoin(left, left_rcs, right, right_rcs, res, plan_node->join_res[0], plan_node->cardinality);
   return opt;
 }
 
@@ -77,7 +147,57 @@ Operator* CodeGenerator::generateBackProbeHashJoin(const PlanNode* plan_node, st
 
   resources.insert(res.begin(), res.end());
 
-  Operator* opt = new BackProbeHashJoin(opts, rcs, res, plan_node->join_nodes, plan_node->cardinality);
+  Operator* opt = new BackProbeHashJoin(opts, rcs, res, plan_node->join_nodes, plan_node->cardinality, this->explain);
+  return opt;
+}
+
+Operator* CodeGenerator::generateLeapfrogTriejoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  std::vector<Operator*> opts;
+  // input resources
+  std::vector<std::map<uint32_t, Resource*>> rcs;
+  for(int i=0; i<plan_node->child_nodes.size(); i++) {
+    std::map<uint32_t, Resource*> r;
+    opts.push_back(generateInternal(plan_node->child_nodes[i], r));
+    rcs.push_back(r);
+  }
+
+  // output resources
+  std::map<uint32_t, Resource*> res;
+  for(int i=0; i<plan_node->join_res.size(); i++) {
+    if(plan_node->required_res.count(plan_node->join_res[i]) != 0) {
+      res[plan_node->join_res[i]] = runtime.createResource();
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
+
+  Operator* opt = new LeapfrogTriejoin(opts, rcs, res, plan_node->join_res, plan_node->cardinality);
+  return opt;
+}
+
+Operator* CodeGenerator::generateUnion(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  std::vector<Operator*> opts;
+  // input resources
+  std::vector<std::map<uint32_t, Resource*>> rcs;
+  for(int i=0; i<plan_node->child_nodes.size(); i++) {
+    std::map<uint32_t, Resource*> r;
+    opts.push_back(generateInternal(plan_node->child_nodes[i], r));
+    rcs.push_back(r);
+  }
+
+  // output resources, unbound on the rows of branches that do not bind them
+  std::map<uint32_t, Resource*> res;
+  for(int i=0; i<rcs.size(); i++) {
+    for(std::map<uint32_t, Resource*>::iterator iter = rcs[i].begin(); iter != rcs[i].end(); ++iter) {
+      if(res.count(iter->first) == 0 && plan_node->required_res.count(iter->first) != 0) {
+        res[iter->first] = runtime.createResource();
+      }
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
+
+  Operator* opt = new Union(opts, rcs, res, plan_node->cardinality);
   return opt;
 }
 
@@ -85,6 +205,7 @@ Operator* CodeGenerator::generateTableScan(const PlanNode* plan_node, std::map<u
   Resource* subject = nullptr;
   Resource* predicate = nullptr;
   Resource* object = nullptr;
+  bool same_variable = false;
 
   switch(plan_node->triple_order) {
     case TripleOrder::SP:
@@ -128,7 +249,9 @@ Operator* CodeGenerator::generateTableScan(const PlanNode* plan_node, std::map<u
       }
       break;
     case TripleOrder::P:
-      if(plan_node->required_res.count(plan_node->query_node.subject.id) != 0) {
+      // both columns of ?x p ?x are read to compare the subject with the object
+      same_variable = plan_node->query_node.subject.id == plan_node->query_node.object.id;
+      if(same_variable || plan_node->required_res.count(plan_node->query_node.subject.id) != 0) {
         subject = runtime.createResource();
         resources[plan_node->query_node.subject.id] = subject;
       }
@@ -140,24 +263,125 @@ Operator* CodeGenerator::generateTableScan(const PlanNode* plan_node, std::map<u
         resources[predicate->id] = predicate;
       }
 
-      if(plan_node->required_res.count(plan_node->query_node.object.id) != 0) {
+      if(same_variable || plan_node->required_res.count(plan_node->query_node.object.id) != 0) {
         object = runtime.createResource();
         resources[plan_node->query_node.object.id] = object;
       }
       break;
   }
 
-  Operator* opt = new TableScan(runtime.db.getTripleTable(), plan_node->triple_order, subject, predicate, object, plan_node->cardinality);
+  Operator* opt = new TableScan(runtime.db.getTripleTable(), plan_node->triple_order, subject, predicate, object, plan_node->cardinality, same_variable);
   return opt;
 }
 
 Operator* CodeGenerator::generateFilter(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
-  Operator* child = generateInternal(plan_node->child_nodes[0], resources);
-  Operator* opt = nullptr;
+  std::map<uint32_t, Resource*> rcs;
+  Operator* child = generateInternal(plan_node->child_nodes[0], rcs);
+  // the filter compacts the columns of its input in place, which are its
+  // output too, except the columns only the conditions read
+  std::map<uint32_t, Resource*> res;
+  for(std::map<uint32_t, Resource*>::iterator iter = rcs.begin(); iter != rcs.end(); ++iter) {
+    if(plan_node->filters.empty() || plan_node->required_res.count(iter->first) != 0) {
+      res.insert(*iter);
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
+
+  Operator* opt = new Filter(child, rcs, res, plan_node->filters, runtime.db.getDictionary(), plan_node->cardinality);
+
+  return opt;
+}
+
+Operator* CodeGenerator::generateAggregate(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  std::map<uint32_t, Resource*> rcs;
+  Operator* child = generateInternal(plan_node->child_nodes[0], rcs);
+
+  // output resources, the group keys and aggregates
+  std::map<uint32_t, Resource*> res;
+  for(int i=0; i<plan_node->group_res.size(); i++) {
+    if(plan_node->required_res.count(plan_node->group_res[i]) != 0) {
+      res[plan_node->group_res[i]] = runtime.createResource();
+    }
+  }
+  for(int i=0; i<plan_node->aggregations.size(); i++) {
+    if(plan_node->required_res.count(plan_node->aggregations[i].variable.id) != 0) {
+      res[plan_node->aggregations[i].variable.id] = runtime.createResource();
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
 
-  Resource* res = runtime.createResource();
-  res->id = plan_node->filter_value;
-  opt = new Filter(child, resources[plan_node->filter_key], res, plan_node->cardinality);
+  // repeated rows of a back-probe join are aggregated with their count
+  Resource* count_res = nullptr;
+  BackProbeHashJoin* join = dynamic_cast<BackProbeHashJoin*>(child);
+  if(join != nullptr) {
+    count_res = runtime.createResource();
+    join->setCountResource(count_res);
+  }
+  Operator* opt = new Aggregate(child, rcs, res, plan_node->group_res, plan_node->aggregations, runtime.db.getDictionary(), plan_node->cardinality, count_res);
+  return opt;
+}
+
+Operator* CodeGenerator::generateDistinct(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  std::map<uint32_t, Resource*> rcs;
+  Operator* child = generateInternal(plan_node->child_nodes[0], rcs);
+
+  // rows are compared on the projected variables, whose columns are
+  // compacted in place
+  std::map<uint32_t, Resource*> res;
+  for(int i=0; i<plan_node->projection.size(); i++) {
+    if(rcs.count(plan_node->projection[i].id) != 0) {
+      res[plan_node->projection[i].id] = rcs[plan_node->projection[i].id];
+    }
+  }
+
+  resources.insert(res.begin(), res.end());
+
+  Deduplicate::Strategy strategy = Deduplicate::Hash;
+  uint32_t order_key = UINT32_MAX;
+  if(plan_node->duplicate_modifier == Reduced) {
+    strategy = Deduplicate::Cache;
+  } else if(plan_node->ordering != -1) {
+    strategy = Deduplicate::Sorted;
+    order_key = plan_node->ordering;
+  }
+  // repeated rows of a back-probe join need not be expanded at all
+  Resource* count_res = nullptr;
+  BackProbeHashJoin* join = dynamic_cast<BackProbeHashJoin*>(child);
+  if(join != nullptr) {
+    count_res = runtime.createResource();
+    join->setCountResource(count_res);
+  }
+  Operator* opt = new Deduplicate(child, res, strategy, order_key, plan_node->cardinality, count_res);
+  return opt;
+}
+
+Operator* CodeGenerator::generateTopK(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  std::map<uint32_t, Resource*> rcs;
+  Operator* child = generateInternal(plan_node->child_nodes[0], rcs);
+
+  // the rows are kept with their order keys, which are only output if required
+  std::map<uint32_t, Resource*> res;
+  for(std::map<uint32_t, Resource*>::iterator iter = rcs.begin(); iter != rcs.end(); ++iter) {
+    if(plan_node->required_res.count(iter->first) != 0) {
+      res.insert(*iter);
+    }
+  }
 
+  resources.insert(res.begin(), res.end());
+
+  Operator* opt = new TopK(child, rcs, res, plan_node->order_res, plan_node->ascending, plan_node->limit, runtime.db.getDictionary(), plan_node->cardinality);
+  return opt;
+}
+
+Operator* CodeGenerator::generateLimit(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources) {
+  Operator* child = generateInternal(plan_node->child_nodes[0], resources);
+  // a back-probe join stops enumerating at the end of the slice
+  BackProbeHashJoin* join = dynamic_cast<BackProbeHashJoin*>(child);
+  if(join != nullptr && plan_node->limit >= 0) {
+    join->setRowLimit((uint64_t)plan_node->offset + plan_node->limit);
+  }
+  Operator* opt = new Limit(child, resources, plan_node->offset, plan_node->limit, plan_node->cardinality);
   return opt;
 }
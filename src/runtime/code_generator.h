@@ -12,23 +12,32 @@
 
 class CodeGenerator {
 public:
-  CodeGenerator(Runtime& runtime, bool silent);
+  CodeGenerator(Runtime& runtime, bool silent, bool explain=false);
   ~CodeGenerator();
 
   Operator* generate(const PlanNode* plan_node);
 
-  static Operator* generate(Runtime& runtime, const PlanNode* plan_node, bool silent);
+  static Operator* generate(Runtime& runtime, const PlanNode* plan_node, bool silent, bool explain=false);
 
 private:
   Operator* generateInternal(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateHashJoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateMergeJoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
   Operator* generateBackProbeHashJoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
   Operator* generateResultsPrinter(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateLeapfrogTriejoin(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateUnion(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
   Operator* generateTableScan(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
   Operator* generateStoreScan(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
   Operator* generateFilter(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateAggregate(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateDistinct(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateTopK(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
+  Operator* generateLimit(const PlanNode* plan_node, std::map<uint32_t, Resource*>& resources);
 
   Runtime& runtime;
   bool silent;
+  bool explain;
 };
 
 #endif
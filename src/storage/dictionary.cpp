@@ -1,4 +1,5 @@
 #include "dictionary.h"
+#include "common/resource.h"
 
 Dictionary::Dictionary(const std::string& store_path)
   : str2id(store_path + "/str2id.bdb"), id2str(store_path + "/id2str.bdb"),
@@ -33,6 +34,9 @@ bool Dictionary::close() {
 
   str2id.close();
   id2str.close();
+
+  temporary_terms.clear();
+  temporary_ids.clear();
   return true;
 }
 
@@ -50,7 +54,10 @@ uint32_t Dictionary::append(const std::string& str) {
 
 bool Dictionary::lookup(const std::string& str, uint32_t *id) {
   std::string id_str;
-  if(!str2id.get(str, &id_str)) {
+  str2id_mutex.lock();
+  bool found = str2id.get(str, &id_str);
+  str2id_mutex.unlock();
+  if(!found) {
     return false;
   }
   *id = std::stoi(id_str);
@@ -58,17 +65,63 @@ bool Dictionary::lookup(const std::string& str, uint32_t *id) {
 }
 
 bool Dictionary::lookupById(uint32_t id, std::string *str) {
-  std::string id_str = std::to_string(id);
-  if(!id2str.get(id_str, str)) {
-    return false;
+  if(id > meta_data->last_seq_id && id < UNBOUND_ID) {
+    temporary_mutex.lock();
+    size_t index = UNBOUND_ID - 1 - id;
+    bool found = index < temporary_terms.size();
+    if(found) {
+      *str = temporary_terms[index];
+    }
+    temporary_mutex.unlock();
+    if(found) {
+      return true;
+    }
   }
-  return true;
+  std::string id_str = std::to_string(id);
+  id2str_mutex.lock();
+  bool found = id2str.get(id_str, str);
+  id2str_mutex.unlock();
+  return found;
 }
 
 uint64_t Dictionary::count() {
   return meta_data->total_count;
 }
 
+uint32_t Dictionary::encodeTemporary(const std::string& str) {
+  temporary_mutex.lock();
+  std::unordered_map<std::string, uint32_t>::iterator iter = temporary_ids.find(str);
+  if(iter != temporary_ids.end()) {
+    uint32_t id = iter->second;
+    temporary_mutex.unlock();
+    return id;
+  }
+  temporary_mutex.unlock();
+
+  uint32_t id;
+  bool found = lookup(str, &id);
+  temporary_mutex.lock();
+  iter = temporary_ids.find(str);
+  if(iter != temporary_ids.end()) {
+    id = iter->second;
+  } else {
+    if(!found) {
+      id = UNBOUND_ID - 1 - temporary_terms.size();
+      temporary_terms.push_back(str);
+    }
+    temporary_ids[str] = id;
+  }
+  temporary_mutex.unlock();
+  return id;
+}
+
+void Dictionary::clearTemporary() {
+  temporary_mutex.lock();
+  temporary_terms.clear();
+  temporary_ids.clear();
+  temporary_mutex.unlock();
+}
+
 const uint64_t Dictionary::INIT_ID = 1;
 const uint32_t Dictionary::META_FILE_SIZE = sizeof(uint64_t) * 2;
 
@@ -3,6 +3,9 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "thread/mutex.h"
 #include "util/bdb_file.h"
 #include "util/file_directory.h"
 
@@ -23,6 +26,13 @@ public:
   bool lookupById(uint32_t id, std::string *str);
   uint64_t count();
 
+  // Id of a term computed by a query, e.g. the result of an aggregate. A
+  // term missing from the dictionary is kept in memory only, under an id
+  // counting down from below UNBOUND_ID, until clearTemporary().
+  uint32_t encodeTemporary(const std::string& str);
+  // Forgets the terms of encodeTemporary once the query is done.
+  void clearTemporary();
+
 private:
   #pragma pack(push, 1)
   struct Metadata {
@@ -42,10 +52,20 @@ private:
 
   BDBFile str2id;
   BDBFile id2str;
+  // a BDBFile reads through one cursor, so lookups from operators running on
+  // several threads take turns
+  Mutex str2id_mutex;
+  Mutex id2str_mutex;
 
   std::string meta_file_path;
   RandomRWFile meta_file;
   Metadata* meta_data;
+
+  // temporary_terms[i] is the term of id UINT32_MAX - 1 - i
+  std::vector<std::string> temporary_terms;
+  // ids given by encodeTemporary, including those found in the dictionary
+  std::unordered_map<std::string, uint32_t> temporary_ids;
+  Mutex temporary_mutex;
 };
 
 
@@ -1,7 +1,12 @@
 #include <cstring>
+#include <algorithm>
 #include "triple_table.h"
+#include "database/config.h"
 
 #include <iostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 TripleTable::TripleTable(const std::string& store_path, const std::string& table_name, BufferManager* buffer_manager)
   : kvstore(store_path + "/" + table_name), data_file(store_path + "/" + table_name + "_data.graw", buffer_manager), index_file(store_path + "/" + table_name + "_index.graw", buffer_manager) {}
@@ -39,7 +44,19 @@ bool TripleTable::close() {
 }
 
 TripleTable::BlockScanner::BlockScanner(TripleTable& table, TripleOrder key_order, Resource *subject, Resource *predicate, Resource *object)
-  : table(table), key_order(key_order), subject(subject), predicate(predicate), object(object), idx(0), x_block_no(0), y_block_no(0) {
+  : table(table), key_order(key_order), subject(subject), predicate(predicate), object(object), idx(0), x_block_no(0), y_block_no(0), x_extent(), y_extent(), x_cursor(), y_cursor(), fetch_pool(nullptr), failed(false) {
+}
+
+TripleTable::BlockScanner::~BlockScanner() {
+  if(fetch_pool != nullptr) {
+    fetch_pool->wait();
+    for(int i=0; i<fetch_tasks.size(); i++) {
+      delete fetch_tasks[i];
+    }
+    delete fetch_pool;
+  }
+  resetCursor(x_cursor, 0, 0);
+  resetCursor(y_cursor, 0, 0);
 }
 
 bool TripleTable::BlockScanner::find() {
@@ -47,11 +64,11 @@ bool TripleTable::BlockScanner::find() {
     case P:
       {
         Key key = { 1, predicate->id, 0};
-        std::string value;
-        if(!this->table.kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        values.resize(1);
+        if(!this->table.kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &values[0])){
           return false;
         }
-        values.push_back(value);
+        slots.push_back(0);
         return true;
       }
       break;
@@ -59,24 +76,18 @@ bool TripleTable::BlockScanner::find() {
       {
         if(subject->column.size() > 0) {
           key_ids = subject->column;
-          std::vector<std::string> keys(key_ids.size());
-          Key key = { 2, 0, predicate->id};
-          for(int i=0; i<key_ids.size(); i++) {
-            key.x = key_ids[i];
-            keys[i] = std::string(reinterpret_cast<char*>(&key), KEY_SIZE);
-          }
-          if(!this->table.kvstore.multiGet(keys, &values)){
+          subject->column.clear();
+          if(!fetchSegments(2)) {
             return false;
           }
-          subject->column.clear();
         } else {
           Key key = { 2, subject->id, predicate->id};
-          std::string value;
-          if(!this->table.kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+          values.resize(1);
+          if(!this->table.kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &values[0])){
             return false;
           }
           key_ids.push_back(subject->id);
-          values.push_back(value);
+          slots.push_back(0);
         }
         return true;
       }
@@ -85,24 +96,18 @@ bool TripleTable::BlockScanner::find() {
       {
         if(object->column.size() > 0) {
           key_ids = object->column;
-          std::vector<std::string> keys(key_ids.size());
-          Key key = { 4, 0, predicate->id};
-          for(int i=0; i<key_ids.size(); i++) {
-            key.x = key_ids[i];
-            keys[i] = std::string(reinterpret_cast<char*>(&key), KEY_SIZE);
-          }
-          if(!this->table.kvstore.multiGet(keys, &values)){
+          object->column.clear();
+          if(!fetchSegments(4)) {
             return false;
           }
-          object->column.clear();
         } else {
           Key key = { 4, object->id, predicate->id};
-          std::string value;
-          if(!this->table.kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+          values.resize(1);
+          if(!this->table.kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &values[0])){
             return false;
           }
           key_ids.push_back(object->id);
-          values.push_back(value);
+          slots.push_back(0);
         }
         return true;
       }
@@ -112,108 +117,97 @@ bool TripleTable::BlockScanner::find() {
 }
 
 bool TripleTable::BlockScanner::read() {
-  if(x_block_no != 0 && y_block_no != 0) {
-    BufferPage* page = this->table.data_file.getNode(x_block_no);
-    char* block = page->getBlockData();
-    Node* node = reinterpret_cast<Node*>(block);
-
-    subject->column.insert(subject->column.end(), reinterpret_cast<uint32_t*>(node->data), reinterpret_cast<uint32_t*>(node->data)+node->dsize/sizeof(uint32_t));
-
-    x_block_no = node->next_block_no;
-    this->table.data_file.updateNode(page, false, true);
-
-    page = this->table.data_file.getNode(y_block_no);
-    block = page->getBlockData();
-    node = reinterpret_cast<Node*>(block);
-
-    object->column.insert(object->column.end(), reinterpret_cast<uint32_t*>(node->data), reinterpret_cast<uint32_t*>(node->data)+node->dsize/sizeof(uint32_t));
-
-    y_block_no = node->next_block_no;
-    this->table.data_file.updateNode(page, false, true);
-
-    // Prefetch next nodes
-    if(x_block_no != 0) {
-      this->table.data_file.prefetchNode(x_block_no);
-    }
-    if(y_block_no != 0) {
-      this->table.data_file.prefetchNode(y_block_no);
-    }
-    return true;
+  if(key_order == P && subject != nullptr && object != nullptr) {
+    return readPaired();
   } else if(x_block_no != 0) {
-    BufferPage* page = this->table.data_file.getNode(x_block_no);
-    char* block = page->getBlockData();
-    Node* node = reinterpret_cast<Node*>(block);
-
-    subject->column.insert(subject->column.end(), reinterpret_cast<uint32_t*>(node->data), reinterpret_cast<uint32_t*>(node->data)+node->dsize/sizeof(uint32_t));
+    x_block_no = scanNode(x_block_no, x_extent, subject->column);
     if(object != nullptr) {
       for(int k=object->column.size(); k<subject->column.size(); k++) {
         object->column.push_back(object->id);
       }
     }
-
-    x_block_no = node->next_block_no;
-    this->table.data_file.updateNode(page, false, true);
-
-    // Prefetch next nodes
-    if(x_block_no != 0) {
-      this->table.data_file.prefetchNode(x_block_no);
-    }
     return true;
   } else if(y_block_no != 0) {
-    BufferPage* page = this->table.data_file.getNode(y_block_no);
-    char* block = page->getBlockData();
-    Node* node = reinterpret_cast<Node*>(block);
-
-    object->column.insert(object->column.end(), reinterpret_cast<uint32_t*>(node->data), reinterpret_cast<uint32_t*>(node->data)+node->dsize/sizeof(uint32_t));
+    y_block_no = scanNode(y_block_no, y_extent, object->column);
     if(subject != nullptr) {
       for(int k=subject->column.size(); k<object->column.size(); k++) {
         subject->column.push_back(subject->id);
       }
     }
-
-    y_block_no = node->next_block_no;
-    this->table.data_file.updateNode(page, false, true);
-
-    // Prefetch next nodes
-    if(y_block_no != 0) {
-      this->table.data_file.prefetchNode(y_block_no);
-    }
     return true;
   }
   return false;
 }
 
+bool TripleTable::BlockScanner::readPaired() {
+  if(x_rest.empty() && x_block_no != 0) {
+    x_block_no = scanNode(x_block_no, x_extent, x_rest);
+  }
+  if(y_rest.empty() && y_block_no != 0) {
+    y_block_no = scanNode(y_block_no, y_extent, y_rest);
+  }
+  size_t n = std::min(x_rest.size(), y_rest.size());
+  if(n == 0) {
+    return false;
+  }
+  subject->column.insert(subject->column.end(), x_rest.begin(), x_rest.begin()+n);
+  object->column.insert(object->column.end(), y_rest.begin(), y_rest.begin()+n);
+  x_rest.erase(x_rest.begin(), x_rest.begin()+n);
+  y_rest.erase(y_rest.begin(), y_rest.begin()+n);
+  return true;
+}
+
+uint32_t TripleTable::BlockScanner::scanNode(uint32_t block_no, ExtentCursor& extent, std::vector<uint32_t>& column) {
+  this->table.enterExtent(extent, block_no);
+  BufferPage* page = this->table.data_file.getNode(block_no);
+  Node* node = reinterpret_cast<Node*>(page->getBlockData());
+  decodeNode(node, column);
+  uint32_t next_block_no = node->next_block_no;
+  this->table.data_file.updateNode(page, false, true);
+
+  // Prefetch next nodes
+  if(next_block_no != 0) {
+    this->table.enterExtent(extent, next_block_no);
+  }
+  return next_block_no;
+}
+
 bool TripleTable::BlockScanner::next() {
   if(read()) {
     return true;
   }
   bool exist = false;
-  while(idx<values.size()) {
+  while(idx<slots.size()) {
     int i = idx;
     ++idx;
-    if(values[i].size() == 0) {
+    if(!waitFetched(i)) {
+      idx = slots.size();
+      break;
+    }
+    const rocksdb::PinnableSlice& value = values[slots[i]];
+    if(value.size() == 0) {
       continue;
     }
-    char chunk[SEGMENT_MAX_SIZE];
-    Segment* segment = reinterpret_cast<Segment*>(chunk);
-    memcpy(chunk, values[i].c_str(), values[i].size());
+    const Segment* segment = reinterpret_cast<const Segment*>(value.data());
     switch(key_order) {
       case P:
         {
           if(subject != nullptr) {
             x_block_no = segment->x_first_block_no;
+            x_extent = { 0, 0, segment->x_last_block_no };
           }
           if(object != nullptr) {
             y_block_no = segment->y_first_block_no;
+            y_extent = { 0, 0, segment->y_last_block_no };
           }
 
           if(segment->dsize != 0) {
             // Prefetch next nodes
             if(x_block_no != 0) {
-              this->table.data_file.prefetchNode(x_block_no);
+              this->table.enterExtent(x_extent, x_block_no);
             }
             if(y_block_no != 0) {
-              this->table.data_file.prefetchNode(y_block_no);
+              this->table.enterExtent(y_extent, y_block_no);
             }
 
             int x = 0;
@@ -239,14 +233,15 @@ bool TripleTable::BlockScanner::next() {
           subject->id = key_ids[i];
           if(object != nullptr) {
             y_block_no = segment->y_first_block_no;
+            y_extent = { 0, 0, segment->y_last_block_no };
 
             if(segment->dsize != 0) {
               // Prefetch next nodes
               if(y_block_no != 0) {
-                this->table.data_file.prefetchNode(y_block_no);
+                this->table.enterExtent(y_extent, y_block_no);
               }
 
-              object->column.insert(object->column.end(), reinterpret_cast<uint32_t*>(segment->data), reinterpret_cast<uint32_t*>(segment->data)+segment->dsize/sizeof(uint32_t));
+              object->column.insert(object->column.end(), reinterpret_cast<const uint32_t*>(segment->data), reinterpret_cast<const uint32_t*>(segment->data)+segment->dsize/sizeof(uint32_t));
 
               for(int k=subject->column.size(); k<object->column.size(); k++) {
                 subject->column.push_back(subject->id);
@@ -270,14 +265,15 @@ bool TripleTable::BlockScanner::next() {
           object->id = key_ids[i];
           if(subject != nullptr) {
             x_block_no = segment->x_first_block_no;
+            x_extent = { 0, 0, segment->x_last_block_no };
 
             if(segment->dsize != 0) {
               // Prefetch next nodes
               if(x_block_no != 0) {
-                this->table.data_file.prefetchNode(x_block_no);
+                this->table.enterExtent(x_extent, x_block_no);
               }
 
-              subject->column.insert(subject->column.end(), reinterpret_cast<uint32_t*>(segment->data), reinterpret_cast<uint32_t*>(segment->data)+segment->dsize/sizeof(uint32_t));
+              subject->column.insert(subject->column.end(), reinterpret_cast<const uint32_t*>(segment->data), reinterpret_cast<const uint32_t*>(segment->data)+segment->dsize/sizeof(uint32_t));
 
               for(int k=object->column.size(); k<subject->column.size(); k++) {
                 object->column.push_back(object->id);
@@ -306,19 +302,326 @@ bool TripleTable::BlockScanner::next() {
   return exist;
 }
 
+const int TripleTable::BlockScanner::FETCH_BATCH_SIZE = 4096;
+const char TripleTable::BlockScanner::FETCH_PENDING = 0;
+const char TripleTable::BlockScanner::FETCH_DONE = 1;
+const char TripleTable::BlockScanner::FETCH_FAILED = 2;
+
+bool TripleTable::BlockScanner::fetchSegments(uint8_t label) {
+  // keys in the order of RocksDB's bytewise comparator, which compares x
+  // from its low byte up, so that MultiGet may take them as sorted
+  std::sort(key_ids.begin(), key_ids.end(), [](uint32_t a, uint32_t b) {
+    return __builtin_bswap32(a) < __builtin_bswap32(b);
+  });
+  std::vector<uint32_t> unique_ids;
+  slots.resize(key_ids.size());
+  for(int i=0; i<key_ids.size(); i++) {
+    if(i == 0 || key_ids[i] != key_ids[i-1]) {
+      unique_ids.push_back(key_ids[i]);
+    }
+    slots[i] = unique_ids.size() - 1;
+  }
+  segmentKeys(label, unique_ids, predicate->id, keys, key_slices);
+  values.resize(unique_ids.size());
+
+  int num_batches = (unique_ids.size() + FETCH_BATCH_SIZE - 1) / FETCH_BATCH_SIZE;
+  fetch_state.assign(num_batches, FETCH_PENDING);
+  if(num_batches == 0) {
+    return true;
+  }
+  // the scan starts on the first batch while the others are fetched
+  if(!fetch(0)) {
+    failed = true;
+    return false;
+  }
+  fetch_state[0] = FETCH_DONE;
+
+  Config config;
+  int num_threads = config.getIntParam(ConfigKey::NUM_THREADS);
+  if(num_threads > 1 && num_batches > 1) {
+    fetch_pool = new ThreadPool(std::min(num_threads, num_batches - 1));
+    for(int b=1; b<num_batches; b++) {
+      fetch_tasks.push_back(new FetchTask(this, b));
+    }
+    for(int b=0; b<fetch_tasks.size(); b++) {
+      fetch_pool->execute(fetch_tasks[b]);
+    }
+  } else {
+    for(int b=1; b<num_batches; b++) {
+      fetch_state[b] = fetch(b) ? FETCH_DONE : FETCH_FAILED;
+    }
+  }
+  return true;
+}
+
+bool TripleTable::BlockScanner::fetch(int batch) {
+  size_t begin = (size_t)batch * FETCH_BATCH_SIZE;
+  size_t end = std::min(begin + FETCH_BATCH_SIZE, key_slices.size());
+  return this->table.kvstore.multiGet(key_slices.data() + begin, end - begin, values.data() + begin, true);
+}
+
+void TripleTable::BlockScanner::runFetch(int batch) {
+  bool ok = fetch(batch);
+  fetch_mutex.lock();
+  fetch_state[batch] = ok ? FETCH_DONE : FETCH_FAILED;
+  fetch_cond.notifyAll();
+  fetch_mutex.unlock();
+}
+
+bool TripleTable::BlockScanner::waitFetched(int i) {
+  if(fetch_state.empty()) {
+    return true;
+  }
+  int batch = slots[i] / FETCH_BATCH_SIZE;
+  fetch_mutex.lock();
+  while(fetch_state[batch] == FETCH_PENDING) {
+    fetch_cond.wait(fetch_mutex);
+  }
+  bool done = fetch_state[batch] == FETCH_DONE;
+  fetch_mutex.unlock();
+  if(!done) {
+    failed = true;
+  }
+  return done;
+}
+
+bool TripleTable::BlockScanner::hasFailed() {
+  return failed;
+}
+
+static TripleTable::ColumnView constantView(const Resource* resource) {
+  TripleTable::ColumnView view = { nullptr, resource != nullptr ? resource->id : UNBOUND_ID };
+  return view;
+}
+
+bool TripleTable::BlockScanner::nextBatch(Batch& batch) {
+  release(batch);
+  if(readBatch(batch)) {
+    return true;
+  }
+  // SP and OP scans without the other column have one row per key found
+  std::shared_ptr<std::vector<uint32_t>> keys;
+  while(idx<slots.size()) {
+    int i = idx;
+    ++idx;
+    if(!waitFetched(i)) {
+      idx = slots.size();
+      break;
+    }
+    const rocksdb::PinnableSlice& value = values[slots[i]];
+    if(value.size() == 0) {
+      continue;
+    }
+    // inline ids are handed out from values, which the scanner keeps
+    const Segment* segment = reinterpret_cast<const Segment*>(value.data());
+    switch(key_order) {
+      case P:
+        {
+          resetCursor(x_cursor, subject != nullptr ? segment->x_first_block_no : 0, segment->x_last_block_no);
+          resetCursor(y_cursor, object != nullptr ? segment->y_first_block_no : 0, segment->y_last_block_no);
+
+          if(segment->dsize != 0) {
+            // pairs are taken as next() takes them
+            std::shared_ptr<std::vector<uint32_t>> x_ids = std::make_shared<std::vector<uint32_t>>();
+            std::shared_ptr<std::vector<uint32_t>> y_ids = std::make_shared<std::vector<uint32_t>>();
+            int x = 0;
+            int y = sizeof(uint32_t);
+            while(y < segment->dsize) {
+              x_ids->push_back(*reinterpret_cast<const uint32_t*>(segment->data + x));
+              y_ids->push_back(*reinterpret_cast<const uint32_t*>(segment->data + y));
+              x += sizeof(uint32_t);
+              y += sizeof(uint32_t);
+            }
+            batch.size = x_ids->size();
+            batch.subject = constantView(subject);
+            batch.object = constantView(object);
+            if(subject != nullptr) {
+              bufferColumn(x_ids, batch.subject, batch);
+            }
+            if(object != nullptr) {
+              bufferColumn(y_ids, batch.object, batch);
+            }
+            return true;
+          }
+        }
+        break;
+      case SP:
+        {
+          subject->id = key_ids[i];
+          if(object != nullptr) {
+            resetCursor(y_cursor, segment->y_first_block_no, segment->y_last_block_no);
+
+            if(segment->dsize != 0) {
+              batch.size = segment->dsize/sizeof(uint32_t);
+              batch.subject = constantView(subject);
+              batch.object.ids = reinterpret_cast<const uint32_t*>(segment->data);
+              return true;
+            }
+          } else {
+            if(!keys) {
+              keys = std::make_shared<std::vector<uint32_t>>();
+            }
+            keys->push_back(subject->id);
+            continue;
+          }
+        }
+        break;
+      case OP:
+        {
+          object->id = key_ids[i];
+          if(subject != nullptr) {
+            resetCursor(x_cursor, segment->x_first_block_no, segment->x_last_block_no);
+
+            if(segment->dsize != 0) {
+              batch.size = segment->dsize/sizeof(uint32_t);
+              batch.subject.ids = reinterpret_cast<const uint32_t*>(segment->data);
+              batch.object = constantView(object);
+              return true;
+            }
+          } else {
+            if(!keys) {
+              keys = std::make_shared<std::vector<uint32_t>>();
+            }
+            keys->push_back(object->id);
+            continue;
+          }
+        }
+        break;
+    }
+
+    if(readBatch(batch)) {
+      return true;
+    }
+  }
+
+  if(keys) {
+    batch.size = keys->size();
+    batch.subject = constantView(subject);
+    batch.object = constantView(object);
+    bufferColumn(keys, key_order == SP ? batch.subject : batch.object, batch);
+    return true;
+  }
+  return false;
+}
+
+void TripleTable::BlockScanner::release(Batch& batch) {
+  for(int i=0; i<batch.pages.size(); i++) {
+    this->table.data_file.updateNode(batch.pages[i], false, true);
+  }
+  batch.pages.clear();
+  batch.buffers.clear();
+  batch.size = 0;
+}
+
+bool TripleTable::BlockScanner::readBatch(Batch& batch) {
+  batch.subject = constantView(subject);
+  batch.object = constantView(object);
+  if(key_order == P && subject != nullptr && object != nullptr) {
+    // the nodes of the two columns need not end on the same row
+    if(!advance(x_cursor) || !advance(y_cursor)) {
+      return false;
+    }
+    batch.size = std::min(x_cursor.size - x_cursor.pos, y_cursor.size - y_cursor.pos);
+    take(x_cursor, batch.size, batch.subject, batch);
+    take(y_cursor, batch.size, batch.object, batch);
+    return true;
+  } else if(advance(x_cursor)) {
+    batch.size = x_cursor.size - x_cursor.pos;
+    take(x_cursor, batch.size, batch.subject, batch);
+    return true;
+  } else if(advance(y_cursor)) {
+    batch.size = y_cursor.size - y_cursor.pos;
+    take(y_cursor, batch.size, batch.object, batch);
+    return true;
+  }
+  return false;
+}
+
+bool TripleTable::BlockScanner::advance(Cursor& cursor) {
+  while(cursor.pos == cursor.size) {
+    uint32_t block_no = cursor.next_block_no;
+    if(block_no == 0) {
+      return false;
+    }
+    if(cursor.page != nullptr) {
+      this->table.data_file.updateNode(cursor.page, false, true);
+      cursor.page = nullptr;
+    }
+    cursor.decoded.reset();
+    cursor.pos = 0;
+
+    this->table.enterExtent(cursor.extent, block_no);
+    BufferPage* page = this->table.data_file.getNode(block_no);
+    Node* node = reinterpret_cast<Node*>(page->getBlockData());
+    cursor.next_block_no = node->next_block_no;
+    if(node->dtype == RAW_NODE) {
+      cursor.page = page;
+      cursor.ids = reinterpret_cast<const uint32_t*>(node->data);
+      cursor.size = node->dsize/sizeof(uint32_t);
+    } else {
+      cursor.decoded = std::make_shared<std::vector<uint32_t>>();
+      decodeNode(node, *cursor.decoded);
+      this->table.data_file.updateNode(page, false, true);
+      cursor.ids = cursor.decoded->data();
+      cursor.size = cursor.decoded->size();
+    }
+
+    // Prefetch next nodes
+    if(cursor.next_block_no != 0) {
+      this->table.enterExtent(cursor.extent, cursor.next_block_no);
+    }
+  }
+  return true;
+}
+
+void TripleTable::BlockScanner::take(Cursor& cursor, size_t n, ColumnView& view, Batch& batch) {
+  view.ids = cursor.ids + cursor.pos;
+  cursor.pos += n;
+  if(cursor.page != nullptr) {
+    if(cursor.pos == cursor.size) {
+      // the last rows of the node take the pin of the cursor
+      batch.pages.push_back(cursor.page);
+      cursor.page = nullptr;
+    } else {
+      batch.pages.push_back(this->table.data_file.getNode(cursor.page->getBlockNo()));
+    }
+  } else if(cursor.decoded) {
+    batch.buffers.push_back(cursor.decoded);
+  }
+}
+
+void TripleTable::BlockScanner::resetCursor(Cursor& cursor, uint32_t block_no, uint32_t last_block_no) {
+  if(cursor.page != nullptr) {
+    this->table.data_file.updateNode(cursor.page, false, true);
+  }
+  cursor.page = nullptr;
+  cursor.decoded.reset();
+  cursor.ids = nullptr;
+  cursor.pos = 0;
+  cursor.size = 0;
+  cursor.next_block_no = block_no;
+  cursor.extent = { 0, 0, last_block_no };
+  if(block_no != 0) {
+    this->table.enterExtent(cursor.extent, block_no);
+  }
+}
+
+void TripleTable::BlockScanner::bufferColumn(std::shared_ptr<std::vector<uint32_t>>& ids, ColumnView& view, Batch& batch) {
+  view.ids = ids->data();
+  batch.buffers.push_back(ids);
+}
+
 bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predicate, Resource *object) {
   bool exist = false;
   switch(key_order) {
     case P:
       {
         Key key = { 1, predicate->id, 0};
-        std::string value;
-        char chunk[SEGMENT_MAX_SIZE];
-        Segment* segment = reinterpret_cast<Segment*>(chunk);
-        if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        rocksdb::PinnableSlice value;
+        if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
           return false;
         }
-        memcpy(chunk, value.c_str(), value.size());
+        const Segment* segment = reinterpret_cast<const Segment*>(value.data());
         if(segment->dsize != 0) {
           exist = true;
 
@@ -354,27 +657,22 @@ bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predi
       {
         if(subject->column.size() > 0) {
           std::vector<uint32_t> subject_ids = subject->column;
-          std::vector<std::string> keys(subject_ids.size());
-          Key key = { 2, 0, predicate->id};
-          for(int i=0; i<subject_ids.size(); i++) {
-            key.x = subject_ids[i];
-            keys[i] = std::string(reinterpret_cast<char*>(&key), KEY_SIZE);
-          }
-          std::vector<std::string> values;
-          if(!this->kvstore.multiGet(keys, &values)){
+          std::string keys;
+          std::vector<rocksdb::Slice> slices;
+          segmentKeys(2, subject_ids, predicate->id, keys, slices);
+          std::vector<rocksdb::PinnableSlice> values;
+          if(!this->kvstore.multiGet(slices, &values)){
             return false;
           }
 
           subject->column.clear();
-          char chunk[SEGMENT_MAX_SIZE];
-          Segment* segment = reinterpret_cast<Segment*>(chunk);
           if(object != nullptr) {
             int k = 0;
             for(int i=0; i<subject_ids.size(); i++) {
               if(values[i].size() == 0) {
                 continue;
               }
-              memcpy(chunk, values[i].c_str(), values[i].size());
+              const Segment* segment = reinterpret_cast<const Segment*>(values[i].data());
               if(segment->dsize != 0) {
                 exist = true;
 
@@ -397,7 +695,7 @@ bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predi
               if(values[i].size() == 0) {
                 continue;
               }
-              memcpy(chunk, values[i].c_str(), values[i].size());
+              const Segment* segment = reinterpret_cast<const Segment*>(values[i].data());
               exist = true;
               for(int k = 0; k<segment->count; k++) {
                 subject->column.push_back(subject_ids[i]);
@@ -407,13 +705,11 @@ bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predi
           return exist;
         } else {
           Key key = { 2, subject->id, predicate->id};
-          std::string value;
-          char chunk[SEGMENT_MAX_SIZE];
-          Segment* segment = reinterpret_cast<Segment*>(chunk);
-          if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+          rocksdb::PinnableSlice value;
+          if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
             return false;
           }
-          memcpy(chunk, value.c_str(), value.size());
+          const Segment* segment = reinterpret_cast<const Segment*>(value.data());
 
           if(object != nullptr) {
             if(segment->dsize != 0) {
@@ -445,27 +741,22 @@ bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predi
       {
         if(object->column.size() > 0) {
           std::vector<uint32_t> object_ids = object->column;
-          std::vector<std::string> keys(object_ids.size());
-          Key key = { 4, 0, predicate->id};
-          for(int i=0; i<object_ids.size(); i++) {
-            key.x = object_ids[i];
-            keys[i] = std::string(reinterpret_cast<char*>(&key), KEY_SIZE);
-          }
-          std::vector<std::string> values;
-          if(!this->kvstore.multiGet(keys, &values)){
+          std::string keys;
+          std::vector<rocksdb::Slice> slices;
+          segmentKeys(4, object_ids, predicate->id, keys, slices);
+          std::vector<rocksdb::PinnableSlice> values;
+          if(!this->kvstore.multiGet(slices, &values)){
             return false;
           }
 
           object->column.clear();
-          char chunk[SEGMENT_MAX_SIZE];
-          Segment* segment = reinterpret_cast<Segment*>(chunk);
           if(subject != nullptr) {
             int k = 0;
             for(int i=0; i<object_ids.size(); i++) {
               if(values[i].size() == 0) {
                 continue;
               }
-              memcpy(chunk, values[i].c_str(), values[i].size());
+              const Segment* segment = reinterpret_cast<const Segment*>(values[i].data());
 
               if(segment->dsize != 0) {
                 exist = true;
@@ -491,7 +782,7 @@ bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predi
               if(values[i].size() == 0) {
                 continue;
               }
-              memcpy(chunk, values[i].c_str(), values[i].size());
+              const Segment* segment = reinterpret_cast<const Segment*>(values[i].data());
               exist = true;
 
               for(int k=0; k<segment->count; k++) {
@@ -502,13 +793,11 @@ bool TripleTable::read(TripleOrder key_order, Resource *subject, Resource *predi
           return exist;
         } else {
           Key key = { 4, object->id, predicate->id};
-          std::string value;
-          char chunk[SEGMENT_MAX_SIZE];
-          Segment* segment = reinterpret_cast<Segment*>(chunk);
-          if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+          rocksdb::PinnableSlice value;
+          if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
             return false;
           }
-          memcpy(chunk, value.c_str(), value.size());
+          const Segment* segment = reinterpret_cast<const Segment*>(value.data());
 
           if(subject != nullptr) {
             if(segment->dsize != 0) {
@@ -563,6 +852,10 @@ void TripleTable::write(TripleOrder key_order, const Resource& subject, const Re
           segment->y_last_block_no = 0;
           segment->x_index_block_no = 0;
           segment->y_index_block_no = 0;
+          segment->x_extent_start = 0;
+          segment->x_extent_length = 0;
+          segment->y_extent_start = 0;
+          segment->y_extent_length = 0;
           segment->dtype = 0;
           segment->dsize = 0;
         }
@@ -601,6 +894,10 @@ void TripleTable::write(TripleOrder key_order, const Resource& subject, const Re
           segment->y_last_block_no = 0;
           segment->x_index_block_no = 0;
           segment->y_index_block_no = 0;
+          segment->x_extent_start = 0;
+          segment->x_extent_length = 0;
+          segment->y_extent_start = 0;
+          segment->y_extent_length = 0;
           segment->dtype = 0;
           segment->dsize = 0;
         }
@@ -628,6 +925,10 @@ void TripleTable::write(TripleOrder key_order, const Resource& subject, const Re
           segment->y_last_block_no = 0;
           segment->x_index_block_no = 0;
           segment->y_index_block_no = 0;
+          segment->x_extent_start = 0;
+          segment->x_extent_length = 0;
+          segment->y_extent_start = 0;
+          segment->y_extent_length = 0;
           segment->dtype = 0;
           segment->dsize = 0;
         }
@@ -645,39 +946,33 @@ int TripleTable::count(TripleOrder key_order, uint32_t subject, uint32_t predica
     case P:
       {
         Key key = { 1, predicate, 0};
-        std::string value;
-        char chunk[SEGMENT_MAX_SIZE];
-        Segment* segment = reinterpret_cast<Segment*>(chunk);
-        if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        rocksdb::PinnableSlice value;
+        if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
           return 0;
         }
-        memcpy(chunk, value.c_str(), value.size());
+        const Segment* segment = reinterpret_cast<const Segment*>(value.data());
         return segment->count;
       }
       break;
     case SP:
       {
         Key key = { 2, subject, predicate};
-        std::string value;
-        char chunk[SEGMENT_MAX_SIZE];
-        Segment* segment = reinterpret_cast<Segment*>(chunk);
-        if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        rocksdb::PinnableSlice value;
+        if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
           return 0;
         }
-        memcpy(chunk, value.c_str(), value.size());
+        const Segment* segment = reinterpret_cast<const Segment*>(value.data());
         return segment->count;
       }
       break;
     case OP:
       {
         Key key = { 4, object, predicate};
-        std::string value;
-        char chunk[SEGMENT_MAX_SIZE];
-        Segment* segment = reinterpret_cast<Segment*>(chunk);
-        if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        rocksdb::PinnableSlice value;
+        if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
           return 0;
         }
-        memcpy(chunk, value.c_str(), value.size());
+        const Segment* segment = reinterpret_cast<const Segment*>(value.data());
         return segment->count;
       }
       break;
@@ -690,26 +985,22 @@ int TripleTable::distinctCount(TripleOrder key_order, uint32_t subject, uint32_t
     case SP:
       {
         Key key = { 1, predicate, 0};
-        std::string value;
-        char chunk[SEGMENT_MAX_SIZE];
-        Segment* segment = reinterpret_cast<Segment*>(chunk);
-        if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        rocksdb::PinnableSlice value;
+        if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
           return 0;
         }
-        memcpy(chunk, value.c_str(), value.size());
+        const Segment* segment = reinterpret_cast<const Segment*>(value.data());
         return segment->x_distinct_count;
       }
       break;
     case OP:
       {
         Key key = { 1, predicate, 0};
-        std::string value;
-        char chunk[SEGMENT_MAX_SIZE];
-        Segment* segment = reinterpret_cast<Segment*>(chunk);
-        if(!this->kvstore.get(std::string(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
+        rocksdb::PinnableSlice value;
+        if(!this->kvstore.get(rocksdb::Slice(reinterpret_cast<char*>(&key), KEY_SIZE), &value)){
           return 0;
         }
-        memcpy(chunk, value.c_str(), value.size());
+        const Segment* segment = reinterpret_cast<const Segment*>(value.data());
         return segment->y_distinct_count;
       }
       break;
@@ -717,15 +1008,35 @@ int TripleTable::distinctCount(TripleOrder key_order, uint32_t subject, uint32_t
   return 0;
 }
 
+void TripleTable::segmentKeys(uint8_t label, const std::vector<uint32_t>& ids, uint32_t y, std::string& keys, std::vector<rocksdb::Slice>& slices) {
+  keys.resize(ids.size() * KEY_SIZE);
+  slices.resize(ids.size());
+  Key key = { label, 0, y};
+  for(int i=0; i<ids.size(); i++) {
+    key.x = ids[i];
+    memcpy(&keys[i * KEY_SIZE], reinterpret_cast<char*>(&key), KEY_SIZE);
+    slices[i] = rocksdb::Slice(keys.data() + i * KEY_SIZE, KEY_SIZE);
+  }
+}
+
 const uint32_t TripleTable::KEY_SIZE = sizeof(uint32_t) * 2 + sizeof(uint8_t);
 
 const uint32_t TripleTable::SEGMENT_MAX_SIZE = 4096;
-const uint32_t TripleTable::SEGMENT_HEADER_SIZE = sizeof(uint32_t) * 9 + sizeof(uint16_t) * 2;
+const uint32_t TripleTable::SEGMENT_HEADER_SIZE = sizeof(uint32_t) * 13 + sizeof(uint16_t) * 2;
 const uint32_t TripleTable::SEGMENT_DATA_MAX_SIZE = SEGMENT_MAX_SIZE - TripleTable::SEGMENT_HEADER_SIZE;
 
 const uint32_t TripleTable::NODE_HEADER_SIZE = sizeof(uint32_t) * 2 + sizeof(uint16_t) * 2;
 const uint32_t TripleTable::NODE_DATA_MAX_SIZE = BLOCK_SIZE - TripleTable::NODE_HEADER_SIZE;
 
+const uint16_t TripleTable::RAW_NODE = 0;
+const uint16_t TripleTable::FOR_NODE = 1;
+const uint16_t TripleTable::DELTA_NODE = 2;
+const uint32_t TripleTable::PACKED_HEADER_SIZE = sizeof(uint32_t) * 2 + sizeof(uint8_t);
+const uint32_t TripleTable::PACKED_MAX_COUNT = 1 << 16;
+
+const uint32_t TripleTable::EXTENT_MIN_BLOCKS = 1;
+const uint32_t TripleTable::EXTENT_MAX_BLOCKS = 64;
+
 
 bool TripleTable::readNode(uint32_t block_no, Node* node) {
   return true;
@@ -736,26 +1047,30 @@ bool TripleTable::writeNode(uint32_t block_no, Node* node) {
 
 bool TripleTable::readData(const Segment* segment, int pos, std::vector<uint32_t>& column) {
   uint32_t first_block_no = 0;
+  ExtentCursor extent = { 0, 0, 0 };
   if(pos == 1) {
     first_block_no = segment->x_first_block_no;
+    extent.last_block_no = segment->x_last_block_no;
   } else if(pos == 2) {
     first_block_no = segment->y_first_block_no;
+    extent.last_block_no = segment->y_last_block_no;
   }
   bool exist = false;
   if(first_block_no != 0) {
     exist = true;
+    enterExtent(extent, first_block_no);
     BufferPage* page = this->data_file.getNode(first_block_no);
     char* block = page->getBlockData();
     Node* node = reinterpret_cast<Node*>(block);
-    int pos = 0;
     while(true) {
       if(node->next_block_no != 0) {
-        this->data_file.prefetchNode(node->next_block_no);
+        enterExtent(extent, node->next_block_no);
       }
 
-      column.insert(column.end(), reinterpret_cast<uint32_t*>(node->data), reinterpret_cast<uint32_t*>(node->data)+node->dsize/sizeof(uint32_t));
+      decodeNode(node, column);
 
       if(node->next_block_no == 0) {
+        this->data_file.updateNode(page, false, true);
         break;
       }
       this->data_file.updateNode(page, false, true);
@@ -786,15 +1101,21 @@ void TripleTable::writeData(Segment* segment, int pos, const std::vector<uint32_
     return;
   }
 
+  uint32_t extent_start = pos == 1 ? segment->x_extent_start : segment->y_extent_start;
+  uint32_t extent_length = pos == 1 ? segment->x_extent_length : segment->y_extent_length;
+
   BufferPage* page;
   char* block;
   Node* node;
+  // the ids of the last node are encoded again together with the new ones
+  std::vector<uint32_t> ids;
   if(last_block_no != 0) {
     page = this->data_file.getNode(last_block_no);
     block = page->getBlockData();
     node = reinterpret_cast<Node*>(block);
+    decodeNode(node, ids);
   } else {
-    page = this->data_file.appendNode();
+    page = this->data_file.newNode(nextDataBlock(extent_start, extent_length, 0));
     if(pos == 1) {
       segment->x_first_block_no = page->getBlockNo();
     }else if(pos == 2) {
@@ -804,40 +1125,232 @@ void TripleTable::writeData(Segment* segment, int pos, const std::vector<uint32_
     node = reinterpret_cast<Node*>(block);
     node->block_no = page->getBlockNo();
     node->next_block_no = 0;
-    node->dtype = 0;
-    node->dsize = 0;
   }
+  ids.insert(ids.end(), column.begin(), column.end());
 
-  for(int i=0; i<column.size(); i++) {
-    entry = column[i];
-
-    if(node->dsize + sizeof(uint32_t) >= NODE_DATA_MAX_SIZE) {
-      BufferPage* new_page = this->data_file.appendNode();
-      node->next_block_no = new_page->getBlockNo();
-      this->data_file.updateNode(page, true, true);
-
-      page = new_page;
-      block = page->getBlockData();
-      node = reinterpret_cast<Node*>(block);
-      node->block_no = page->getBlockNo();
-      node->next_block_no = 0;
-      node->dtype = 0;
-      node->dsize = 0;
-    }
+  size_t i = encodeNode(node, ids.data(), ids.size());
+  while(i < ids.size()) {
+    BufferPage* new_page = this->data_file.newNode(nextDataBlock(extent_start, extent_length, page->getBlockNo()));
+    node->next_block_no = new_page->getBlockNo();
+    this->data_file.updateNode(page, true, true);
 
-    memcpy(node->data + node->dsize, reinterpret_cast<char*>(&entry), sizeof(uint32_t));
-    node->dsize += sizeof(uint32_t);
+    page = new_page;
+    block = page->getBlockData();
+    node = reinterpret_cast<Node*>(block);
+    node->block_no = page->getBlockNo();
+    node->next_block_no = 0;
+    i += encodeNode(node, ids.data() + i, ids.size() - i);
   }
 
   if(pos == 1) {
     segment->x_last_block_no = page->getBlockNo();
+    segment->x_extent_start = extent_start;
+    segment->x_extent_length = extent_length;
   } else if(pos == 2) {
     segment->y_last_block_no = page->getBlockNo();
+    segment->y_extent_start = extent_start;
+    segment->y_extent_length = extent_length;
   }
 
   this->data_file.updateNode(page, true, true);
 }
 
+uint32_t TripleTable::nextDataBlock(uint32_t& start, uint32_t& length, uint32_t last_block_no) {
+  if(last_block_no != 0 && last_block_no + 1 < start + length) {
+    return last_block_no + 1;
+  }
+  length = length == 0 ? EXTENT_MIN_BLOCKS : std::min(length * 2, EXTENT_MAX_BLOCKS);
+  start = this->data_file.allocateExtent(length);
+  return start;
+}
+
+void TripleTable::enterExtent(ExtentCursor& extent, uint32_t block_no) {
+  if(block_no >= extent.start && block_no < extent.start + extent.length) {
+    return;
+  }
+  // extents follow each other in the order they were allocated
+  extent.length = extent.length == 0 ? EXTENT_MIN_BLOCKS : std::min(extent.length * 2, EXTENT_MAX_BLOCKS);
+  extent.start = block_no;
+  uint32_t length = extent.length;
+  if(extent.last_block_no >= block_no && extent.last_block_no < block_no + length) {
+    length = extent.last_block_no - block_no + 1;
+  }
+  this->data_file.prefetchExtent(block_no, length);
+}
+
+static int bitWidth(uint32_t value) {
+  return value == 0 ? 0 : 32 - __builtin_clz(value);
+}
+
+size_t TripleTable::encodeNode(Node* node, const uint32_t* ids, size_t n) {
+  if(n == 0) {
+    node->dtype = RAW_NODE;
+    node->dsize = 0;
+    return 0;
+  }
+  // unpacking loads eight bytes from where a value starts
+  const size_t max_bits = (size_t)(NODE_DATA_MAX_SIZE - PACKED_HEADER_SIZE - sizeof(uint64_t)) * 8;
+  const size_t max_count = std::min<size_t>(n, PACKED_MAX_COUNT);
+
+  // the longest prefix of ids each encoding holds
+  size_t raw_count = std::min<size_t>(n, (NODE_DATA_MAX_SIZE - 1) / sizeof(uint32_t));
+  size_t for_count = 0, delta_count = 0;
+  int for_width = 0, delta_width = 0;
+  uint32_t min_id = ids[0], max_id = ids[0];
+  while(for_count < max_count) {
+    uint32_t lo = std::min(min_id, ids[for_count]), hi = std::max(max_id, ids[for_count]);
+    int width = bitWidth(hi - lo);
+    if((for_count + 1) * width > max_bits) {
+      break;
+    }
+    min_id = lo;
+    max_id = hi;
+    for_width = width;
+    for_count++;
+  }
+  while(delta_count < max_count) {
+    if(delta_count > 0 && ids[delta_count] < ids[delta_count-1]) {
+      break;
+    }
+    int width = std::max(delta_width, delta_count > 0 ? bitWidth(ids[delta_count] - ids[delta_count-1]) : 0);
+    if((delta_count + 1) * width > max_bits) {
+      break;
+    }
+    delta_width = width;
+    delta_count++;
+  }
+
+  // the encoding holding the most ids, and the smallest one among those
+  uint16_t dtype = RAW_NODE;
+  size_t count = raw_count;
+  size_t size = raw_count * sizeof(uint32_t);
+  size_t for_size = PACKED_HEADER_SIZE + (for_count * for_width + 7) / 8;
+  size_t delta_size = PACKED_HEADER_SIZE + (delta_count * delta_width + 7) / 8;
+  if(for_count > count || (for_count == count && for_size < size)) {
+    dtype = FOR_NODE;
+    count = for_count;
+    size = for_size;
+  }
+  if(delta_count > count || (delta_count == count && delta_size < size)) {
+    dtype = DELTA_NODE;
+    count = delta_count;
+    size = delta_size;
+  }
+
+  node->dtype = dtype;
+  node->dsize = size;
+  if(dtype == RAW_NODE) {
+    memcpy(node->data, ids, size);
+    return count;
+  }
+
+  PackedData* packed = reinterpret_cast<PackedData*>(node->data);
+  packed->count = count;
+  packed->base = dtype == FOR_NODE ? min_id : ids[0];
+  packed->width = dtype == FOR_NODE ? for_width : delta_width;
+  memset(packed->bits, 0, size - PACKED_HEADER_SIZE + sizeof(uint64_t));
+  int width = packed->width;
+  for(size_t i=0; i<count && width > 0; i++) {
+    uint64_t value = dtype == FOR_NODE ? ids[i] - packed->base : (i == 0 ? 0 : ids[i] - ids[i-1]);
+    size_t bit = i * width;
+    uint64_t word;
+    memcpy(&word, packed->bits + bit / 8, sizeof(uint64_t));
+    word |= value << (bit % 8);
+    memcpy(packed->bits + bit / 8, &word, sizeof(uint64_t));
+  }
+  return count;
+}
+
+void TripleTable::decodeNode(const Node* node, std::vector<uint32_t>& column) {
+  if(node->dtype == RAW_NODE) {
+    const uint32_t* ids = reinterpret_cast<const uint32_t*>(node->data);
+    column.insert(column.end(), ids, ids + node->dsize/sizeof(uint32_t));
+    return;
+  }
+
+  const PackedData* packed = reinterpret_cast<const PackedData*>(node->data);
+  size_t count = packed->count;
+  uint32_t base = packed->base;
+  int width = packed->width;
+  size_t offset = column.size();
+  column.resize(offset + count);
+  uint32_t* out = column.data() + offset;
+
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if(has_avx2 && width <= 25) {
+    unpackBitsAvx2(packed->bits, width, count, out);
+  } else
+#endif
+  unpackBits(packed->bits, width, count, out);
+
+  if(node->dtype == FOR_NODE) {
+    for(size_t i=0; i<count; i++) {
+      out[i] += base;
+    }
+    return;
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  if(has_avx2) {
+    prefixSumAvx2(out, count, base);
+    return;
+  }
+#endif
+  for(size_t i=0; i<count; i++) {
+    base += out[i];
+    out[i] = base;
+  }
+}
+
+void TripleTable::unpackBits(const char* bits, int width, size_t count, uint32_t* out) {
+  uint64_t mask = ((uint64_t)1 << width) - 1;
+  for(size_t i=0; i<count; i++) {
+    size_t bit = i * width;
+    uint64_t word;
+    memcpy(&word, bits + bit / 8, sizeof(uint64_t));
+    out[i] = (word >> (bit % 8)) & mask;
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void TripleTable::unpackBitsAvx2(const char* bits, int width, size_t count, uint32_t* out) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i mask = _mm256_set1_epi32(width == 0 ? 0 : (uint32_t)(((uint64_t)1 << width) - 1));
+  const __m256i seven = _mm256_set1_epi32(7);
+  size_t i = 0;
+  for(; i+8<=count; i+=8) {
+    // bit offsets of the eight values, which stay below 2^31 in a node
+    __m256i bit = _mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(i), lanes), _mm256_set1_epi32(width));
+    __m256i word = _mm256_i32gather_epi32((const int*)bits, _mm256_srli_epi32(bit, 3), 1);
+    word = _mm256_srlv_epi32(word, _mm256_and_si256(bit, seven));
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(word, mask));
+  }
+  unpackBits(bits + i * width / 8, width, count - i, out + i);
+}
+
+__attribute__((target("avx2")))
+void TripleTable::prefixSumAvx2(uint32_t* values, size_t count, uint32_t base) {
+  __m256i carry = _mm256_set1_epi32(base);
+  size_t i = 0;
+  for(; i+8<=count; i+=8) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+    // sums within each 128-bit lane, then the low lane's total into the high one
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    x = _mm256_add_epi32(x, _mm256_permute2x128_si256(_mm256_shuffle_epi32(x, 0xFF), _mm256_shuffle_epi32(x, 0xFF), 0x08));
+    x = _mm256_add_epi32(x, carry);
+    _mm256_storeu_si256((__m256i*)(values + i), x);
+    carry = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+  }
+  base = _mm256_cvtsi256_si32(carry);
+  for(; i<count; i++) {
+    base += values[i];
+    values[i] = base;
+  }
+}
+#endif
+
 bool TripleTable::readBitVector(Segment* segment, ResourcePosition pos, RoaringBitVector& bitvec) {
   switch(pos) {
     case SUBJECT:
@@ -851,6 +1364,7 @@ bool TripleTable::readBitVector(Segment* segment, ResourcePosition pos, RoaringB
           buf.append(node->data, node->dsize);
 
           if(node->next_block_no == 0) {
+            this->index_file.updateNode(page, false, true);
             break;
           }
           this->index_file.updateNode(page, false, true);
@@ -874,6 +1388,7 @@ bool TripleTable::readBitVector(Segment* segment, ResourcePosition pos, RoaringB
           buf.append(node->data, node->dsize);
 
           if(node->next_block_no == 0) {
+            this->index_file.updateNode(page, false, true);
             break;
           }
           this->index_file.updateNode(page, false, true);
@@ -991,7 +1506,7 @@ TripleTable::HeapFile::~HeapFile() {}
 
 bool TripleTable::HeapFile::open() {
   if(!File::exist(file_path)) {
-    if(!create(FILE_GROWTH, 0)) {
+    if(!create(FILE_GROWTH, VERSION)) {
       return false;
     }
   }
@@ -1002,6 +1517,8 @@ bool TripleTable::HeapFile::open() {
 
   header = reinterpret_cast<Header*>(new char[HEADER_SIZE]);
   if(!readHeader()) {
+    delete[] reinterpret_cast<char*>(header);
+    file.close();
     return false;
   }
   return true;
@@ -1031,6 +1548,27 @@ BufferPage* TripleTable::HeapFile::appendNode() {
   return page;
 }
 
+uint32_t TripleTable::HeapFile::allocateExtent(uint32_t length) {
+  mutex.lock();
+  uint32_t block_no = header->num_block;
+  header->num_block += length;
+  uint64_t fsize = (uint64_t)header->num_block * BLOCK_SIZE;
+  if(fsize > header->file_size) {
+    fsize = (uint64_t)(header->num_block + FILE_GROWTH) * BLOCK_SIZE;
+    file.truncate(fsize);
+    header->file_size = fsize;
+  }
+  mutex.unlock();
+  return block_no;
+}
+
+BufferPage* TripleTable::HeapFile::newNode(uint32_t block_no) {
+  mutex.lock();
+  BufferPage* page = buffer_manager->allocBufferPage(&this->file, block_no, false);
+  mutex.unlock();
+  return page;
+}
+
 BufferPage* TripleTable::HeapFile::getNode(uint32_t block_no) {
   return this->buffer_manager->getBufferPage(&this->file, block_no, true);
 }
@@ -1039,12 +1577,17 @@ void TripleTable::HeapFile::prefetchNode(uint32_t block_no) {
   this->file.prefetch(block_no * BLOCK_SIZE, BLOCK_SIZE);
 }
 
+void TripleTable::HeapFile::prefetchExtent(uint32_t block_no, uint32_t length) {
+  this->file.prefetch((off64_t)block_no * BLOCK_SIZE, (size_t)length * BLOCK_SIZE);
+}
+
 void TripleTable::HeapFile::updateNode(BufferPage* page, bool dirty, bool exclusive) {
   this->buffer_manager->unfixBufferPage(page, dirty, exclusive);
 }
 
 const uint32_t TripleTable::HeapFile::HEADER_SIZE = sizeof(uint32_t) * 4 + sizeof(uint64_t);
 const uint32_t TripleTable::HeapFile::FILE_GROWTH = 20;
+const uint32_t TripleTable::HeapFile::VERSION = 1;
 
 bool TripleTable::HeapFile::create(uint32_t capacity, uint32_t version) {
   if(capacity < 1) {
@@ -1066,10 +1609,19 @@ bool TripleTable::HeapFile::create(uint32_t capacity, uint32_t version) {
 
 bool TripleTable::HeapFile::readHeader() {
   this->file.read(reinterpret_cast<char*>(header), HEADER_SIZE, 0);
-  return true;
+  // files of an older version have segments of another layout
+  return header->version == VERSION;
 }
 
 bool TripleTable::HeapFile::writeHeader() {
   this->file.write(reinterpret_cast<const char*>(header), HEADER_SIZE, 0);
   return true;
 }
+
+
+
+TripleTable::BlockScanner::FetchTask::FetchTask(BlockScanner* parent, int batch) : parent(parent), batch(batch) {}
+
+void TripleTable::BlockScanner::FetchTask::run() {
+  parent->runFetch(batch);
+}
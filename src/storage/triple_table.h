@@ -2,6 +2,7 @@
 #define TRIPLE_TABLE_H
 
 #include <string>
+#include <memory>
 #include "common/triple.h"
 #include "common/resource.h"
 #include "common/constants.h"
@@ -11,6 +12,9 @@
 #include "util/bdb_file.h"
 #include "util/file_directory.h"
 #include "thread/mutex.h"
+#include "thread/condition.h"
+#include "thread/runnable.h"
+#include "thread/thread_pool.h"
 
 
 
@@ -22,15 +26,107 @@ public:
   bool open();
   bool close();
 
+  // The extent a scan of a chain of nodes is in. Each extent is read ahead
+  // as a whole once the scan enters it, up to the last node of the chain.
+  struct ExtentCursor {
+    uint32_t start;
+    uint32_t length;
+    uint32_t last_block_no;
+  };
+
+  // A column of a Batch: the ids of its rows, or one id repeated on every
+  // row when ids is nullptr.
+  struct ColumnView {
+    const uint32_t* ids;
+    uint32_t constant;
+
+    uint32_t operator[](size_t row) const { return ids != nullptr ? ids[row] : constant; }
+  };
+
+  // Rows handed out by BlockScanner::nextBatch without copying them. The
+  // views point into data pages pinned by the batch, or into ids decoded
+  // from packed nodes, and stay valid until the batch is released.
+  struct Batch {
+    size_t size;
+    ColumnView subject;
+    ColumnView object;
+
+    std::vector<BufferPage*> pages;
+    std::vector<std::shared_ptr<std::vector<uint32_t>>> buffers;
+  };
+
+  // A scanner is read either through the columns of its resources with
+  // next(), or in batches with nextBatch(). Pushed down keys are sorted, and
+  // their segments are looked up in batches: with more than one thread the
+  // batches after the first are fetched by a pool while the scan reads the
+  // ones already there.
   class BlockScanner {
   public:
     BlockScanner(TripleTable& table, TripleOrder key_order, Resource *subject, Resource *predicate, Resource *object);
+    ~BlockScanner();
 
     bool find();
     bool next();
 
+    // Releases the rows batch held, fills it with the next ones, and tells
+    // whether there were any.
+    bool nextBatch(Batch& batch);
+    // Unpins the pages of the batch.
+    void release(Batch& batch);
+    // Tells whether the segments of some keys could not be read, which
+    // ends the scan early.
+    bool hasFailed();
+
   private:
+    // The node of a column a batch scan is in.
+    struct Cursor {
+      ExtentCursor extent;
+      // pinned while the node is raw
+      BufferPage* page;
+      std::shared_ptr<std::vector<uint32_t>> decoded;
+      const uint32_t* ids;
+      size_t pos;
+      size_t size;
+      uint32_t next_block_no;
+    };
+
     bool read();
+    // Reads both columns of a P segment, whose nodes need not end on the
+    // same row; the ids one column read ahead wait in x_rest or y_rest.
+    bool readPaired();
+    // Appends the ids of the node to column, and returns the next block.
+    uint32_t scanNode(uint32_t block_no, ExtentCursor& extent, std::vector<uint32_t>& column);
+    // Moves the cursor to the next node of its column, if it has none left.
+    bool advance(Cursor& cursor);
+    // Points view at the next n ids of the cursor, pinning them for batch.
+    void take(Cursor& cursor, size_t n, ColumnView& view, Batch& batch);
+    void resetCursor(Cursor& cursor, uint32_t block_no, uint32_t last_block_no);
+    // the rows of the batch from the nodes of the current segment
+    bool readBatch(Batch& batch);
+    // the rows of the batch from ids the scanner decoded itself
+    void bufferColumn(std::shared_ptr<std::vector<uint32_t>>& ids, ColumnView& view, Batch& batch);
+
+    class FetchTask : public Runnable {
+    public:
+      FetchTask(BlockScanner* parent, int batch);
+      void run();
+
+    private:
+      BlockScanner* parent;
+      int batch;
+    };
+
+    // Looks up the segments of the keys in key_ids under label.
+    bool fetchSegments(uint8_t label);
+    bool fetch(int batch);
+    void runFetch(int batch);
+    // Waits for the segment of key i, and tells whether it could be read.
+    bool waitFetched(int i);
+
+    static const int FETCH_BATCH_SIZE;
+    static const char FETCH_PENDING;
+    static const char FETCH_DONE;
+    static const char FETCH_FAILED;
 
     TripleTable& table;
     Resource *subject, *predicate, *object;
@@ -40,8 +136,25 @@ public:
     int idx;
     uint32_t x_block_no;
     uint32_t y_block_no;
-
-    std::vector<std::string> values;
+    ExtentCursor x_extent;
+    ExtentCursor y_extent;
+    std::vector<uint32_t> x_rest;
+    std::vector<uint32_t> y_rest;
+    Cursor x_cursor;
+    Cursor y_cursor;
+
+    // segments read in place from RocksDB, the one of key i in slots[i]
+    std::vector<rocksdb::PinnableSlice> values;
+    std::vector<int> slots;
+    std::string keys;
+    std::vector<rocksdb::Slice> key_slices;
+
+    ThreadPool* fetch_pool;
+    std::vector<FetchTask*> fetch_tasks;
+    std::vector<char> fetch_state;
+    bool failed;
+    Mutex fetch_mutex;
+    Condition fetch_cond;
   };
   friend class BlockScanner;
 
@@ -72,6 +185,11 @@ private:
     uint32_t y_last_block_no;
     uint32_t x_index_block_no;
     uint32_t y_index_block_no;
+    // the extents the last nodes of the columns are in
+    uint32_t x_extent_start;
+    uint32_t x_extent_length;
+    uint32_t y_extent_start;
+    uint32_t y_extent_length;
     uint16_t dtype;
     uint16_t dsize;
     char data[1];
@@ -83,10 +201,21 @@ private:
     uint16_t dsize;
     char data[1];
   };
+  // data of a FOR_NODE or DELTA_NODE: count values of width bits each
+  struct PackedData {
+    uint32_t count;
+    uint32_t base;
+    uint8_t width;
+    char bits[1];
+  };
   #pragma pack(pop)
 
   static const uint32_t KEY_SIZE;
 
+  // Keys of the segments (label, ids[i], y), with slices over them for a
+  // batched lookup.
+  static void segmentKeys(uint8_t label, const std::vector<uint32_t>& ids, uint32_t y, std::string& keys, std::vector<rocksdb::Slice>& slices);
+
   static const uint32_t SEGMENT_MAX_SIZE;
   static const uint32_t SEGMENT_HEADER_SIZE;
   static const uint32_t SEGMENT_DATA_MAX_SIZE;
@@ -94,6 +223,21 @@ private:
   static const uint32_t NODE_HEADER_SIZE;
   static const uint32_t NODE_DATA_MAX_SIZE;
 
+  // Node encodings, in Node::dtype:
+  //  - RAW_NODE holds the ids as they are.
+  //  - FOR_NODE holds every id minus base, the smallest one.
+  //  - DELTA_NODE holds the gaps between ascending ids, from base on.
+  static const uint16_t RAW_NODE;
+  static const uint16_t FOR_NODE;
+  static const uint16_t DELTA_NODE;
+  static const uint32_t PACKED_HEADER_SIZE;
+  static const uint32_t PACKED_MAX_COUNT;
+
+  // The nodes of a column are allocated in runs of contiguous blocks, each
+  // twice as long as the one before, up to EXTENT_MAX_BLOCKS.
+  static const uint32_t EXTENT_MIN_BLOCKS;
+  static const uint32_t EXTENT_MAX_BLOCKS;
+
   // Segment file
   class HeapFile {
   public:
@@ -106,6 +250,11 @@ private:
     BufferPage* appendNode();
     BufferPage* getNode(uint32_t block_no);
     void prefetchNode(uint32_t block_no);
+    // Reserves length contiguous blocks, and returns the first one.
+    uint32_t allocateExtent(uint32_t length);
+    // Page of a block reserved by allocateExtent.
+    BufferPage* newNode(uint32_t block_no);
+    void prefetchExtent(uint32_t block_no, uint32_t length);
     void updateNode(BufferPage* page, bool dirty, bool exclusive);
 
   private:
@@ -121,6 +270,8 @@ private:
 
     static const uint32_t HEADER_SIZE;
     static const uint32_t FILE_GROWTH;
+    // Layout of the store, files of another version are not opened.
+    static const uint32_t VERSION;
 
     bool create(uint32_t capacity, uint32_t version);
 
@@ -148,6 +299,23 @@ private:
 
   bool readNode(uint32_t block_no, Node* node);
   bool writeNode(uint32_t block_no, Node* node);
+  // Fills the node with as many of the n ids as its most compact encoding
+  // holds, and tells how many.
+  static size_t encodeNode(Node* node, const uint32_t* ids, size_t n);
+  // Appends the ids of the node to column.
+  static void decodeNode(const Node* node, std::vector<uint32_t>& column);
+  static void unpackBits(const char* bits, int width, size_t count, uint32_t* out);
+  // unpacks eight values of up to 25 bits with one 32-bit gather
+  static void unpackBitsAvx2(const char* bits, int width, size_t count, uint32_t* out);
+  // turns gaps into ids by a running sum from base, eight lanes at a time
+  static void prefixSumAvx2(uint32_t* values, size_t count, uint32_t base);
+
+  // Block for the node after last_block_no in a column, from the extent
+  // (start, length) or from a new one that replaces it.
+  uint32_t nextDataBlock(uint32_t& start, uint32_t& length, uint32_t last_block_no);
+  // Moves the scan to block_no, reading ahead the extent it enters.
+  void enterExtent(ExtentCursor& extent, uint32_t block_no);
+
   bool readData(const Segment* segment, int pos, std::vector<uint32_t>& column);
   void writeData(Segment* segment, int pos, const std::vector<uint32_t>& column);
   bool readBitVector(Segment* segment, ResourcePosition pos, RoaringBitVector& bitvec);
@@ -157,6 +325,8 @@ private:
 
   HeapFile data_file;
   HeapFile index_file;
+
+  friend class NodeCodecTest;
 };
 
 
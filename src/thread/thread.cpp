@@ -30,4 +30,5 @@ long Thread::threadID() {
 void* Thread::threadMain(void* arg) {
   Runnable* runnable = static_cast<Runnable*>(arg);
   runnable->run();
+  return nullptr;
 }
@@ -0,0 +1,70 @@
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool(int num_threads) : num_pending(0), stopped(false) {
+  for(int i=0; i<num_threads; i++) {
+    Worker* worker = new Worker(*this);
+    Thread* thread = new Thread(worker, false);
+    workers.push_back(worker);
+    threads.push_back(thread);
+    thread->start();
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  mutex.lock();
+  stopped = true;
+  task_cond.notifyAll();
+  mutex.unlock();
+  for(int i=0; i<threads.size(); i++) {
+    threads[i]->join();
+    delete threads[i];
+    delete workers[i];
+  }
+}
+
+int ThreadPool::numOfThreads() {
+  return threads.size();
+}
+
+void ThreadPool::execute(Runnable* task) {
+  mutex.lock();
+  tasks.push_back(task);
+  ++num_pending;
+  task_cond.notifyOne();
+  mutex.unlock();
+}
+
+void ThreadPool::wait() {
+  mutex.lock();
+  while(num_pending > 0) {
+    done_cond.wait(mutex);
+  }
+  mutex.unlock();
+}
+
+ThreadPool::Worker::Worker(ThreadPool& pool) : pool(pool) {}
+
+void ThreadPool::Worker::run() {
+  while(true) {
+    pool.mutex.lock();
+    while(pool.tasks.empty() && !pool.stopped) {
+      pool.task_cond.wait(pool.mutex);
+    }
+    if(pool.tasks.empty()) {
+      pool.mutex.unlock();
+      return;
+    }
+    Runnable* task = pool.tasks.front();
+    pool.tasks.pop_front();
+    pool.mutex.unlock();
+
+    task->run();
+
+    pool.mutex.lock();
+    if(--pool.num_pending == 0) {
+      pool.done_cond.notifyAll();
+    }
+    pool.mutex.unlock();
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <deque>
+#include <vector>
+#include "thread.h"
+#include "mutex.h"
+#include "condition.h"
+#include "runnable.h"
+
+
+class ThreadPool {
+public:
+  ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  int numOfThreads();
+
+  // Tasks are owned by the caller and must stay alive until wait() returns.
+  void execute(Runnable* task);
+  void wait();
+
+private:
+  class Worker : public Runnable {
+  public:
+    Worker(ThreadPool& pool);
+    void run();
+
+  private:
+    ThreadPool& pool;
+  };
+
+  std::vector<Worker*> workers;
+  std::vector<Thread*> threads;
+
+  std::deque<Runnable*> tasks;
+  int num_pending;
+  bool stopped;
+
+  Mutex mutex;
+  Condition task_cond;
+  Condition done_cond;
+};
+
+
+#endif
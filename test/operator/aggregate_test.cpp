@@ -0,0 +1,60 @@
+#include <string>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include "operator/aggregate.h"
+
+class AggregateTest : public testing::Test {
+protected:
+  typedef Aggregate::State State;
+
+  static bool addInteger(State& state, int64_t value, uint64_t count) {
+    return Aggregate::addInteger(state, value, count);
+  }
+
+  static std::string integerLiteral(int64_t number) {
+    return Aggregate::integerLiteral(number);
+  }
+
+  static std::string numericLiteral(double number, bool integral) {
+    return Aggregate::numericLiteral(number, integral);
+  }
+
+  static std::string lexical(const std::string& literal) {
+    return literal.substr(1, literal.find('"', 1) - 1);
+  }
+};
+
+TEST_F(AggregateTest, exactIntegerSum) {
+  // beyond 2^53 a double sum drops the last units
+  State state;
+  EXPECT_TRUE(addInteger(state, 9007199254740993LL, 1));
+  EXPECT_TRUE(addInteger(state, 1, 2));
+  EXPECT_EQ(9007199254740995LL, state.integer_sum);
+  EXPECT_EQ("9007199254740995", lexical(integerLiteral(state.integer_sum)));
+
+  EXPECT_TRUE(addInteger(state, -3, 3));
+  EXPECT_EQ(9007199254740986LL, state.integer_sum);
+}
+
+TEST_F(AggregateTest, integerOverflow) {
+  State state;
+  EXPECT_TRUE(addInteger(state, INT64_MAX, 1));
+  EXPECT_FALSE(addInteger(state, 1, 1));
+  EXPECT_FALSE(addInteger(state, INT64_MAX / 2, 3));
+  // a failed addition leaves the sum as it was
+  EXPECT_EQ(INT64_MAX, state.integer_sum);
+}
+
+TEST_F(AggregateTest, literals) {
+  EXPECT_EQ("\"-12\"^^<http://www.w3.org/2001/XMLSchema#integer>", integerLiteral(-12));
+  EXPECT_EQ("\"2.5\"^^<http://www.w3.org/2001/XMLSchema#decimal>", numericLiteral(2.5, false));
+  EXPECT_EQ("3.0", lexical(numericLiteral(3, false)));
+
+  // no magnitude is cut short
+  std::string integral = lexical(numericLiteral(-1e300, true));
+  EXPECT_EQ(302, integral.size());
+  EXPECT_EQ("-1000000000000000052", integral.substr(0, 20));
+  std::string decimal = lexical(numericLiteral(1.5e308, false));
+  EXPECT_EQ(311, decimal.size());
+  EXPECT_EQ(".0", decimal.substr(309));
+}
@@ -0,0 +1,91 @@
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+#include <gtest/gtest.h>
+#include "common/constants.h"
+#include "database/config.h"
+#include "operator/hash_join.h"
+
+// Produces its rows in one batch.
+class ValuesInput : public Operator {
+public:
+  ValuesInput(const std::map<Resource*, std::vector<uint32_t>>& values) : Operator(values.begin()->second.size()), values(values) {}
+
+  void open() {}
+  void close() {}
+
+  bool first() {
+    for(std::map<Resource*, std::vector<uint32_t>>::iterator iter = values.begin(); iter != values.end(); ++iter) {
+      iter->first->column.insert(iter->first->column.end(), iter->second.begin(), iter->second.end());
+    }
+    return !values.begin()->second.empty();
+  }
+
+  bool next() {
+    return false;
+  }
+
+private:
+  std::map<Resource*, std::vector<uint32_t>> values;
+};
+
+class HashJoinTest : public testing::Test {
+protected:
+  void SetUp() {
+    Config::setParam(ConfigKey::NUM_THREADS, "1");
+  }
+
+  // every row of the join, over the columns of output
+  static std::multiset<std::vector<uint32_t>> run(HashJoin& join, const std::vector<Resource*>& output) {
+    std::multiset<std::vector<uint32_t>> rows;
+    join.open();
+    for(bool more = join.first(); more; more = join.next()) {
+      for(size_t r=0; r<output[0]->column.size(); r++) {
+        std::vector<uint32_t> row;
+        for(int s=0; s<output.size(); s++) {
+          row.push_back(output[s]->column[r]);
+        }
+        rows.insert(row);
+      }
+      for(int s=0; s<output.size(); s++) {
+        output[s]->column.clear();
+      }
+    }
+    join.close();
+    return rows;
+  }
+};
+
+TEST_F(HashJoinTest, optionalWithoutKey) {
+  // ?b is unbound on a required row, which is compatible with every
+  // optional row: no hash key can find them, the join has none
+  Resource a(0), b(1), c(2);
+  Resource opt_b(1), opt_c(2);
+  Resource out_a(0), out_b(1), out_c(2);
+  ValuesInput* required = new ValuesInput({ { &a, { 2, 3, 4 } }, { &b, { UNBOUND_ID, 5, 7 } } });
+  ValuesInput* optional = new ValuesInput({ { &opt_b, { 5, 6 } }, { &opt_c, { 50, 60 } } });
+  HashJoin join(optional, { { 1, &opt_b }, { 2, &opt_c } }, required, { { 0, &a }, { 1, &b } }, { { 0, &out_a }, { 1, &out_b }, { 2, &out_c } }, UINT32_MAX, 3, true);
+
+  std::multiset<std::vector<uint32_t>> expected = {
+    { 2, 5, 50 }, { 2, 6, 60 },
+    { 3, 5, 50 },
+    { 4, 7, UNBOUND_ID }
+  };
+  EXPECT_EQ(expected, run(join, { &out_a, &out_b, &out_c }));
+  delete required;
+  delete optional;
+}
+
+TEST_F(HashJoinTest, optionalCrossProduct) {
+  Resource a(0), opt_c(2);
+  Resource out_a(0), out_c(2);
+  ValuesInput* required = new ValuesInput({ { &a, { 1, 2 } } });
+  ValuesInput* optional = new ValuesInput({ { &opt_c, { 8, 9 } } });
+  HashJoin join(optional, { { 2, &opt_c } }, required, { { 0, &a } }, { { 0, &out_a }, { 2, &out_c } }, UINT32_MAX, 2, true);
+
+  std::multiset<std::vector<uint32_t>> expected = { { 1, 8 }, { 1, 9 }, { 2, 8 }, { 2, 9 } };
+  EXPECT_EQ(expected, run(join, { &out_a, &out_c }));
+  delete required;
+  delete optional;
+}
@@ -205,3 +205,99 @@ TEST_F(SPARQParserTest, parse9) {
   bool valid4 = parser.parse(&query_graph4);
   EXPECT_FALSE(valid4);
 }
+
+TEST_F(SPARQParserTest, parse10) {
+  std::string query_string = "SELECT ?x ?name \n";
+  query_string += "WHERE { ?x <http://xmlns.com/foaf/0.1/name> ?name. } \n";
+  query_string += "ORDER BY DESC(?name) ?x LIMIT 10 OFFSET 5";
+  QueryGraph query_graph;
+  bool valid = SPARQLParser::parse(query_string, &query_graph);
+  EXPECT_TRUE(valid);
+  EXPECT_EQ(10, query_graph.getLimit());
+  EXPECT_EQ(5, query_graph.getOffset());
+
+  const std::vector<Order>& order = query_graph.getOrder();
+  EXPECT_EQ(2, order.size());
+  EXPECT_FALSE(order[0].ascending);
+  EXPECT_EQ(QueryExpression::Variable, order[0].condition->type);
+  EXPECT_TRUE(order[1].ascending);
+  EXPECT_EQ(QueryExpression::Variable, order[1].condition->type);
+}
+
+TEST_F(SPARQParserTest, parse11) {
+  std::string query_string = "SELECT ?x \n";
+  query_string += "WHERE { ?x <http://xmlns.com/foaf/0.1/name> ?name. } \n";
+  query_string += "ORDER BY ?name";
+  QueryGraph query_graph;
+  bool valid = SPARQLParser::parse(query_string, &query_graph);
+  EXPECT_TRUE(valid);
+  EXPECT_EQ(-1, query_graph.getLimit());
+  EXPECT_EQ(0, query_graph.getOffset());
+  EXPECT_EQ(1, query_graph.getOrder().size());
+}
+
+TEST_F(SPARQParserTest, parse12) {
+  std::string query_string = "SELECT ?x ?z ?w \n";
+  query_string += "WHERE { ?x <p> ?y. \n";
+  query_string += "OPTIONAL { ?y <q> ?z. OPTIONAL { ?z <r> ?w. } } \n";
+  query_string += "OPTIONAL { ?x <s> ?v. } }";
+  QueryGraph query_graph;
+  bool valid = SPARQLParser::parse(query_string, &query_graph);
+  EXPECT_TRUE(valid);
+
+  const QueryPattern* graph_pattern = query_graph.getQueryPattern();
+  EXPECT_EQ(1, graph_pattern->nodes.size());
+  EXPECT_EQ(2, graph_pattern->optionals.size());
+  EXPECT_EQ(1, graph_pattern->optionals[0]->nodes.size());
+  EXPECT_EQ(1, graph_pattern->optionals[0]->optionals.size());
+  EXPECT_EQ(1, graph_pattern->optionals[0]->optionals[0]->nodes.size());
+  EXPECT_EQ(0, graph_pattern->optionals[1]->optionals.size());
+}
+
+TEST_F(SPARQParserTest, parse13) {
+  std::string query_string = "SELECT ?x ?y \n";
+  query_string += "WHERE { { ?x <p> ?y. ?x <q> ?z. } UNION { ?x <r> ?y. FILTER(?y > 1) } UNION { ?x <s> ?y. } }";
+  QueryGraph query_graph;
+  bool valid = SPARQLParser::parse(query_string, &query_graph);
+  EXPECT_TRUE(valid);
+
+  const QueryPattern* graph_pattern = query_graph.getQueryPattern();
+  EXPECT_EQ(QueryPattern::Union, graph_pattern->type);
+  EXPECT_EQ(0, graph_pattern->nodes.size());
+  EXPECT_EQ(3, graph_pattern->sub_patterns.size());
+  EXPECT_EQ(2, graph_pattern->sub_patterns[0]->nodes.size());
+  EXPECT_EQ(1, graph_pattern->sub_patterns[1]->filters.size());
+  EXPECT_EQ(1, graph_pattern->sub_patterns[2]->nodes.size());
+}
+
+TEST_F(SPARQParserTest, parse14) {
+  std::string query_string = "SELECT ?x (COUNT(*) AS ?n) (avg(DISTINCT ?y) AS ?a) (MAX(?z) AS ?m) \n";
+  query_string += "WHERE { ?x <p> ?y. ?x <q> ?z. } GROUP BY ?x ORDER BY ?n LIMIT 5";
+  QueryGraph query_graph;
+  bool valid = SPARQLParser::parse(query_string, &query_graph);
+  EXPECT_TRUE(valid);
+
+  const std::vector<QueryResource>& projection = query_graph.getProjection();
+  EXPECT_EQ(4, projection.size());
+  EXPECT_EQ("?n", projection[1].value);
+
+  const std::vector<QueryResource>& group_by = query_graph.getGroupBy();
+  EXPECT_EQ(1, group_by.size());
+  EXPECT_EQ("?x", group_by[0].value);
+
+  const std::vector<Aggregation>& aggregations = query_graph.getAggregations();
+  EXPECT_EQ(3, aggregations.size());
+  EXPECT_EQ(Aggregation::Count, aggregations[0].function);
+  EXPECT_EQ(nullptr, aggregations[0].argument);
+  EXPECT_EQ(Aggregation::Avg, aggregations[1].function);
+  EXPECT_TRUE(aggregations[1].distinct);
+  EXPECT_EQ("?y", aggregations[1].argument->value);
+  EXPECT_EQ(Aggregation::Max, aggregations[2].function);
+  EXPECT_FALSE(aggregations[2].distinct);
+  EXPECT_EQ("?m", aggregations[2].variable.value);
+  EXPECT_EQ(5, query_graph.getLimit());
+
+  QueryGraph invalid_graph;
+  valid = SPARQLParser::parse("SELECT ?x ?y (SUM(?y) AS ?s) WHERE { ?x <p> ?y. } GROUP BY ?x", &invalid_graph);
+  EXPECT_FALSE(valid);
+}
@@ -0,0 +1,121 @@
+#include <vector>
+#include <memory>
+#include <gtest/gtest.h>
+#include "plan/query_planner.h"
+
+class QueryPlannerTest : public testing::Test {
+protected:
+  static const int NUM_VARIABLES = 8;
+
+  ~QueryPlannerTest() {
+    for(int i=0; i<nodes.size(); i++) {
+      nodes[i]->~PlanNode();
+    }
+  }
+
+  // Plan nodes are not constructed by the plan either, so they start from
+  // zeroed memory with the fields the planner reads assigned.
+  PlanNode* createNode(PlanNode::Operator op, const std::vector<uint32_t>& vars, const std::vector<PlanNode*>& child_nodes) {
+    buffers.emplace_back(new char[sizeof(PlanNode)]());
+    PlanNode* node = reinterpret_cast<PlanNode*>(buffers.back().get());
+    nodes.push_back(node);
+    node->op = op;
+    node->next = nullptr;
+    node->child_nodes = child_nodes;
+    node->available_res = BitSet(NUM_VARIABLES);
+    for(int i=0; i<vars.size(); i++) {
+      node->available_res.set(vars[i]);
+    }
+    for(int i=0; i<child_nodes.size(); i++) {
+      node->available_res |= child_nodes[i]->available_res;
+    }
+    return node;
+  }
+
+  PlanNode* scan(const std::vector<uint32_t>& vars) {
+    return createNode(PlanNode::TableScan, vars, {});
+  }
+
+  // an OPTIONAL plan node: child 0 is the optional side
+  PlanNode* optionalJoin(PlanNode* required, PlanNode* optional) {
+    return createNode(PlanNode::OptionalJoin, {}, { optional, required });
+  }
+
+  static std::vector<uint32_t> certainRes(const PlanNode* node) {
+    BitSet res = QueryPlanner::getCertainRes(node);
+    std::vector<uint32_t> vars;
+    for(BitSet::SetBitIterator iter = res.begin(); iter != res.end(); ++iter) {
+      vars.push_back(*iter);
+    }
+    return vars;
+  }
+
+  static uint32_t optionalJoinKey(const PlanNode* required, const PlanNode* optional) {
+    return QueryPlanner::getOptionalJoinKey(required, optional);
+  }
+
+  // a pattern ?s <p> ?o of two variables
+  static QueryNode pattern(uint32_t subject, uint32_t object) {
+    QueryNode query_node(QueryResource(QueryResource::Variable, "?s"), QueryResource(QueryResource::IRI, "<p>"), QueryResource(QueryResource::Variable, "?o"));
+    query_node.subject.id = subject;
+    query_node.object.id = object;
+    return query_node;
+  }
+
+  static bool isCyclic(const std::vector<QueryNode>& patterns) {
+    std::vector<const QueryNode*> query_nodes;
+    for(int i=0; i<patterns.size(); i++) {
+      query_nodes.push_back(&patterns[i]);
+    }
+    return QueryPlanner::isCyclic(NUM_VARIABLES, query_nodes);
+  }
+
+  std::vector<std::unique_ptr<char[]>> buffers;
+  std::vector<PlanNode*> nodes;
+};
+
+TEST_F(QueryPlannerTest, certainRes) {
+  PlanNode* join = createNode(PlanNode::HashJoin, {}, { scan({ 0, 1 }), scan({ 1, 2 }) });
+  EXPECT_EQ(std::vector<uint32_t>({ 0, 1, 2 }), certainRes(join));
+
+  // variables of an OPTIONAL may be unbound
+  PlanNode* optional = optionalJoin(scan({ 0 }), scan({ 0, 3 }));
+  EXPECT_EQ(std::vector<uint32_t>({ 0 }), certainRes(optional));
+
+  // and so are the variables of only some UNION branches
+  PlanNode* branches = createNode(PlanNode::Union, {}, { scan({ 0, 1 }), scan({ 1, 2 }) });
+  EXPECT_EQ(std::vector<uint32_t>({ 1 }), certainRes(branches));
+
+  PlanNode* filter = createNode(PlanNode::Filter, {}, { optional });
+  EXPECT_EQ(std::vector<uint32_t>({ 0 }), certainRes(filter));
+}
+
+TEST_F(QueryPlannerTest, optionalJoinKey) {
+  EXPECT_EQ(1, optionalJoinKey(scan({ 0, 1 }), scan({ 1, 2 })));
+
+  // ?b may be unbound on the required side, an unbound row matches every
+  // optional row, which no hash lookup finds
+  PlanNode* required = optionalJoin(scan({ 0 }), scan({ 0, 1 }));
+  EXPECT_EQ(UINT32_MAX, optionalJoinKey(required, scan({ 1, 2 })));
+  // the same on the optional side
+  EXPECT_EQ(UINT32_MAX, optionalJoinKey(scan({ 1, 4 }), optionalJoin(scan({ 2 }), scan({ 1, 2 }))));
+  // a variable bound on both sides is still a key
+  EXPECT_EQ(0, optionalJoinKey(required, scan({ 0, 1, 2 })));
+
+  // nothing shared
+  EXPECT_EQ(UINT32_MAX, optionalJoinKey(scan({ 0 }), scan({ 5 })));
+}
+
+TEST_F(QueryPlannerTest, isCyclic) {
+  EXPECT_FALSE(isCyclic({ pattern(0, 1), pattern(1, 2), pattern(2, 3) }));
+  EXPECT_TRUE(isCyclic({ pattern(0, 1), pattern(1, 2), pattern(2, 0) }));
+  // two patterns over the same two variables
+  EXPECT_TRUE(isCyclic({ pattern(0, 1), pattern(1, 0) }));
+}
+
+TEST_F(QueryPlannerTest, selfLoopIsAcyclic) {
+  // ?x p ?x is not a cycle of the join graph
+  EXPECT_FALSE(isCyclic({ pattern(0, 0) }));
+  EXPECT_FALSE(isCyclic({ pattern(0, 1), pattern(1, 1), pattern(1, 2) }));
+  EXPECT_TRUE(isCyclic({ pattern(0, 0), pattern(0, 1), pattern(1, 2), pattern(2, 0) }));
+}
@@ -0,0 +1,175 @@
+#include <vector>
+#include <set>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include "operator/hash_join.h"
+
+class HashJoinTableTest : public testing::Test {
+protected:
+  typedef HashJoin::HashTable HashTable;
+  typedef HashJoin::Entry Entry;
+
+  const uint32_t EMPTY_KEY = HashTable::EMPTY_KEY;
+  const int BUCKET_SIZE = HashTable::BUCKET_SIZE;
+
+  static size_t numOfBuckets(HashTable& table) {
+    return table.num_buckets;
+  }
+
+  static int numOfKicks(HashTable& table) {
+    return table.kick;
+  }
+
+  static void hash(HashTable& table, uint32_t key, size_t& b1, size_t& b2) {
+    table.hash(key, b1, b2);
+  }
+
+  // rows of key, in the order the table chains them
+  static std::vector<uint32_t> rows(HashTable& table, Entry* entry) {
+    std::vector<uint32_t> result;
+    for(; entry != nullptr; entry = table.next(entry)) {
+      result.push_back(entry->row);
+    }
+    return result;
+  }
+
+  static std::multiset<uint32_t> rowSet(HashTable& table, Entry* entry) {
+    std::vector<uint32_t> result = rows(table, entry);
+    return std::multiset<uint32_t>(result.begin(), result.end());
+  }
+};
+
+TEST_F(HashJoinTableTest, rowsOfKey) {
+  HashTable table(16);
+  table.insert(5, 0);
+  table.insert(9, 1);
+  table.insert(5, 2);
+  table.insert(5, 3);
+  EXPECT_EQ(2, table.numOfKeys());
+  EXPECT_EQ(std::vector<uint32_t>({ 3, 2, 0 }), rows(table, table.lookup(5)));
+  EXPECT_EQ(std::vector<uint32_t>({ 1 }), rows(table, table.lookup(9)));
+  EXPECT_TRUE(table.exist(9));
+  EXPECT_FALSE(table.exist(7));
+  EXPECT_EQ(nullptr, table.lookup(7));
+}
+
+TEST_F(HashJoinTableTest, displacement) {
+  HashTable table(16);
+  size_t num_buckets = numOfBuckets(table);
+  ASSERT_GE(num_buckets, 4);
+
+  // fill bucket 0 with keys whose other bucket is 1, and bucket 1 with keys
+  // whose other bucket is 2; one more key of buckets 0 and 1 must evict
+  std::vector<uint32_t> first, second;
+  uint32_t extra = EMPTY_KEY;
+  for(uint32_t key=0; first.size() < BUCKET_SIZE || second.size() < BUCKET_SIZE || extra == EMPTY_KEY; key++) {
+    size_t b1, b2;
+    hash(table, key, b1, b2);
+    if(b1 == 0 && b2 == 1) {
+      if(first.size() < BUCKET_SIZE) {
+        first.push_back(key);
+      } else if(extra == EMPTY_KEY) {
+        extra = key;
+      }
+    } else if(b1 == 1 && b2 == 2 && second.size() < BUCKET_SIZE) {
+      second.push_back(key);
+    }
+  }
+  std::vector<uint32_t> keys = first;
+  keys.insert(keys.end(), second.begin(), second.end());
+  keys.push_back(extra);
+  for(uint32_t i=0; i<keys.size(); i++) {
+    table.insert(keys[i], i);
+  }
+  EXPECT_GT(numOfKicks(table), 0);
+  EXPECT_EQ(num_buckets, numOfBuckets(table));
+  EXPECT_EQ(keys.size(), table.numOfKeys());
+  for(uint32_t i=0; i<keys.size(); i++) {
+    EXPECT_EQ(std::vector<uint32_t>({ i }), rows(table, table.lookup(keys[i]))) << "key " << keys[i];
+  }
+}
+
+TEST_F(HashJoinTableTest, rehash) {
+  HashTable table(16);
+  size_t num_buckets = numOfBuckets(table);
+  std::mt19937 rng(7);
+  std::map<uint32_t, std::multiset<uint32_t>> expected;
+  for(uint32_t row=0; row<30000; row++) {
+    uint32_t key = rng() % 10000;
+    table.insert(key, row);
+    expected[key].insert(row);
+  }
+  EXPECT_GT(numOfBuckets(table), num_buckets);
+  EXPECT_EQ(expected.size(), table.numOfKeys());
+  for(std::map<uint32_t, std::multiset<uint32_t>>::iterator iter = expected.begin(); iter != expected.end(); ++iter) {
+    EXPECT_EQ(iter->second, rowSet(table, table.lookup(iter->first))) << "key " << iter->first;
+  }
+
+  std::vector<uint32_t> keys;
+  table.getAllKeys(keys);
+  std::sort(keys.begin(), keys.end());
+  EXPECT_EQ(expected.size(), keys.size());
+  EXPECT_TRUE(std::equal(keys.begin(), keys.end(), expected.begin(), [](uint32_t key, const std::pair<const uint32_t, std::multiset<uint32_t>>& p) { return key == p.first; }));
+}
+
+TEST_F(HashJoinTableTest, emptyKey) {
+  // EMPTY_KEY marks free slots, so its rows are kept on a side list
+  HashTable table(16);
+  EXPECT_EQ(nullptr, table.lookup(EMPTY_KEY));
+  EXPECT_FALSE(table.exist(EMPTY_KEY));
+  table.insert(EMPTY_KEY, 1);
+  table.insert(3, 2);
+  table.insert(EMPTY_KEY, 4);
+  EXPECT_EQ(2, table.numOfKeys());
+  EXPECT_EQ(std::vector<uint32_t>({ 4, 1 }), rows(table, table.lookup(EMPTY_KEY)));
+
+  // the side list survives rehashing
+  for(uint32_t key=100; key<5000; key++) {
+    table.insert(key, key);
+  }
+  EXPECT_EQ(std::vector<uint32_t>({ 4, 1 }), rows(table, table.lookup(EMPTY_KEY)));
+  EXPECT_EQ(std::vector<uint32_t>({ 2 }), rows(table, table.lookup(3)));
+
+  std::vector<uint32_t> keys;
+  table.getAllKeys(keys);
+  EXPECT_EQ(1, std::count(keys.begin(), keys.end(), EMPTY_KEY));
+
+  uint32_t probes[] = { 3, EMPTY_KEY, 99, EMPTY_KEY };
+  Entry* entries[4];
+  table.lookup(probes, 4, entries);
+  EXPECT_EQ(table.lookup(3), entries[0]);
+  EXPECT_EQ(table.lookup(EMPTY_KEY), entries[1]);
+  EXPECT_EQ(nullptr, entries[2]);
+  EXPECT_EQ(table.lookup(EMPTY_KEY), entries[3]);
+}
+
+TEST_F(HashJoinTableTest, batchedLookup) {
+  HashTable table(1024);
+  std::mt19937 rng(11);
+  std::vector<uint32_t> keys;
+  for(uint32_t row=0; row<20000; row++) {
+    uint32_t key = rng() % 50000;
+    keys.push_back(key);
+    table.insert(key, row);
+  }
+  table.insert(EMPTY_KEY, 20000);
+
+  // hits and misses, in batches below, at and above the lookup batch size
+  std::vector<uint32_t> probes;
+  for(int i=0; i<3001; i++) {
+    probes.push_back(i % 2 == 0 ? keys[rng() % keys.size()] : rng() % 100000);
+  }
+  probes[17] = EMPTY_KEY;
+  probes[1000] = EMPTY_KEY;
+  for(int n : { 1, 7, 64, 65, 200, 3001 }) {
+    std::vector<Entry*> entries(n);
+    for(int j=0; j+n<=probes.size(); j+=n) {
+      table.lookup(probes.data() + j, n, entries.data());
+      for(int i=0; i<n; i++) {
+        ASSERT_EQ(table.lookup(probes[j+i]), entries[i]) << "key " << probes[j+i] << ", batch of " << n;
+      }
+    }
+  }
+}
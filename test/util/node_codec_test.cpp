@@ -0,0 +1,264 @@
+#include <vector>
+#include <random>
+#include <cstring>
+#include <gtest/gtest.h>
+#include "common/constants.h"
+#include "storage/triple_table.h"
+
+class NodeCodecTest : public testing::Test {
+protected:
+  typedef TripleTable::Node Node;
+  typedef TripleTable::PackedData PackedData;
+
+  const uint16_t RAW_NODE = TripleTable::RAW_NODE;
+  const uint16_t FOR_NODE = TripleTable::FOR_NODE;
+  const uint16_t DELTA_NODE = TripleTable::DELTA_NODE;
+  const size_t NODE_DATA_MAX_SIZE = TripleTable::NODE_DATA_MAX_SIZE;
+
+  NodeCodecTest() : block(BLOCK_SIZE), rng(42) {}
+
+  Node* node() {
+    return reinterpret_cast<Node*>(block.data());
+  }
+
+  size_t encode(const uint32_t* ids, size_t n) {
+    return TripleTable::encodeNode(node(), ids, n);
+  }
+
+  size_t encode(const std::vector<uint32_t>& ids) {
+    return encode(ids.data(), ids.size());
+  }
+
+  void decode(std::vector<uint32_t>& column) {
+    TripleTable::decodeNode(node(), column);
+  }
+
+  int width() {
+    return reinterpret_cast<const PackedData*>(node()->data)->width;
+  }
+
+  // count values of width bits, packed as encodeNode packs them
+  std::vector<char> pack(const std::vector<uint32_t>& values, int width) {
+    std::vector<char> bits((values.size() * width + 7) / 8 + sizeof(uint64_t), 0);
+    for(size_t i=0; i<values.size() && width > 0; i++) {
+      size_t bit = i * width;
+      uint64_t word;
+      memcpy(&word, bits.data() + bit / 8, sizeof(uint64_t));
+      word |= (uint64_t)values[i] << (bit % 8);
+      memcpy(bits.data() + bit / 8, &word, sizeof(uint64_t));
+    }
+    return bits;
+  }
+
+  std::vector<uint32_t> randomValues(size_t n, int width) {
+    std::vector<uint32_t> values(n);
+    uint64_t mask = ((uint64_t)1 << width) - 1;
+    for(size_t i=0; i<n; i++) {
+      values[i] = rng() & mask;
+    }
+    return values;
+  }
+
+  static void unpackBits(const char* bits, int width, size_t count, uint32_t* out) {
+    TripleTable::unpackBits(bits, width, count, out);
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  static void unpackBitsAvx2(const char* bits, int width, size_t count, uint32_t* out) {
+    TripleTable::unpackBitsAvx2(bits, width, count, out);
+  }
+
+  static void prefixSumAvx2(uint32_t* values, size_t count, uint32_t base) {
+    TripleTable::prefixSumAvx2(values, count, base);
+  }
+#endif
+
+  std::vector<char> block;
+  std::mt19937 rng;
+};
+
+TEST_F(NodeCodecTest, rawNode) {
+  // full 32-bit range, packed at width 32 it holds fewer ids than raw
+  std::vector<uint32_t> ids = randomValues(5000, 32);
+  ids[0] = 0;
+  ids[1] = UINT32_MAX;
+  size_t count = encode(ids);
+  EXPECT_EQ(RAW_NODE, node()->dtype);
+  EXPECT_EQ((NODE_DATA_MAX_SIZE - 1) / sizeof(uint32_t), count);
+  std::vector<uint32_t> column;
+  decode(column);
+  EXPECT_EQ(std::vector<uint32_t>(ids.begin(), ids.begin() + count), column);
+}
+
+TEST_F(NodeCodecTest, width32) {
+  std::vector<uint32_t> ids = { 0, UINT32_MAX, 5, 1u << 31 };
+  EXPECT_EQ(ids.size(), encode(ids));
+  EXPECT_EQ(RAW_NODE, node()->dtype);
+  std::vector<uint32_t> column;
+  decode(column);
+  EXPECT_EQ(ids, column);
+
+  std::vector<uint32_t> ascending = { 0, UINT32_MAX };
+  EXPECT_EQ(ascending.size(), encode(ascending));
+  EXPECT_EQ(RAW_NODE, node()->dtype);
+  column.clear();
+  decode(column);
+  EXPECT_EQ(ascending, column);
+}
+
+TEST_F(NodeCodecTest, width0) {
+  std::vector<uint32_t> ids(1003, 77);
+  EXPECT_EQ(ids.size(), encode(ids));
+  EXPECT_EQ(FOR_NODE, node()->dtype);
+  EXPECT_EQ(0, width());
+  std::vector<uint32_t> column;
+  decode(column);
+  EXPECT_EQ(ids, column);
+}
+
+TEST_F(NodeCodecTest, forNode) {
+  for(int w : { 1, 7, 13, 24, 25, 26, 31 }) {
+    std::vector<uint32_t> ids = randomValues(1001, w);
+    ids[3] = 0;
+    ids[500] = (uint32_t)(((uint64_t)1 << w) - 1);
+    // unsorted, so not a delta node
+    ids[600] = 1;
+    ids[601] = 0;
+    for(size_t i=0; i<ids.size(); i++) {
+      ids[i] += 1000;
+    }
+    size_t count = encode(ids);
+    EXPECT_EQ(FOR_NODE, node()->dtype) << "width " << w;
+    EXPECT_EQ(w, width());
+    std::vector<uint32_t> column;
+    decode(column);
+    EXPECT_EQ(std::vector<uint32_t>(ids.begin(), ids.begin() + count), column) << "width " << w;
+  }
+}
+
+TEST_F(NodeCodecTest, deltaNode) {
+  for(int w : { 1, 9, 20, 25, 26 }) {
+    // few enough gaps that the ids stay below 2^32
+    std::vector<uint32_t> gaps = randomValues(w < 20 ? 1003 : 60, w);
+    gaps[10] = (uint32_t)(((uint64_t)1 << w) - 1);
+    std::vector<uint32_t> ids(gaps.size());
+    uint32_t id = 12345;
+    for(size_t i=0; i<gaps.size(); i++) {
+      id += i == 0 ? 0 : gaps[i];
+      ids[i] = id;
+    }
+    size_t count = encode(ids);
+    EXPECT_EQ(DELTA_NODE, node()->dtype) << "width " << w;
+    EXPECT_EQ(w, width());
+    std::vector<uint32_t> column;
+    decode(column);
+    EXPECT_EQ(std::vector<uint32_t>(ids.begin(), ids.begin() + count), column) << "width " << w;
+  }
+}
+
+TEST_F(NodeCodecTest, decodeAppends) {
+  std::vector<uint32_t> ids = { 10, 11, 13, 20 };
+  encode(ids);
+  std::vector<uint32_t> column = { 1, 2 };
+  decode(column);
+  EXPECT_EQ(std::vector<uint32_t>({ 1, 2, 10, 11, 13, 20 }), column);
+}
+
+TEST_F(NodeCodecTest, reencodeLastNode) {
+  // the last node is decoded, extended with the appended ids and encoded
+  // again, as writeData does
+  std::vector<uint32_t> ids;
+  for(uint32_t i=0; i<300; i++) {
+    ids.push_back(100 + 2 * i);
+  }
+  encode(ids);
+  EXPECT_EQ(DELTA_NODE, node()->dtype);
+
+  std::vector<uint32_t> column;
+  decode(column);
+  // the appended ids break the order, the node becomes a FOR node
+  std::vector<uint32_t> appended = { 50, 5000, 7, 1 << 20 };
+  column.insert(column.end(), appended.begin(), appended.end());
+  EXPECT_EQ(column.size(), encode(column));
+  EXPECT_EQ(FOR_NODE, node()->dtype);
+
+  std::vector<uint32_t> expected = ids;
+  expected.insert(expected.end(), appended.begin(), appended.end());
+  std::vector<uint32_t> result;
+  decode(result);
+  EXPECT_EQ(expected, result);
+}
+
+TEST_F(NodeCodecTest, chainOfNodes) {
+  // runs of every encoding, split over as many nodes as they need
+  std::vector<uint32_t> ids;
+  for(uint32_t i=0; i<20000; i++) {
+    ids.push_back(i * 3);
+  }
+  std::vector<uint32_t> noise = randomValues(10000, 32);
+  ids.insert(ids.end(), noise.begin(), noise.end());
+  std::vector<uint32_t> small = randomValues(30000, 11);
+  ids.insert(ids.end(), small.begin(), small.end());
+
+  std::vector<uint32_t> column;
+  size_t pos = 0;
+  int num_nodes = 0;
+  while(pos < ids.size()) {
+    size_t count = encode(ids.data() + pos, ids.size() - pos);
+    ASSERT_GT(count, 0);
+    EXPECT_LE(node()->dsize, NODE_DATA_MAX_SIZE);
+    decode(column);
+    pos += count;
+    num_nodes++;
+  }
+  EXPECT_EQ(ids, column);
+  EXPECT_GT(num_nodes, 3);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+TEST_F(NodeCodecTest, unpackBitsAvx2) {
+  // the scalar paths are covered on CPUs without AVX2
+  if(!__builtin_cpu_supports("avx2")) {
+    return;
+  }
+  for(int w=0; w<=25; w++) {
+    for(size_t n : { 0, 7, 8, 9, 64, 1001 }) {
+      std::vector<uint32_t> values = randomValues(n, w);
+      std::vector<char> bits = pack(values, w);
+      std::vector<uint32_t> scalar(n), simd(n);
+      unpackBits(bits.data(), w, n, scalar.data());
+      unpackBitsAvx2(bits.data(), w, n, simd.data());
+      EXPECT_EQ(values, scalar) << "width " << w << ", count " << n;
+      EXPECT_EQ(values, simd) << "width " << w << ", count " << n;
+    }
+  }
+}
+
+TEST_F(NodeCodecTest, prefixSumAvx2) {
+  // the scalar paths are covered on CPUs without AVX2
+  if(!__builtin_cpu_supports("avx2")) {
+    return;
+  }
+  for(size_t n : { 0, 1, 8, 15, 16, 1003 }) {
+    std::vector<uint32_t> gaps = randomValues(n, 20);
+    std::vector<uint32_t> expected(n);
+    uint32_t base = 987654;
+    for(size_t i=0; i<n; i++) {
+      base += gaps[i];
+      expected[i] = base;
+    }
+    prefixSumAvx2(gaps.data(), n, 987654);
+    EXPECT_EQ(expected, gaps) << "count " << n;
+  }
+}
+#endif
+
+TEST_F(NodeCodecTest, unpackBitsScalar) {
+  for(int w=26; w<=32; w++) {
+    std::vector<uint32_t> values = randomValues(257, w);
+    std::vector<char> bits = pack(values, w);
+    std::vector<uint32_t> out(values.size());
+    unpackBits(bits.data(), w, values.size(), out.data());
+    EXPECT_EQ(values, out) << "width " << w;
+  }
+}
@@ -185,6 +185,18 @@ void QueryCommand::run() {
   if(options.count("config-file")) {
     Config::loadConfig(options["config-file"]);
   }
+  if(options.count("threads")) {
+    Config::setParam(ConfigKey::NUM_THREADS, options["threads"]);
+  }
+  if(options.count("hash-table")) {
+    Config::setParam(ConfigKey::HASH_TABLE_LAYOUT, options["hash-table"]);
+  }
+  if(options.count("join-filter")) {
+    Config::setParam(ConfigKey::JOIN_FILTER, options["join-filter"]);
+  }
+  if(options.count("memory-limit")) {
+    Config::setParam(ConfigKey::JOIN_MEMORY_LIMIT, options["memory-limit"]);
+  }
   Database db(params[0]);
   db.open();
 
@@ -283,6 +295,10 @@ void QueryCommand::printUsage(const std::string& exec_name)
             << "\t--config-file=<configfile>\t\tSpecify config file name\n"
             << "\t--input-file=<infile>\t\tSpecify input file name\n"
             << "\t--output-file=<outfile>\t\tSpecify output file name\n"
+            << "\t--threads=<num>\t\t\tNumber of threads used by joins\n"
+            << "\t--hash-table=<chained|flat>\t\tHash table layout used by joins\n"
+            << "\t--join-filter=<none|xor|fuse>\t\tKey filter tested before join hash tables\n"
+            << "\t--memory-limit=<MB>\t\t\tMemory budget of join hash tables, spilled to disk beyond it\n"
             << "\t--help\t\t\t\tShow this help mesage for query command\n"
             << std::endl;
 }